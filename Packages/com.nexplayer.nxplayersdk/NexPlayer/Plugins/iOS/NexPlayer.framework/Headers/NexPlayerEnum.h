@@ -28,6 +28,9 @@ enum NexPlayer_EVENT_TYPE {
     NEXUNITY_EVENT_ERROR                 = 6,
     NEXUNITY_EVENT_LOADSTART             = 7,
     NEXUNITY_EVENT_STATUS_CHANGED        = 8,
+    NEXUNITY_EVENT_COMMAND_COMPLETE      = 9,
+    NEXUNITY_EVENT_CAPTION_GRID          = 10,
+    NEXUNITY_EVENT_METADATA_CUE          = 11,
     NEXUNITY_EVENT_TEXT_INIT            = 255,
     NEXUNITY_EVENT_TEXT_RENDER            = 256,
     NEXUNITY_EVENT_TIMED_METADATA_RENDER            = 0x90002
@@ -44,6 +47,143 @@ enum NexPlayerASYNC_EVENT_TYPE {
     NEXUNITY_ASYNC_CMD_SEEK = 11,
 };
 
+// State of a command enqueued on the native command worker, see NexPlayerUnity_GetCommandStatus.
+enum NexPlayerCOMMAND_STATUS {
+    NEXUNITY_COMMAND_UNKNOWN = 0,
+    NEXUNITY_COMMAND_PENDING = 1,
+    NEXUNITY_COMMAND_RUNNING = 2,
+    NEXUNITY_COMMAND_WAITING = 3,
+    NEXUNITY_COMMAND_DONE = 4,
+    NEXUNITY_COMMAND_FAILED = 5,
+    NEXUNITY_COMMAND_CANCELLED = 6,
+};
+
+// Memory regions returned by NexPlayerUnity_GetRegion.
+enum NexPlayerREGION {
+    NEXUNITY_REGION_EVENTS = 0,     // NexEventRecord ring
+    NEXUNITY_REGION_STATS = 1,      // NexStatsRecord per instance
+    NEXUNITY_REGION_PLAYHEAD = 2,   // NexPlayheadRecord per instance
+    NEXUNITY_REGION_STREAMS = 3,    // NexStreamRecord catalog
+    NEXUNITY_REGION_STRINGS = 4,    // NUL-terminated UTF-8 strings referenced by offset
+    NEXUNITY_REGION_TRACKS = 5,     // NexTrackRecord catalog
+    NEXUNITY_REGION_COUNT
+};
+
+// Timed-metadata fields; the nType of NEXPLAYERUnity_GetTimedMetadata_Data and NexMetadataEntry.field.
+enum NexPlayerMETADATA_FIELD {
+    NEXUNITY_METADATA_TITLE = 0,
+    NEXUNITY_METADATA_ALBUM = 1,
+    NEXUNITY_METADATA_ARTIST = 2,
+    NEXUNITY_METADATA_LYRICS = 3,
+    NEXUNITY_METADATA_GENRE = 4,
+    NEXUNITY_METADATA_PICTURE = 5,
+    NEXUNITY_METADATA_TRACK_NUMBER = 6,
+    NEXUNITY_METADATA_YEAR = 7,
+    NEXUNITY_METADATA_PRIVATE_FRAME = 8,
+    NEXUNITY_METADATA_COMMENT = 10,
+    NEXUNITY_METADATA_TEXT = 11,
+    NEXUNITY_METADATA_EXTRA = 12,   // NxTimedMetaExtraTag, identified by its tag id
+};
+
+enum NexPlayerMETADATA_FLAG {
+    NEXUNITY_METADATA_BINARY = 1,   // payload is raw bytes rather than UTF-8 text
+    NEXUNITY_METADATA_PICTURE_DATA = 2,
+};
+
+// Source of a NexTimelineEntry.
+enum NexPlayerTIMELINE_KIND {
+    NEXUNITY_TIMELINE_ID3 = 0,          // in-band timed metadata (payload: NexMetadataHeader buffer)
+    NEXUNITY_TIMELINE_EVENT = 1,        // entries added with NexPlayerUnity_AddTimelineEntry
+};
+
+// NexCaptionCell attributes bits.
+enum NexPlayerCAPTION_ATTRIBUTE {
+    NEXUNITY_CAPTION_ITALIC = 1,
+    NEXUNITY_CAPTION_UNDERLINE = 2,
+    NEXUNITY_CAPTION_FLASH = 4,
+    NEXUNITY_CAPTION_LARGE = 8,
+};
+
+// NexCueRecord type of subtitles rendered by the plugin.
+enum NexPlayerSUBTITLE_FORMAT {
+    NEXUNITY_SUBTITLE_WEBVTT = 0x50000001,
+    NEXUNITY_SUBTITLE_TTML = 0x50000002,
+    NEXUNITY_SUBTITLE_SRT = 0x50000003,
+};
+
+enum NexPlayerSTREAM_KIND {
+    NEXUNITY_STREAM_AUDIO = 0,
+    NEXUNITY_STREAM_TEXT = 1,
+    NEXUNITY_STREAM_VIDEO_TRACK = 2,    // renditions of the current video stream
+};
+
+// NexManifestInfo type of a manifest parsed by the plugin.
+enum NexPlayerMANIFEST_TYPE {
+    NEXUNITY_MANIFEST_DASH = 0,
+    NEXUNITY_MANIFEST_HLS = 1,
+};
+
+// NexSegmentRecord flags.
+enum NexPlayerSEGMENT_FLAG {
+    NEXUNITY_SEGMENT_DISCONTINUITY = 1,
+    NEXUNITY_SEGMENT_GAP = 2,
+    NEXUNITY_SEGMENT_INDEPENDENT = 4,
+    NEXUNITY_SEGMENT_PRELOAD_HINT = 8,  // LL-HLS part the server announced but has not finished
+};
+
+// NexKeyRecord method of an HLS EXT-X-KEY.
+enum NexPlayerKEY_METHOD {
+    NEXUNITY_KEY_NONE = 0,
+    NEXUNITY_KEY_AES_128 = 1,
+    NEXUNITY_KEY_SAMPLE_AES = 2,
+    NEXUNITY_KEY_SAMPLE_AES_CTR = 3,
+};
+
+// NexDeviceProfile videoCodecs mask.
+enum NexPlayerVIDEO_CODEC {
+    NEXUNITY_VIDEO_CODEC_AVC = 1,       // avc1, avc3
+    NEXUNITY_VIDEO_CODEC_HEVC = 2,      // hvc1, hev1, dvh1, dvhe
+    NEXUNITY_VIDEO_CODEC_AV1 = 4,
+    NEXUNITY_VIDEO_CODEC_VP9 = 8,
+};
+
+// NexDeviceProfile avcProfiles mask, by profile_idc of the avc1 codecs string.
+enum NexPlayerAVC_PROFILE {
+    NEXUNITY_AVC_PROFILE_BASELINE = 1,  // 66
+    NEXUNITY_AVC_PROFILE_MAIN = 2,      // 77
+    NEXUNITY_AVC_PROFILE_HIGH = 4,      // 100
+    NEXUNITY_AVC_PROFILE_HIGH_10 = 8,   // 110
+};
+
+// NexDeviceProfile order of the variants of an HLS master playlist.
+enum NexPlayerRENDITION_ORDER {
+    NEXUNITY_RENDITION_ORDER_AS_LISTED = 0,
+    NEXUNITY_RENDITION_ORDER_ASCENDING = 1,     // lowest BANDWIDTH first, so playback starts low
+    NEXUNITY_RENDITION_ORDER_DESCENDING = 2,
+};
+
+// NexCdnLocationStats state of a steering location.
+enum NexPlayerCDN_STATE {
+    NEXUNITY_CDN_HEALTHY = 0,
+    NEXUNITY_CDN_DEGRADED = 1,      // error rate or throughput well behind another location
+    NEXUNITY_CDN_HELD = 2,          // failing, no requests until holdRemainingMs runs out
+    NEXUNITY_CDN_PROBING = 3,       // out of its hold-off, one request in flight decides
+};
+
+// Steps of the stall watchdog, taken in this order (see NexRecoveryStats).
+enum NexPlayerRECOVERY_ACTION {
+    NEXUNITY_RECOVERY_RECONNECT = 0,    // reconnectNetwork
+    NEXUNITY_RECOVERY_SEEK = 1,         // seek to the current position
+    NEXUNITY_RECOVERY_DROP_RUNG = 2,    // next lower video track
+    NEXUNITY_RECOVERY_REOPEN = 3,       // close and open again at the current position
+};
+
+// How the resilience policy treats an NXError (see NexPlayerUnity_ClassifyError).
+enum NexPlayerERROR_CLASS {
+    NEXUNITY_ERROR_RETRYABLE = 0,       // network, timeout, HTTP 408/429/5xx
+    NEXUNITY_ERROR_FATAL = 1,
+};
+
 enum NexPlayer_PROPERTY_TYPE {
     NEXUNITY_NXPropertyInitialBufferingDuration = 9,
     NEXUNITY_NXPropertyReBufferingDuration = 10,
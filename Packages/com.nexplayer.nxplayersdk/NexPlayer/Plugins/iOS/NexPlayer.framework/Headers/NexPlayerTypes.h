@@ -8,6 +8,7 @@
 #ifndef NexPlayerTypes_h
 #define NexPlayerTypes_h
 
+#include <stdint.h>
 
 struct NexPlayerTrack
 {
@@ -19,4 +20,395 @@ public:
     int framerate;
 };
 
+// Per-instance player preferences, passed as one struct from Unity.
+// version and size must match NEXPLAYER_CONFIG_VERSION and sizeof(NexPlayerConfig);
+// zero leaves a preference at the SDK default, as with NEXPLAYERUnity_SetProperty.
+#define NEXPLAYER_CONFIG_VERSION 1
+
+struct NexPlayerConfig
+{
+public:
+    int version;
+    int size;
+    int maxBW;
+    int minBW;
+    int avSyncOffset;
+    int preferLanguage;
+    int preferBW;
+    int bufferingTime;
+    int enableTrackDown;
+    int trackDownVideoRatio;
+    int vDispWait;
+    int vDispSkip;
+    int startNearestBW;
+    int spdEnable;
+    int spdTime;
+    int spdSpeedUpSyncTime;
+    int spdJumpSyncTime;
+};
+
+// Playhead of one instance in shared memory, one cache line each (see NexPlayerUnity_GetPlayheadRecords).
+// sequence is odd while the record is being written: read sequence, the fields, then sequence again,
+// and retry if it was odd or changed. Between updates the position advances by
+// (now - monotonicUs) * rate while state is NXPlayerStatePlay.
+struct alignas(64) NexPlayheadRecord
+{
+public:
+    uint32_t sequence;
+    int32_t state;          // NXPlayerState
+    float rate;
+    int32_t reserved;
+    int64_t ptsMs;
+    int64_t monotonicUs;    // NexPlayerUnity_GetMonotonicUs() clock at which ptsMs was sampled
+};
+
+// Per-instance playback statistics, refreshed by the frame governor (see NexPlayerUnity_GetStats).
+struct NexStatsSnapshot
+{
+public:
+    int state;
+    int currentTimeMs;
+    int bufferedEndMs;
+    int durationMs;
+    int videoBitrate;
+    int audioBitrate;
+    int width;
+    int height;
+    int frameRate;
+    int trackBandwidth;
+};
+
+// The structs below are laid out for direct reads from NexPlayerUnity_GetRegion memory.
+// Records carrying a sequence are updated in place: read it, copy the fields, read it again
+// and retry if it was odd or changed.
+struct NexStatsRecord
+{
+public:
+    uint32_t sequence;
+    int32_t reserved;
+    NexStatsSnapshot stats;
+};
+
+// One slot of the event ring. number is the ordinal of the event (wrapping), so a reader
+// that remembers the region generation it last saw knows which slots are new.
+struct NexEventRecord
+{
+public:
+    uint32_t sequence;
+    uint32_t number;
+    int32_t event;          // NexPlayerEVENT
+    int32_t args[5];
+    int64_t monotonicUs;
+};
+
+// Audio or text stream of one instance; names are offsets into the NEXUNITY_REGION_STRINGS
+// region of the same generation (-1 when absent).
+struct NexStreamRecord
+{
+public:
+    int32_t instance;
+    int32_t kind;           // NexPlayerSTREAM_KIND
+    int32_t streamIndex;    // index among the instance's streams of that kind
+    int32_t id;
+    int32_t nameOffset;
+    int32_t languageOffset;
+    int32_t isCurrent;
+    int32_t reserved;
+};
+
+// Rendition of an instance's current video stream.
+struct NexTrackRecord
+{
+public:
+    int32_t instance;
+    int32_t trackIndex;
+    int32_t id;
+    int32_t bandwidth;
+    int32_t width;
+    int32_t height;
+    int32_t frameRateMilli; // frames per 1000 s
+    int32_t codec;          // NXCodecID
+    int32_t avcProfile;
+    int32_t avcLevel;
+    int32_t iFrame;
+    int32_t isCurrent;
+};
+
+#define NEXPLAYER_CEA608_ROWS 15
+#define NEXPLAYER_CEA608_COLS 32
+
+// One CEA-608 cell. character is a code in charset (0 = Unicode), 0 for an empty cell;
+// fg/bg are NXCEA608Color values and attributes is a NexPlayerCAPTION_ATTRIBUTE mask.
+#pragma pack(push, 2)
+struct NexCaptionCell
+{
+public:
+    uint16_t character;
+    uint8_t fg;
+    uint8_t bg;
+    uint8_t attributes;
+    uint8_t charset;
+};
+#pragma pack(pop)
+
+// CEA-608 grid of one instance, row-major (see NexPlayerUnity_GetCaptionGrid). Updated in
+// place under sequence; dirtyRows has bit r set for every row changed since the renderer last
+// took the mask with NexPlayerUnity_TakeCaptionDirtyRows.
+struct NexCaptionGrid
+{
+public:
+    uint32_t sequence;
+    uint32_t dirtyRows;
+    int32_t channel;        // NXCEA608Channel, 0 when off
+    int32_t rollupBaseRow;
+    int32_t rollupRows;
+    int32_t reserved;
+    NexCaptionCell cells[NEXPLAYER_CEA608_ROWS * NEXPLAYER_CEA608_COLS];
+};
+
+// Timed metadata of one update, serialized once (see NexPlayerUnity_GetTimedMetadataBuffer):
+// a NexMetadataHeader, entryCount NexMetadataEntry records, then the bytes they point at.
+// Offsets are from the start of the buffer; absent strings have offset -1 and length 0.
+struct NexMetadataHeader
+{
+public:
+    uint32_t generation;
+    int32_t entryCount;
+    int32_t totalSize;
+    int32_t instance;
+};
+
+struct NexMetadataEntry
+{
+public:
+    int32_t field;          // NexPlayerMETADATA_FIELD
+    int32_t flags;          // NexPlayerMETADATA_FLAG
+    int32_t tagOffset;      // tag id (UTF-8), for NEXUNITY_METADATA_EXTRA
+    int32_t tagLength;
+    int32_t mimeOffset;     // MIME type (UTF-8) of binary payloads, when known
+    int32_t mimeLength;
+    int32_t payloadOffset;
+    int32_t payloadLength;
+};
+
+// Entry of an instance's metadata timeline (see NexPlayerUnity_QueryTimeline).
+struct NexTimelineEntry
+{
+public:
+    int64_t ptsMs;
+    int64_t durationMs;
+    uint32_t id;
+    int32_t kind;           // NexPlayerTIMELINE_KIND
+    int32_t payloadSize;
+    int32_t reserved;
+};
+
+// Largest cue, terminator included; also the default and ceiling of NEXUNITY_NXPropertyMaxCaptionLength.
+#define NEXPLAYER_CUE_TEXT_MAX 8192
+
+// Current subtitle cue of one instance (see NexPlayerUnity_GetCue). text is UTF-8 and
+// NUL-terminated; length excludes the terminator and never exceeds NEXPLAYER_CUE_TEXT_MAX - 1.
+// endMs is -1 when the source does not say when the cue ends.
+struct NexCueRecord
+{
+public:
+    uint32_t sequence;
+    int32_t type;
+    int64_t startMs;
+    int64_t endMs;
+    uint32_t hash;
+    int32_t length;
+    char text[NEXPLAYER_CUE_TEXT_MAX];
+};
+
+// Manifest parsed by the plugin for one instance (see NexPlayerUnity_LoadManifest).
+struct NexManifestInfo
+{
+public:
+    uint32_t generation;
+    int32_t type;           // NexPlayerMANIFEST_TYPE
+    int32_t live;
+    int32_t periodCount;
+    int32_t renditionCount;
+    int32_t parseUs;
+    int32_t refreshUs;      // last reload of a live manifest that updated the index, 0 after a full parse
+    int32_t reserved;
+    int64_t durationMs;     // -1 when the end is not known
+    int64_t segmentCount;   // over all renditions
+};
+
+// Representation (DASH) or variant/rendition (HLS) of a parsed manifest. Strings are offsets for
+// NexPlayerUnity_GetManifestString (-1 when absent); startMs and durationMs span the segments the
+// index currently holds. HLS renditions of a master playlist have no segments until their media
+// playlist is loaded with NexPlayerUnity_LoadMediaPlaylist.
+struct NexRenditionRecord
+{
+public:
+    int32_t period;
+    int32_t kind;           // NexPlayerSTREAM_KIND, NEXUNITY_STREAM_VIDEO_TRACK for video
+    int32_t bandwidth;
+    int32_t width;
+    int32_t height;
+    int32_t frameRateMilli; // frames per 1000 s
+    int32_t idOffset;       // DASH id, HLS NAME
+    int32_t codecsOffset;
+    int32_t languageOffset;
+    int32_t uriOffset;      // HLS media playlist URL
+    int32_t groupOffset;    // HLS GROUP-ID, or the AUDIO group of a variant
+    int32_t targetDurationMs;
+    int32_t partTargetMs;   // LL-HLS PART-TARGET, 0 without parts
+    int32_t holdBackMs;     // LL-HLS PART-HOLD-BACK, else HOLD-BACK; -1 when absent
+    int32_t pendingPartCount;   // LL-HLS parts of the segment still being produced, hint included
+    int32_t dateRangeCount;
+    uint32_t segmentCount;
+    uint32_t timescale;
+    uint64_t firstNumber;
+    int64_t startMs;
+    int64_t durationMs;
+};
+
+// Segment of a rendition, resolved from the index on request.
+struct NexSegmentRecord
+{
+public:
+    uint64_t number;        // $Number$
+    uint64_t time;          // $Time$, in the rendition's timescale
+    int64_t startMs;
+    int64_t durationMs;
+    int64_t rangeStart;     // -1 for the whole resource
+    int64_t rangeLength;    // 0 with rangeStart set: up to the end of the resource
+    int64_t programDateMs;  // HLS EXT-X-PROGRAM-DATE-TIME in Unix ms, -1 when unknown
+    uint32_t flags;         // NexPlayerSEGMENT_FLAG
+    int32_t keyIndex;       // NexPlayerUnity_GetManifestKey, -1 when clear
+    int32_t partCount;      // LL-HLS parts (NexPlayerUnity_GetManifestPart)
+    int32_t reserved;
+};
+
+// HLS EXT-X-KEY; strings are offsets for NexPlayerUnity_GetManifestString with the rendition.
+struct NexKeyRecord
+{
+public:
+    int32_t method;         // NexPlayerKEY_METHOD
+    int32_t uriOffset;
+    int32_t keyFormatOffset;
+    int32_t hasIV;
+    uint8_t iv[16];
+};
+
+// HLS EXT-X-DATERANGE. attributesOffset is the whole attribute list as written, for
+// SCTE35-* and X-* values.
+struct NexDateRangeRecord
+{
+public:
+    int32_t idOffset;
+    int32_t classOffset;
+    int32_t attributesOffset;
+    int32_t endOnNext;
+    int64_t startDateMs;    // Unix ms
+    int64_t endDateMs;      // -1 when absent
+    int64_t durationMs;     // -1 when absent
+    int64_t plannedDurationMs;
+};
+
+// What an instance's device can decode (see NexPlayerUnity_SetDeviceProfile). Video renditions
+// over a limit are cut out of its manifests before the SDK parses them; zero leaves a limit off.
+// version and size must match NEXPLAYER_DEVICE_PROFILE_VERSION and sizeof(NexDeviceProfile).
+#define NEXPLAYER_DEVICE_PROFILE_VERSION 1
+
+struct NexDeviceProfile
+{
+public:
+    int32_t version;
+    int32_t size;
+    int32_t maxWidth;
+    int32_t maxHeight;
+    int32_t maxBitrate;     // bps, DASH bandwidth or HLS BANDWIDTH
+    int32_t videoCodecs;    // NexPlayerVIDEO_CODEC mask
+    int32_t avcProfiles;    // NexPlayerAVC_PROFILE mask
+    int32_t maxAvcLevel;    // level_idc, 31 for 3.1
+    int32_t order;          // NexPlayerRENDITION_ORDER
+    int32_t reserved;
+};
+
+// Last manifest a device profile was applied to (see NexPlayerUnity_GetManifestRewriteInfo).
+struct NexManifestRewriteInfo
+{
+public:
+    uint32_t count;         // manifests rewritten for the instance so far
+    int32_t type;           // NexPlayerMANIFEST_TYPE
+    int32_t kept;           // video renditions
+    int32_t removed;
+    int32_t inputSize;
+    int32_t outputSize;
+    int32_t rewriteUs;
+    int32_t reserved;
+};
+
+// One location of an instance's CDN steering set (see NexPlayerUnity_SetCdnLocations), in the
+// order of preference. throughputBps and errorRate are moving averages over finished requests.
+struct NexCdnLocationStats
+{
+public:
+    int32_t state;          // NexPlayerCDN_STATE
+    int32_t consecutiveErrors;
+    int64_t throughputBps;  // 0 until measured
+    float errorRate;        // 0 to 1
+    uint32_t requests;      // finished or failed while this location served them
+    uint32_t failures;
+    uint32_t steeredTo;     // requests moved here from the location they named
+    int32_t holdRemainingMs;
+    int32_t reserved;
+};
+
+// Stall watchdog QoE of one instance (see NexPlayerUnity_EnableWatchdog). A stall is counted from
+// the moment the position stopped advancing; it is recovered once the position advances again.
+struct NexRecoveryStats
+{
+public:
+    uint32_t stalls;
+    uint32_t recoveries;
+    uint32_t unrecovered;           // ended by leaving playback, or still frozen after every action
+    uint32_t actions[4];            // taken, by NexPlayerRECOVERY_ACTION
+    int32_t meanTimeToRecoverMs;    // -1 until the first recovery
+    int32_t lastTimeToRecoverMs;
+    int32_t maxTimeToRecoverMs;
+    int32_t stalledMs;              // length of the stall in progress, 0 when none
+    int32_t reserved;
+};
+
+// Per-instance network resilience policy (see NexPlayerUnity_SetResiliencePolicy).
+// version and size must match NEXPLAYER_RESILIENCE_VERSION and sizeof(NexResiliencePolicy);
+// zero leaves a field at its default, given in brackets.
+#define NEXPLAYER_RESILIENCE_VERSION 1
+
+struct NexResiliencePolicy
+{
+public:
+    int version;
+    int size;
+    int segmentRetries;             // HTTP errors of one segment URL left to the SDK [3]
+    int sessionRetries;             // recoveries between two opens [20]
+    int backoffBaseMs;              // first backoff, doubled per consecutive retry [500]
+    int backoffMaxMs;               // [16000]
+    int jitterPercent;              // each backoff varies by up to this much either way [50]
+    int dataInactivityTimeoutMs;    // NXPropertyDataInactivityTimeout [SDK default]
+    int socketOperationTimeoutMs;   // NXPropertySocketOperationTimeout [SDK default]
+};
+
+// Counters of an instance's resilience policy (see NexPlayerUnity_GetResilienceStats).
+struct NexResilienceStats
+{
+public:
+    uint32_t retryableErrors;       // errors absorbed, and segments past their retries
+    uint32_t fatalErrors;
+    uint32_t retries;               // recoveries attempted
+    uint32_t recoveries;            // playback advanced again after them
+    uint32_t forwarded;             // retryable errors passed to the app with the budget spent
+    int32_t sessionRetriesLeft;
+    int32_t meanRecoveryMs;         // first error to playback advancing, -1 until the first recovery
+    int32_t lastRecoveryMs;
+    int32_t maxRecoveryMs;
+    int32_t lastError;              // NXError
+};
+
 #endif /* NexPlayerTypes_h */
@@ -0,0 +1,356 @@
+//
+//  NexCdnSteering.h
+//  Unity-iPhone
+//
+//  Health-driven steering of an instance's HTTP requests between equivalent CDN locations.
+//  Plain C++; the bridge keeps one per instance under steeringLock.
+//
+
+#ifndef NexCdnSteering_h
+#define NexCdnSteering_h
+
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <NexPlayer/NexPlayerEnum.h>
+#include <NexPlayer/NexPlayerTypes.h>
+
+#include "NexTextScan.h"
+#include "NexManifestIndex.h"
+
+// Requests of an instance are steered between equivalent locations of the same content, URL
+// prefixes such as "https://a.example.com/vod/" and "https://b.example.net/cache/vod/", given by
+// NexPlayerUnity_SetCdnLocations or taken from the alternate BaseURLs of the MPD. The player hands
+// every request to nexPlayer:onModifyHttpRequest:, where one whose URL starts with a location is
+// pointed at the location to use now. Health comes from the statistics API's HTTP state callbacks:
+// moving averages of throughput and error rate per location, and after consecutive failures a
+// hold-off that doubles up to CDN_HOLD_MAX_US. A location coming out of its hold-off is sent one
+// probe request, and its success restores it. Traffic goes to the healthiest location, so it fails
+// back as soon as the one it left has recovered.
+#define CDN_MAX_LOCATIONS 8
+#define CDN_HOLD_MIN_US 2000000
+#define CDN_HOLD_MAX_US 30000000
+#define CDN_FAILURES_TO_HOLD 2
+#define CDN_MIN_SAMPLE_BYTES 16384      // smaller transfers say more about latency than throughput
+#define CDN_MIN_SAMPLES 3
+#define CDN_DEGRADED_ERROR_RATE 0.25
+#define CDN_SWITCH_ERROR_RATE 0.2       // one failure's worth
+#define CDN_SWITCH_MARGIN 1.25
+
+typedef struct {
+    std::string prefix;         // without the scheme: host[:port]/path
+    bool https;
+    double throughput;          // bytes per second
+    double errorRate;
+    uint32_t samples;
+    int consecutiveErrors;
+    int64_t holdUntilUs;
+    int64_t holdUs;             // the next hold-off
+    bool probing;
+    int64_t probeStartUs;
+    int64_t lastUs;             // when a transfer from it last ended
+    uint32_t requests;
+    uint32_t failures;
+    uint32_t steeredTo;
+} NexCdnLocation;
+
+typedef struct {
+    int location;
+    int64_t startUs;
+} NexCdnTransfer;
+
+// URL without its scheme, the form locations are matched in.
+static inline std::string NexSchemeless(const char *url, size_t length, bool *https) {
+    const char *separator = (const char *)memmem(url, length, "://", 3);
+    if(https != NULL)
+        *https = separator != NULL && separator - url == 5 && strncasecmp(url, "https", 5) == 0;
+    if(separator == NULL)
+        return std::string(url, length);
+    return std::string(separator + 3, url + length - separator - 3);
+}
+
+class NexCdnSteering {
+public:
+    std::vector<NexCdnLocation> locations;      // in the order of preference
+    bool configured;                            // set by the app, not taken from a manifest
+    int current;                                // where the last steered request went
+
+    NexCdnSteering() : configured(false), current(-1) {}
+
+    void setLocations(const std::vector<std::string> &urls, bool fromApp);
+    int locate(const std::string &url) const;
+    int choose(int named, int64_t nowUs);
+    bool rewrite(std::string &request, int64_t nowUs);
+    void started(const std::string &url, int64_t nowUs);
+    void finished(const std::string &url, int64_t bytes, int64_t nowUs);
+    void failed(const std::string &url, int64_t nowUs);
+    int state(const NexCdnLocation &location, int64_t nowUs) const;
+
+private:
+    std::unordered_map<std::string, int> steered;           // requested URL -> location it went to
+    std::unordered_map<std::string, NexCdnTransfer> transfers;
+    int transferLocation(const std::string &url, bool erase);
+    bool degraded(const NexCdnLocation &location, int64_t nowUs) const;
+    bool healthier(const NexCdnLocation &location, const NexCdnLocation &other, int64_t nowUs) const;
+};
+
+inline void NexCdnSteering::setLocations(const std::vector<std::string> &urls, bool fromApp) {
+    locations.clear();
+    steered.clear();
+    transfers.clear();
+    current = -1;
+    configured = fromApp && !urls.empty();
+    for(const std::string &url : urls){
+        if(locations.size() >= CDN_MAX_LOCATIONS)
+            break;
+        NexCdnLocation location = {};
+        location.prefix = NexSchemeless(url.data(), url.size(), &location.https);
+        location.holdUs = CDN_HOLD_MIN_US;
+        if(!location.prefix.empty())
+            locations.push_back(location);
+    }
+    if(locations.size() < 2)
+        locations.clear();
+}
+
+// Longest location prefix of a schemeless URL, -1 when none.
+inline int NexCdnSteering::locate(const std::string &url) const {
+    int found = -1;
+    for(size_t i = 0; i < locations.size(); i++)
+        if(url.compare(0, locations[i].prefix.size(), locations[i].prefix) == 0 &&
+           (found < 0 || locations[i].prefix.size() > locations[found].prefix.size()))
+            found = (int)i;
+    return found;
+}
+
+// Degraded locations get no traffic to disprove it, so the verdict lapses after CDN_HOLD_MAX_US.
+inline bool NexCdnSteering::degraded(const NexCdnLocation &location, int64_t nowUs) const {
+    if(nowUs - location.lastUs > CDN_HOLD_MAX_US)
+        return false;
+    if(location.errorRate > CDN_DEGRADED_ERROR_RATE)
+        return true;
+    if(location.samples < CDN_MIN_SAMPLES)
+        return false;
+    // An edge delivering under half of what another healthy location does is degraded too.
+    for(const NexCdnLocation &other : locations)
+        if(&other != &location && other.https == location.https && other.consecutiveErrors == 0 &&
+           other.samples >= CDN_MIN_SAMPLES && other.errorRate <= CDN_DEGRADED_ERROR_RATE && other.throughput > 2 * location.throughput)
+            return true;
+    return false;
+}
+
+inline int NexCdnSteering::state(const NexCdnLocation &location, int64_t nowUs) const {
+    if(nowUs < location.holdUntilUs)
+        return NEXUNITY_CDN_HELD;
+    if(location.consecutiveErrors >= CDN_FAILURES_TO_HOLD || location.probing)
+        return NEXUNITY_CDN_PROBING;
+    return degraded(location, nowUs) ? NEXUNITY_CDN_DEGRADED : NEXUNITY_CDN_HEALTHY;
+}
+
+// Location for a request naming `named`. A location out of its hold-off with no probe in flight
+// is sent the request as its probe (one never reported is given up after CDN_HOLD_MIN_US), so
+// recovered locations are found even while others carry the traffic. Otherwise the healthiest
+// healthy location: the first in preference order unless another has an error rate lower by more
+// than one failure's worth or, both measured, CDN_SWITCH_MARGIN times its throughput. Failing that
+// the first degraded one; failing that the one named. Only locations of the same scheme qualify, as the request cannot
+// change it.
+inline int NexCdnSteering::choose(int named, int64_t nowUs) {
+    int best = -1, fallback = -1;
+    for(size_t i = 0; i < locations.size(); i++){
+        NexCdnLocation &location = locations[i];
+        if(location.https != locations[named].https)
+            continue;
+        int state = this->state(location, nowUs);
+        if(state == NEXUNITY_CDN_PROBING && (!location.probing || nowUs - location.probeStartUs > CDN_HOLD_MIN_US)){
+            location.probing = true;
+            location.probeStartUs = nowUs;
+            return (int)i;
+        }
+        if(state == NEXUNITY_CDN_HEALTHY && (best < 0 || healthier(location, locations[best], nowUs)))
+            best = (int)i;
+        if(state == NEXUNITY_CDN_DEGRADED && fallback < 0)
+            fallback = (int)i;
+    }
+    return best >= 0 ? best : fallback >= 0 ? fallback : named;
+}
+
+// Whether `location` should take the traffic from `other`, which comes first in preference order.
+// The margins keep it from moving back and forth between locations that perform alike, and
+// figures of one left without traffic for CDN_HOLD_MAX_US are too old to keep it out.
+inline bool NexCdnSteering::healthier(const NexCdnLocation &location, const NexCdnLocation &other, int64_t nowUs) const {
+    if(nowUs - other.lastUs > CDN_HOLD_MAX_US)
+        return false;
+    if(location.errorRate + CDN_SWITCH_ERROR_RATE < other.errorRate)
+        return true;
+    if(other.errorRate + CDN_SWITCH_ERROR_RATE < location.errorRate)
+        return false;
+    return location.samples >= CDN_MIN_SAMPLES && other.samples >= CDN_MIN_SAMPLES &&
+           location.throughput > CDN_SWITCH_MARGIN * other.throughput;
+}
+
+// Points an HTTP request ("GET target HTTP/1.1\r\nHost: ...") that names a location at the one
+// chosen. The target may be absolute or a path with the host in the Host header.
+inline bool NexCdnSteering::rewrite(std::string &request, int64_t nowUs) {
+    if(locations.empty())
+        return false;
+    size_t targetStart = request.find(' ');
+    size_t targetEnd = targetStart != std::string::npos ? request.find(' ', targetStart + 1) : std::string::npos;
+    size_t lineEnd = request.find("\r\n");
+    if(targetEnd == std::string::npos || lineEnd == std::string::npos || targetEnd > lineEnd)
+        return false;
+    targetStart++;
+    bool absolute = request.compare(targetStart, 1, "/") != 0;
+    size_t hostStart = std::string::npos, hostEnd = std::string::npos;
+    for(size_t line = lineEnd + 2; line < request.size();){
+        size_t next = request.find("\r\n", line);
+        if(next == std::string::npos || next == line)
+            break;
+        if(next - line > 5 && strncasecmp(request.c_str() + line, "Host:", 5) == 0){
+            hostStart = line + 5;
+            while(hostStart < next && request[hostStart] == ' ')
+                hostStart++;
+            hostEnd = next;
+            break;
+        }
+        line = next + 2;
+    }
+    std::string url;
+    if(absolute)
+        url = NexSchemeless(request.c_str() + targetStart, targetEnd - targetStart, NULL);
+    else if(hostStart != std::string::npos)
+        url = request.substr(hostStart, hostEnd - hostStart) + request.substr(targetStart, targetEnd - targetStart);
+    else
+        return false;
+    int named = locate(url);
+    if(named < 0)
+        return false;
+    int chosen = choose(named, nowUs);
+    current = chosen;
+    steered[url] = chosen;
+    if(steered.size() > 256)
+        steered.clear();
+    if(chosen == named)
+        return false;
+
+    std::string moved = locations[chosen].prefix + url.substr(locations[named].prefix.size());
+    steered[moved] = chosen;
+    locations[chosen].steeredTo++;
+    size_t slash = moved.find('/');
+    std::string host = moved.substr(0, slash), path = slash != std::string::npos ? moved.substr(slash) : "/";
+    // Host first: it lies after the target, so replacing it leaves the target offsets valid.
+    if(hostStart != std::string::npos)
+        request.replace(hostStart, hostEnd - hostStart, host);
+    if(absolute)
+        request.replace(targetStart, targetEnd - targetStart, (locations[chosen].https ? "https://" : "http://") + moved);
+    else
+        request.replace(targetStart, targetEnd - targetStart, path);
+    return true;
+}
+
+// Location a transfer belongs to: where it was steered, else the one its URL names.
+inline int NexCdnSteering::transferLocation(const std::string &url, bool erase) {
+    auto found = steered.find(url);
+    if(found == steered.end())
+        return locate(url);
+    int location = found->second;
+    if(erase)
+        steered.erase(found);
+    return location;
+}
+
+inline void NexCdnSteering::started(const std::string &url, int64_t nowUs) {
+    int location = transferLocation(url, false);
+    if(location < 0)
+        return;
+    if(transfers.size() > 64)
+        transfers.clear();
+    transfers[url] = { location, nowUs };
+}
+
+inline void NexCdnSteering::finished(const std::string &url, int64_t bytes, int64_t nowUs) {
+    auto transfer = transfers.find(url);
+    int index = transfer != transfers.end() ? transfer->second.location : transferLocation(url, true);
+    if(index < 0 || index >= (int)locations.size())
+        return;
+    NexCdnLocation &location = locations[index];
+    int64_t elapsedUs = transfer != transfers.end() ? nowUs - transfer->second.startUs : 0;
+    if(bytes >= CDN_MIN_SAMPLE_BYTES && elapsedUs > 0){
+        double sample = (double)bytes * 1000000.0 / (double)elapsedUs;
+        location.throughput = location.samples == 0 ? sample : location.throughput * 0.7 + sample * 0.3;
+        location.samples++;
+    }
+    // A probe that succeeds clears the errors that put the location on hold.
+    location.errorRate = location.probing ? 0 : location.errorRate * 0.8;
+    location.consecutiveErrors = 0;
+    location.lastUs = nowUs;
+    location.holdUs = CDN_HOLD_MIN_US;
+    location.probing = false;
+    location.requests++;
+    if(transfer != transfers.end())
+        transfers.erase(transfer);
+    steered.erase(url);
+}
+
+inline void NexCdnSteering::failed(const std::string &url, int64_t nowUs) {
+    auto transfer = transfers.find(url);
+    int index = transfer != transfers.end() ? transfer->second.location : transferLocation(url, true);
+    if(index < 0 || index >= (int)locations.size())
+        return;
+    NexCdnLocation &location = locations[index];
+    location.errorRate = location.errorRate * 0.8 + 0.2;
+    location.consecutiveErrors++;
+    location.lastUs = nowUs;
+    location.requests++;
+    location.failures++;
+    if(location.probing || location.consecutiveErrors >= CDN_FAILURES_TO_HOLD){
+        location.holdUntilUs = nowUs + location.holdUs;
+        location.holdUs = std::min<int64_t>(location.holdUs * 2, CDN_HOLD_MAX_US);
+    }
+    location.probing = false;
+    if(transfer != transfers.end())
+        transfers.erase(transfer);
+    steered.erase(url);
+}
+
+// Absolute BaseURLs at the top of an MPD, before the first Period: alternate locations of
+// everything below them.
+static inline std::vector<std::string> NexMpdLocations(const char *data, size_t size) {
+    std::vector<std::string> urls;
+    const char *p = data, *end = data + size, *name;
+    std::string text;
+    while(p < end){
+        const char *tag = (const char *)memchr(p, '<', end - p);
+        if(tag == NULL || tag + 1 >= end)
+            break;
+        const char *tagEnd = (const char *)memchr(tag, '>', end - tag);
+        if(tagEnd == NULL)
+            break;
+        p = tagEnd + 1;
+        if(tag[1] == '/' || tag[1] == '!' || tag[1] == '?')
+            continue;
+        size_t length = NexTagLocalName(tag + 1, tagEnd, name);
+        if(NexNameIs(name, length, "Period"))
+            break;
+        if(!NexNameIs(name, length, "BaseURL") || tagEnd[-1] == '/')
+            continue;
+        const char *close = (const char *)memchr(p, '<', end - p);
+        if(close == NULL)
+            break;
+        text.clear();
+        NexAppendXmlText(text, p, close);
+        while(!text.empty() && text.back() == ' ')
+            text.pop_back();
+        if(text.compare(0, 7, "http://") == 0 || text.compare(0, 8, "https://") == 0)
+            urls.push_back(text);
+        p = close;
+    }
+    return urls;
+}
+
+#endif /* NexCdnSteering_h */
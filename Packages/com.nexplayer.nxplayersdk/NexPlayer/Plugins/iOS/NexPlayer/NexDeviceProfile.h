@@ -0,0 +1,336 @@
+//
+//  NexDeviceProfile.h
+//  Unity-iPhone
+//
+//  In-place rewrite of an MPD or HLS master playlist to the video renditions a device profile
+//  allows. Plain C++; NexDeviceProfile and NexManifestRewriteInfo come from NexPlayerTypes.h.
+//
+
+#ifndef NexDeviceProfile_h
+#define NexDeviceProfile_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <NexPlayer/NexPlayerEnum.h>
+#include <NexPlayer/NexPlayerTypes.h>
+
+#include "NexPlayerCore.h"
+#include "NexTextScan.h"
+#include "NexManifestIndex.h"
+
+typedef struct {
+    size_t start;           // bytes of the Representation element or variant, whole lines
+    size_t end;
+    int64_t bandwidth;
+    int group;              // AdaptationSet, or HLS variants (0) and I-frame variants (1)
+    bool video;
+    bool keep;
+} NexRewriteRendition;
+
+static inline int NexHexByte(const char *p) {
+    int value = 0;
+    for(int i = 0; i < 2; i++){
+        char c = p[i];
+        int digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+        if(digit < 0)
+            return -1;
+        value = value * 16 + digit;
+    }
+    return value;
+}
+
+// Video codec family of one RFC 6381 codec, 0 for anything else.
+static inline int NexVideoCodecFamily(const char *codec, const char *end) {
+    if(NexLineStarts(codec, end, "avc1") || NexLineStarts(codec, end, "avc3"))
+        return NEXUNITY_VIDEO_CODEC_AVC;
+    if(NexLineStarts(codec, end, "hvc1") || NexLineStarts(codec, end, "hev1") || NexLineStarts(codec, end, "dvh1") || NexLineStarts(codec, end, "dvhe"))
+        return NEXUNITY_VIDEO_CODEC_HEVC;
+    if(NexLineStarts(codec, end, "av01"))
+        return NEXUNITY_VIDEO_CODEC_AV1;
+    if(NexLineStarts(codec, end, "vp09") || NexLineStarts(codec, end, "vp9"))
+        return NEXUNITY_VIDEO_CODEC_VP9;
+    return 0;
+}
+
+// Whether every video codec of a codecs list passes the profile; reports whether it has one.
+static inline bool NexCodecsAllowed(const NexDeviceProfile &profile, const std::string &codecs, bool &video) {
+    const char *p = codecs.c_str(), *end = p + codecs.size();
+    while(p < end){
+        while(p < end && (*p == ',' || *p == ' '))
+            p++;
+        const char *codec = p;
+        while(p < end && *p != ',' && *p != ' ')
+            p++;
+        int family = NexVideoCodecFamily(codec, p);
+        if(family == 0)
+            continue;
+        video = true;
+        if(profile.videoCodecs != 0 && (profile.videoCodecs & family) == 0)
+            return false;
+        // avc1.PPCCLL: profile_idc, constraint flags, level_idc.
+        if(family != NEXUNITY_VIDEO_CODEC_AVC || p - codec < 11 || codec[4] != '.')
+            continue;
+        int profileIdc = NexHexByte(codec + 5), levelIdc = NexHexByte(codec + 9);
+        if(profile.avcProfiles != 0){
+            int mask = profileIdc == 66 ? NEXUNITY_AVC_PROFILE_BASELINE : profileIdc == 77 ? NEXUNITY_AVC_PROFILE_MAIN :
+                       profileIdc == 100 ? NEXUNITY_AVC_PROFILE_HIGH : profileIdc == 110 ? NEXUNITY_AVC_PROFILE_HIGH_10 : 0;
+            if((profile.avcProfiles & mask) == 0)
+                return false;
+        }
+        if(profile.maxAvcLevel > 0 && levelIdc > profile.maxAvcLevel)
+            return false;
+    }
+    return true;
+}
+
+static inline bool NexRenditionAllowed(const NexDeviceProfile &profile, int64_t width, int64_t height, int64_t bandwidth) {
+    return (profile.maxWidth <= 0 || width <= profile.maxWidth) && (profile.maxHeight <= 0 || height <= profile.maxHeight) &&
+           (profile.maxBitrate <= 0 || bandwidth <= profile.maxBitrate);
+}
+
+// Widens [start, end) to whole lines when nothing else shares them, so removals leave no blank lines.
+static inline void NexWholeLines(const char *data, size_t size, size_t &start, size_t &end) {
+    size_t lineStart = start;
+    while(lineStart > 0 && (data[lineStart - 1] == ' ' || data[lineStart - 1] == '\t'))
+        lineStart--;
+    if(lineStart > 0 && data[lineStart - 1] != '\n')
+        return;
+    size_t lineEnd = end;
+    while(lineEnd < size && (data[lineEnd] == ' ' || data[lineEnd] == '\t' || data[lineEnd] == '\r'))
+        lineEnd++;
+    if(lineEnd < size && data[lineEnd] != '\n')
+        return;
+    start = lineStart;
+    end = lineEnd < size ? lineEnd + 1 : lineEnd;
+}
+
+// A group of video renditions the profile rules out entirely keeps its lowest, so the SDK is
+// never left with nothing to play.
+static inline void NexKeepLowest(std::vector<NexRewriteRendition> &renditions, size_t first, int group) {
+    NexRewriteRendition *lowest = NULL;
+    for(size_t i = first; i < renditions.size(); i++){
+        if(!renditions[i].video || renditions[i].group != group)
+            continue;
+        if(renditions[i].keep)
+            return;
+        if(lowest == NULL || renditions[i].bandwidth < lowest->bandwidth)
+            lowest = &renditions[i];
+    }
+    if(lowest != NULL)
+        lowest->keep = true;
+}
+
+// Video Representations of an MPD. Attributes a Representation leaves out come from its
+// AdaptationSet; audio and text are always kept.
+static inline bool NexProfileDASH(const NexDeviceProfile &profile, const char *data, size_t size, std::vector<NexRewriteRendition> &renditions) {
+    const char *p = data, *end = data + size, *name;
+    std::string value, setCodecs, setMime;
+    int64_t setWidth = 0, setHeight = 0;
+    int group = -1;
+    size_t groupFirst = 0;
+    while(p < end){
+        const char *tag = (const char *)memchr(p, '<', end - p);
+        if(tag == NULL || tag + 1 >= end)
+            break;
+        if(tag[1] == '!'){
+            const char *close = tag + 1;
+            if(end - tag >= 4 && strncmp(tag, "<!--", 4) == 0){
+                for(close = tag + 4; close + 2 < end && !(close[0] == '-' && close[1] == '-' && close[2] == '>'); close++);
+                close += 2;
+            } else {
+                close = (const char *)memchr(tag, '>', end - tag);
+            }
+            if(close == NULL || close >= end)
+                break;
+            p = close + 1;
+            continue;
+        }
+        const char *tagEnd = (const char *)memchr(tag, '>', end - tag);
+        if(tagEnd == NULL)
+            return false;
+        p = tagEnd + 1;
+        if(tag[1] == '?')
+            continue;
+        bool closing = tag[1] == '/';
+        size_t length = NexTagLocalName(tag + (closing ? 2 : 1), tagEnd, name);
+        if(NexNameIs(name, length, "AdaptationSet")){
+            if(closing){
+                if(group >= 0)
+                    NexKeepLowest(renditions, groupFirst, group);
+                continue;
+            }
+            group++;
+            groupFirst = renditions.size();
+            setCodecs = NexXmlAttribute(tag, tagEnd, "codecs", value) ? value : "";
+            setMime = NexXmlAttribute(tag, tagEnd, "mimeType", value) ? value : NexXmlAttribute(tag, tagEnd, "contentType", value) ? value : "";
+            setWidth = NexXmlAttribute(tag, tagEnd, "width", value) ? strtoll(value.c_str(), NULL, 10) : 0;
+            setHeight = NexXmlAttribute(tag, tagEnd, "height", value) ? strtoll(value.c_str(), NULL, 10) : 0;
+        } else if(!closing && NexNameIs(name, length, "Representation") && group >= 0){
+            NexRewriteRendition rendition = {};
+            rendition.start = tag - data;
+            if(tagEnd[-1] == '/'){
+                rendition.end = p - data;
+            } else {
+                const char *close = NexFindClosingTag(p, end, "Representation");
+                const char *closeEnd = close != NULL ? (const char *)memchr(close, '>', end - close) : NULL;
+                if(closeEnd == NULL)
+                    return false;
+                p = closeEnd + 1;
+                rendition.end = p - data;
+            }
+            NexWholeLines(data, size, rendition.start, rendition.end);
+            std::string codecs = NexXmlAttribute(tag, tagEnd, "codecs", value) ? value : setCodecs;
+            std::string mime = NexXmlAttribute(tag, tagEnd, "mimeType", value) ? value : setMime;
+            int64_t width = NexXmlAttribute(tag, tagEnd, "width", value) ? strtoll(value.c_str(), NULL, 10) : setWidth;
+            int64_t height = NexXmlAttribute(tag, tagEnd, "height", value) ? strtoll(value.c_str(), NULL, 10) : setHeight;
+            rendition.bandwidth = NexXmlAttribute(tag, tagEnd, "bandwidth", value) ? strtoll(value.c_str(), NULL, 10) : 0;
+            rendition.group = group;
+            bool allowed = NexCodecsAllowed(profile, codecs, rendition.video);
+            rendition.video = rendition.video || mime.compare(0, 5, "video") == 0 || (mime.empty() && width > 0);
+            rendition.keep = !rendition.video || (allowed && NexRenditionAllowed(profile, width, height, rendition.bandwidth));
+            renditions.push_back(rendition);
+        }
+    }
+    return true;
+}
+
+// Variants of an HLS master playlist: EXT-X-STREAM-INF with its URI line, and EXT-X-I-FRAME-STREAM-INF.
+// Media playlists have neither and pass through.
+static inline bool NexProfileHLS(const NexDeviceProfile &profile, const char *data, size_t size, std::vector<NexRewriteRendition> &renditions) {
+    const char *p = data, *end = data + size;
+    std::string value;
+    size_t pending = SIZE_MAX;      // STREAM-INF still waiting for its URI line
+    // One that never gets it is left alone for the SDK to reject.
+    auto abandon = [&renditions](size_t variant) {
+        renditions[variant].group = -1;
+        renditions[variant].video = false;
+        renditions[variant].keep = true;
+    };
+    while(p < end){
+        const char *line = p, *lineEnd = NexLineEnd(p, end);
+        p = NexNextLine(p, end);
+        bool streamInf = NexLineStarts(line, lineEnd, "#EXT-X-STREAM-INF:"), iFrame = NexLineStarts(line, lineEnd, "#EXT-X-I-FRAME-STREAM-INF:");
+        if(streamInf || iFrame){
+            const char *list = line + (streamInf ? 18 : 26);
+            NexRewriteRendition rendition = {};
+            rendition.start = line - data;
+            rendition.end = p - data;
+            rendition.group = streamInf ? 0 : 1;
+            rendition.bandwidth = NexHlsAttribute(list, lineEnd, "BANDWIDTH", value) ? strtoll(value.c_str(), NULL, 10) : 0;
+            int64_t width = 0, height = 0;
+            if(NexHlsAttribute(list, lineEnd, "RESOLUTION", value)){
+                const char *x = strchr(value.c_str(), 'x');
+                width = strtoll(value.c_str(), NULL, 10);
+                height = x != NULL ? strtoll(x + 1, NULL, 10) : 0;
+            }
+            bool allowed = !NexHlsAttribute(list, lineEnd, "CODECS", value) || NexCodecsAllowed(profile, value, rendition.video);
+            rendition.video = rendition.video || width > 0 || iFrame;
+            rendition.keep = !rendition.video || (allowed && NexRenditionAllowed(profile, width, height, rendition.bandwidth));
+            if(pending != SIZE_MAX)
+                abandon(pending);
+            pending = streamInf ? renditions.size() : SIZE_MAX;
+            renditions.push_back(rendition);
+        } else if(pending != SIZE_MAX && line < lineEnd && *line != '#'){
+            // The URI line ends the variant.
+            renditions[pending].end = p - data;
+            pending = SIZE_MAX;
+        }
+    }
+    if(pending != SIZE_MAX)
+        abandon(pending);
+    NexKeepLowest(renditions, 0, 0);
+    NexKeepLowest(renditions, 0, 1);
+    return true;
+}
+
+// Moves what is kept down over the removed renditions; kept ones get their new offsets.
+static inline size_t NexRemoveRenditions(char *data, size_t size, std::vector<NexRewriteRendition> &renditions) {
+    size_t read = 0, write = 0;
+    for(NexRewriteRendition &rendition : renditions){
+        size_t shift = read - write;
+        if(rendition.keep){
+            rendition.start -= shift;
+            rendition.end -= shift;
+            continue;
+        }
+        if(write != read)
+            memmove(data + write, data + read, rendition.start - read);
+        write += rendition.start - read;
+        read = rendition.end;
+    }
+    if(write != read)
+        memmove(data + write, data + read, size - read);
+    return write + size - read;
+}
+
+// Puts the kept HLS variants in BANDWIDTH order in the slots they already occupy; whatever lies
+// between them stays where it is.
+static inline void NexOrderVariants(char *data, std::vector<NexRewriteRendition> &renditions, int order) {
+    std::vector<const NexRewriteRendition *> slots;
+    for(const NexRewriteRendition &rendition : renditions)
+        if(rendition.keep && rendition.group == 0){
+            // Moving a last line without its newline would join it to the next.
+            if(data[rendition.end - 1] != '\n')
+                return;
+            slots.push_back(&rendition);
+        }
+    if(slots.size() < 2)
+        return;
+    std::vector<const NexRewriteRendition *> sorted(slots);
+    std::stable_sort(sorted.begin(), sorted.end(), [order](const NexRewriteRendition *a, const NexRewriteRendition *b) {
+        return order == NEXUNITY_RENDITION_ORDER_DESCENDING ? a->bandwidth > b->bandwidth : a->bandwidth < b->bandwidth;
+    });
+    size_t begin = slots.front()->start, finish = slots.back()->end;
+    std::vector<char> copy(data + begin, data + finish);
+    char *out = data + begin;
+    size_t read = begin;
+    for(size_t i = 0; i < slots.size(); i++){
+        memcpy(out, &copy[read - begin], slots[i]->start - read);
+        out += slots[i]->start - read;
+        memcpy(out, &copy[sorted[i]->start - begin], sorted[i]->end - sorted[i]->start);
+        out += sorted[i]->end - sorted[i]->start;
+        read = slots[i]->end;
+    }
+}
+
+// Applies a device profile to an MPD or master playlist in place; returns the new size.
+static inline size_t NexApplyDeviceProfile(const NexDeviceProfile &profile, char *data, size_t size, NexManifestRewriteInfo &info) {
+    int64_t startUs = NexMonotonicUs();
+    info.inputSize = info.outputSize = (int32_t)size;
+    const char *p = data, *end = data + size;
+    if(size >= 3 && (uint8_t)p[0] == 0xEF && (uint8_t)p[1] == 0xBB && (uint8_t)p[2] == 0xBF)
+        p += 3;
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+        p++;
+    std::vector<NexRewriteRendition> renditions;
+    bool parsed;
+    if(NexLineStarts(p, end, "#EXTM3U")){
+        info.type = NEXUNITY_MANIFEST_HLS;
+        parsed = NexProfileHLS(profile, data, size, renditions);
+    } else if(p < end && *p == '<'){
+        info.type = NEXUNITY_MANIFEST_DASH;
+        parsed = NexProfileDASH(profile, data, size, renditions);
+    } else {
+        return size;
+    }
+    if(!parsed)
+        return size;
+    for(const NexRewriteRendition &rendition : renditions)
+        if(rendition.video)
+            (rendition.keep ? info.kept : info.removed)++;
+    if(info.removed > 0)
+        size = NexRemoveRenditions(data, size, renditions);
+    if(info.type == NEXUNITY_MANIFEST_HLS && profile.order != NEXUNITY_RENDITION_ORDER_AS_LISTED)
+        NexOrderVariants(data, renditions, profile.order);
+    info.outputSize = (int32_t)size;
+    info.rewriteUs = (int32_t)(NexMonotonicUs() - startUs);
+    return size;
+}
+
+#endif /* NexDeviceProfile_h */
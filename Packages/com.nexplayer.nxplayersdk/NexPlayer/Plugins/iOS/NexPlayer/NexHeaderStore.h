@@ -0,0 +1,185 @@
+//
+//  NexHeaderStore.h
+//  Unity-iPhone
+//
+//  Per-instance sets of HTTP headers and query tokens, published whole and applied to each
+//  request the SDK makes. Plain C++; the bridge keeps one set per instance under headerStoreLock.
+//
+
+#ifndef NexHeaderStore_h
+#define NexHeaderStore_h
+
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+typedef struct {
+    std::string name;
+    std::string value;
+} NexHeaderField;
+
+typedef struct {
+    uint32_t generation;
+    std::vector<NexHeaderField> headers;
+    std::vector<NexHeaderField> tokens;     // query parameters, values as they appear in the URL
+} NexHeaderSet;
+
+// Sets, or with value NULL removes, a field; header names compare without case.
+static inline void NexStoreField(std::vector<NexHeaderField> &fields, const std::string &name, const char *value, bool header) {
+    for(auto field = fields.begin(); field != fields.end(); ++field){
+        bool same = header ? field->name.size() == name.size() && strncasecmp(field->name.c_str(), name.c_str(), name.size()) == 0
+                           : field->name == name;
+        if(!same)
+            continue;
+        if(value != NULL)
+            field->value = value;
+        else
+            fields.erase(field);
+        return;
+    }
+    if(value != NULL)
+        fields.push_back({ name, value });
+}
+
+// Replaces the value of a query parameter of a request target, appending it when absent. The
+// value goes in as it is; the store only holds values NexEncodeQueryValue has made safe.
+static inline bool NexSetQueryToken(std::string &target, const NexHeaderField &token) {
+    std::string field = token.name + "=" + token.value;
+    size_t query = target.find('?');
+    if(query == std::string::npos){
+        target += "?" + field;
+        return true;
+    }
+    for(size_t p = query + 1; p <= target.size();){
+        size_t end = target.find('&', p);
+        if(end == std::string::npos)
+            end = target.size();
+        if(end - p >= token.name.size() && target.compare(p, token.name.size(), token.name) == 0 &&
+           (end - p == token.name.size() || target[p + token.name.size()] == '=')){
+            if(target.compare(p, end - p, field) == 0)
+                return false;
+            target.replace(p, end - p, field);
+            return true;
+        }
+        p = end + 1;
+    }
+    target += (target.back() == '?' || target.back() == '&' ? "" : "&") + field;
+    return true;
+}
+
+// Applies a set to an HTTP request ("GET target HTTP/1.1\r\nName: value\r\n...\r\n\r\n"). A header
+// already present is replaced, repeats of it are dropped, and a missing one goes last.
+static inline bool NexApplyHeaderSet(const NexHeaderSet &set, std::string &request) {
+    size_t lineEnd = request.find("\r\n");
+    if(lineEnd == std::string::npos)
+        return false;
+    bool changed = false;
+    if(!set.tokens.empty()){
+        size_t targetStart = request.find(' ');
+        size_t targetEnd = targetStart != std::string::npos ? request.find(' ', targetStart + 1) : std::string::npos;
+        if(targetEnd != std::string::npos && targetEnd < lineEnd){
+            targetStart++;
+            std::string target = request.substr(targetStart, targetEnd - targetStart);
+            bool moved = false;
+            for(const NexHeaderField &token : set.tokens)
+                moved |= NexSetQueryToken(target, token);
+            if(moved){
+                request.replace(targetStart, targetEnd - targetStart, target);
+                lineEnd = request.find("\r\n");
+                changed = true;
+            }
+        }
+    }
+    for(const NexHeaderField &header : set.headers){
+        std::string field = header.name + ": " + header.value;
+        bool found = false;
+        size_t line = lineEnd + 2;
+        while(line < request.size()){
+            size_t next = request.find("\r\n", line);
+            if(next == std::string::npos || next == line)
+                break;
+            if(next - line > header.name.size() && request[line + header.name.size()] == ':' &&
+               strncasecmp(request.c_str() + line, header.name.c_str(), header.name.size()) == 0){
+                if(found){
+                    request.erase(line, next + 2 - line);
+                    changed = true;
+                    continue;
+                }
+                found = true;
+                if(request.compare(line, next - line, field) != 0){
+                    request.replace(line, next - line, field);
+                    changed = true;
+                    next = line + field.size();
+                }
+            }
+            line = next + 2;
+        }
+        if(!found && request.compare(line, 2, "\r\n") == 0){
+            request.insert(line, field + "\r\n");
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+static inline bool NexHexDigit(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+// A query token value made safe for the request line: bytes a query value cannot hold (space,
+// '&', '#', controls, non-ASCII and the like) become %XX, and so does a '%' that does not start
+// an escape. A value already URL-encoded comes back unchanged.
+static inline std::string NexEncodeQueryValue(const std::string &value) {
+    static const char hex[] = "0123456789ABCDEF";
+    std::string encoded;
+    encoded.reserve(value.size());
+    for(size_t i = 0; i < value.size(); i++){
+        unsigned char c = (unsigned char)value[i];
+        bool escape = c == '%' && i + 2 < value.size() && NexHexDigit(value[i + 1]) && NexHexDigit(value[i + 2]);
+        if(escape || (c > 0x20 && c < 0x7F && strchr("\"#&<>\\^`{|}%", c) == NULL)){
+            encoded += (char)c;
+        } else {
+            encoded += '%';
+            encoded += hex[c >> 4];
+            encoded += hex[c & 15];
+        }
+    }
+    return encoded;
+}
+
+// A header name is an RFC 7230 token and its value holds no control characters but tab; a query
+// token name holds none of the characters that delimit it. Token values are encoded, not refused.
+static inline bool NexHeaderFieldValid(const std::string &name, const std::string &value, bool query) {
+    if(name.empty())
+        return false;
+    for(unsigned char c : name)
+        if(c <= 0x20 || c >= 0x7F || strchr(query ? "&=?#%" : "\"(),/:;<=>?@[\\]{}", c) != NULL)
+            return false;
+    if(!query)
+        for(unsigned char c : value)
+            if((c < 0x20 && c != '\t') || c == 0x7F)
+                return false;
+    return true;
+}
+
+// Publishes into `store` a copy of its set with one header or query token replaced, or with value
+// NULL removed; returns the new generation. Readers holding the old set keep it unchanged. The
+// caller serialises publishers.
+static inline uint32_t NexPublishHeaderField(std::shared_ptr<const NexHeaderSet> &store, const std::string &name, const char *value, bool query) {
+    std::shared_ptr<NexHeaderSet> updated = store != nullptr ? std::make_shared<NexHeaderSet>(*store) : std::make_shared<NexHeaderSet>();
+    if(store == nullptr)
+        updated->generation = 0;
+    updated->generation++;
+    if(query && value != NULL)
+        NexStoreField(updated->tokens, name, NexEncodeQueryValue(value).c_str(), false);
+    else
+        NexStoreField(query ? updated->tokens : updated->headers, name, value, !query);
+    store = updated;
+    return updated->generation;
+}
+
+#endif /* NexHeaderStore_h */
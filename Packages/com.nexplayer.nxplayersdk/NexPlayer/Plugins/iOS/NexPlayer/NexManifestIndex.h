@@ -0,0 +1,1831 @@
+//
+//  NexManifestIndex.h
+//  Unity-iPhone
+//
+//  Native DASH MPD and HLS playlist parser behind the bridge's per-instance segment index. Plain
+//  C++; the record layouts come from NexPlayerTypes.h and the constants from NexPlayerEnum.h.
+//
+
+#ifndef NexManifestIndex_h
+#define NexManifestIndex_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <NexPlayer/NexPlayerEnum.h>
+#include <NexPlayer/NexPlayerTypes.h>
+
+#include "NexPlayerCore.h"
+#include "NexTextScan.h"
+
+// DASH and HLS manifests parsed natively into a segment index per instance (see
+// NexPlayerUnity_LoadManifest). One forward pass builds it. DASH segments are never
+// materialised: a rendition keeps its resolved URL template plus either a fixed segment duration
+// and number range or a run-length SegmentTimeline, shared by every rendition of its
+// AdaptationSet. SegmentBase and SegmentList renditions are listed without segments. HLS media
+// playlists keep one fixed-size record per segment with the URI as written.
+// Reloads of a live manifest are diffed against the index instead of parsed again: an HLS
+// refresh finds the last segment it already holds by scanning back from the end of the new
+// playlist and parses only what follows, so its cost follows the new lines, not the event length.
+// A DASH refresh copies the runs of each known SegmentTimeline and parses only the S elements
+// after its end, but the server resends the whole MPD: finding each </SegmentTimeline> is still
+// a scan of the bytes, so a DASH refresh stays linear in the manifest size, only with a smaller
+// constant than a parse. Either way the index keeps at most the instance's window of segments
+// (NexPlayerUnity_SetManifestWindow).
+#define SEGMENT_RUN_OPEN UINT32_MAX
+
+typedef struct {
+    int64_t startMs;
+    int64_t durationMs;     // -1 while unknown
+} NexManifestPeriod;
+
+typedef struct {
+    uint64_t time;          // timescale units
+    uint64_t duration;
+    uint32_t count;         // SEGMENT_RUN_OPEN for r="-1" until the run is resolved
+    uint32_t first;         // segments of the timeline before this run
+} NexSegmentRun;
+
+typedef struct {
+    NexRenditionRecord record;
+    int32_t mediaOffset;    // resolved URL templates
+    int32_t initOffset;
+    uint64_t duration;      // fixed segment duration in timescale units, 0 with a timeline
+    uint64_t startNumber;
+    uint64_t presentationTimeOffset;
+    int64_t runStart;       // first NexSegmentRun, -1 without a timeline
+    uint32_t runCount;
+} NexManifestRendition;
+
+// HLS media playlist segment. Byte ranges without an offset continue the previous range.
+typedef struct {
+    int64_t startUs;        // from the first segment of the playlist
+    int64_t programDateMs;  // EXT-X-PROGRAM-DATE-TIME, extrapolated; -1 before the first one
+    int64_t rangeStart;     // -1 for the whole resource
+    int64_t rangeLength;
+    int32_t durationUs;
+    int32_t uriOffset;
+    int32_t keyIndex;       // -1 when clear
+    int32_t mapIndex;       // EXT-X-MAP in effect, -1 without
+    uint32_t flags;         // NexPlayerSEGMENT_FLAG
+    uint32_t partStart;     // LL-HLS parts, by serial (see NexMediaPlaylist::partBase)
+    uint32_t partCount;
+    int32_t reserved;
+} NexHlsSegment;
+
+typedef struct {
+    int64_t rangeStart;
+    int64_t rangeLength;
+    int32_t durationUs;
+    int32_t uriOffset;
+    uint32_t flags;
+    int32_t reserved;
+} NexHlsPart;
+
+typedef struct {
+    int64_t rangeStart;
+    int64_t rangeLength;
+    int32_t uriOffset;
+    int32_t reserved;
+} NexHlsMap;
+
+class NexMediaPlaylist {
+public:
+    std::string url;
+    uint64_t mediaSequence;                 // of segments.front()
+    uint64_t discontinuitySequence;
+    int64_t targetDurationMs;
+    int64_t partTargetMs;
+    int64_t holdBackMs;
+    bool endList;
+    bool canBlockReload;
+    std::deque<NexHlsSegment> segments;     // deques, so a sliding window drops from the front in place
+    std::deque<NexHlsPart> parts;           // of the segments, then of the one still being produced
+    uint32_t partBase;                      // serial of parts.front()
+    uint32_t pendingPartStart;              // serial
+    std::vector<NexKeyRecord> keys;
+    std::vector<NexHlsMap> maps;
+    std::vector<NexDateRangeRecord> dateRanges;
+    std::vector<char> strings;
+    int64_t parseUs;
+    int64_t refreshUs;                      // last incremental update, 0 after a full parse
+    uint32_t appendedSegments;              // by the last parse, or since the playlist a refresh replaced
+
+    NexMediaPlaylist() {
+        reset();
+    }
+
+    bool parse(const char *data, size_t size, const char *playlistUrl, size_t window);
+    bool refresh(const char *data, size_t size, size_t window);
+
+    const char *string(int32_t offset) const {
+        return offset >= 0 && (size_t)offset < strings.size() ? &strings[offset] : NULL;
+    }
+
+    uint32_t partEnd() const {
+        return partBase + (uint32_t)parts.size();
+    }
+
+    // Media sequence number after the last segment held.
+    uint64_t sequenceEnd() const {
+        return mediaSequence + segments.size();
+    }
+
+    int64_t durationUs() const {
+        return segments.empty() ? 0 : endUs - segments.front().startUs;
+    }
+
+private:
+    // Carried from one segment to the next, and so from a parse to the following refresh.
+    int64_t endUs;
+    int64_t nextRangeOffset;
+    int32_t keyIndex;
+    int32_t mapIndex;
+    bool independentSegments;
+    int64_t holdBack, partHoldBack;
+    uint64_t lastSignature, previousSignature;  // of the last two segments, see NexSegmentSignature
+    size_t compactedSize;
+
+    void reset();
+    const char *parseLines(const char *p, const char *end, bool header);
+    const char *findTail(const char *begin, const char *end, uint32_t &newer) const;
+    uint32_t listedParts(const char *begin, const char *uriEnd) const;
+    void dropUnlistedParts(uint32_t listed);
+    void trim(uint64_t listed, size_t window);
+    void compact();
+
+    int32_t addString(const char *p, size_t length) {
+        if(length == 0)
+            return -1;
+        int32_t offset = (int32_t)strings.size();
+        strings.insert(strings.end(), p, p + length);
+        strings.push_back(0);
+        return offset;
+    }
+
+    int32_t addString(const std::string &value) {
+        return addString(value.data(), value.size());
+    }
+};
+
+// SegmentTimeline of a parsed MPD, in document order; a refresh resumes the matching one.
+typedef struct {
+    int64_t runStart;
+    uint32_t runCount;
+    bool open;              // has an r="-1" run, which the clock resolves; parsed in full
+    uint64_t endTime;       // after the last segment
+    uint64_t firstNumber;   // $Number$ of the first segment kept
+} NexDashTimeline;
+
+struct NexDashLevel;
+
+class NexManifestIndex {
+public:
+    int type;               // NexPlayerMANIFEST_TYPE
+    bool live;
+    uint32_t generation;
+    size_t window;          // segments kept per rendition, 0 for all listed
+    int64_t durationMs;
+    int64_t availabilityStartMs;
+    int64_t timeShiftBufferMs;
+    int64_t minimumUpdateMs;
+    int64_t parseUs;
+    int64_t refreshUs;      // last incremental update, 0 after a full parse
+    std::string url;
+    std::vector<NexManifestPeriod> periods;
+    std::vector<NexManifestRendition> renditions;
+    std::vector<NexSegmentRun> runs;
+    std::vector<NexDashTimeline> timelines;
+    std::vector<char> strings;
+    std::vector<std::unique_ptr<NexMediaPlaylist>> playlists;   // HLS, per rendition; null until loaded
+    std::vector<std::unique_ptr<NexMediaPlaylist>> spares;      // what playlists[] held before the last reload
+
+    NexManifestIndex() : type(NEXUNITY_MANIFEST_DASH), live(false), generation(0), window(0), durationMs(-1), availabilityStartMs(-1),
+                         timeShiftBufferMs(-1), minimumUpdateMs(-1), parseUs(0), refreshUs(0) {}
+
+    // previous, when given, is the index of an earlier load of the same live MPD.
+    bool parse(const char *data, size_t size, const char *url, int64_t nowMs, const NexManifestIndex *previous = NULL);
+    bool refreshPlaylist(size_t rendition, const char *data, size_t size);
+    std::unique_ptr<NexMediaPlaylist> stagePlaylist(size_t rendition, const char *data, size_t size);
+    void publishPlaylist(size_t rendition, std::unique_ptr<NexMediaPlaylist> staged);
+    bool segment(size_t rendition, uint32_t position, NexSegmentRecord &segment) const;
+    int64_t findSegment(size_t rendition, int64_t ms) const;
+    bool segmentURL(size_t rendition, uint32_t position, bool init, std::string &url) const;
+    bool part(size_t rendition, uint32_t position, uint32_t part, NexSegmentRecord &segment, std::string *url) const;
+    void attachPlaylist(size_t rendition, std::unique_ptr<NexMediaPlaylist> playlist);
+
+    // A media playlist loaded on its own rather than through a master playlist.
+    bool mediaOnly() const {
+        return type == NEXUNITY_MANIFEST_HLS && playlists.size() == 1 && playlists[0] != nullptr && playlists[0]->url == url;
+    }
+
+    // Whether a load of url for the rendition is a reload of its live media playlist.
+    bool refreshable(size_t rendition, const char *playlistUrl) const {
+        const NexMediaPlaylist *media = playlist(rendition);
+        return media != NULL && !media->endList && !media->segments.empty() && media->url == (playlistUrl != NULL ? playlistUrl : "");
+    }
+
+    const NexMediaPlaylist *playlist(size_t rendition) const {
+        return type == NEXUNITY_MANIFEST_HLS && rendition < playlists.size() ? playlists[rendition].get() : NULL;
+    }
+
+    // Index strings with rendition -1, HLS media playlist strings with the rendition.
+    const char *string(int rendition, int32_t offset) const {
+        if(rendition >= 0){
+            const NexMediaPlaylist *media = playlist(rendition);
+            return media != NULL ? media->string(offset) : NULL;
+        }
+        return offset >= 0 && (size_t)offset < strings.size() ? &strings[offset] : NULL;
+    }
+
+    const char *string(int32_t offset) const {
+        return string(-1, offset);
+    }
+
+    int64_t segmentTotal() const {
+        int64_t total = 0;
+        for(const NexManifestRendition &rendition : renditions)
+            total += rendition.record.segmentCount;
+        return total;
+    }
+
+private:
+    std::unordered_map<std::string, int32_t> interned;     // only while parsing
+
+    int32_t intern(const std::string &value) {
+        if(value.empty())
+            return -1;
+        auto found = interned.find(value);
+        if(found != interned.end())
+            return found->second;
+        int32_t offset = (int32_t)strings.size();
+        strings.insert(strings.end(), value.c_str(), value.c_str() + value.size() + 1);
+        interned.emplace(value, offset);
+        return offset;
+    }
+
+    bool parseDASH(const char *p, const char *end, const std::string &url, int64_t nowMs, const NexManifestIndex *previous);
+    const char *resumeTimeline(const char *p, const char *end, const NexDashTimeline &known, const NexManifestIndex &previous,
+                               NexDashLevel &level, uint64_t &nextTime);
+    void addRun(int64_t runStart, uint64_t time, uint64_t duration, uint32_t count);
+    uint64_t trimTimeline(int64_t runStart);
+    void updateRendition(size_t rendition);
+    void addDashRendition(const NexDashLevel &level);
+    void finishDASH(int64_t nowMs);
+    bool parseHLSMaster(const char *p, const char *end, const std::string &url);
+};
+
+// ISO 8601 duration (PnYnMnDTnHnMnS); years and months count as 365 and 30 days.
+static inline bool NexParseIsoDuration(const std::string &value, int64_t &ms) {
+    const char *p = value.c_str();
+    if(*p != 'P')
+        return false;
+    p++;
+    bool time = false;
+    double total = 0;
+    while(*p != 0){
+        if(*p == 'T'){
+            time = true;
+            p++;
+            continue;
+        }
+        char *unit;
+        double number = strtod(p, &unit);
+        if(unit == p)
+            return false;
+        switch(*unit){
+            case 'Y': total += number * 31536000.0; break;
+            case 'M': total += number * (time ? 60.0 : 2592000.0); break;
+            case 'W': total += number * 604800.0; break;
+            case 'D': total += number * 86400.0; break;
+            case 'H': total += number * 3600.0; break;
+            case 'S': total += number; break;
+            default: return false;
+        }
+        p = unit + 1;
+    }
+    ms = (int64_t)(total * 1000.0 + 0.5);
+    return true;
+}
+
+static inline bool NexReadDigits(const char *&p, int count, int &out) {
+    out = 0;
+    for(int i = 0; i < count; i++, p++){
+        if(*p < '0' || *p > '9')
+            return false;
+        out = out * 10 + (*p - '0');
+    }
+    return true;
+}
+
+// xs:dateTime (2024-05-01T10:00:00[.fff][Z|+hh:mm]) to Unix milliseconds. Parsed by hand rather
+// than sscanf/timegm: HLS carries one PROGRAM-DATE-TIME per segment.
+static inline bool NexParseIsoDate(const std::string &value, int64_t &ms) {
+    const char *p = value.c_str();
+    int year, month, day, hour, minute, second;
+    if(!NexReadDigits(p, 4, year) || *p++ != '-' || !NexReadDigits(p, 2, month) || *p++ != '-' || !NexReadDigits(p, 2, day) ||
+       (*p != 'T' && *p != 't' && *p != ' ') || !NexReadDigits(++p, 2, hour) || *p++ != ':' || !NexReadDigits(p, 2, minute))
+        return false;
+    if(*p != ':' || !NexReadDigits(++p, 2, second))
+        second = 0;
+    if(month < 1 || month > 12 || day < 1 || day > 31)
+        return false;
+    int fraction = 0;
+    if(*p == '.'){
+        int scale = 100;
+        for(p++; *p >= '0' && *p <= '9'; p++, scale /= 10)
+            fraction += (*p - '0') * scale;
+    }
+    int offsetMinutes = 0;
+    if(*p == '+' || *p == '-'){
+        int sign = *p++ == '-' ? -1 : 1, hours = 0, minutes = 0;
+        if(!NexReadDigits(p, 2, hours))
+            return false;
+        if(*p == ':')
+            p++;
+        NexReadDigits(p, 2, minutes);
+        offsetMinutes = sign * (hours * 60 + minutes);
+    }
+    // Days since 1970-01-01 in the proleptic Gregorian calendar.
+    int y = year - (month <= 2);
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yearOfEra = y - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    int64_t days = (int64_t)era * 146097 + dayOfEra - 719468;
+    int64_t seconds = days * 86400 + hour * 3600 + minute * 60 + second - offsetMinutes * 60;
+    ms = seconds * 1000 + fraction;
+    return true;
+}
+
+// RFC 3986 reference resolution, enough for manifest BaseURLs and segment templates.
+static inline std::string NexResolveUrl(const std::string &base, const std::string &reference) {
+    size_t scheme = reference.find("://");
+    if(scheme != std::string::npos && reference.find_first_of("/?#") > scheme)
+        return reference;
+    size_t authority = base.find("://");
+    size_t pathStart = authority == std::string::npos ? 0 : base.find('/', authority + 3);
+    if(pathStart == std::string::npos)
+        pathStart = base.size();
+    if(reference.compare(0, 2, "//") == 0)
+        return base.substr(0, authority == std::string::npos ? 0 : authority + 1) + reference;
+
+    std::string path;
+    if(!reference.empty() && reference[0] == '/'){
+        path = reference;
+    } else {
+        size_t queryStart = base.find_first_of("?#", pathStart);
+        std::string basePath = base.substr(pathStart, queryStart == std::string::npos ? std::string::npos : queryStart - pathStart);
+        size_t slash = basePath.rfind('/');
+        path = (slash == std::string::npos ? std::string() : basePath.substr(0, slash + 1)) + reference;
+    }
+    // Dot segments, up to the query.
+    size_t queryStart = path.find_first_of("?#");
+    std::string tail = queryStart == std::string::npos ? std::string() : path.substr(queryStart);
+    path.resize(queryStart == std::string::npos ? path.size() : queryStart);
+    std::string output;
+    size_t i = 0;
+    while(i < path.size()){
+        size_t next = path.find('/', i);
+        bool last = next == std::string::npos;
+        std::string segment = path.substr(i, last ? std::string::npos : next - i);
+        if(segment == "."){
+            if(last && !output.empty() && output.back() != '/')
+                output.push_back('/');
+        } else if(segment == ".."){
+            if(!output.empty() && output.back() == '/')
+                output.pop_back();
+            size_t slash = output.rfind('/');
+            output.resize(slash == std::string::npos ? 0 : slash + 1);
+        } else {
+            output += segment;
+            if(!last)
+                output.push_back('/');
+        }
+        if(last)
+            break;
+        i = next + 1;
+    }
+    if(!path.empty() && path[0] == '/' && (output.empty() || output[0] != '/'))
+        output.insert(0, 1, '/');
+    return base.substr(0, pathStart) + output + tail;
+}
+
+// Local name of the element whose name starts at p (namespace prefix dropped).
+static inline size_t NexTagLocalName(const char *p, const char *end, const char *&name) {
+    const char *q = p;
+    while(q < end && *q != ' ' && *q != '>' && *q != '/' && *q != '\n' && *q != '\t' && *q != '\r')
+        q++;
+    const char *colon = (const char *)memchr(p, ':', q - p);
+    name = colon != NULL ? colon + 1 : p;
+    return q - name;
+}
+
+static inline bool NexNameIs(const char *name, size_t length, const char *expected) {
+    return strlen(expected) == length && memcmp(name, expected, length) == 0;
+}
+
+static inline void NexXmlUnescape(const std::string &value, std::string &out) {
+    if(value.find('&') == std::string::npos){
+        out = value;
+        return;
+    }
+    out.clear();
+    NexAppendXmlText(out, value.data(), value.data() + value.size());
+}
+
+static inline int NexParseFrameRate(const std::string &value) {
+    double numerator = atof(value.c_str());
+    size_t slash = value.find('/');
+    double denominator = slash == std::string::npos ? 1.0 : atof(value.c_str() + slash + 1);
+    return denominator > 0 ? (int)(numerator * 1000.0 / denominator + 0.5) : 0;
+}
+
+// Inherited state of one level of the MPD (MPD, Period, AdaptationSet, Representation).
+struct NexDashLevel {
+    std::string base;
+    bool ownBase = false;
+    std::string media, init;
+    uint32_t timescale = 1;
+    uint64_t duration = 0;
+    uint64_t startNumber = 1;
+    uint64_t presentationTimeOffset = 0;
+    int64_t runStart = -1;
+    uint32_t runCount = 0;
+    uint64_t timelineNumber = 1;    // startNumber past the segments a window or refresh left out
+    bool indexed = true;    // false under SegmentBase/SegmentList
+    std::string id, contentType, mimeType, codecs, language;
+    int bandwidth = 0, width = 0, height = 0, frameRateMilli = 0;
+};
+
+static inline void NexReadDashAttributes(NexDashLevel &level, const char *tag, const char *tagEnd, std::string &value) {
+    if(NexXmlAttribute(tag, tagEnd, "id", value)) level.id = value;
+    if(NexXmlAttribute(tag, tagEnd, "contentType", value)) level.contentType = value;
+    if(NexXmlAttribute(tag, tagEnd, "mimeType", value)) level.mimeType = value;
+    if(NexXmlAttribute(tag, tagEnd, "codecs", value)) level.codecs = value;
+    if(NexXmlAttribute(tag, tagEnd, "lang", value)) level.language = value;
+    if(NexXmlAttribute(tag, tagEnd, "bandwidth", value)) level.bandwidth = atoi(value.c_str());
+    if(NexXmlAttribute(tag, tagEnd, "width", value)) level.width = atoi(value.c_str());
+    if(NexXmlAttribute(tag, tagEnd, "height", value)) level.height = atoi(value.c_str());
+    if(NexXmlAttribute(tag, tagEnd, "frameRate", value)) level.frameRateMilli = NexParseFrameRate(value);
+}
+
+static inline int NexDashKind(const NexDashLevel &level) {
+    const std::string &type = !level.contentType.empty() ? level.contentType : level.mimeType;
+    if(type.compare(0, 5, "video") == 0)
+        return NEXUNITY_STREAM_VIDEO_TRACK;
+    if(type.compare(0, 5, "audio") == 0)
+        return NEXUNITY_STREAM_AUDIO;
+    return NEXUNITY_STREAM_TEXT;
+}
+
+// Start of the closing tag of `name`, with any namespace prefix, after p.
+static inline const char *NexFindClosingTag(const char *p, const char *end, const char *name) {
+    size_t length = strlen(name);
+    for(const char *scan = p; scan < end;){
+        const char *found = (const char *)memmem(scan, end - scan, name, length);
+        if(found == NULL || found + length >= end)
+            return NULL;
+        const char *tag = found;
+        if(tag > p && tag[-1] == ':')
+            for(tag--; tag > p && tag[-1] != '/' && tag[-1] != '<'; tag--);
+        char after = found[length];
+        if(tag - p >= 2 && tag[-1] == '/' && tag[-2] == '<' && (after == '>' || after == ' ' || after == '\t' || after == '\r' || after == '\n'))
+            return tag - 2;
+        scan = found + length;
+    }
+    return NULL;
+}
+
+inline void NexManifestIndex::addRun(int64_t runStart, uint64_t time, uint64_t duration, uint32_t count) {
+    NexSegmentRun *previous = (int64_t)runs.size() > runStart ? &runs.back() : NULL;
+    // Consecutive S elements of equal duration fold into one run.
+    if(previous != NULL && previous->count != SEGMENT_RUN_OPEN && count != SEGMENT_RUN_OPEN && (uint64_t)previous->count + count < SEGMENT_RUN_OPEN &&
+       previous->duration == duration && previous->time + previous->duration * previous->count == time){
+        previous->count += count;
+    } else {
+        NexSegmentRun run = { time, duration, count, 0 };
+        runs.push_back(run);
+    }
+}
+
+// Drops segments from the front of the timeline being parsed so at most `window` remain;
+// returns how many.
+inline uint64_t NexManifestIndex::trimTimeline(int64_t runStart) {
+    uint64_t total = 0;
+    for(size_t i = (size_t)runStart; i < runs.size(); i++)
+        total += runs[i].count;
+    if(window == 0 || total <= window)
+        return 0;
+    uint64_t skip = total - window;
+    size_t first = (size_t)runStart;
+    while(skip >= runs[first].count)
+        skip -= runs[first++].count;
+    runs[first].time += skip * runs[first].duration;
+    runs[first].count -= (uint32_t)skip;
+    runs.erase(runs.begin() + runStart, runs.begin() + first);
+    return total - window;
+}
+
+// Fills the SegmentTimeline whose first element is at p from the previous index's runs plus
+// the S elements past known.endTime. Only the tail is parsed: back from </SegmentTimeline> to
+// the last S with a t at or before the known end, when packagers write t on every S (or fold
+// repeats). Finding the closing tag and copying the known runs remain linear. Returns the
+// closing tag, or NULL with nothing added when the timeline has to be parsed in full.
+inline const char *NexManifestIndex::resumeTimeline(const char *p, const char *end, const NexDashTimeline &known, const NexManifestIndex &previous,
+                                             NexDashLevel &level, uint64_t &nextTime) {
+    std::string value;
+    const char *name;
+    const char *first = (const char *)memchr(p, '<', end - p);
+    const char *firstEnd = first != NULL ? (const char *)memchr(first, '>', end - first) : NULL;
+    if(firstEnd == NULL || first[1] == '/' || first[1] == '!' || !NexNameIs(name, NexTagLocalName(first + 1, firstEnd, name), "S"))
+        return NULL;
+    // The first S is where the listed window now starts.
+    uint64_t startTime = NexXmlAttribute(first, firstEnd, "t", value) ? strtoull(value.c_str(), NULL, 10) : 0;
+    const char *close = NexFindClosingTag(firstEnd, end, "SegmentTimeline");
+    if(close == NULL || known.runCount == 0 || startTime >= known.endTime)
+        return NULL;
+
+    typedef struct {
+        uint64_t time;
+        uint64_t duration;
+        long long repeat;
+        bool timed;
+    } NexTailElement;
+    std::vector<NexTailElement> tail;
+    for(const char *q = close; q > first;){
+        const char *tagEnd = q - 1;
+        while(tagEnd > first && *tagEnd != '>')
+            tagEnd--;
+        const char *tag = tagEnd;
+        while(tag > first && *tag != '<')
+            tag--;
+        if(*tagEnd != '>' || *tag != '<' || tag[1] == '/' || tag[1] == '!' || !NexNameIs(name, NexTagLocalName(tag + 1, tagEnd, name), "S"))
+            return NULL;
+        NexTailElement element = {};
+        bool hasTime = NexXmlAttribute(tag, tagEnd, "t", value);
+        element.time = tag == first ? startTime : hasTime ? strtoull(value.c_str(), NULL, 10) : 0;
+        element.timed = hasTime || tag == first;
+        element.duration = NexXmlAttribute(tag, tagEnd, "d", value) ? strtoull(value.c_str(), NULL, 10) : 0;
+        element.repeat = NexXmlAttribute(tag, tagEnd, "r", value) ? strtoll(value.c_str(), NULL, 10) : 0;
+        if(element.repeat < 0)
+            return NULL;
+        tail.push_back(element);
+        if(element.timed && element.time <= known.endTime)
+            break;
+        q = tag;
+    }
+
+    // Known runs from the new start, then the tail past the known end.
+    const NexSegmentRun *run = &previous.runs[known.runStart], *last = run + known.runCount;
+    uint64_t dropped = 0;
+    for(; run < last && run->time + run->duration * run->count <= startTime; run++)
+        dropped += run->count;
+    for(; run < last; run++){
+        uint64_t skip = run->time < startTime ? (startTime - run->time + run->duration - 1) / run->duration : 0;
+        if(skip >= run->count){
+            dropped += run->count;
+            continue;
+        }
+        dropped += skip;
+        addRun(level.runStart, run->time + skip * run->duration, run->duration, run->count - (uint32_t)skip);
+        // The rest were folded when first parsed, so they copy across as they are.
+        runs.insert(runs.end(), run + 1, last);
+        break;
+    }
+    uint64_t time = known.endTime;
+    for(auto element = tail.rbegin(); element != tail.rend(); ++element){
+        if(element->duration == 0)
+            continue;
+        if(element->timed)
+            time = element->time;
+        uint64_t count = (uint64_t)element->repeat + 1;
+        uint64_t skip = time >= known.endTime ? 0 : (known.endTime - time + element->duration - 1) / element->duration;
+        if(skip < count)
+            addRun(level.runStart, time + skip * element->duration, element->duration, (uint32_t)(count - skip));
+        time += element->duration * count;
+    }
+    nextTime = std::max(time, known.endTime);
+    level.timelineNumber = known.firstNumber + dropped;
+    return close;
+}
+
+inline bool NexManifestIndex::parseDASH(const char *p, const char *end, const std::string &url, int64_t nowMs, const NexManifestIndex *previous) {
+    NexDashLevel levels[4];
+    int depth = -1;
+    int timelineDepth = -1;
+    uint64_t nextTime = 0;
+    // Refreshes resume timelines only under the same window, or the copied runs could start late.
+    if(previous != NULL && (previous->type != NEXUNITY_MANIFEST_DASH || previous->window != window))
+        previous = NULL;
+    std::string value, text;
+
+    while(p < end){
+        const char *tag = (const char *)memchr(p, '<', end - p);
+        if(tag == NULL || tag + 1 >= end)
+            break;
+        if(tag[1] == '!'){
+            // Comments may hold '>', so look for their own terminator.
+            const char *close = tag + 1;
+            if(end - tag >= 4 && strncmp(tag, "<!--", 4) == 0){
+                for(close = tag + 4; close + 2 < end && !(close[0] == '-' && close[1] == '-' && close[2] == '>'); close++);
+                close += 2;
+            } else {
+                close = (const char *)memchr(tag, '>', end - tag);
+            }
+            if(close == NULL || close >= end)
+                break;
+            p = close + 1;
+            continue;
+        }
+        const char *tagEnd = (const char *)memchr(tag, '>', end - tag);
+        if(tagEnd == NULL)
+            break;
+        p = tagEnd + 1;
+        if(tag[1] == '?')
+            continue;
+        bool closing = tag[1] == '/';
+        bool selfClosing = tagEnd[-1] == '/';
+        const char *name;
+        size_t length = NexTagLocalName(tag + (closing ? 2 : 1), tagEnd, name);
+
+        if(closing){
+            if(NexNameIs(name, length, "SegmentTimeline") && timelineDepth >= 0){
+                NexDashLevel &level = levels[timelineDepth];
+                NexDashTimeline timeline = { level.runStart, 0, false, nextTime, 0 };
+                for(size_t i = (size_t)level.runStart; i < runs.size(); i++)
+                    timeline.open |= runs[i].count == SEGMENT_RUN_OPEN;
+                if(!timeline.open)
+                    level.timelineNumber += trimTimeline(level.runStart);
+                level.runCount = timeline.runCount = (uint32_t)(runs.size() - level.runStart);
+                timeline.firstNumber = level.timelineNumber;
+                timelines.push_back(timeline);
+                timelineDepth = -1;
+            } else if(NexNameIs(name, length, "Representation") && depth == 3){
+                addDashRendition(levels[3]);
+                depth = 2;
+            } else if(NexNameIs(name, length, "AdaptationSet") && depth == 2){
+                depth = 1;
+            } else if(NexNameIs(name, length, "Period") && depth == 1){
+                depth = 0;
+            }
+            continue;
+        }
+
+        if(NexNameIs(name, length, "S")){
+            if(timelineDepth < 0)
+                continue;
+            uint64_t time = NexXmlAttribute(tag, tagEnd, "t", value) ? strtoull(value.c_str(), NULL, 10) : nextTime;
+            uint64_t duration = NexXmlAttribute(tag, tagEnd, "d", value) ? strtoull(value.c_str(), NULL, 10) : 0;
+            long long repeat = NexXmlAttribute(tag, tagEnd, "r", value) ? strtoll(value.c_str(), NULL, 10) : 0;
+            if(duration == 0)
+                continue;
+            uint32_t count = repeat < 0 ? SEGMENT_RUN_OPEN : (uint32_t)repeat + 1;
+            addRun(levels[timelineDepth].runStart, time, duration, count);
+            nextTime = count == SEGMENT_RUN_OPEN ? time : time + duration * count;
+        } else if(NexNameIs(name, length, "MPD")){
+            depth = 0;
+            levels[0] = NexDashLevel();
+            levels[0].base = url;
+            live = NexXmlAttribute(tag, tagEnd, "type", value) && value == "dynamic";
+            if(NexXmlAttribute(tag, tagEnd, "mediaPresentationDuration", value))
+                NexParseIsoDuration(value, durationMs);
+            if(NexXmlAttribute(tag, tagEnd, "availabilityStartTime", value))
+                NexParseIsoDate(value, availabilityStartMs);
+            if(NexXmlAttribute(tag, tagEnd, "timeShiftBufferDepth", value))
+                NexParseIsoDuration(value, timeShiftBufferMs);
+            if(NexXmlAttribute(tag, tagEnd, "minimumUpdatePeriod", value))
+                NexParseIsoDuration(value, minimumUpdateMs);
+        } else if(depth < 0){
+            continue;
+        } else if(NexNameIs(name, length, "Period")){
+            depth = 1;
+            levels[1] = levels[0];
+            levels[1].ownBase = false;
+            NexManifestPeriod period = { -1, -1 };
+            if(NexXmlAttribute(tag, tagEnd, "start", value))
+                NexParseIsoDuration(value, period.startMs);
+            if(NexXmlAttribute(tag, tagEnd, "duration", value))
+                NexParseIsoDuration(value, period.durationMs);
+            periods.push_back(period);
+        } else if(NexNameIs(name, length, "AdaptationSet") && depth >= 1){
+            depth = 2;
+            levels[2] = levels[1];
+            levels[2].ownBase = false;
+            NexReadDashAttributes(levels[2], tag, tagEnd, value);
+        } else if(NexNameIs(name, length, "Representation") && depth >= 2){
+            depth = 3;
+            levels[3] = levels[2];
+            levels[3].ownBase = false;
+            NexReadDashAttributes(levels[3], tag, tagEnd, value);
+            if(selfClosing){
+                addDashRendition(levels[3]);
+                depth = 2;
+            }
+        } else if(NexNameIs(name, length, "BaseURL")){
+            // Only the first BaseURL of a level is followed.
+            const char *textEnd = (const char *)memchr(p, '<', end - p);
+            if(textEnd == NULL || selfClosing || levels[depth].ownBase)
+                continue;
+            text.clear();
+            NexAppendXmlText(text, p, textEnd);
+            while(!text.empty() && text.back() == ' ')
+                text.pop_back();
+            levels[depth].base = NexResolveUrl(depth > 0 ? levels[depth - 1].base : url, text);
+            levels[depth].ownBase = true;
+            p = textEnd;
+        } else if(NexNameIs(name, length, "SegmentTemplate")){
+            NexDashLevel &level = levels[depth];
+            if(NexXmlAttribute(tag, tagEnd, "media", value)) NexXmlUnescape(value, level.media);
+            if(NexXmlAttribute(tag, tagEnd, "initialization", value)) NexXmlUnescape(value, level.init);
+            if(NexXmlAttribute(tag, tagEnd, "timescale", value)) level.timescale = std::max(1u, (uint32_t)strtoul(value.c_str(), NULL, 10));
+            if(NexXmlAttribute(tag, tagEnd, "duration", value)) level.duration = strtoull(value.c_str(), NULL, 10);
+            if(NexXmlAttribute(tag, tagEnd, "startNumber", value)) level.startNumber = strtoull(value.c_str(), NULL, 10);
+            if(NexXmlAttribute(tag, tagEnd, "presentationTimeOffset", value)) level.presentationTimeOffset = strtoull(value.c_str(), NULL, 10);
+            level.indexed = true;
+        } else if(NexNameIs(name, length, "SegmentTimeline")){
+            if(selfClosing)
+                continue;
+            timelineDepth = depth;
+            levels[depth].runStart = (int64_t)runs.size();
+            levels[depth].runCount = 0;
+            levels[depth].duration = 0;
+            levels[depth].timelineNumber = levels[depth].startNumber;
+            nextTime = 0;
+            if(previous != NULL && timelines.size() < previous->timelines.size() && !previous->timelines[timelines.size()].open){
+                const char *close = resumeTimeline(p, end, previous->timelines[timelines.size()], *previous, levels[depth], nextTime);
+                if(close != NULL)
+                    p = close;
+            }
+        } else if(NexNameIs(name, length, "SegmentBase") || NexNameIs(name, length, "SegmentList")){
+            levels[depth].indexed = false;
+        }
+    }
+    if(periods.empty())
+        return false;
+    finishDASH(nowMs);
+    return true;
+}
+
+static inline NexManifestRendition NexEmptyRendition() {
+    NexManifestRendition rendition = {};
+    NexRenditionRecord &record = rendition.record;
+    record.idOffset = record.codecsOffset = record.languageOffset = record.uriOffset = record.groupOffset = -1;
+    record.holdBackMs = -1;
+    record.timescale = 1;
+    rendition.mediaOffset = rendition.initOffset = -1;
+    rendition.runStart = -1;
+    return rendition;
+}
+
+static inline bool NexLineStarts(const char *p, const char *end, const char *prefix) {
+    size_t length = strlen(prefix);
+    return (size_t)(end - p) >= length && memcmp(p, prefix, length) == 0;
+}
+
+// Playlist bytes are not NUL-terminated, so numbers are copied out before conversion.
+static inline double NexParseNumber(const char *p, const char *end) {
+    char number[48];
+    size_t length = std::min<size_t>(end - p, sizeof(number) - 1);
+    memcpy(number, p, length);
+    number[length] = 0;
+    return strtod(number, NULL);
+}
+
+// Value of NAME in an HLS attribute list (NAME=value,NAME="quoted value",...), quotes removed.
+static inline bool NexHlsAttribute(const char *p, const char *end, const char *name, std::string &value) {
+    size_t length = strlen(name);
+    while(p < end){
+        while(p < end && (*p == ' ' || *p == ','))
+            p++;
+        const char *equals = (const char *)memchr(p, '=', end - p);
+        if(equals == NULL)
+            return false;
+        const char *valueStart = equals + 1, *valueEnd, *next;
+        if(valueStart < end && *valueStart == '"'){
+            valueStart++;
+            valueEnd = (const char *)memchr(valueStart, '"', end - valueStart);
+            if(valueEnd == NULL)
+                valueEnd = end;
+            next = (const char *)memchr(valueEnd, ',', end - valueEnd);
+        } else {
+            valueEnd = (const char *)memchr(valueStart, ',', end - valueStart);
+            if(valueEnd == NULL)
+                valueEnd = end;
+            next = valueEnd;
+        }
+        if((size_t)(equals - p) == length && memcmp(p, name, length) == 0){
+            value.assign(valueStart, valueEnd - valueStart);
+            return true;
+        }
+        if(next == NULL)
+            return false;
+        p = next + 1;
+    }
+    return false;
+}
+
+// "length[@offset]"; offset is -1 when absent.
+static inline bool NexParseByteRange(const std::string &value, int64_t &length, int64_t &offset) {
+    char *at;
+    length = strtoll(value.c_str(), &at, 10);
+    offset = *at == '@' ? strtoll(at + 1, NULL, 10) : -1;
+    return length > 0;
+}
+
+static inline bool NexParseHexIV(const std::string &value, uint8_t iv[16]) {
+    const char *p = value.c_str();
+    if(p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+        p += 2;
+    size_t digits = strlen(p);
+    if(digits == 0 || digits > 32)
+        return false;
+    memset(iv, 0, 16);
+    // Right-aligned: shorter values are big-endian numbers.
+    for(size_t i = 0; i < digits; i++){
+        char c = p[digits - 1 - i];
+        int nibble = c >= '0' && c <= '9' ? c - '0' : (c | 0x20) >= 'a' && (c | 0x20) <= 'f' ? (c | 0x20) - 'a' + 10 : -1;
+        if(nibble < 0)
+            return false;
+        iv[15 - i / 2] |= (uint8_t)(i % 2 == 0 ? nibble : nibble << 4);
+    }
+    return true;
+}
+
+// The lines a segment is told apart by across reloads: EXTINF, BYTERANGE, PROGRAM-DATE-TIME
+// and the URI. Servers repeat them unchanged while the segment stays listed; parts come and go.
+typedef struct {
+    const char *line[4];
+    size_t length[4];
+} NexHlsSegmentLines;
+
+static inline uint64_t NexSegmentSignature(const NexHlsSegmentLines &lines) {
+    uint64_t hash = 14695981039346656037ull;
+    for(int i = 0; i < 4; i++){
+        if(lines.line[i] != NULL)
+            hash = NexValueHash(hash, lines.line[i], lines.length[i]);
+        hash = NexValueHash(hash, "\n", 1);
+    }
+    return hash;
+}
+
+// Tags that belong to the segment after them, where the header of a playlist ends.
+static inline bool NexHlsSegmentTag(const char *line, const char *lineEnd) {
+    static const char *const tags[] = { "#EXTINF:", "#EXT-X-BYTERANGE:", "#EXT-X-KEY:", "#EXT-X-MAP:", "#EXT-X-PROGRAM-DATE-TIME:",
+                                        "#EXT-X-DATERANGE:", "#EXT-X-GAP", "#EXT-X-PART:", "#EXT-X-PRELOAD-HINT:", "#EXT-X-SKIP:", "#EXT-X-BITRATE:" };
+    if(*line != '#' || (lineEnd - line == 20 && NexLineStarts(line, lineEnd, "#EXT-X-DISCONTINUITY")))
+        return true;
+    for(const char *tag : tags)
+        if(NexLineStarts(line, lineEnd, tag))
+            return true;
+    return false;
+}
+
+inline void NexMediaPlaylist::reset() {
+    url.clear();
+    mediaSequence = discontinuitySequence = 0;
+    targetDurationMs = partTargetMs = 0;
+    holdBackMs = holdBack = partHoldBack = -1;
+    endList = canBlockReload = independentSegments = false;
+    segments.clear();
+    parts.clear();
+    partBase = pendingPartStart = 0;
+    keys.clear();
+    maps.clear();
+    dateRanges.clear();
+    strings.clear();
+    parseUs = refreshUs = 0;
+    appendedSegments = 0;
+    endUs = nextRangeOffset = 0;
+    keyIndex = mapIndex = -1;
+    lastSignature = previousSignature = 0;
+    compactedSize = 0;
+}
+
+inline bool NexMediaPlaylist::parse(const char *data, size_t size, const char *playlistUrl, size_t window) {
+    int64_t startUs = NexMonotonicUs();
+    reset();
+    url = playlistUrl != NULL ? playlistUrl : "";
+    const char *p = data, *end = data + size;
+    if(size >= 3 && (uint8_t)p[0] == 0xEF && (uint8_t)p[1] == 0xBB && (uint8_t)p[2] == 0xBF)
+        p += 3;
+    if(!NexLineStarts(p, end, "#EXTM3U"))
+        return false;
+    parseLines(p, end, false);
+    appendedSegments = (uint32_t)segments.size();
+    trim(mediaSequence, window);
+    compactedSize = strings.size();
+    parseUs = NexMonotonicUs() - startUs;
+    return true;
+}
+
+// Parses from p on, continuing the segments already held. With header set it stops at the
+// first segment line and returns it.
+inline const char *NexMediaPlaylist::parseLines(const char *p, const char *end, bool header) {
+    std::string value;
+    int64_t durationUs = -1, rangeLength = 0, rangeOffset = -1, nextPartOffset = 0, programDateMs = -1;
+    uint32_t flags = 0, segmentPartStart = pendingPartStart, added = 0;
+    bool hasHint = false;
+    NexHlsPart hint = {};
+    NexHlsSegmentLines lines = {}, lastLines = {}, previousLines = {};
+    while(p < end){
+        const char *line = p, *lineEnd = NexLineEnd(p, end);
+        p = NexNextLine(p, end);
+        while(lineEnd > line && (lineEnd[-1] == ' ' || lineEnd[-1] == '\t'))
+            lineEnd--;
+        if(line == lineEnd)
+            continue;
+        if(header && NexHlsSegmentTag(line, lineEnd))
+            return line;
+        if(*line != '#'){
+            lines.line[3] = line;
+            lines.length[3] = lineEnd - line;
+            previousLines = lastLines;
+            lastLines = lines;
+            lines = NexHlsSegmentLines();
+            added++;
+            NexHlsSegment segment = {};
+            segment.startUs = endUs;
+            segment.durationUs = (int32_t)std::max<int64_t>(0, durationUs);
+            segment.uriOffset = addString(line, lineEnd - line);
+            segment.rangeStart = -1;
+            if(rangeLength > 0){
+                segment.rangeStart = rangeOffset >= 0 ? rangeOffset : nextRangeOffset;
+                segment.rangeLength = rangeLength;
+                nextRangeOffset = segment.rangeStart + rangeLength;
+            }
+            if(programDateMs >= 0)
+                segment.programDateMs = programDateMs;
+            else if(!segments.empty() && segments.back().programDateMs >= 0)
+                segment.programDateMs = segments.back().programDateMs + segments.back().durationUs / 1000;
+            else
+                segment.programDateMs = -1;
+            segment.keyIndex = keyIndex;
+            segment.mapIndex = mapIndex;
+            segment.flags = flags | (independentSegments ? NEXUNITY_SEGMENT_INDEPENDENT : 0);
+            segment.partStart = segmentPartStart;
+            segment.partCount = partEnd() - segmentPartStart;
+            segments.push_back(segment);
+            endUs += segment.durationUs;
+            segmentPartStart = partEnd();
+            durationUs = -1;
+            rangeLength = 0;
+            rangeOffset = -1;
+            programDateMs = -1;
+            flags = 0;
+            nextPartOffset = 0;
+            continue;
+        }
+
+        if(NexLineStarts(line, lineEnd, "#EXTINF:")){
+            durationUs = (int64_t)(NexParseNumber(line + 8, lineEnd) * 1000000.0 + 0.5);
+            lines.line[0] = line;
+            lines.length[0] = lineEnd - line;
+        } else if(NexLineStarts(line, lineEnd, "#EXT-X-PART:")){
+            const char *list = line + 12;
+            NexHlsPart part = {};
+            part.rangeStart = -1;
+            if(NexHlsAttribute(list, lineEnd, "DURATION", value))
+                part.durationUs = (int32_t)(atof(value.c_str()) * 1000000.0 + 0.5);
+            if(NexHlsAttribute(list, lineEnd, "URI", value))
+                part.uriOffset = addString(value);
+            else
+                part.uriOffset = -1;
+            if(NexHlsAttribute(list, lineEnd, "BYTERANGE", value) && NexParseByteRange(value, part.rangeLength, part.rangeStart)){
+                if(part.rangeStart < 0)
+                    part.rangeStart = nextPartOffset;
+                nextPartOffset = part.rangeStart + part.rangeLength;
+            }
+            if(NexHlsAttribute(list, lineEnd, "INDEPENDENT", value) && value == "YES")
+                part.flags |= NEXUNITY_SEGMENT_INDEPENDENT;
+            if(NexHlsAttribute(list, lineEnd, "GAP", value) && value == "YES")
+                part.flags |= NEXUNITY_SEGMENT_GAP;
+            parts.push_back(part);
+        } else if(NexLineStarts(line, lineEnd, "#EXT-X-PROGRAM-DATE-TIME:")){
+            value.assign(line + 25, lineEnd - line - 25);
+            if(!NexParseIsoDate(value, programDateMs))
+                programDateMs = -1;
+            lines.line[2] = line;
+            lines.length[2] = lineEnd - line;
+        } else if(NexLineStarts(line, lineEnd, "#EXT-X-BYTERANGE:")){
+            value.assign(line + 17, lineEnd - line - 17);
+            NexParseByteRange(value, rangeLength, rangeOffset);
+            lines.line[1] = line;
+            lines.length[1] = lineEnd - line;
+        } else if(NexLineStarts(line, lineEnd, "#EXT-X-KEY:")){
+            const char *list = line + 11;
+            NexKeyRecord key = {};
+            key.uriOffset = key.keyFormatOffset = -1;
+            if(NexHlsAttribute(list, lineEnd, "METHOD", value)){
+                if(value == "AES-128") key.method = NEXUNITY_KEY_AES_128;
+                else if(value == "SAMPLE-AES") key.method = NEXUNITY_KEY_SAMPLE_AES;
+                else if(value == "SAMPLE-AES-CTR") key.method = NEXUNITY_KEY_SAMPLE_AES_CTR;
+            }
+            if(key.method == NEXUNITY_KEY_NONE){
+                keyIndex = -1;
+                continue;
+            }
+            if(NexHlsAttribute(list, lineEnd, "URI", value))
+                key.uriOffset = addString(value);
+            if(NexHlsAttribute(list, lineEnd, "KEYFORMAT", value))
+                key.keyFormatOffset = addString(value);
+            if(NexHlsAttribute(list, lineEnd, "IV", value))
+                key.hasIV = NexParseHexIV(value, key.iv);
+            keys.push_back(key);
+            keyIndex = (int32_t)keys.size() - 1;
+        } else if(NexLineStarts(line, lineEnd, "#EXT-X-MAP:")){
+            NexHlsMap map = { -1, 0, -1, 0 };
+            if(NexHlsAttribute(line + 11, lineEnd, "URI", value))
+                map.uriOffset = addString(value);
+            if(NexHlsAttribute(line + 11, lineEnd, "BYTERANGE", value) && NexParseByteRange(value, map.rangeLength, map.rangeStart) && map.rangeStart < 0)
+                map.rangeStart = 0;
+            maps.push_back(map);
+            mapIndex = (int32_t)maps.size() - 1;
+        } else if(lineEnd - line == 20 && NexLineStarts(line, lineEnd, "#EXT-X-DISCONTINUITY")){
+            flags |= NEXUNITY_SEGMENT_DISCONTINUITY;
+        } else if(lineEnd - line == 10 && NexLineStarts(line, lineEnd, "#EXT-X-GAP")){
+            flags |= NEXUNITY_SEGMENT_GAP;
+        } else if(NexLineStarts(line, lineEnd, "#EXT-X-DATERANGE:")){
+            const char *list = line + 17;
+            if(!NexHlsAttribute(list, lineEnd, "ID", value) || value.empty())
+                continue;
+            // A later tag with the same ID completes the earlier one (END-DATE, DURATION).
+            NexDateRangeRecord *range = NULL;
+            for(NexDateRangeRecord &existing : dateRanges)
+                if(strcmp(value.c_str(), string(existing.idOffset)) == 0)
+                    range = &existing;
+            if(range == NULL){
+                NexDateRangeRecord added = { addString(value), -1, -1, 0, -1, -1, -1, -1 };
+                dateRanges.push_back(added);
+                range = &dateRanges.back();
+            }
+            // Attributes accumulate so client X- attributes from the opening tag survive the update.
+            if(range->attributesOffset >= 0){
+                std::string merged = string(range->attributesOffset);
+                merged.push_back(',');
+                merged.append(list, lineEnd - list);
+                range->attributesOffset = addString(merged);
+            } else {
+                range->attributesOffset = addString(list, lineEnd - list);
+            }
+            int64_t ms;
+            if(NexHlsAttribute(list, lineEnd, "CLASS", value))
+                range->classOffset = addString(value);
+            if(NexHlsAttribute(list, lineEnd, "START-DATE", value) && NexParseIsoDate(value, ms))
+                range->startDateMs = ms;
+            if(NexHlsAttribute(list, lineEnd, "END-DATE", value) && NexParseIsoDate(value, ms))
+                range->endDateMs = ms;
+            if(NexHlsAttribute(list, lineEnd, "DURATION", value))
+                range->durationMs = (int64_t)(atof(value.c_str()) * 1000.0 + 0.5);
+            if(NexHlsAttribute(list, lineEnd, "PLANNED-DURATION", value))
+                range->plannedDurationMs = (int64_t)(atof(value.c_str()) * 1000.0 + 0.5);
+            if(NexHlsAttribute(list, lineEnd, "END-ON-NEXT", value))
+                range->endOnNext = value == "YES";
+        } else if(NexLineStarts(line, lineEnd, "#EXT-X-PRELOAD-HINT:")){
+            const char *list = line + 20;
+            if(!NexHlsAttribute(list, lineEnd, "TYPE", value) || value != "PART")
+                continue;
+            hint = NexHlsPart();
+            hint.flags = NEXUNITY_SEGMENT_PRELOAD_HINT;
+            hint.uriOffset = NexHlsAttribute(list, lineEnd, "URI", value) ? addString(value) : -1;
+            hint.rangeStart = -1;
+            if(NexHlsAttribute(list, lineEnd, "BYTERANGE-START", value))
+                hint.rangeStart = strtoll(value.c_str(), NULL, 10);
+            if(NexHlsAttribute(list, lineEnd, "BYTERANGE-LENGTH", value)){
+                hint.rangeLength = strtoll(value.c_str(), NULL, 10);
+                if(hint.rangeStart < 0)
+                    hint.rangeStart = 0;
+            }
+            hasHint = true;
+        } else if(NexLineStarts(line, lineEnd, "#EXT-X-MEDIA-SEQUENCE:")){
+            mediaSequence = (uint64_t)NexParseNumber(line + 22, lineEnd);
+        } else if(NexLineStarts(line, lineEnd, "#EXT-X-DISCONTINUITY-SEQUENCE:")){
+            discontinuitySequence = (uint64_t)NexParseNumber(line + 30, lineEnd);
+        } else if(NexLineStarts(line, lineEnd, "#EXT-X-TARGETDURATION:")){
+            targetDurationMs = (int64_t)(NexParseNumber(line + 22, lineEnd) * 1000.0);
+        } else if(NexLineStarts(line, lineEnd, "#EXT-X-PART-INF:")){
+            if(NexHlsAttribute(line + 16, lineEnd, "PART-TARGET", value))
+                partTargetMs = (int64_t)(atof(value.c_str()) * 1000.0 + 0.5);
+        } else if(NexLineStarts(line, lineEnd, "#EXT-X-SERVER-CONTROL:")){
+            const char *list = line + 22;
+            if(NexHlsAttribute(list, lineEnd, "CAN-BLOCK-RELOAD", value))
+                canBlockReload = value == "YES";
+            if(NexHlsAttribute(list, lineEnd, "HOLD-BACK", value))
+                holdBack = (int64_t)(atof(value.c_str()) * 1000.0 + 0.5);
+            if(NexHlsAttribute(list, lineEnd, "PART-HOLD-BACK", value))
+                partHoldBack = (int64_t)(atof(value.c_str()) * 1000.0 + 0.5);
+        } else if(NexLineStarts(line, lineEnd, "#EXT-X-ENDLIST")){
+            endList = true;
+        } else if(NexLineStarts(line, lineEnd, "#EXT-X-INDEPENDENT-SEGMENTS")){
+            independentSegments = true;
+        }
+    }
+    if(header)
+        return end;
+    pendingPartStart = segmentPartStart;
+    if(hasHint)
+        parts.push_back(hint);
+    holdBackMs = partTargetMs > 0 && partHoldBack >= 0 ? partHoldBack : holdBack;
+    if(added > 0){
+        previousSignature = added > 1 ? NexSegmentSignature(previousLines) : lastSignature;
+        lastSignature = NexSegmentSignature(lastLines);
+    }
+    return end;
+}
+
+// End of the URI line of the last segment held, found by signature going back from the end of
+// the playlist; newer counts the segments listed after it. NULL when it is no longer listed.
+inline const char *NexMediaPlaylist::findTail(const char *begin, const char *end, uint32_t &newer) const {
+    NexHlsSegmentLines lines = {};
+    const char *uriEnd = NULL;
+    newer = 0;
+    for(const char *lineEnd = end; ; lineEnd--){
+        const char *line = lineEnd;
+        while(line > begin && line[-1] != '\n' && line[-1] != '\r')
+            line--;
+        const char *trimmed = lineEnd;
+        while(trimmed > line && (trimmed[-1] == ' ' || trimmed[-1] == '\t'))
+            trimmed--;
+        if(trimmed > line && *line != '#'){
+            if(uriEnd != NULL){
+                if(NexSegmentSignature(lines) == lastSignature)
+                    return uriEnd;
+                newer++;
+            }
+            lines = NexHlsSegmentLines();
+            lines.line[3] = line;
+            lines.length[3] = trimmed - line;
+            uriEnd = trimmed;
+        } else if(trimmed > line && uriEnd != NULL){
+            // Closest to the URI wins, as it does going forward.
+            int slot = NexLineStarts(line, trimmed, "#EXTINF:") ? 0 : NexLineStarts(line, trimmed, "#EXT-X-BYTERANGE:") ? 1 :
+                       NexLineStarts(line, trimmed, "#EXT-X-PROGRAM-DATE-TIME:") ? 2 : -1;
+            if(slot >= 0 && lines.line[slot] == NULL){
+                lines.line[slot] = line;
+                lines.length[slot] = trimmed - line;
+            }
+        }
+        if(line == begin)
+            break;
+        lineEnd = line;
+    }
+    return uriEnd != NULL && NexSegmentSignature(lines) == lastSignature ? uriEnd : NULL;
+}
+
+// How many of the held segments up to the one whose URI ends at uriEnd still list their
+// LL-HLS parts. Servers remove EXT-X-PART lines from the oldest segments first, so this goes
+// back only as far as the held segments with parts.
+inline uint32_t NexMediaPlaylist::listedParts(const char *begin, const char *uriEnd) const {
+    uint32_t parted = 0;
+    for(auto segment = segments.rbegin(); segment != segments.rend() && segment->partCount > 0; ++segment)
+        parted++;
+    uint32_t listed = 0;
+    bool hasPart = false;
+    const char *lineEnd = uriEnd;
+    while(lineEnd > begin && lineEnd[-1] != '\n' && lineEnd[-1] != '\r')
+        lineEnd--;
+    while(listed < parted && lineEnd > begin){
+        while(lineEnd > begin && (lineEnd[-1] == '\n' || lineEnd[-1] == '\r'))
+            lineEnd--;
+        const char *line = lineEnd;
+        while(line > begin && line[-1] != '\n' && line[-1] != '\r')
+            line--;
+        if(NexLineStarts(line, lineEnd, "#EXT-X-PART:")){
+            hasPart = true;
+        } else if(line < lineEnd && *line != '#' && *line != ' ' && *line != '\t'){
+            // The URI of the segment before: the one above is complete.
+            if(!hasPart)
+                return listed;
+            listed++;
+            hasPart = false;
+        }
+        lineEnd = line;
+    }
+    return std::min(parted, listed + (hasPart ? 1u : 0u));
+}
+
+// Forgets the parts of held segments other than the last `listed` that have them.
+inline void NexMediaPlaylist::dropUnlistedParts(uint32_t listed) {
+    uint32_t keep = pendingPartStart;
+    size_t position = segments.size();
+    for(uint32_t i = 0; i < listed && position > 0; i++)
+        keep = segments[--position].partStart;
+    for(; position > 0 && segments[position - 1].partCount > 0; position--)
+        segments[position - 1].partCount = 0;
+    size_t stale = std::min<size_t>(keep > partBase ? keep - partBase : 0, parts.size());
+    parts.erase(parts.begin(), parts.begin() + stale);
+    partBase += (uint32_t)stale;
+}
+
+// Drops the segments before the listed media sequence, then any beyond the window.
+inline void NexMediaPlaylist::trim(uint64_t listed, size_t window) {
+    size_t drop = (size_t)std::min<uint64_t>(listed > mediaSequence ? listed - mediaSequence : 0, segments.size());
+    if(window > 0 && segments.size() - drop > window)
+        drop = segments.size() - window;
+    segments.erase(segments.begin(), segments.begin() + drop);
+    mediaSequence += drop;
+    uint32_t keep = segments.empty() ? pendingPartStart : segments.front().partStart;
+    size_t stale = std::min<size_t>(keep > partBase ? keep - partBase : 0, parts.size());
+    parts.erase(parts.begin(), parts.begin() + stale);
+    partBase += (uint32_t)stale;
+}
+
+// Rebuilds the string pool, keys and maps from what the window still uses and drops date ranges
+// that ended before it. Runs once the pool has doubled, so its cost spreads over the refreshes.
+inline void NexMediaPlaylist::compact() {
+    std::vector<char> kept;
+    kept.reserve(compactedSize);
+    auto keep = [&](int32_t &offset) {
+        if(offset < 0)
+            return;
+        const char *value = &strings[offset];
+        offset = (int32_t)kept.size();
+        kept.insert(kept.end(), value, value + strlen(value) + 1);
+    };
+    std::vector<int32_t> keyRemap(keys.size(), -1), mapRemap(maps.size(), -1);
+    std::vector<NexKeyRecord> keptKeys;
+    std::vector<NexHlsMap> keptMaps;
+    auto keepKey = [&](int32_t &index) {
+        if(index < 0)
+            return;
+        if(keyRemap[index] < 0){
+            NexKeyRecord key = keys[index];
+            keep(key.uriOffset);
+            keep(key.keyFormatOffset);
+            keyRemap[index] = (int32_t)keptKeys.size();
+            keptKeys.push_back(key);
+        }
+        index = keyRemap[index];
+    };
+    auto keepMap = [&](int32_t &index) {
+        if(index < 0)
+            return;
+        if(mapRemap[index] < 0){
+            NexHlsMap map = maps[index];
+            keep(map.uriOffset);
+            mapRemap[index] = (int32_t)keptMaps.size();
+            keptMaps.push_back(map);
+        }
+        index = mapRemap[index];
+    };
+    for(NexHlsSegment &segment : segments){
+        keep(segment.uriOffset);
+        keepKey(segment.keyIndex);
+        keepMap(segment.mapIndex);
+    }
+    for(NexHlsPart &part : parts)
+        keep(part.uriOffset);
+    keepKey(keyIndex);
+    keepMap(mapIndex);
+    int64_t windowStartMs = segments.empty() ? -1 : segments.front().programDateMs;
+    std::vector<NexDateRangeRecord> keptRanges;
+    for(NexDateRangeRecord range : dateRanges){
+        int64_t endMs = range.endDateMs >= 0 ? range.endDateMs : range.startDateMs >= 0 && range.durationMs >= 0 ? range.startDateMs + range.durationMs : -1;
+        if(windowStartMs >= 0 && endMs >= 0 && endMs < windowStartMs)
+            continue;
+        keep(range.idOffset);
+        keep(range.classOffset);
+        keep(range.attributesOffset);
+        keptRanges.push_back(range);
+    }
+    strings.swap(kept);
+    keys.swap(keptKeys);
+    maps.swap(keptMaps);
+    dateRanges.swap(keptRanges);
+    compactedSize = strings.size();
+}
+
+// Reload of a live playlist: the header is read again, only the lines after the last segment
+// held are parsed, and the front is trimmed to the listed media sequence and the window. When
+// the last segment cannot be found (it left the playlist, or its lines repeat so it cannot be
+// told apart) the playlist is parsed in full and shifted onto the held timeline.
+inline bool NexMediaPlaylist::refresh(const char *data, size_t size, size_t window) {
+    int64_t startUs = NexMonotonicUs();
+    const char *p = data, *end = data + size;
+    if(size >= 3 && (uint8_t)p[0] == 0xEF && (uint8_t)p[1] == 0xBB && (uint8_t)p[2] == 0xBF)
+        p += 3;
+    if(!NexLineStarts(p, end, "#EXTM3U"))
+        return false;
+    uint64_t front = mediaSequence, held = segments.size();
+    const char *tail = NULL;
+    uint32_t newer = 0;
+    if(!endList && held > 0 && lastSignature != previousSignature)
+        tail = findTail(parseLines(p, end, true), end, newer);
+    uint64_t listed = mediaSequence;
+    mediaSequence = front;
+    if(tail == NULL || listed >= front + held){
+        NexMediaPlaylist fresh;
+        if(!fresh.parse(data, size, url.c_str(), window))
+            return false;
+        if(held > 0 && !fresh.segments.empty() && fresh.mediaSequence >= front && fresh.mediaSequence < front + held){
+            int64_t shiftUs = segments[fresh.mediaSequence - front].startUs - fresh.segments.front().startUs;
+            for(NexHlsSegment &segment : fresh.segments)
+                segment.startUs += shiftUs;
+            fresh.endUs += shiftUs;
+        }
+        *this = std::move(fresh);
+        return true;
+    }
+    dropUnlistedParts(listedParts(data, tail));
+    // The pending parts and preload hint of the last reload are listed again after the tail.
+    parts.erase(parts.begin() + (pendingPartStart - partBase), parts.end());
+    parseLines(tail, end, false);
+    appendedSegments = newer;
+    trim(listed, window);
+    if(strings.size() > 2 * compactedSize + 65536)
+        compact();
+    refreshUs = NexMonotonicUs() - startUs;
+    return true;
+}
+
+inline bool NexManifestIndex::parseHLSMaster(const char *p, const char *end, const std::string &url) {
+    std::string value;
+    NexManifestPeriod period = { 0, -1 };
+    periods.push_back(period);
+    NexManifestRendition variant = NexEmptyRendition();
+    bool variantPending = false;
+    while(p < end){
+        const char *line = p, *lineEnd = NexLineEnd(p, end);
+        p = NexNextLine(p, end);
+        while(lineEnd > line && (lineEnd[-1] == ' ' || lineEnd[-1] == '\t'))
+            lineEnd--;
+        if(line == lineEnd)
+            continue;
+        if(*line != '#'){
+            if(variantPending){
+                variant.record.uriOffset = intern(NexResolveUrl(url, std::string(line, lineEnd - line)));
+                renditions.push_back(variant);
+                variantPending = false;
+            }
+            continue;
+        }
+        if(NexLineStarts(line, lineEnd, "#EXT-X-STREAM-INF:")){
+            const char *list = line + 18;
+            variant = NexEmptyRendition();
+            NexRenditionRecord &record = variant.record;
+            record.kind = NEXUNITY_STREAM_VIDEO_TRACK;
+            record.timescale = 1000000;
+            if(NexHlsAttribute(list, lineEnd, "BANDWIDTH", value))
+                record.bandwidth = atoi(value.c_str());
+            if(NexHlsAttribute(list, lineEnd, "RESOLUTION", value))
+                sscanf(value.c_str(), "%dx%d", &record.width, &record.height);
+            if(NexHlsAttribute(list, lineEnd, "FRAME-RATE", value))
+                record.frameRateMilli = NexParseFrameRate(value);
+            if(NexHlsAttribute(list, lineEnd, "CODECS", value)){
+                record.codecsOffset = intern(value);
+                // Audio-only variants list no video codec.
+                if(record.width == 0 && value.find("avc") == std::string::npos && value.find("hvc") == std::string::npos &&
+                   value.find("hev") == std::string::npos && value.find("av01") == std::string::npos && value.find("vp09") == std::string::npos)
+                    record.kind = NEXUNITY_STREAM_AUDIO;
+            }
+            if(NexHlsAttribute(list, lineEnd, "AUDIO", value))
+                record.groupOffset = intern(value);
+            variantPending = true;
+        } else if(NexLineStarts(line, lineEnd, "#EXT-X-MEDIA:")){
+            const char *list = line + 13;
+            if(!NexHlsAttribute(list, lineEnd, "TYPE", value) || value == "CLOSED-CAPTIONS")
+                continue;
+            NexManifestRendition media = NexEmptyRendition();
+            NexRenditionRecord &record = media.record;
+            record.kind = value == "AUDIO" ? NEXUNITY_STREAM_AUDIO : value == "VIDEO" ? NEXUNITY_STREAM_VIDEO_TRACK : NEXUNITY_STREAM_TEXT;
+            record.timescale = 1000000;
+            if(NexHlsAttribute(list, lineEnd, "NAME", value))
+                record.idOffset = intern(value);
+            if(NexHlsAttribute(list, lineEnd, "LANGUAGE", value))
+                record.languageOffset = intern(value);
+            if(NexHlsAttribute(list, lineEnd, "GROUP-ID", value))
+                record.groupOffset = intern(value);
+            // Without a URI the rendition is carried in the variant streams.
+            if(NexHlsAttribute(list, lineEnd, "URI", value))
+                record.uriOffset = intern(NexResolveUrl(url, value));
+            renditions.push_back(media);
+        }
+    }
+    playlists.resize(renditions.size());
+    return !renditions.empty();
+}
+
+inline void NexManifestIndex::attachPlaylist(size_t index, std::unique_ptr<NexMediaPlaylist> media) {
+    playlists[index] = std::move(media);
+    spares.resize(playlists.size());
+    spares[index].reset();
+    updateRendition(index);
+}
+
+// Incremental reload of a rendition's live media playlist (see refreshable), in place. For an
+// index readers share, stage and publish instead.
+inline bool NexManifestIndex::refreshPlaylist(size_t index, const char *data, size_t size) {
+    std::unique_ptr<NexMediaPlaylist> staged = stagePlaylist(index, data, size);
+    if(staged == nullptr)
+        return false;
+    publishPlaylist(index, std::move(staged));
+    return true;
+}
+
+// Reload of a rendition's live media playlist built without touching what readers see: the
+// spare, the playlist published before the current one, is brought forward with refresh, which
+// parses only past the last segment it holds, so it costs one reload more than an in-place
+// update. The first reload copies the current playlist. Loads of one index must be serialised;
+// readers may keep using it meanwhile. NULL when the playlist does not parse.
+inline std::unique_ptr<NexMediaPlaylist> NexManifestIndex::stagePlaylist(size_t index, const char *data, size_t size) {
+    spares.resize(playlists.size());
+    std::unique_ptr<NexMediaPlaylist> staged = std::move(spares[index]);
+    if(staged == nullptr)
+        staged.reset(new NexMediaPlaylist(*playlists[index]));
+    if(!staged->refresh(data, size, window)){
+        spares[index] = std::move(staged);
+        return nullptr;
+    }
+    return staged;
+}
+
+// Swaps a staged playlist in; the one it replaces becomes the next spare. Callers hold the
+// readers' lock.
+inline void NexManifestIndex::publishPlaylist(size_t index, std::unique_ptr<NexMediaPlaylist> staged) {
+    const NexMediaPlaylist *held = playlists[index].get();
+    staged->appendedSegments = (uint32_t)(staged->sequenceEnd() > held->sequenceEnd() ? staged->sequenceEnd() - held->sequenceEnd() : 0);
+    spares.resize(playlists.size());
+    spares[index] = std::move(playlists[index]);
+    playlists[index] = std::move(staged);
+    updateRendition(index);
+}
+
+inline void NexManifestIndex::updateRendition(size_t index) {
+    const NexMediaPlaylist *media = playlists[index].get();
+    NexRenditionRecord &record = renditions[index].record;
+    record.segmentCount = (uint32_t)media->segments.size();
+    record.firstNumber = media->mediaSequence;
+    record.timescale = 1000000;
+    record.startMs = media->segments.empty() ? 0 : media->segments.front().startUs / 1000;
+    record.durationMs = media->durationUs() / 1000;
+    record.targetDurationMs = (int32_t)media->targetDurationMs;
+    record.partTargetMs = (int32_t)media->partTargetMs;
+    record.holdBackMs = (int32_t)media->holdBackMs;
+    record.pendingPartCount = (int32_t)(media->partEnd() - media->pendingPartStart);
+    record.dateRangeCount = (int32_t)media->dateRanges.size();
+    if(!media->endList)
+        live = true;
+    else if(!live)
+        durationMs = std::max(durationMs, record.durationMs);
+    refreshUs = media->refreshUs;
+}
+
+// LL-HLS part of a segment; position == segmentCount addresses the segment still being produced.
+inline bool NexManifestIndex::part(size_t index, uint32_t position, uint32_t partIndex, NexSegmentRecord &segment, std::string *url) const {
+    const NexMediaPlaylist *media = playlist(index);
+    if(media == NULL || position > media->segments.size())
+        return false;
+    uint32_t first, count;
+    int64_t timeUs;
+    int32_t keyIndex;
+    if(position < media->segments.size()){
+        const NexHlsSegment &parent = media->segments[position];
+        first = parent.partStart;
+        count = parent.partCount;
+        timeUs = parent.startUs;
+        keyIndex = parent.keyIndex;
+    } else {
+        first = media->pendingPartStart;
+        count = media->partEnd() - first;
+        timeUs = media->segments.empty() ? 0 : media->segments.back().startUs + media->segments.back().durationUs;
+        keyIndex = media->segments.empty() ? -1 : media->segments.back().keyIndex;
+    }
+    // Parts of the oldest segments may have left with the window's front.
+    if(partIndex >= count || first < media->partBase)
+        return false;
+    first -= media->partBase;
+    for(uint32_t i = 0; i < partIndex; i++)
+        timeUs += media->parts[first + i].durationUs;
+    const NexHlsPart &part = media->parts[first + partIndex];
+    segment.number = media->mediaSequence + position;
+    segment.time = (uint64_t)timeUs;
+    segment.startMs = timeUs / 1000;
+    segment.durationMs = part.durationUs / 1000;
+    segment.rangeStart = part.rangeStart;
+    segment.rangeLength = part.rangeLength;
+    segment.programDateMs = -1;
+    segment.flags = part.flags;
+    segment.keyIndex = keyIndex;
+    segment.partCount = 0;
+    segment.reserved = 0;
+    if(url != NULL){
+        const char *uri = media->string(part.uriOffset);
+        if(uri == NULL)
+            return false;
+        *url = NexResolveUrl(media->url, uri);
+    }
+    return true;
+}
+
+inline void NexManifestIndex::addDashRendition(const NexDashLevel &level) {
+    NexManifestRendition rendition = NexEmptyRendition();
+    NexRenditionRecord &record = rendition.record;
+    record.period = (int32_t)periods.size() - 1;
+    record.kind = NexDashKind(level);
+    record.bandwidth = level.bandwidth;
+    record.width = level.width;
+    record.height = level.height;
+    record.frameRateMilli = level.frameRateMilli;
+    record.idOffset = intern(level.id);
+    record.codecsOffset = intern(level.codecs);
+    record.languageOffset = intern(level.language);
+    record.timescale = level.timescale;
+    if(level.indexed && !level.media.empty() && (level.duration > 0 || level.runStart >= 0)){
+        rendition.mediaOffset = intern(NexResolveUrl(level.base, level.media));
+        if(!level.init.empty())
+            rendition.initOffset = intern(NexResolveUrl(level.base, level.init));
+        rendition.duration = level.runStart >= 0 ? 0 : level.duration;
+        rendition.startNumber = level.runStart >= 0 ? level.timelineNumber : level.startNumber;
+        rendition.presentationTimeOffset = level.presentationTimeOffset;
+        rendition.runStart = level.runStart;
+        rendition.runCount = level.runCount;
+    }
+    renditions.push_back(rendition);
+}
+
+// Period bounds, open runs and per-rendition ranges; needs the whole MPD.
+inline void NexManifestIndex::finishDASH(int64_t nowMs) {
+    for(size_t i = 0; i < periods.size(); i++){
+        NexManifestPeriod &period = periods[i];
+        if(period.startMs < 0)
+            period.startMs = i == 0 ? 0 : (periods[i - 1].durationMs >= 0 ? periods[i - 1].startMs + periods[i - 1].durationMs : periods[i - 1].startMs);
+    }
+    for(size_t i = 0; i < periods.size(); i++){
+        NexManifestPeriod &period = periods[i];
+        if(period.durationMs >= 0)
+            continue;
+        if(i + 1 < periods.size() && periods[i + 1].startMs >= period.startMs)
+            period.durationMs = periods[i + 1].startMs - period.startMs;
+        else if(i + 1 == periods.size() && durationMs >= 0)
+            period.durationMs = std::max<int64_t>(0, durationMs - period.startMs);
+    }
+    if(durationMs < 0 && !live)
+        durationMs = periods.back().durationMs >= 0 ? periods.back().startMs + periods.back().durationMs : -1;
+    // How far into a live period segments are available.
+    auto liveEdgeMs = [&](const NexManifestPeriod &period) -> int64_t {
+        return availabilityStartMs >= 0 ? nowMs - availabilityStartMs - period.startMs : -1;
+    };
+
+    int64_t resolvedRun = -1;   // timelines are shared, resolve each once
+    for(NexManifestRendition &rendition : renditions){
+        NexRenditionRecord &record = rendition.record;
+        const NexManifestPeriod &period = periods[record.period];
+        uint64_t timescale = record.timescale;
+        if(rendition.runStart >= 0 && rendition.runCount > 0){
+            NexSegmentRun *first = &runs[rendition.runStart], *last = first + rendition.runCount;
+            if(rendition.runStart > resolvedRun){
+                int64_t periodEndMs = period.durationMs >= 0 ? period.durationMs : liveEdgeMs(period);
+                uint64_t segments = 0;
+                for(NexSegmentRun *run = first; run < last; run++){
+                    if(run->count == SEGMENT_RUN_OPEN){
+                        // Up to the next S or the period end; at a live edge only complete segments.
+                        bool atEdge = run + 1 == last && period.durationMs < 0;
+                        uint64_t limit = 0;
+                        if(run + 1 < last)
+                            limit = run[1].time;
+                        else if(periodEndMs >= 0)
+                            limit = rendition.presentationTimeOffset + (uint64_t)periodEndMs * timescale / 1000;
+                        uint64_t span = limit > run->time ? limit - run->time : 0;
+                        run->count = (uint32_t)(atEdge ? span / run->duration : (span + run->duration - 1) / run->duration);
+                    }
+                    run->first = (uint32_t)segments;
+                    segments += run->count;
+                }
+                resolvedRun = rendition.runStart;
+            }
+            const NexSegmentRun &back = last[-1];
+            record.segmentCount = back.first + back.count;
+            record.firstNumber = rendition.startNumber;
+            int64_t startTime = (int64_t)(first->time - rendition.presentationTimeOffset);
+            record.startMs = period.startMs + startTime * 1000 / (int64_t)timescale;
+            record.durationMs = (int64_t)((back.time + back.duration * back.count - first->time) * 1000 / timescale);
+        } else if(rendition.duration > 0){
+            uint64_t unitMs = rendition.duration * 1000;
+            uint64_t firstIndex = 0, endIndex = 0;
+            if(period.durationMs >= 0)
+                endIndex = ((uint64_t)period.durationMs * timescale + unitMs - 1) / unitMs;
+            if(live){
+                // Complete segments up to the live edge, within the time-shift window.
+                int64_t edgeMs = liveEdgeMs(period);
+                uint64_t available = edgeMs > 0 ? (uint64_t)edgeMs * timescale / unitMs : 0;
+                endIndex = period.durationMs >= 0 ? std::min(endIndex, available) : available;
+                if(timeShiftBufferMs >= 0 && edgeMs > timeShiftBufferMs)
+                    firstIndex = (uint64_t)(edgeMs - timeShiftBufferMs) * timescale / unitMs;
+                firstIndex = std::min(firstIndex, endIndex);
+            }
+            record.segmentCount = (uint32_t)std::min<uint64_t>(endIndex - firstIndex, UINT32_MAX);
+            record.firstNumber = rendition.startNumber + firstIndex;
+            record.startMs = period.startMs + (int64_t)(firstIndex * unitMs / timescale);
+            record.durationMs = (int64_t)(record.segmentCount * unitMs / timescale);
+        } else {
+            record.startMs = period.startMs;
+            record.durationMs = std::max<int64_t>(0, period.durationMs);
+        }
+        // The last segment is usually cut short by the period end.
+        if(period.durationMs >= 0)
+            record.durationMs = std::max<int64_t>(0, std::min(record.durationMs, period.startMs + period.durationMs - record.startMs));
+    }
+}
+
+inline bool NexManifestIndex::segment(size_t index, uint32_t position, NexSegmentRecord &segment) const {
+    if(index >= renditions.size() || position >= renditions[index].record.segmentCount)
+        return false;
+    segment.programDateMs = -1;
+    segment.flags = 0;
+    segment.keyIndex = -1;
+    segment.partCount = 0;
+    segment.reserved = 0;
+    if(type == NEXUNITY_MANIFEST_HLS){
+        const NexMediaPlaylist *media = playlist(index);
+        if(media == NULL)
+            return false;
+        const NexHlsSegment &entry = media->segments[position];
+        segment.number = media->mediaSequence + position;
+        segment.time = (uint64_t)entry.startUs;
+        segment.startMs = entry.startUs / 1000;
+        segment.durationMs = entry.durationUs / 1000;
+        segment.rangeStart = entry.rangeStart;
+        segment.rangeLength = entry.rangeLength;
+        segment.programDateMs = entry.programDateMs;
+        segment.flags = entry.flags;
+        segment.keyIndex = entry.keyIndex;
+        segment.partCount = (int32_t)entry.partCount;
+        return true;
+    }
+    const NexManifestRendition &rendition = renditions[index];
+    uint64_t time, duration;
+    if(rendition.runStart >= 0){
+        const NexSegmentRun *first = &runs[rendition.runStart], *last = first + rendition.runCount;
+        const NexSegmentRun *run = std::upper_bound(first, last, position, [](uint32_t value, const NexSegmentRun &run) { return value < run.first; }) - 1;
+        time = run->time + (position - run->first) * run->duration;
+        duration = run->duration;
+    } else {
+        time = rendition.presentationTimeOffset + (rendition.record.firstNumber - rendition.startNumber + position) * rendition.duration;
+        duration = rendition.duration;
+    }
+    int64_t timescale = rendition.record.timescale;
+    const NexManifestPeriod &period = periods[rendition.record.period];
+    segment.number = rendition.record.firstNumber + position;
+    segment.time = time;
+    segment.startMs = period.startMs + (int64_t)(time - rendition.presentationTimeOffset) * 1000 / timescale;
+    segment.durationMs = (int64_t)duration * 1000 / timescale;
+    if(period.durationMs >= 0)
+        segment.durationMs = std::max<int64_t>(0, std::min(segment.durationMs, period.startMs + period.durationMs - segment.startMs));
+    segment.rangeStart = -1;
+    segment.rangeLength = 0;
+    return true;
+}
+
+// Position of the segment holding ms, -1 outside the rendition's range.
+inline int64_t NexManifestIndex::findSegment(size_t index, int64_t ms) const {
+    if(index >= renditions.size())
+        return -1;
+    const NexManifestRendition &rendition = renditions[index];
+    const NexRenditionRecord &record = rendition.record;
+    if(record.segmentCount == 0 || ms < record.startMs || ms >= record.startMs + record.durationMs)
+        return -1;
+    if(type == NEXUNITY_MANIFEST_HLS){
+        const std::deque<NexHlsSegment> &segments = playlist(index)->segments;
+        auto found = std::upper_bound(segments.begin(), segments.end(), ms * 1000, [](int64_t us, const NexHlsSegment &segment) { return us < segment.startUs; });
+        return std::max<int64_t>(0, found - segments.begin() - 1);
+    }
+    // Last tick within the millisecond, so the truncated startMs of a segment maps back to it.
+    int64_t time = ((ms - periods[record.period].startMs + 1) * (int64_t)record.timescale - 1) / 1000 + (int64_t)rendition.presentationTimeOffset;
+    if(rendition.runStart >= 0){
+        const NexSegmentRun *first = &runs[rendition.runStart], *last = first + rendition.runCount;
+        const NexSegmentRun *run = std::upper_bound(first, last, (uint64_t)std::max<int64_t>(0, time), [](uint64_t value, const NexSegmentRun &run) { return value < run.time; });
+        if(run != first)
+            run--;
+        uint64_t offset = (uint64_t)std::max<int64_t>(0, time - (int64_t)run->time) / run->duration;
+        return run->first + std::min<uint64_t>(offset, run->count - 1);
+    }
+    int64_t position = (time - (int64_t)rendition.presentationTimeOffset) / (int64_t)rendition.duration - (int64_t)(record.firstNumber - rendition.startNumber);
+    return std::max<int64_t>(0, std::min<int64_t>(position, record.segmentCount - 1));
+}
+
+// HLS URIs resolve against their playlist; DASH templates are expanded ($RepresentationID$,
+// $Number$, $Time$, $Bandwidth$ with optional %0Nd, $$).
+inline bool NexManifestIndex::segmentURL(size_t index, uint32_t position, bool init, std::string &url) const {
+    if(index >= renditions.size())
+        return false;
+    if(type == NEXUNITY_MANIFEST_HLS){
+        const NexMediaPlaylist *media = playlist(index);
+        if(media == NULL || position >= media->segments.size())
+            return false;
+        const NexHlsSegment &segment = media->segments[position];
+        int32_t uriOffset = init ? (segment.mapIndex >= 0 ? media->maps[segment.mapIndex].uriOffset : -1) : segment.uriOffset;
+        const char *uri = media->string(uriOffset);
+        if(uri == NULL)
+            return false;
+        url = NexResolveUrl(media->url, uri);
+        return true;
+    }
+    const NexManifestRendition &rendition = renditions[index];
+    const char *pattern = string(init ? rendition.initOffset : rendition.mediaOffset);
+    NexSegmentRecord segment = {};
+    if(pattern == NULL || (!init && !this->segment(index, position, segment)))
+        return false;
+    url.clear();
+    char number[32];
+    for(const char *p = pattern; *p != 0; p++){
+        const char *close = *p == '$' ? strchr(p + 1, '$') : NULL;
+        if(close == NULL){
+            url.push_back(*p);
+            continue;
+        }
+        const char *name = p + 1;
+        const char *format = (const char *)memchr(name, '%', close - name);
+        size_t length = (format != NULL ? format : close) - name;
+        int width = format != NULL && format[1] == '0' ? atoi(format + 2) : 0;
+        uint64_t value;
+        if(length == 0){
+            url.push_back('$');
+            p = close;
+            continue;
+        } else if(NexNameIs(name, length, "RepresentationID")){
+            const char *id = string(rendition.record.idOffset);
+            url += id != NULL ? id : "";
+            p = close;
+            continue;
+        } else if(NexNameIs(name, length, "Number")){
+            value = segment.number;
+        } else if(NexNameIs(name, length, "Time")){
+            value = segment.time;
+        } else if(NexNameIs(name, length, "Bandwidth")){
+            value = (uint64_t)rendition.record.bandwidth;
+        } else {
+            url.push_back(*p);
+            continue;
+        }
+        snprintf(number, sizeof(number), "%0*llu", width, (unsigned long long)value);
+        url += number;
+        p = close;
+    }
+    return true;
+}
+
+inline bool NexManifestIndex::parse(const char *data, size_t size, const char *url, int64_t nowMs, const NexManifestIndex *previous) {
+    int64_t startUs = NexMonotonicUs();
+    this->url = url != NULL ? url : "";
+    periods.clear();
+    renditions.clear();
+    runs.clear();
+    timelines.clear();
+    strings.clear();
+    playlists.clear();
+    spares.clear();
+    interned.clear();
+    refreshUs = 0;
+    const char *p = data, *end = data + size;
+    if(size >= 3 && (uint8_t)p[0] == 0xEF && (uint8_t)p[1] == 0xBB && (uint8_t)p[2] == 0xBF)
+        p += 3;
+    while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+        p++;
+    bool parsed = false;
+    if(p < end && *p == '<'){
+        type = NEXUNITY_MANIFEST_DASH;
+        parsed = parseDASH(p, end, this->url, nowMs, previous);
+    } else if(NexLineStarts(p, end, "#EXTM3U")){
+        type = NEXUNITY_MANIFEST_HLS;
+        // Master playlists are the ones listing variants; the first segment rules that out.
+        bool master = false;
+        for(const char *tag = p; tag != NULL && tag + 1 < end; tag = (const char *)memchr(tag + 1, '#', end - tag - 1)){
+            if(NexLineStarts(tag, end, "#EXTINF:"))
+                break;
+            if(NexLineStarts(tag, end, "#EXT-X-STREAM-INF:")){
+                master = true;
+                break;
+            }
+        }
+        if(master){
+            parsed = parseHLSMaster(p, end, url != NULL ? url : "");
+        } else {
+            std::unique_ptr<NexMediaPlaylist> media(new NexMediaPlaylist());
+            parsed = media->parse(data, size, url, window);
+            if(parsed){
+                NexManifestRendition rendition = NexEmptyRendition();
+                rendition.record.kind = NEXUNITY_STREAM_VIDEO_TRACK;
+                rendition.record.uriOffset = intern(url != NULL ? url : "");
+                renditions.push_back(rendition);
+                NexManifestPeriod period = { 0, -1 };
+                periods.push_back(period);
+                playlists.resize(1);
+                attachPlaylist(0, std::move(media));
+            }
+        }
+    }
+    interned.clear();
+    parseUs = NexMonotonicUs() - startUs;
+    return parsed;
+}
+
+#endif /* NexManifestIndex_h */
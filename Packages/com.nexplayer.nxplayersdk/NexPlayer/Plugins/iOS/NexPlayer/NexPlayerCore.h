@@ -0,0 +1,106 @@
+//
+//  NexPlayerCore.h
+//  Unity-iPhone
+//
+//  Clocks, hashing and the seqlock shared by the bridge and its host-side tests. Plain C++, no SDK types.
+//
+
+#ifndef NexPlayerCore_h
+#define NexPlayerCore_h
+
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+static inline int64_t NexMonotonicUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline int64_t NexWallClockMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// FNV-1a step; start from 14695981039346656037.
+static inline uint64_t NexValueHash(uint64_t hash, const void *data, size_t length) {
+    for(size_t i = 0; i < length; i++)
+        hash = (hash ^ ((const uint8_t *)data)[i]) * 1099511628211ull;
+    return hash;
+}
+
+// Seqlock for state written from SDK callback threads and read from Unity's thread.
+// Writers serialise on a mutex, readers never block and retry if a write overlapped.
+// The payload lives in atomic words, so a racing read is well defined (and ThreadSanitizer-clean)
+// and the sequence check throws the torn copy away. Word stores are release and word loads acquire:
+// a reader that sees any new word also sees the odd sequence that preceded it, without fences.
+template <typename T>
+class NexSeqlock {
+public:
+    NexSeqlock() : sequence(0) {
+        for(size_t i = 0; i < kWords; i++)
+            words[i].store(0, std::memory_order_relaxed);
+    }
+
+    void write(const T &value) {
+        std::lock_guard<std::mutex> lock(writerLock);
+        store(value);
+    }
+
+    // Read-modify-write under the writer lock.
+    template <typename F>
+    void update(F mutate) {
+        std::lock_guard<std::mutex> lock(writerLock);
+        T value;
+        load(value);
+        mutate(value);
+        store(value);
+    }
+
+    // Returns the generation the copy belongs to; it only changes when a write completes.
+    uint32_t read(T &value) const {
+        uint64_t buffer[kWords];
+        for(;;){
+            uint32_t before = sequence.load(std::memory_order_acquire);
+            if(before & 1)
+                continue;
+            for(size_t i = 0; i < kWords; i++)
+                buffer[i] = words[i].load(std::memory_order_acquire);
+            if(sequence.load(std::memory_order_relaxed) == before){
+                memcpy(&value, buffer, sizeof(T));
+                return before >> 1;
+            }
+        }
+    }
+
+    uint32_t generation() const {
+        return sequence.load(std::memory_order_acquire) >> 1;
+    }
+
+private:
+    static const size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    void load(T &value) const {
+        uint64_t buffer[kWords];
+        for(size_t i = 0; i < kWords; i++)
+            buffer[i] = words[i].load(std::memory_order_relaxed);
+        memcpy(&value, buffer, sizeof(T));
+    }
+
+    void store(const T &value) {
+        uint64_t buffer[kWords] = {0};
+        memcpy(buffer, &value, sizeof(T));
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        for(size_t i = 0; i < kWords; i++)
+            words[i].store(buffer[i], std::memory_order_release);
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint64_t> words[kWords];
+    std::mutex writerLock;
+};
+
+#endif /* NexPlayerCore_h */
@@ -27,9 +27,28 @@
 #include <string.h>
 #include <stdint.h>
 
-#define PIXEL_FORMAT_32BGRA  1
-
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <thread>
+
+#include "NexPlayerCore.h"
+#include "NexTextScan.h"
+#include "NexSubtitleParser.h"
+#include "NexManifestIndex.h"
+#include "NexDeviceProfile.h"
+#include "NexCdnSteering.h"
+#include "NexResilience.h"
+#include "NexHeaderStore.h"
 
+#define PIXEL_FORMAT_32BGRA  1
 
 #define NEX_HTTP_RETRIEVE_CALLBACK 0
 #define NEX_HTTP_STORE_CALLBACK 1
@@ -43,7 +62,7 @@
 @property (nonatomic, strong) NSString *subtitlePath;
 @end
 
-@interface NexPlayerScripting : NSObject <NXPlayerDelegate, NXABRDelegate>
+@interface NexPlayerScripting : NSObject <NXPlayerDelegate, NXABRDelegate, NXPlayerCEA608CaptionUpdateReceiver, NXManifestAndPlaylistDescrambler, NXHttpStateDelegate>
 
 @property (nonatomic, strong) NXPlayerView *playerView;
 @property (nonatomic, readonly) NXPlayer *player;
@@ -64,13 +83,7 @@
 @property (nonatomic, strong) NXPlayerABRController *abrController;
 @property (nonatomic, strong) NSString *keyServerURL;
 @property (nonatomic, strong) NSString *subtitle_path;
-@property (nonatomic, strong) NSString *current_subtitle;
-@property (nonatomic, strong) NSDictionary *timedMetadata;
-@property (nonatomic, strong) NSString *CUSTOM_TAGS;
 
-@property (nonatomic) NSUInteger subtitle_startTime;
-@property (nonatomic) NSUInteger subtitle_endTime;
-@property (nonatomic) NSUInteger subtitle_type;
 
 //MULTI 13/01/2020
 @property (nonatomic) NSUInteger multiStreamScreens;
@@ -89,7 +102,6 @@
 @property (nonatomic, strong) NexPlayerHTTPStoreHandler *httpStoreHandler;
 @property (nonatomic, strong) NSString *storeStreamURL;
 @property (nonatomic, strong) NSDictionary *info;
-@property (nonatomic) NSUInteger downloadProgress;
 @property (nonatomic) NSUInteger videoBitrate;
 @property (nonatomic) NSUInteger numberOfStoredFiles;
 @property (nonatomic) NSUInteger totalFilesToDload;
@@ -101,11 +113,11 @@
 - (int)setupPlayer:(int)width :(int) height;
 - (int)openPlayer:(NSString *)path;
 - (int)openFD:(NSString *)fileName;
-- (void)startPlayer:(int)msec;
-- (void)pausePlayer;
-- (void)resumePlayer;
-- (void)seekPlayerToTime:(int)msec;
-- (void)stopPlayer;
+- (int)startPlayer:(int)msec;
+- (int)pausePlayer;
+- (int)resumePlayer;
+- (int)seekPlayerToTime:(int)msec;
+- (int)stopPlayer;
 - (void)closePlayer;
 - (void)shutDownPlayer;
 - (void)setLogLevel:(int)log_level;
@@ -134,6 +146,8 @@
 - (void)cleanVideoTexture;
 - (void)setLowLatency:(BOOL)enable toValue:(int)value;
 - (void)setProperties;
+-(void)applyConfig:(int)index;
+-(int)setConfig:(int)index toValue:(const NexPlayerConfig *)config;
 - (void)setEnabledABR:(BOOL)enable;
 - (void)setPlayersEnabledABRWithProperty;
 - (void)setCustomTags:(NSString*) Tags;
@@ -160,6 +174,67 @@
 //End multi-instance martin 14012020
 -(void)setTrack:(NSUInteger)bitRate;
 
+-(NXPlayer*)playerAtIndex:(int)index;
+-(int)indexOfPlayer:(NXPlayer*)nxplayer;
+
+//Trick play
+-(int)startTrickPlay:(int)previewIndex toValue:(int)playbackIndex speed:(int)speed;
+-(void)setTrickPlaySpeed:(int)previewIndex toValue:(int)speed;
+-(void)scrubTrickPlay:(int)previewIndex toValue:(int)msec;
+-(int)stopTrickPlay:(int)previewIndex commit:(BOOL)commit;
+-(int)getTrickPlayPosition:(int)previewIndex;
+//End trick play
+
+//Sync group
+-(int)openSyncGroup:(int)memberMask autoStart:(BOOL)autoStart;
+-(void)closeSyncGroup;
+-(void)pauseSyncGroup;
+-(void)resumeSyncGroup;
+-(void)seekSyncGroup:(int)msec;
+-(float)getSyncGroupDrift:(int)index;
+//End sync group
+
+//Live latency
+-(void)enableLatencyControl:(int)index enable:(BOOL)enable target:(int)targetMs;
+-(int)getLatency:(int)index;
+-(int)getLatencyPercentile:(int)index percentile:(int)percentile;
+-(void)resetLatencyStats:(int)index;
+//End live latency
+
+//Command worker
+-(int)enqueueCommand:(int)kind index:(int)index arg:(int)arg work:(int (^)(void))work;
+-(int)performCommand:(int)kind index:(int)index arg:(int)arg work:(int (^)(void))work;
+-(int)getCommandStatus:(int)token result:(int *)result;
+-(int)getAvoidedCallCount:(int)index;
+//End command worker
+
+//Manifest index
+-(BOOL)loadManifest:(const char *)data length:(size_t)length url:(NSString *)url index:(int)index;
+-(BOOL)loadMediaPlaylist:(const char *)data length:(size_t)length url:(NSString *)url index:(int)index rendition:(int)rendition;
+//End manifest index
+
+//Device profile
+-(int)setDeviceProfile:(int)index toValue:(const NexDeviceProfile *)profile;
+//End device profile
+
+//CDN steering
+-(void)setCdnLocations:(int)index locations:(NSString *)locations;
+//End CDN steering
+
+//Stall watchdog
+-(void)enableWatchdog:(int)index enable:(BOOL)enable;
+-(int)takeWatchdogResume:(int)index;
+//End stall watchdog
+
+//Resilience
+-(int)setResiliencePolicy:(int)index toValue:(const NexResiliencePolicy *)policy;
+-(void)resetResilienceSession:(int)index;
+//End resilience
+
+//Header store
+-(int)storeHeaderField:(int)index name:(NSString *)name value:(NSString *)value query:(BOOL)query;
+//End header store
+
 @end
 
 @implementation NexPlayerScripting
@@ -189,6 +264,127 @@ intptr_t frameTexture;
 typedef void ( *PlayerListener )( int, int, int, int, int, int );
 static PlayerListener g_playerListener = NULL;
 
+//Frame governor
+// With the governor on, events are queued by priority instead of calling into Unity from SDK
+// threads. NexPlayerUnity_GovernorTick drains them on Unity's thread, then refreshes stats
+// snapshots, until the frame budget is spent; whatever is left waits for the next frame.
+#define GOVERNOR_QUEUE 256
+#define GOVERNOR_PRIORITIES 3
+
+typedef struct {
+    int event;
+    int args[5];
+} NexQueuedEvent;
+
+typedef struct {
+    NexQueuedEvent events[GOVERNOR_QUEUE];
+    int head;
+    int count;
+} NexEventQueue;
+
+std::atomic<bool> governorEnabled(false);
+std::mutex governorLock;
+NexEventQueue governorQueues[GOVERNOR_PRIORITIES];
+std::deque<NexQueuedEvent> governorCritical;  // priority-0 events that did not fit the ring; never dropped
+std::atomic<int> governorDropped(0);
+std::atomic<int> governorDebtUs(0);         // overrun of the last tick, taken out of the next budget
+std::atomic<int> governorOverruns(0);
+std::atomic<int> governorLastOverrunUs(0);
+std::atomic<int> governorMaxOverrunUs(0);
+int governorStatsCursor = 0;
+
+static int NexEventPriority(int event) {
+    switch(event){
+        case NEXUNITY_EVENT_ERROR:
+        case NEXUNITY_EVENT_ASYNC_COMPLETE:
+        case NEXUNITY_EVENT_END_OF_CONTENT:
+        case NEXUNITY_EVENT_STATUS_CHANGED:
+        case NEXUNITY_EVENT_COMMAND_COMPLETE:
+        case NEXUNITY_EVENT_LOADSTART:
+            return 0;
+        case NEXUNITY_EVENT_TIME:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+// Every event also lands in a ring Unity can poll from memory (NEXUNITY_REGION_EVENTS).
+#define EVENT_RING_SIZE 256
+NexEventRecord eventRing[EVENT_RING_SIZE];
+std::atomic<uint32_t> eventRingWritten(0);
+std::mutex eventRingLock;
+
+static void NexRecordEvent(int event, int a, int b, int c, int d, int e) {
+    std::lock_guard<std::mutex> lock(eventRingLock);
+    uint32_t number = eventRingWritten.load(std::memory_order_relaxed);
+    NexEventRecord *record = &eventRing[number % EVENT_RING_SIZE];
+    uint32_t sequence = __atomic_load_n(&record->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&record->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&record->number, number, __ATOMIC_RELEASE);
+    __atomic_store_n(&record->event, (int32_t)event, __ATOMIC_RELEASE);
+    int args[5] = { a, b, c, d, e };
+    for(int i = 0; i < 5; i++)
+        __atomic_store_n(&record->args[i], (int32_t)args[i], __ATOMIC_RELEASE);
+    __atomic_store_n(&record->monotonicUs, NexMonotonicUs(), __ATOMIC_RELEASE);
+    __atomic_store_n(&record->sequence, sequence + 2, __ATOMIC_RELEASE);
+    eventRingWritten.store(number + 1, std::memory_order_release);
+}
+
+static void NexPostEvent(int event, int a, int b, int c, int d, int e) {
+    NexRecordEvent(event,a,b,c,d,e);
+    if(!governorEnabled){
+        if(g_playerListener)
+            g_playerListener(event,a,b,c,d,e);
+        return;
+    }
+    int priority = NexEventPriority(event);
+    std::lock_guard<std::mutex> lock(governorLock);
+    NexEventQueue *queue = &governorQueues[priority];
+    // Low-priority events are progress reports; only the newest one of a kind matters.
+    if(priority == GOVERNOR_PRIORITIES - 1 && queue->count > 0){
+        NexQueuedEvent *last = &queue->events[(queue->head + queue->count - 1) % GOVERNOR_QUEUE];
+        if(last->event == event){
+            NexQueuedEvent replacement = { event, { a, b, c, d, e } };
+            *last = replacement;
+            return;
+        }
+    }
+    NexQueuedEvent queued = { event, { a, b, c, d, e } };
+    // Errors and completions are never evicted; once their ring is full they queue behind it.
+    if(priority == 0 && (queue->count == GOVERNOR_QUEUE || !governorCritical.empty())){
+        governorCritical.push_back(queued);
+        return;
+    }
+    if(queue->count == GOVERNOR_QUEUE){
+        queue->head = (queue->head + 1) % GOVERNOR_QUEUE;
+        queue->count--;
+        governorDropped++;
+    }
+    queue->events[(queue->head + queue->count) % GOVERNOR_QUEUE] = queued;
+    queue->count++;
+}
+
+static bool NexPopEvent(NexQueuedEvent *event) {
+    std::lock_guard<std::mutex> lock(governorLock);
+    for(int priority = 0; priority < GOVERNOR_PRIORITIES; priority++){
+        NexEventQueue *queue = &governorQueues[priority];
+        if(queue->count == 0 && priority == 0 && !governorCritical.empty()){
+            *event = governorCritical.front();
+            governorCritical.pop_front();
+            return true;
+        }
+        if(queue->count == 0)
+            continue;
+        *event = queue->events[queue->head];
+        queue->head = (queue->head + 1) % GOVERNOR_QUEUE;
+        queue->count--;
+        return true;
+    }
+    return false;
+}
+//End frame governor
+
 typedef int ( *NEXPLAYERGetKeyExtCallbackFunc)(NSString *, long, NSData*, long, intptr_t, intptr_t);
 static NEXPLAYERGetKeyExtCallbackFunc g_GetKeyExtCallback = NULL;
 
@@ -203,26 +399,108 @@ bool m_isClose = NO;
 
 // player preference
 bool supportABR = true;
-int maxBW = 0;
-int minBW = 0;
-int avSyncOffset = 0;
-int preferLanguage = 0;
-int preferBW = 0;
-int bufferingTime = 0;
-int enableTrackDown = 0;
-int trackDwonVideoRatio = 0;
-int VDispWait = 0;
-int VDispSkip = 0;
-int StartNearestBW = 0;
-int MaxCaptionLength = 8192;
+std::atomic<int> MaxCaptionLength(NEXPLAYER_CUE_TEXT_MAX);    // cue text limit in bytes, terminator included
 bool offlineMode = false;
-
-int localSPDEnable = 0;
-int localSPDTime = 0;
-int localSPDSpeedUpSyncTime = 0;
-int localSPDJumpSyncTime = 0;
 int loglevel = -1;
 
+// Preferences set with NEXPLAYERUnity_SetProperty apply to every instance without a config of its own.
+// Each instance remembers the NXProperty values last sent to its player, so only changes reach the SDK.
+#define CONFIG_PROPERTY_COUNT 20
+#define CONFIG_UNSET NSIntegerMin
+
+NexPlayerConfig sharedConfig = { NEXPLAYER_CONFIG_VERSION, sizeof(NexPlayerConfig) };
+NexPlayerConfig instanceConfig[8];
+bool hasInstanceConfig[8];
+NSInteger appliedConfig[8][CONFIG_PROPERTY_COUNT];
+bool appliedConfigValid[8];
+int configPropertyCalls[8];
+int configPropertySkipped[8];
+
+static const NXProperty configProperties[CONFIG_PROPERTY_COUNT] = {
+    NXPropertyMaxBW,
+    NXPropertyMinBW,
+    NXPropertyAVSyncOffset,
+    NXPropertyPreferLanguage,
+    NXPropertyPreferBandwidth,
+    NXPropertyInitialBufferingDuration,
+    NXPropertyReBufferingDuration,
+    NXPropertyEnableTrackdown,
+    NXPropertyTrackdownVideoRatio,
+    NXPropertyTimestampDifferenceVDispWait,
+    NXPropertyTimestampDifferenceVDispSkip,
+    NXPropertyStartNearestBW,
+    NXPropertyEnableSpdSyncToGlobalTime,
+    NXPropertySuggestedPresentationDelayTime,
+    NXPropertyLiveViewOption,
+    NXPropertyPartialPrefetch,
+    NXPropertySpdSyncDiffTime,
+    NXPropertySpdTooMuchDiffTime,
+    NXPropertyDataInactivityTimeout,       // these two come from the resilience policy
+    NXPropertySocketOperationTimeout
+};
+
+static const NexPlayerConfig *NexConfigFor(int index) {
+    if(index >= 0 && index < 8 && hasInstanceConfig[index])
+        return &instanceConfig[index];
+    return &sharedConfig;
+}
+
+// Maps a config onto configProperties, CONFIG_UNSET leaves the SDK value alone.
+static void NexResolveConfig(const NexPlayerConfig *config, NSInteger values[CONFIG_PROPERTY_COUNT]) {
+    for(int i = 0; i < CONFIG_PROPERTY_COUNT; i++)
+        values[i] = CONFIG_UNSET;
+
+    if(config->maxBW > 0)           values[0] = config->maxBW;
+    if(config->minBW > 0)           values[1] = config->minBW;
+    if(config->avSyncOffset > 0)    values[2] = config->avSyncOffset;
+    if(config->preferLanguage > 0)  values[3] = config->preferLanguage;
+    if(config->preferBW > 0)        values[4] = config->preferBW;
+    if(config->bufferingTime != 0){
+        values[5] = config->bufferingTime;
+        values[6] = config->bufferingTime;
+    }
+    if(config->enableTrackDown > 0){
+        values[7] = config->enableTrackDown;
+        values[8] = config->trackDownVideoRatio;
+    }
+    if(config->vDispWait > 0)       values[9] = config->vDispWait;
+    if(config->vDispSkip > 0)       values[10] = config->vDispSkip;
+    if(config->startNearestBW > 0)  values[11] = config->startNearestBW;
+    if(config->spdEnable != 0 && config->spdTime != 0){
+        values[12] = 1;
+        values[13] = config->spdTime;
+        values[14] = NXPropertyLiveViewLowLatency;
+        values[15] = 1;
+        values[16] = config->spdSpeedUpSyncTime != 0 ? config->spdSpeedUpSyncTime : 300;
+        values[17] = config->spdJumpSyncTime != 0 ? config->spdJumpSyncTime : 5000;
+    }
+}
+
+// Returns false when the NEXUNITY property is not part of NexPlayerConfig.
+static bool NexConfigSetField(NexPlayerConfig *config, int property, int value) {
+    switch(property) {
+        case NEXUNITY_NXPropertyMaxBW:                          config->maxBW = value; break;
+        case NEXUNITY_NXPropertyMinBW:                          config->minBW = value; break;
+        case NEXUNITY_NXPropertyAVSyncOffset:                   config->avSyncOffset = value; break;
+        case NEXUNITY_NXPropertyPreferLanguage:                 config->preferLanguage = value; break;
+        case NEXUNITY_NXPropertyPreferBandwidth:                config->preferBW = value; break;
+        case NEXUNITY_NXPropertyInitialBufferingDuration:
+        case NEXUNITY_NXPropertyReBufferingDuration:            config->bufferingTime = value; break;
+        case NEXUNITY_NXPropertyEnableTrackdown:                config->enableTrackDown = value; break;
+        case NEXUNITY_NXPropertyTrackdownVideoRatio:            config->trackDownVideoRatio = value; break;
+        case NEXUNITY_NXPropertyTimestampDifferenceVDispWait:   config->vDispWait = value; break;
+        case NEXUNITY_NXPropertyTimestampDifferenceVDispSkip:   config->vDispSkip = value; break;
+        case NEXUNITY_NXPropertyStartNearestBW:                 config->startNearestBW = value; break;
+        case NEXUNITY_NXPropertySPDEnable:                      config->spdEnable = value; break;
+        case NEXUNITY_NXPropertySPDTime:                        config->spdTime = value; break;
+        case NEXUNITY_NXPropertySPDSpeedUpSyncTime:             config->spdSpeedUpSyncTime = value; break;
+        case NEXUNITY_NXPropertySPDJumpSyncTime:                config->spdJumpSyncTime = value; break;
+        default:
+            return false;
+    }
+    return true;
+}
+
 NSUInteger m_licenseRequestTimeout = 30;
 
 NSString* m_AlticastSecret;
@@ -237,8 +515,577 @@ NSUInteger chosenPlayerMulti = 0;
 bool multiPropertyLoop[8];
 bool multiPropertyAutoStart[8];
 bool multiPropertyMute[8];
-int lastSubMultiIndex = 0;
-int lastMultiInitPlayer = 0;
+std::atomic<int> lastSubMultiIndex(0);
+std::atomic<int> lastMultiInitPlayer(0);
+
+// Per-instance state published by the delegate callbacks, read by the NEXPLAYERUnity_* getters.
+typedef struct {
+    int downloadProgress;
+} NexInstanceSnapshot;
+
+NexSeqlock<NexInstanceSnapshot> instanceSnapshot[8];
+
+// Timed metadata, serialized once per update. Only read under metadataLock: every getter
+// copies out, so replacing a buffer never pulls memory from under a reader.
+std::vector<uint8_t> metadataBuffers[8];
+std::atomic<uint32_t> metadataGeneration[8];
+std::mutex metadataLock;
+
+class NexMetadataWriter {
+public:
+    std::vector<NexMetadataEntry> entries;
+    std::vector<uint8_t> bytes;
+
+    void add(int field, int flags, NSString *tag, NSString *mime, const void *payload, size_t length) {
+        NexMetadataEntry entry;
+        entry.field = field;
+        entry.flags = flags;
+        append(tag, entry.tagOffset, entry.tagLength);
+        append(mime, entry.mimeOffset, entry.mimeLength);
+        append(payload, length, entry.payloadOffset, entry.payloadLength);
+        entries.push_back(entry);
+    }
+
+    void addValue(int field, NSString *tag, id value) {
+        if([value isKindOfClass:[NSString class]]){
+            const char *utf8 = [(NSString *)value UTF8String];
+            add(field, 0, tag, nil, utf8, strlen(utf8));
+        } else if([value isKindOfClass:[NSData class]]){
+            NSData *data = (NSData *)value;
+            add(field, NEXUNITY_METADATA_BINARY | (field == NEXUNITY_METADATA_PICTURE ? NEXUNITY_METADATA_PICTURE_DATA : 0), tag, nil, data.bytes, data.length);
+        }
+    }
+
+    // Header and entry table first, then the bytes; offsets are rebased onto the final layout.
+    void finish(std::vector<uint8_t> &out, uint32_t generation, int instance) {
+        int32_t base = (int32_t)(sizeof(NexMetadataHeader) + entries.size() * sizeof(NexMetadataEntry));
+        for(NexMetadataEntry &entry : entries){
+            rebase(entry.tagOffset, base);
+            rebase(entry.mimeOffset, base);
+            rebase(entry.payloadOffset, base);
+        }
+        NexMetadataHeader header = { generation, (int32_t)entries.size(), base + (int32_t)bytes.size(), instance };
+        out.resize(header.totalSize);
+        memcpy(out.data(), &header, sizeof(header));
+        if(!entries.empty())
+            memcpy(out.data() + sizeof(header), entries.data(), entries.size() * sizeof(NexMetadataEntry));
+        if(!bytes.empty())
+            memcpy(out.data() + base, bytes.data(), bytes.size());
+    }
+
+private:
+    void append(NSString *string, int32_t &offset, int32_t &length) {
+        if(string == nil){
+            offset = -1;
+            length = 0;
+            return;
+        }
+        const char *utf8 = [string UTF8String];
+        append(utf8, strlen(utf8), offset, length);
+    }
+
+    void append(const void *data, size_t size, int32_t &offset, int32_t &length) {
+        offset = (int32_t)bytes.size();
+        length = (int32_t)size;
+        if(size > 0)
+            bytes.insert(bytes.end(), (const uint8_t *)data, (const uint8_t *)data + size);
+        while(bytes.size() % 4)     // keep every payload 4-byte aligned for direct views
+            bytes.push_back(0);
+    }
+
+    static void rebase(int32_t &offset, int32_t base) {
+        if(offset >= 0)
+            offset += base;
+    }
+};
+
+// Custom ID3 tag subscription (NEXPLAYERUnity_SetTimedMetadata_CustomTags). The players keep
+// the pointer handed to NXPropertyTimedID3MetaKey with no way to tell when they let go of it,
+// so every distinct value is interned for the life of the plugin and customTagsValue points
+// into that set; its nodes never move. Apps set a handful of tag lists, so it stays small.
+// With subscriptions, an update reaches Unity only if a standard field or a subscribed tag
+// changed value; unsubscribed extra tags are left out of the serialized buffer.
+typedef std::unordered_set<std::string> NexTagSet;
+
+std::unordered_set<std::string> customTagsInterned;
+const char *customTagsValue = "";
+std::shared_ptr<const NexTagSet> subscribedTags;
+std::unordered_map<std::string, uint64_t> tagValueHashes[8];   // field or tag id -> value hash
+int suppressedMetadataUpdates[8];
+std::mutex customTagLock;
+
+static std::shared_ptr<const NexTagSet> NexSubscribedTags() {
+    std::lock_guard<std::mutex> lock(customTagLock);
+    return subscribedTags;
+}
+
+static uint64_t NexMetadataValueHash(id value) {
+    uint64_t hash = 14695981039346656037ull;
+    if([value isKindOfClass:[NSString class]]){
+        const char *utf8 = [(NSString *)value UTF8String];
+        return NexValueHash(hash, utf8, strlen(utf8));
+    }
+    if([value isKindOfClass:[NSData class]])
+        return NexValueHash(hash, [(NSData *)value bytes], [(NSData *)value length]);
+    if([value isKindOfClass:[NxTimedMetaExtraTag class]]){
+        NxTimedMetaExtraTag *tag = (NxTimedMetaExtraTag *)value;
+        const char *text = tag.text != nil ? [tag.text UTF8String] : "";
+        hash = NexValueHash(hash, text, strlen(text) + 1);
+        return NexValueHash(hash, tag.data.bytes, tag.data.length);
+    }
+    return hash;
+}
+
+static bool NexTagSubscribed(const NexTagSet *filter, NSString *key, NxTimedMetaExtraTag *tag) {
+    if(filter == NULL)
+        return true;
+    if(filter->count([key UTF8String]) != 0)
+        return true;
+    return tag.tagID != nil && filter->count([tag.tagID UTF8String]) != 0;
+}
+
+// Records the value of every standard field and subscribed tag; true if any of them differs
+// from the instance's previous update. Callers hold customTagLock.
+static bool NexMetadataChanged(int index, NSDictionary *metaData, const NexTagSet &filter) {
+    std::unordered_map<std::string, uint64_t> &hashes = tagValueHashes[index];
+    bool changed = false;
+    for(NSString *key in metaData){
+        id value = metaData[key];
+        if([key isEqualToString:kNXTimedMetaKeyExtraData]){
+            NSDictionary *extraTags = (NSDictionary *)value;
+            for(NSString *tagKey in extraTags){
+                NxTimedMetaExtraTag *tag = extraTags[tagKey];
+                if(![tag isKindOfClass:[NxTimedMetaExtraTag class]] || !NexTagSubscribed(&filter, tagKey, tag))
+                    continue;
+                uint64_t hash = NexMetadataValueHash(tag);
+                auto inserted = hashes.emplace(std::string("tag:") + [tagKey UTF8String], hash);
+                if(inserted.second || inserted.first->second != hash){
+                    inserted.first->second = hash;
+                    changed = true;
+                }
+            }
+            continue;
+        }
+        uint64_t hash = NexMetadataValueHash(value);
+        auto inserted = hashes.emplace([key UTF8String], hash);
+        if(inserted.second || inserted.first->second != hash){
+            inserted.first->second = hash;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+static void NexSerializeMetadata(NSDictionary *metaData, std::vector<uint8_t> &out, uint32_t generation, int instance, const NexTagSet *filter) {
+    static const struct { int field; NSString * __unsafe_unretained key; } fields[] = {
+        { NEXUNITY_METADATA_TITLE, kNXTimedMetaKeyTitle },
+        { NEXUNITY_METADATA_ALBUM, kNXTimedMetaKeyAlbum },
+        { NEXUNITY_METADATA_ARTIST, kNXTimedMetaKeyArtist },
+        { NEXUNITY_METADATA_LYRICS, kNXTimedMetaKeyLyrics },
+        { NEXUNITY_METADATA_GENRE, kNXTimedMetaKeyGenre },
+        { NEXUNITY_METADATA_PICTURE, kNXTimedMetaKeyImage },
+        { NEXUNITY_METADATA_TRACK_NUMBER, kNXTimedMetaKeyTrackNum },
+        { NEXUNITY_METADATA_YEAR, kNXTimedMetaKeyYear },
+        { NEXUNITY_METADATA_PRIVATE_FRAME, kNXTimedMetaKeyPrivateFrame },
+        { NEXUNITY_METADATA_COMMENT, kNXTimedMetaKeyComment },
+        { NEXUNITY_METADATA_TEXT, kNXTimedMetaKeyText },
+    };
+    NexMetadataWriter writer;
+    for(size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++){
+        id value = metaData[fields[i].key];
+        if(value != nil)
+            writer.addValue(fields[i].field, nil, value);
+    }
+    NSDictionary *extraTags = metaData[kNXTimedMetaKeyExtraData];
+    for(NSString *key in extraTags){
+        NxTimedMetaExtraTag *tag = extraTags[key];
+        if(![tag isKindOfClass:[NxTimedMetaExtraTag class]] || !NexTagSubscribed(filter, key, tag))
+            continue;
+        if(tag.data != nil){
+            int flags = NEXUNITY_METADATA_BINARY | (tag.isPicture ? NEXUNITY_METADATA_PICTURE_DATA : 0);
+            writer.add(NEXUNITY_METADATA_EXTRA, flags, key, tag.mimeType, tag.data.bytes, tag.data.length);
+        }
+        if(tag.text != nil){
+            const char *utf8 = [tag.text UTF8String];
+            writer.add(NEXUNITY_METADATA_EXTRA, 0, key, nil, utf8, strlen(utf8));
+        }
+    }
+    writer.finish(out, generation, instance);
+}
+
+// Text entry of the latest instance-0 update for the legacy per-field getters; copies into
+// buffer when given and returns the length. Callers hold metadataLock.
+static int NexLookupMetadataText(int field, const char *tagId, unsigned char *buffer) {
+    const std::vector<uint8_t> &data = metadataBuffers[0];
+    if(data.size() < sizeof(NexMetadataHeader))
+        return 0;
+    const NexMetadataHeader *header = (const NexMetadataHeader *)data.data();
+    const NexMetadataEntry *entries = (const NexMetadataEntry *)(data.data() + sizeof(NexMetadataHeader));
+    size_t tagLength = tagId != NULL ? strlen(tagId) : 0;
+    for(int i = 0; i < header->entryCount; i++){
+        const NexMetadataEntry &entry = entries[i];
+        if(entry.field != field || (entry.flags & NEXUNITY_METADATA_BINARY))
+            continue;
+        if(field == NEXUNITY_METADATA_EXTRA
+           && (tagId == NULL || (size_t)entry.tagLength != tagLength || memcmp(&data[entry.tagOffset], tagId, tagLength) != 0))
+            continue;
+        if(buffer != NULL)
+            memcpy(buffer, &data[entry.payloadOffset], entry.payloadLength);
+        return entry.payloadLength;
+    }
+    return 0;
+}
+
+// Metadata timeline: entries keyed by presentation time, kept sorted and bounded per instance,
+// by count and by payload bytes (an APIC picture can be megabytes). Playhead updates fire
+// NEXUNITY_EVENT_METADATA_CUE for the entries crossed since the previous update; seeks move the
+// cursor without firing what was skipped.
+#define TIMELINE_CAPACITY 1024
+#define TIMELINE_BYTE_BUDGET (8 << 20)
+#define TIMELINE_SEEK_GAP_MS 2000
+
+typedef struct {
+    NexTimelineEntry entry;
+    std::vector<uint8_t> payload;
+} NexTimelineItem;
+
+std::vector<NexTimelineItem> timeline[8];
+size_t timelineBytes[8];
+int64_t timelineCursorMs[8] = { -1, -1, -1, -1, -1, -1, -1, -1 };
+uint32_t timelineNextId = 1;
+std::mutex timelineLock;
+
+static bool NexTimelineLess(const NexTimelineItem &item, int64_t ptsMs) {
+    return item.entry.ptsMs < ptsMs;
+}
+
+// Callers hold timelineLock. Keeps entries ordered by PTS, then arrival; when full, the entries
+// furthest behind the cursor go, unless the new one would be older than all of them.
+static uint32_t NexTimelineInsert(int index, int64_t ptsMs, int64_t durationMs, int kind, std::vector<uint8_t> &payload) {
+    std::vector<NexTimelineItem> &items = timeline[index];
+    if(payload.size() > TIMELINE_BYTE_BUDGET)
+        return 0;
+    size_t evict = 0;
+    size_t bytes = timelineBytes[index];
+    while(evict < items.size() && (items.size() - evict >= TIMELINE_CAPACITY || bytes + payload.size() > TIMELINE_BYTE_BUDGET)){
+        if(items[evict].entry.ptsMs > ptsMs)
+            return 0;
+        bytes -= items[evict].payload.size();
+        evict++;
+    }
+    items.erase(items.begin(), items.begin() + evict);
+    timelineBytes[index] = bytes + payload.size();
+    auto position = std::upper_bound(items.begin(), items.end(), ptsMs, [](int64_t pts, const NexTimelineItem &item) {
+        return pts < item.entry.ptsMs;
+    });
+    NexTimelineItem item;
+    item.entry.ptsMs = ptsMs;
+    item.entry.durationMs = durationMs;
+    item.entry.id = timelineNextId++;
+    item.entry.kind = kind;
+    item.entry.payloadSize = (int32_t)payload.size();
+    item.entry.reserved = 0;
+    item.payload.swap(payload);
+    uint32_t id = item.entry.id;
+    items.insert(position, std::move(item));
+    return id;
+}
+
+// Subtitle cues, double-buffered per instance: the writer fills the slot readers are not
+// pointed at and then flips cueGeneration, whose low bit selects the active slot. Readers
+// holding a pointer confirm the slot sequence (or the generation) did not move after reading.
+NexCueRecord cueSlots[8][2];
+std::atomic<uint32_t> cueGeneration[8];
+std::mutex cueLock;
+
+static uint32_t NexCueHash(const char *text, size_t length, int type) {
+    uint32_t hash = 2166136261u;
+    for(size_t i = 0; i < length; i++)
+        hash = (hash ^ (uint8_t)text[i]) * 16777619u;
+    return (hash ^ (uint32_t)type) * 16777619u;
+}
+
+// Returns false when the cue equals the active one, so no event is due. startMs < 0 means the
+// source has no cue times; the cue is then stamped with playheadMs if it is new.
+static bool NexPublishCue(int index, const char *utf8, int type, int64_t startMs, int64_t endMs, int64_t playheadMs) {
+    size_t length = strlen(utf8);
+    size_t limit = (size_t)MaxCaptionLength.load(std::memory_order_relaxed);
+    if(length >= limit){
+        length = limit - 1;
+        while(length > 0 && (utf8[length] & 0xC0) == 0x80)
+            length--;
+    }
+    std::lock_guard<std::mutex> lock(cueLock);
+    uint32_t generation = cueGeneration[index].load(std::memory_order_relaxed);
+    const NexCueRecord *active = &cueSlots[index][generation & 1];
+    if(type < 0)
+        type = active->type;
+    uint32_t hash = NexCueHash(utf8, length, type);
+    // The hash only rules out a match; the text itself decides. Only this writer, under cueLock,
+    // touches the slots, so the active one can be compared directly.
+    if(hash == active->hash && (int32_t)length == active->length && (startMs < 0 || startMs == active->startMs)
+       && memcmp(active->text, utf8, length) == 0)
+        return false;
+
+    NexCueRecord *next = &cueSlots[index][(generation + 1) & 1];
+    uint32_t sequence = __atomic_load_n(&next->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&next->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&next->type, (int32_t)type, __ATOMIC_RELEASE);
+    __atomic_store_n(&next->startMs, startMs >= 0 ? startMs : playheadMs, __ATOMIC_RELEASE);
+    __atomic_store_n(&next->endMs, startMs >= 0 ? endMs : (int64_t)-1, __ATOMIC_RELEASE);
+    __atomic_store_n(&next->hash, hash, __ATOMIC_RELEASE);
+    __atomic_store_n(&next->length, (int32_t)length, __ATOMIC_RELEASE);
+    for(size_t i = 0; i < length; i++)
+        __atomic_store_n(&next->text[i], utf8[i], __ATOMIC_RELAXED);
+    __atomic_store_n(&next->text[length], (char)0, __ATOMIC_RELAXED);
+    __atomic_store_n(&next->sequence, sequence + 2, __ATOMIC_RELEASE);
+    cueGeneration[index].store(generation + 1, std::memory_order_release);
+    return true;
+}
+
+// Copies the active cue of an instance; the text is copied only up to capacity bytes.
+static uint32_t NexReadCue(int index, NexCueRecord &cue, char *text, int capacity) {
+    for(;;){
+        uint32_t generation = cueGeneration[index].load(std::memory_order_acquire);
+        const NexCueRecord *slot = &cueSlots[index][generation & 1];
+        uint32_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        if(sequence & 1)
+            continue;
+        cue.type = __atomic_load_n(&slot->type, __ATOMIC_ACQUIRE);
+        cue.startMs = __atomic_load_n(&slot->startMs, __ATOMIC_ACQUIRE);
+        cue.endMs = __atomic_load_n(&slot->endMs, __ATOMIC_ACQUIRE);
+        cue.hash = __atomic_load_n(&slot->hash, __ATOMIC_ACQUIRE);
+        cue.length = __atomic_load_n(&slot->length, __ATOMIC_ACQUIRE);
+        int copied = text != NULL ? std::min(cue.length, capacity) : 0;
+        for(int i = 0; i < copied; i++)
+            text[i] = __atomic_load_n(&slot->text[i], __ATOMIC_RELAXED);
+        if(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) == sequence
+           && cueGeneration[index].load(std::memory_order_acquire) == generation){
+            if(text != NULL)
+                cue.length = copied;
+            return generation;
+        }
+    }
+}
+NXStatisticsAPI *multiStatisticsAPI[8];
+
+// Stats records live in the NEXUNITY_REGION_STATS region; only the governor tick writes them.
+NexStatsRecord statsRecords[8];
+std::atomic<uint32_t> statsGeneration(0);
+
+static void NexPublishStats(int index, const NexStatsSnapshot &stats) {
+    NexStatsRecord *record = &statsRecords[index];
+    const int *src = (const int *)&stats;
+    int *dst = (int *)&record->stats;
+    uint32_t sequence = __atomic_load_n(&record->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&record->sequence, sequence + 1, __ATOMIC_RELAXED);
+    for(size_t i = 0; i < sizeof(NexStatsSnapshot) / sizeof(int); i++)
+        __atomic_store_n(&dst[i], src[i], __ATOMIC_RELEASE);
+    __atomic_store_n(&record->sequence, sequence + 2, __ATOMIC_RELEASE);
+    statsGeneration.fetch_add(1, std::memory_order_release);
+}
+
+static bool NexReadStats(int index, NexStatsSnapshot &stats) {
+    const NexStatsRecord *record = &statsRecords[index];
+    const int *src = (const int *)&record->stats;
+    int *dst = (int *)&stats;
+    for(;;){
+        uint32_t before = __atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE);
+        if(before & 1)
+            continue;
+        for(size_t i = 0; i < sizeof(NexStatsSnapshot) / sizeof(int); i++)
+            dst[i] = __atomic_load_n(&src[i], __ATOMIC_ACQUIRE);
+        if(__atomic_load_n(&record->sequence, __ATOMIC_RELAXED) == before)
+            return before > 0;
+    }
+}
+
+// Track/stream catalog and its string table, rebuilt on every content-info update. Records of
+// one instance and kind are contiguous, so every getter is an index into a flat array.
+// Two fixed-capacity arenas that are never freed: a rebuild rewrites the one readers are not
+// using in place, so a pointer from GetRegion or GetStreamName never dangles. catalogGeneration
+// is odd while a rebuild is writing; the text behind a pointer is intact until the generation
+// has advanced by more than one from the value read with it. Content past capacity is dropped.
+#define CATALOG_MAX_STREAMS 256
+#define CATALOG_MAX_TRACKS 256
+#define CATALOG_STRING_BYTES 16384
+
+typedef struct {
+    NexStreamRecord streams[CATALOG_MAX_STREAMS];
+    NexTrackRecord tracks[CATALOG_MAX_TRACKS];
+    char strings[CATALOG_STRING_BYTES];
+    int streamTotal;
+    int trackTotal;
+    int stringBytes;
+    std::unordered_map<std::string, int32_t> interned;
+    std::unordered_map<uint64_t, int32_t> streamById;  // NexCatalogKey -> streamIndex
+    int streamStart[8][2];
+    int streamCount[8][2];
+    int trackStart[8];
+    int trackCount[8];
+} NexCatalogBuffer;
+
+NexCatalogBuffer catalogBuffers[2];
+std::atomic<uint32_t> catalogGeneration(0);
+std::mutex catalogLock;
+std::mutex catalogBuildLock;    // one rebuild at a time
+
+static uint64_t NexCatalogKey(int instance, int kind, uint32_t id) {
+    return ((uint64_t)instance << 40) | ((uint64_t)kind << 32) | id;
+}
+
+static int32_t NexInternString(NexCatalogBuffer &buffer, NSString *string) {
+    if(string == nil)
+        return -1;
+    std::string utf8([string UTF8String]);
+    // Names repeat across instances showing the same content; reuse an identical entry.
+    auto found = buffer.interned.find(utf8);
+    if(found != buffer.interned.end())
+        return found->second;
+    if(buffer.stringBytes + (int)utf8.size() + 1 > CATALOG_STRING_BYTES)
+        return -1;
+    int32_t offset = buffer.stringBytes;
+    memcpy(&buffer.strings[offset], utf8.c_str(), utf8.size() + 1);
+    buffer.stringBytes += (int)utf8.size() + 1;
+    buffer.interned.emplace(utf8, offset);
+    return offset;
+}
+
+static NexCatalogBuffer &NexCatalogAt(uint32_t generation) {
+    return catalogBuffers[(generation >> 1) & 1];
+}
+
+static const NexCatalogBuffer &NexActiveCatalog() {
+    return NexCatalogAt(catalogGeneration.load(std::memory_order_acquire));
+}
+
+// Caller holds catalogBuildLock. Marks the build in progress and hands out the arena the
+// current generation is not using, emptied.
+static NexCatalogBuffer &NexBeginCatalog() {
+    std::lock_guard<std::mutex> lock(catalogLock);
+    uint32_t generation = catalogGeneration.load(std::memory_order_relaxed) + 1;
+    catalogGeneration.store(generation, std::memory_order_release);
+    NexCatalogBuffer &buffer = NexCatalogAt(generation + 1);
+    buffer.streamTotal = 0;
+    buffer.trackTotal = 0;
+    buffer.stringBytes = 0;
+    buffer.interned.clear();
+    buffer.streamById.clear();
+    return buffer;
+}
+
+// Caller holds catalogBuildLock; makes the arena from NexBeginCatalog the active one.
+static void NexPublishCatalog() {
+    std::lock_guard<std::mutex> lock(catalogLock);
+    catalogGeneration.store(catalogGeneration.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// Callers hold catalogLock.
+static const NexStreamRecord *NexCatalogStream(int instance, int kind, int index) {
+    if(instance < 0 || instance >= 8 || kind < NEXUNITY_STREAM_AUDIO || kind > NEXUNITY_STREAM_TEXT)
+        return NULL;
+    const NexCatalogBuffer &catalog = NexActiveCatalog();
+    if(index < 0 || index >= catalog.streamCount[instance][kind])
+        return NULL;
+    return &catalog.streams[catalog.streamStart[instance][kind] + index];
+}
+
+static const char *NexCatalogString(int32_t offset) {
+    const NexCatalogBuffer &catalog = NexActiveCatalog();
+    if(offset < 0 || offset >= catalog.stringBytes)
+        return "";
+    return &catalog.strings[offset];
+}
+
+// strdup'd copy for the legacy exports, whose C# side frees the returned string.
+static char *NexCatalogStringCopy(int instance, int kind, int index, bool language) {
+    std::lock_guard<std::mutex> lock(catalogLock);
+    const NexStreamRecord *stream = NexCatalogStream(instance, kind, index);
+    if(stream == NULL)
+        return strdup("");
+    return strdup(NexCatalogString(language ? stream->languageOffset : stream->nameOffset));
+}
+
+// CEA-608 grids. captionShadow is the writer's own copy used to find changed rows, so the
+// shared grid is only touched for rows that differ.
+NexCaptionGrid captionGrids[8];
+NexCaptionCell captionShadow[8][NEXPLAYER_CEA608_ROWS * NEXPLAYER_CEA608_COLS];
+std::mutex captionGridLock;
+id<NXPlayerCEA608CaptionUpdateReceiver> viewCaptionReceivers[8];   // the player view's, while the grid has the captions
+
+static void NexStoreCaptionRow(NexCaptionGrid *grid, int row, const NexCaptionCell *cells) {
+    // Cells are three 16-bit words; store them as such so readers never see a torn word.
+    const uint16_t *src = (const uint16_t *)cells;
+    uint16_t *dst = (uint16_t *)&grid->cells[row * NEXPLAYER_CEA608_COLS];
+    for(size_t i = 0; i < NEXPLAYER_CEA608_COLS * sizeof(NexCaptionCell) / sizeof(uint16_t); i++)
+        __atomic_store_n(&dst[i], src[i], __ATOMIC_RELAXED);
+}
+
+std::shared_ptr<const NexSubtitleTrack> externalSubtitles[8];
+std::mutex externalSubtitleLock;
+std::atomic<bool> externalSubtitlesOn(true);    // written from Unity, read on playhead callbacks
+
+static std::shared_ptr<const NexSubtitleTrack> NexExternalSubtitles(int index) {
+    std::lock_guard<std::mutex> lock(externalSubtitleLock);
+    return index >= 0 && index < 8 ? externalSubtitles[index] : nullptr;
+}
+
+// Playhead records Unity reads straight from memory instead of waiting for NEXUNITY_EVENT_TIME.
+// Writers of one record serialise on playheadLock; readers only use atomic loads.
+NexPlayheadRecord playheadRecords[8];
+std::mutex playheadLock;
+std::atomic<uint32_t> playheadGeneration(0);
+bool timeEventsEnabled = true;
+
+// state < 0 and rate <= 0 keep the current value.
+static void NexPublishPlayhead(int index, int64_t ptsMs, int state, float rate) {
+    if(index < 0 || index >= 8)
+        return;
+    NexPlayheadRecord *record = &playheadRecords[index];
+    std::lock_guard<std::mutex> lock(playheadLock);
+    if(rate <= 0){
+        float current;
+        __atomic_load(&record->rate, &current, __ATOMIC_RELAXED);
+        if(current <= 0)
+            rate = 1.0f;
+    }
+    uint32_t sequence = __atomic_load_n(&record->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&record->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&record->ptsMs, ptsMs, __ATOMIC_RELEASE);
+    __atomic_store_n(&record->monotonicUs, NexMonotonicUs(), __ATOMIC_RELEASE);
+    if(state >= 0)
+        __atomic_store_n(&record->state, (int32_t)state, __ATOMIC_RELEASE);
+    if(rate > 0)
+        __atomic_store(&record->rate, &rate, __ATOMIC_RELEASE);
+    __atomic_store_n(&record->sequence, sequence + 2, __ATOMIC_RELEASE);
+    playheadGeneration.fetch_add(1, std::memory_order_release);
+}
+
+// Position of the instance at monotonicUs, extrapolated from the last published sample; -1 if none.
+static int64_t NexInterpolatePlayhead(int index, int64_t monotonicUs) {
+    if(index < 0 || index >= 8)
+        return -1;
+    const NexPlayheadRecord *record = &playheadRecords[index];
+    int64_t ptsMs, sampledUs;
+    int32_t state;
+    float rate;
+    for(;;){
+        uint32_t before = __atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE);
+        if(before & 1)
+            continue;
+        ptsMs = __atomic_load_n(&record->ptsMs, __ATOMIC_ACQUIRE);
+        sampledUs = __atomic_load_n(&record->monotonicUs, __ATOMIC_ACQUIRE);
+        state = __atomic_load_n(&record->state, __ATOMIC_ACQUIRE);
+        __atomic_load(&record->rate, &rate, __ATOMIC_ACQUIRE);
+        if(__atomic_load_n(&record->sequence, __ATOMIC_RELAXED) == before)
+            break;
+    }
+    if(sampledUs == 0)
+        return -1;
+    if(state != NXPlayerStatePlay || monotonicUs <= sampledUs)
+        return ptsMs;
+    return ptsMs + (int64_t)((monotonicUs - sampledUs) * (double)rate / 1000.0);
+}
 NSMutableArray* m_AdditionalHeaders1 = [[NSMutableArray alloc] init];
 NSMutableArray* m_AdditionalHeaders2 = [[NSMutableArray alloc] init];
 NSMutableArray* m_AdditionalHeaders3 = [[NSMutableArray alloc] init];
@@ -247,13 +1094,463 @@ NSMutableArray* m_AdditionalHeaders5 = [[NSMutableArray alloc] init];
 NSMutableArray* m_AdditionalHeaders6 = [[NSMutableArray alloc] init];
 NSMutableArray* m_AdditionalHeaders7 = [[NSMutableArray alloc] init];
 NSMutableArray* m_AdditionalHeaders8 = [[NSMutableArray alloc] init];
-bool hasAdditionalHttpHeader[8];
 
 NXPlayer* multiPlayers[8];
 NXPlayerView* multiViews[8];
 NexVideoTextureReceiver* multiReceiver[8];
 //End multi-instance martin 14012020
 
+//Trick play
+// One session per preview instance. The preview instance is switched to the I-frame
+// rendition and paused; the timer then advances a virtual playhead and issues at most
+// one keyframe seek in flight, at no more than trickPlayMaxFps seeks per second.
+#define TRICKPLAY_MIN_SPEED 2
+#define TRICKPLAY_MAX_SPEED 32
+
+#define TRICKPLAY_SEEK_TIMEOUT_MS 1000
+
+typedef struct {
+    bool active;
+    int playbackIndex;      // instance that lands on the final position
+    int speed;              // signed playback multiplier, 0 while scrubbing
+    int startMs;            // playback position when trick play began
+    int positionMs;         // virtual trick-play playhead
+    int lastIssuedMs;
+    bool seekInFlight;
+    int inFlightMs;         // time the outstanding keyframe seek has been pending
+    bool wasPlaying;
+    NSUInteger restoreBW;   // track bandwidth to go back to when ABR is off
+} NexTrickPlaySession;
+
+NexTrickPlaySession trickPlay[8];
+std::mutex trickPlayLock;
+int trickPlayMaxFps = 8;
+dispatch_queue_t trickPlayQueue = nil;
+dispatch_source_t trickPlayTimer = nil;
+bool trickPlayTimerRunning = false;
+//End trick play
+
+//Sync group
+// Members are clocked against a group clock anchored at a common PTS. Small drift is
+// trimmed with playback-rate nudges, large drift with a seek ahead of the clock.
+#define SYNCGROUP_TICK_MS 100
+
+typedef enum {
+    SYNCGROUP_IDLE = 0,
+    SYNCGROUP_OPENING,
+    SYNCGROUP_SEEKING,
+    SYNCGROUP_RUNNING,
+    SYNCGROUP_PAUSED
+} NexSyncGroupPhase;
+
+typedef struct {
+    bool member;
+    bool ready;
+    bool seekPending;
+    bool buffering;
+    float rate;
+    float driftMs;          // smoothed member PTS minus group clock
+} NexSyncMember;
+
+typedef struct {
+    NexSyncGroupPhase phase;
+    NexSyncMember members[8];
+    bool autoStart;
+    bool resumeAfterSeek;
+    int pendingSeeks;
+    int64_t anchorPtsMs;
+    int64_t anchorMonoUs;
+    bool clockRunning;
+    int nudgeThresholdMs;
+    int seekThresholdMs;
+    int seekLeadMs;
+    int correctionWindowMs;
+    float maxRateNudge;
+    bool holdForBuffering;  // clock frozen and members paused while one of them rebuffers
+} NexSyncGroup;
+
+NexSyncGroup syncGroup = { SYNCGROUP_IDLE, {}, false, false, 0, 0, 0, false, 10, 1000, 250, 1000, 0.05f, false };
+std::mutex syncGroupLock;
+dispatch_queue_t syncGroupQueue = nil;
+dispatch_source_t syncGroupTimer = nil;
+bool syncGroupTimerRunning = false;
+
+// Caller holds syncGroupLock.
+static int64_t NexSyncGroupClockMs(int64_t nowUs) {
+    if(!syncGroup.clockRunning)
+        return syncGroup.anchorPtsMs;
+    return syncGroup.anchorPtsMs + (nowUs - syncGroup.anchorMonoUs) / 1000;
+}
+//End sync group
+
+//Live latency
+// Latency is measured as wall clock minus the EXT-X-PROGRAM-DATE-TIME of the rendered frame
+// when the stream carries one, otherwise as the distance from the live edge of the seekable range.
+// The controller holds the target with a playback-rate band and jumps to live past a threshold.
+#define LATENCY_TICK_MS 250
+#define LATENCY_SAMPLES 512
+#define LATENCY_JUMP_COOLDOWN_MS 5000
+
+typedef struct {
+    bool enabled;
+    int targetMs;
+    int latencyMs;          // -1 until the first measurement
+    bool fromPDT;
+    float rate;
+    int64_t lastJumpUs;
+    int jumps;
+    int sampleCount;
+    int sampleHead;
+    int samples[LATENCY_SAMPLES];
+    char pdtText[64];       // last PDT string and its parsed epoch, parsing is only redone on change
+    int64_t pdtEpochMs;
+} NexLatencyControl;
+
+NexLatencyControl latencyControl[8];
+std::mutex latencyLock;
+float latencyMinRate = 0.95f;
+float latencyMaxRate = 1.10f;
+int latencyDeadbandMs = 250;
+int latencyJumpThresholdMs = 8000;
+int latencyCorrectionWindowMs = 10000;
+dispatch_queue_t latencyQueue = nil;
+dispatch_source_t latencyTimer = nil;
+bool latencyTimerRunning = false;
+//End live latency
+
+//Command worker
+// Control calls run on a serial worker queue instead of the calling (Unity) thread.
+// Every command gets a token; a newer open/close/stop or seek cancels older ones still queued,
+// and a newer open also aborts an open that is still waiting for its async completion.
+// COMMAND_REOPEN is the stall watchdog's close and open of one instance: it gives way to any
+// open/close/stop of the app issued after it, and never cancels one itself.
+#define COMMAND_HISTORY 64
+
+typedef enum {
+    COMMAND_OPEN = 0,
+    COMMAND_CLOSE,
+    COMMAND_STOP,
+    COMMAND_SEEK,
+    COMMAND_START,
+    COMMAND_PAUSE,
+    COMMAND_RESUME,
+    COMMAND_REOPEN      // arg: latestLifecycleToken when the watchdog issued it
+} NexCommandKind;
+
+typedef struct {
+    int token;
+    int kind;
+    int index;
+    int arg;
+    int status;
+    int result;
+} NexCommandRecord;
+
+NexCommandRecord commandHistory[COMMAND_HISTORY];
+int nextCommandToken = 1;
+int latestLifecycleToken = 0;   // newest open/close/stop
+int latestSeekToken = 0;
+int awaitingOpenToken = 0;      // open issued, completedAsyncCmdOpen not received yet
+int awaitingSeekToken = 0;
+int awaitingSeekIndex = -1;
+std::mutex commandLock;
+
+static char commandQueueKey;
+
+// Serial queue the command worker runs on, created once on first use from any thread.
+static dispatch_queue_t NexCommandQueue() {
+    static dispatch_queue_t queue = nil;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        queue = dispatch_queue_create("com.nexplayer.unity.command", DISPATCH_QUEUE_SERIAL);
+        dispatch_queue_set_specific(queue, &commandQueueKey, &commandQueueKey, NULL);
+    });
+    return queue;
+}
+
+// True on the worker itself, e.g. in a listener called from a command it runs.
+static bool NexOnCommandQueue() {
+    return dispatch_get_specific(&commandQueueKey) == &commandQueueKey;
+}
+
+// Caller holds commandLock.
+static NexCommandRecord *NexCommandRecordFor(int token) {
+    NexCommandRecord *record = &commandHistory[token % COMMAND_HISTORY];
+    return record->token == token ? record : NULL;
+}
+
+// Caller holds commandLock. Hands out the token of a new command and makes it the latest of its kind.
+static int NexRegisterCommand(int kind, int index, int arg) {
+    int token = nextCommandToken++;
+    NexCommandRecord record = { token, kind, index, arg, NEXUNITY_COMMAND_PENDING, 0 };
+    commandHistory[token % COMMAND_HISTORY] = record;
+    if(kind == COMMAND_SEEK)
+        latestSeekToken = token;
+    else if(kind == COMMAND_OPEN || kind == COMMAND_CLOSE || kind == COMMAND_STOP)
+        latestLifecycleToken = token;
+    return token;
+}
+
+// Per-instance mirror of NXPlayerState, updated from didChangeFromState. Commands are checked
+// against fsmActions before they reach the SDK; opening covers Close/Stop while an open is in flight.
+// target is the state an accepted pause/resume/start/stop is driving toward; it stands in for state
+// until the callback confirms it, so a resume issued right after a pause is not dropped as a no-op.
+#define FSM_STATE_OPENING 5
+
+typedef enum {
+    FSM_ALLOW = 0,
+    FSM_NOOP,           // already in the requested state, dropped
+    FSM_REJECT,         // invalid in this state, failed without an SDK call
+    FSM_DEFER,          // replayed once the open completes
+    FSM_AS_START,
+    FSM_AS_RESUME
+} NexFSMAction;
+
+// Deferred commands wait in one slot per class, so a pause deferred after a seek does not cancel it;
+// a newer command only replaces one of its own class. The slots are replayed in issue order.
+typedef enum {
+    FSM_DEFER_SEEK = 0,
+    FSM_DEFER_TOGGLE,   // pause/resume
+    FSM_DEFER_START,
+    FSM_DEFER_SLOTS
+} NexFSMDeferClass;
+
+static int NexDeferClass(int kind) {
+    switch(kind){
+        case COMMAND_SEEK:   return FSM_DEFER_SEEK;
+        case COMMAND_PAUSE:
+        case COMMAND_RESUME: return FSM_DEFER_TOGGLE;
+        default:             return FSM_DEFER_START;
+    }
+}
+
+//                                            None        Close       Stop          Play        Pause           Opening
+static const NexFSMAction fsmActions[5][6] = {
+    /* COMMAND_STOP   */                    { FSM_REJECT, FSM_REJECT, FSM_NOOP,     FSM_ALLOW,  FSM_ALLOW,      FSM_ALLOW },
+    /* COMMAND_SEEK   */                    { FSM_REJECT, FSM_REJECT, FSM_REJECT,   FSM_ALLOW,  FSM_ALLOW,      FSM_DEFER },
+    /* COMMAND_START  */                    { FSM_REJECT, FSM_REJECT, FSM_ALLOW,    FSM_NOOP,   FSM_AS_RESUME,  FSM_DEFER },
+    /* COMMAND_PAUSE  */                    { FSM_REJECT, FSM_REJECT, FSM_NOOP,     FSM_ALLOW,  FSM_NOOP,       FSM_DEFER },
+    /* COMMAND_RESUME */                    { FSM_REJECT, FSM_REJECT, FSM_AS_START, FSM_NOOP,   FSM_ALLOW,      FSM_DEFER }
+};
+
+typedef struct {
+    bool known;             // state seeded from the player on first use
+    bool opening;
+    int state;
+    int target;             // pending NXPlayerState of the last accepted command, 0 when none
+    int queuedToggleToken;  // pause/resume still in the worker queue, for coalescing
+    int deferredTokens[FSM_DEFER_SLOTS];
+    int avoidedCalls;
+} NexPlayerFSM;
+
+NexPlayerFSM playerFSM[8];
+//End command worker
+
+//Manifest index
+// Indexes are replaced whole by a load and changed in place when a media playlist is attached
+// or a live playlist reloaded; readers hold manifestLock for the duration of a lookup. Loads of
+// an instance are serialised on its manifestLoadLocks entry (taken before manifestLock), so a
+// load may read the index it diffs against without manifestLock and take it only to publish.
+std::unique_ptr<NexManifestIndex> manifestIndexes[8];
+std::mutex manifestLock;
+std::mutex manifestLoadLocks[8];
+std::atomic<uint32_t> manifestGeneration(0);
+int manifestWindows[8];         // segments kept per rendition, 0 for all listed
+
+// Callers hold manifestLock.
+static NexManifestIndex *NexManifestLocked(int index) {
+    return index >= 0 && index < 8 ? manifestIndexes[index].get() : NULL;
+}
+//End manifest index
+
+//Device profile
+// Video renditions an instance's device cannot use are cut out of its manifests before the SDK
+// sees them: the bridge is each player's NXManifestAndPlaylistDescrambler, which is handed every
+// top-level MPD and playlist to change in place and never longer than it came (the rewrite is in
+// NexDeviceProfile.h).
+std::mutex profileLock;
+NexDeviceProfile deviceProfiles[8];
+bool hasDeviceProfile[8];
+NexManifestRewriteInfo rewriteInfos[8];
+//End device profile
+
+//CDN steering
+// Each instance's requests are steered between equivalent CDN locations by a NexCdnSteering
+// (NexCdnSteering.h), fed from nexPlayer:onModifyHttpRequest: and the HTTP state callbacks.
+std::mutex steeringLock;
+NexCdnSteering cdnSteering[8];
+//End CDN steering
+
+//Stall watchdog
+// An instance left in NXPlayerStatePlay whose position, buffer level and HTTP traffic have all
+// stood still for their windows is stalled. The watchdog then takes the NexPlayerRECOVERY_ACTION
+// steps in order, one per watchdogStepMs while the position stays frozen, and starts over after
+// the reopen. The time to recover runs from the last position change to the next.
+#define WATCHDOG_TICK_MS 500
+#define WATCHDOG_ACTIONS 4
+#define WATCHDOG_BUFFER_EPSILON_MS 100     // buffer level jitter that is neither draining nor filling
+
+typedef struct {
+    bool enabled;
+    int64_t ptsMs;              // last observed position and buffer level, and when each last moved
+    int64_t bufferMs;
+    int64_t ptsMovedUs;
+    int64_t bufferMovedUs;
+    int64_t stallStartUs;       // 0 while no stall is in progress
+    int64_t actionUs;
+    int nextAction;
+    int lastAction;             // -1 when none was taken in the stall in progress
+    bool reopening;             // a reopen is in flight and resumes at resumeMs (-1: live, no position)
+    int64_t resumeMs;
+    int64_t recoveredTotalUs;
+    NexRecoveryStats stats;
+} NexWatchdog;
+
+static void NexResetWatchdog(NexWatchdog &watchdog, int64_t nowUs) {
+    bool enabled = watchdog.enabled;
+    watchdog = NexWatchdog();
+    watchdog.enabled = enabled;
+    watchdog.ptsMs = watchdog.bufferMs = -1;
+    watchdog.ptsMovedUs = watchdog.bufferMovedUs = nowUs;
+    watchdog.lastAction = -1;
+    watchdog.resumeMs = -1;
+    watchdog.stats.meanTimeToRecoverMs = -1;
+}
+
+// Feeds one observation of an instance to its watchdog. Returns the recovery action to take now,
+// or -1; *recoveredUs is set when a stall just ended with the position advancing.
+static int NexWatchdogObserve(NexWatchdog &watchdog, bool playing, int64_t ptsMs, int64_t bufferMs, int64_t httpUs,
+                              int64_t nowUs, int stallMs, int bufferWindowMs, int httpMs, int stepMs, int64_t *recoveredUs) {
+    *recoveredUs = 0;
+    int64_t stallUs = (int64_t)stallMs * 1000, bufferUs = (int64_t)bufferWindowMs * 1000, quietUs = (int64_t)httpMs * 1000;
+    int64_t stepUs = (int64_t)stepMs * 1000;
+    if(llabs(bufferMs - watchdog.bufferMs) > WATCHDOG_BUFFER_EPSILON_MS){
+        watchdog.bufferMs = bufferMs;
+        watchdog.bufferMovedUs = nowUs;
+    }
+    if(ptsMs != watchdog.ptsMs){
+        bool first = watchdog.ptsMs < 0;
+        watchdog.ptsMs = ptsMs;
+        if(watchdog.stallStartUs != 0 && playing && !first){
+            *recoveredUs = nowUs - watchdog.stallStartUs;
+            NexRecoveryStats &stats = watchdog.stats;
+            stats.recoveries++;
+            watchdog.recoveredTotalUs += *recoveredUs;
+            stats.meanTimeToRecoverMs = (int32_t)(watchdog.recoveredTotalUs / stats.recoveries / 1000);
+            stats.lastTimeToRecoverMs = (int32_t)(*recoveredUs / 1000);
+            stats.maxTimeToRecoverMs = std::max(stats.maxTimeToRecoverMs, stats.lastTimeToRecoverMs);
+            watchdog.stallStartUs = 0;
+        }
+        watchdog.ptsMovedUs = nowUs;
+    }
+
+    if(!playing){
+        // Paused or stopped by the app: nothing is stalled. Opening after a reopen is given its step.
+        if(watchdog.stallStartUs != 0 && nowUs - watchdog.actionUs > stepUs){
+            watchdog.stats.unrecovered++;
+            watchdog.stallStartUs = 0;
+        }
+        if(watchdog.stallStartUs == 0){
+            watchdog.ptsMovedUs = watchdog.bufferMovedUs = nowUs;
+            watchdog.stats.stalledMs = 0;
+        }
+        return -1;
+    }
+
+    if(watchdog.stallStartUs == 0){
+        if(nowUs - watchdog.ptsMovedUs < stallUs || nowUs - watchdog.bufferMovedUs < bufferUs || nowUs - httpUs < quietUs){
+            watchdog.stats.stalledMs = 0;
+            return -1;
+        }
+        watchdog.stallStartUs = watchdog.ptsMovedUs;
+        watchdog.nextAction = 0;
+        watchdog.lastAction = -1;
+        watchdog.stats.stalls++;
+    } else if(nowUs - watchdog.actionUs < stepUs){
+        watchdog.stats.stalledMs = (int32_t)((nowUs - watchdog.stallStartUs) / 1000);
+        return -1;
+    }
+    watchdog.stats.stalledMs = (int32_t)((nowUs - watchdog.stallStartUs) / 1000);
+
+    if(watchdog.nextAction >= WATCHDOG_ACTIONS){
+        // Still frozen a step after the reopen: this stall is lost, the next one starts over.
+        watchdog.stats.unrecovered++;
+        watchdog.stallStartUs = 0;
+        watchdog.stats.stalledMs = 0;
+        watchdog.ptsMovedUs = watchdog.bufferMovedUs = nowUs;
+        return -1;
+    }
+    int action = watchdog.nextAction++;
+    watchdog.lastAction = action;
+    watchdog.actionUs = nowUs;
+    watchdog.stats.actions[action]++;
+    return action;
+}
+
+NexWatchdog stallWatchdog[8];
+std::mutex watchdogLock;
+std::atomic<int64_t> watchdogHttpUs[8];     // last HTTP activity, from the statistics API callbacks
+NSString *watchdogPaths[8];                 // what instance 0 was opened with; the others use multiPaths
+int watchdogStallMs = 4000;
+int watchdogBufferMs = 4000;
+int watchdogHttpMs = 4000;
+int watchdogStepMs = 5000;
+dispatch_queue_t watchdogQueue = nil;
+dispatch_source_t watchdogTimer = nil;
+bool watchdogTimerRunning = false;
+//End stall watchdog
+
+//Resilience
+// Errors of an instance with a resilience policy are classified before they reach the app.
+// Retryable ones are absorbed: after an exponential backoff with jitter the instance reconnects,
+// or reopens at its position if the SDK already stopped it. HTTP errors of one segment URL are
+// left to the SDK until they pass segmentRetries, and then count like an error. Fatal errors, and
+// retryable ones once sessionRetries are spent, reach the app as before. The policy is in
+// NexResilience.h and sees only the NexPlayerERROR_CLASS of an error.
+static int NexClassifyError(uint32_t code) {
+    if((code & 0xFFFF0000) == NXErrorHTTPStatusCode){
+        uint32_t status = code & 0xFFFF;
+        return status >= 500 || status == 408 || status == 429 ? NEXUNITY_ERROR_RETRYABLE : NEXUNITY_ERROR_FATAL;
+    }
+    switch(code){
+        case NXErrorMediaOpenTimeout:
+        case NXErrorDataInactivityTimeout:
+        case NXErrorNetworkProtocol:
+        case NXErrorNoDataInBuffer:
+        case NXErrorProtocolInvalidResponse:
+        case NXErrorProtocolNetOpenFail:
+        case NXErrorProtocolNetConnectFail:
+        case NXErrorProtocolNetBindFail:
+        case NXErrorProtocolNetDNSFail:
+        case NXErrorProtocolNetConnectionClosed:
+        case NXErrorProtocolNetSendFail:
+        case NXErrorProtocolNetRecvFail:
+        case NXErrorProtocolNetRequestTimeout:
+        case NXErrorDownloaderConnectionFail:
+        case NXErrorDownloaderConnectionClosed:
+        case NXErrorDownloadFailure:
+            return NEXUNITY_ERROR_RETRYABLE;
+        default:
+            return NEXUNITY_ERROR_FATAL;
+    }
+}
+
+NexResilience resilience[8];
+std::mutex resilienceLock;
+std::atomic<bool> resilienceFailing[8];    // a failure is in progress, checked on every playhead update
+dispatch_queue_t resilienceQueue = nil;
+//End resilience
+
+//Header store
+// Headers and query tokens an instance's requests carry from now on, replaceable while it plays,
+// for signed CDN tokens that expire for instance. The SDK only adds headers, so they are applied
+// in nexPlayer:onModifyHttpRequest:. Every change publishes a new immutable set (NexHeaderStore.h)
+// and the hook applies the one current when the request is made, whole: a request never mixes two
+// generations, and one already sent keeps what it had.
+std::mutex headerStoreLock;
+std::shared_ptr<const NexHeaderSet> headerStores[8];
+//End header store
+
 - (NXPlayer *) player {
     int _multInt = 0;
 
@@ -266,6 +1563,25 @@ NexVideoTextureReceiver* multiReceiver[8];
     return player;
 }
 
+- (NXPlayer *) playerAtIndex:(int)index {
+    if(index == 0)
+        return self.player;
+    if(index > 0 && index < self.multiStreamScreens && index < 8)
+        return multiPlayers[index];
+    return nil;
+}
+
+- (int) indexOfPlayer:(NXPlayer *)nxplayer {
+    if(nxplayer == nil)
+        return -1;
+    if(nxplayer == self.player)
+        return 0;
+    for(int i = 1; i < self.multiStreamScreens && i < 8; i++)
+        if(multiPlayers[i] == nxplayer)
+            return i;
+    return -1;
+}
+
 #pragma mark - NexPlayer utility methods
 #ifdef NEXPLAYER
 - (void)setupForDRM {
@@ -302,6 +1618,8 @@ NSString* datFileString;
     [[AVAudioSession sharedInstance] setCategory: AVAudioSessionCategoryPlayback error:NULL];
 
     [self setPlayersEnabledABRWithProperty];
+    [self applyConfig:0];
+    [self resetResilienceSession:0];
 
     m_isClose = NO;
 #ifdef NEXPLAYER
@@ -348,6 +1666,7 @@ NSString* datFileString;
             [self.plugins sender:self event:NexPlayerPluginEventPlaybackWillOpen userInfo:fullInfo];
         } else
             [self Log:4 toValue:@"OpenPlayer could not find local file: " value5: path];
+        watchdogPaths[0] = path;
         if(self.multiStreamScreens > 1){ //multi stream startup
             return [self.player open:multiPaths[0]
                                 mode:NXOpenModeAuto
@@ -368,6 +1687,7 @@ NSString* datFileString;
 
 - (int)openFD:(NSString *)fileName {
     [self setPlayersEnabledABRWithProperty];
+    [self applyConfig:0];
 
     m_isClose = NO;
 #ifdef NEXPLAYER
@@ -388,7 +1708,7 @@ NSString* datFileString;
         return result;
     } else {
         if(g_playerListener)
-            g_playerListener(NEXUNITY_EVENT_ERROR,NXErrorMediaNotFound,0,0,0,0);
+            NexPostEvent(NEXUNITY_EVENT_ERROR,NXErrorMediaNotFound,0,0,0,0);
         return -1;
     }
 }
@@ -418,8 +1738,10 @@ NSString* datFileString;
                 }
             }
 
-            if(self.playerView == nil)
+            if(self.playerView == nil){
                 self.playerView = [[NXPlayerView alloc] initWithFrame: bounds];
+                appliedConfigValid[0] = false;
+            }
 
             if(self.playerView != nil && self.playerView.player != nil){
                 self.playerView.autoresizingMask = UIViewAutoresizingFlexibleWidth|UIViewAutoresizingFlexibleHeight;
@@ -427,6 +1749,7 @@ NSString* datFileString;
                 self.playerView.autoScaling = NXScale_FitInView;
                 self.player.delegate = self;
                 self.player.ABRDelegate = self;
+                self.player.manifestAndPlaylistDescrambler = self;
 
                 // set player preferecne
                 [self setProperties];
@@ -458,30 +1781,33 @@ NSString* datFileString;
                         }
                     }
                     if(m_AdditionalHeaders5 != nil){
-                        for(NSString *header in m_AdditionalHeaders3){
+                        for(NSString *header in m_AdditionalHeaders5){
                             [multiPlayers[4] addHTTPHeaderFields:header];
                         }
                     }
                     if(m_AdditionalHeaders6 != nil){
-                        for(NSString *header in m_AdditionalHeaders4){
+                        for(NSString *header in m_AdditionalHeaders6){
                             [multiPlayers[5] addHTTPHeaderFields:header];
                         }
                     }
                     if(m_AdditionalHeaders7 != nil){
-                        for(NSString *header in m_AdditionalHeaders3){
+                        for(NSString *header in m_AdditionalHeaders7){
                             [multiPlayers[6] addHTTPHeaderFields:header];
                         }
                     }
                     if(m_AdditionalHeaders8 != nil){
-                        for(NSString *header in m_AdditionalHeaders4){
+                        for(NSString *header in m_AdditionalHeaders8){
                             [multiPlayers[7] addHTTPHeaderFields:header];
                         }
                     }
                 }
 
                 [[self player] setProperty:NXPropertySetHWdecoderPixelFormat toValue:PIXEL_FORMAT_32BGRA];
+                // Requests pass through onModifyHttpRequest for CDN steering and the header store; untouched ones come back as they were.
+                [[self player] setProperty:NXPropertyEnableModifyHTTPRequest toValue:1];
 
                 self.statisticsAPI = [[NXStatisticsAPI alloc] initWithPlayer:self.player];
+                self.statisticsAPI.httpStateDelegate = self;
 
                 if(self.multiStreamScreens < 2){
                     self.textureReceiver = [NexVideoTextureReceiver receiverWithPlayer:self.player
@@ -542,10 +1868,8 @@ NSString* datFileString;
  return result;
  }*/
 
--(void)startPlayer:(int)msec {
-    if(self.player) {
-        [self.player startFromTime:msec];
-    }
+-(int)startPlayer:(int)msec {
+    return [self enqueueCommand:COMMAND_START index:0 arg:msec work:nil];
 }
 
 -(void)startPlayer:(int)msec pauseAfterReady:(bool) pause{
@@ -553,55 +1877,20 @@ NSString* datFileString;
         [self.player startFromTime:msec pauseAfterReady:pause];
 }
 
-- (void)pausePlayer {
-    if(chosenPlayerMulti == 0){
-        NXError result = [self.player pause];
-        if (result != PLAYER_ERROR_NONE)
-            [self nexPlayer:self.player encounteredError:result];
-    }
-    else
-        [multiViews[chosenPlayerMulti].player pause];
+- (int)pausePlayer {
+    return [self enqueueCommand:COMMAND_PAUSE index:(int)chosenPlayerMulti arg:0 work:nil];
 }
 
-- (void)resumePlayer {
-    if(chosenPlayerMulti == 0){
-        NXError result = [self.player resume];
-        if (result != PLAYER_ERROR_NONE)
-            [self nexPlayer:self.player encounteredError:result];
-    }
-    else{
-        if(multiViews[chosenPlayerMulti].player.state == NXPlayerStatePause)
-            [multiViews[chosenPlayerMulti].player resume];
-        else
-            [multiViews[chosenPlayerMulti].player start];
-    }
-}
-- (void)seekPlayerToTime:(int)msec {
-    if(chosenPlayerMulti == 0) {
-        NXError result = [self.player seekTo:msec];
-        if (result != PLAYER_ERROR_NONE)
-            [self nexPlayer:self.player encounteredError:result];
-    }
-    else{
-        NXPlayerState state = multiViews[chosenPlayerMulti].player.state;
-        if(state == NXPlayerStatePlay || state == NXPlayerStatePause)
-            [multiViews[chosenPlayerMulti].player seekTo:msec];
-    }
+- (int)resumePlayer {
+    return [self enqueueCommand:COMMAND_RESUME index:(int)chosenPlayerMulti arg:0 work:nil];
 }
 
-- (void)stopPlayer {
-    if(self.player){
-        if([self.player state] == NXPlayerStateStop){ // manually handling stop while the player is stopped since the native stop doesn't return the error
-            [self nexPlayer:self.player encounteredError:NXErrorOperationNotValidInCurrentState];
-        }
-        NXError result = [self.player stop];
-        if (result != PLAYER_ERROR_NONE)
-            [self nexPlayer:self.player encounteredError:result];
+- (int)seekPlayerToTime:(int)msec {
+    return [self enqueueCommand:COMMAND_SEEK index:(int)chosenPlayerMulti arg:msec work:nil];
+}
 
-        for(int i = 1; i < self.multiStreamScreens;i++){
-            [multiPlayers[i] stop];
-        }
-    }
+- (int)stopPlayer {
+    return [self enqueueCommand:COMMAND_STOP index:0 arg:0 work:nil];
 }
 
 #ifdef NEXPLAYER
@@ -634,6 +1923,25 @@ NSString* datFileString;
     for(int i = 1; i < self.multiStreamScreens;i++){
         [multiPlayers[i] close];
     }
+    for(int i = 0; i < 8; i++)
+        [self resetTimeline:i];
+    {
+        // A parsed file belongs to the content it was loaded for.
+        std::lock_guard<std::mutex> lock(externalSubtitleLock);
+        for(int i = 0; i < 8; i++)
+            externalSubtitles[i].reset();
+    }
+    for(int i = 0; i < 8; i++){
+        std::lock_guard<std::mutex> load(manifestLoadLocks[i]);
+        std::unique_ptr<NexManifestIndex> closed;
+        std::lock_guard<std::mutex> lock(manifestLock);
+        closed.swap(manifestIndexes[i]);
+    }
+    {
+        std::lock_guard<std::mutex> lock(customTagLock);
+        for(int i = 0; i < 8; i++)
+            tagValueHashes[i].clear();
+    }
     NXPlayerState stateAfterClose = self.player.state;
 #ifdef NEXPLAYER
     if (stateAfterClose == NXPlayerStateClose) {
@@ -649,18 +1957,382 @@ NSString* datFileString;
             [self closePlayer];
     }
 }
+#pragma mark - Command worker
+
+-(int)enqueueCommand:(int)kind index:(int)index arg:(int)arg work:(int (^)(void))work {
+    int token;
+    int coalesced[2] = {0, 0};
+    bool done = false;
+    {
+        std::lock_guard<std::mutex> lock(commandLock);
+        token = NexRegisterCommand(kind, index, arg);
+
+        // A pause and a resume that meet before the worker ran the first one cancel each other;
+        // a repeated pause or resume replaces the queued one.
+        if((kind == COMMAND_PAUSE || kind == COMMAND_RESUME) && index >= 0 && index < 8){
+            NexPlayerFSM *fsm = &playerFSM[index];
+            int *slots[2] = { &fsm->queuedToggleToken, &fsm->deferredTokens[FSM_DEFER_TOGGLE] };
+            for(int i = 0; i < 2; i++){
+                NexCommandRecord *queued = *slots[i] != 0 ? NexCommandRecordFor(*slots[i]) : NULL;
+                if(queued == NULL || queued->status != NEXUNITY_COMMAND_PENDING || (queued->kind != COMMAND_PAUSE && queued->kind != COMMAND_RESUME))
+                    continue;
+                queued->status = NEXUNITY_COMMAND_CANCELLED;
+                coalesced[0] = *slots[i];
+                *slots[i] = 0;
+                fsm->avoidedCalls++;
+                if(queued->kind != kind){
+                    commandHistory[token % COMMAND_HISTORY].status = NEXUNITY_COMMAND_DONE;
+                    fsm->avoidedCalls++;
+                    coalesced[1] = token;
+                    done = true;
+                }
+                break;
+            }
+            if(!done)
+                fsm->queuedToggleToken = token;
+        }
+    }
+    if(coalesced[0] != 0)
+        [self finishCommand:coalesced[0] status:NEXUNITY_COMMAND_CANCELLED result:0];
+    if(done){
+        [self finishCommand:token status:NEXUNITY_COMMAND_DONE result:0];
+        return token;
+    }
+
+    __weak NexPlayerScripting *weakSelf = self;
+    dispatch_async(NexCommandQueue(), ^{
+        [weakSelf runCommand:token work:work];
+    });
+    return token;
+}
+
+// Blocking form for the legacy exports: the command takes its place behind the queued ones like any
+// other, and the caller waits for it and gets the SDK result instead of a token.
+-(int)performCommand:(int)kind index:(int)index arg:(int)arg work:(int (^)(void))work {
+    int token;
+    {
+        std::lock_guard<std::mutex> lock(commandLock);
+        token = NexRegisterCommand(kind, index, arg);
+    }
+    if(NexOnCommandQueue())
+        return [self runCommand:token work:work];
+    __block int result = PLAYER_ERROR_NONE;
+    dispatch_sync(NexCommandQueue(), ^{
+        result = [self runCommand:token work:work];
+    });
+    return result;
+}
+
+// Caller holds commandLock. seedState is the player's state read before the lock was taken, -1 when
+// there is no player; it only counts while the mirror has not been seeded yet.
+-(NexFSMAction)fsmAction:(int)kind index:(int)index seedState:(int)seedState {
+    int row;
+    switch(kind){
+        case COMMAND_STOP:   row = 0; break;
+        case COMMAND_SEEK:   row = 1; break;
+        case COMMAND_START:  row = 2; break;
+        case COMMAND_PAUSE:  row = 3; break;
+        case COMMAND_RESUME: row = 4; break;
+        default:
+            return FSM_ALLOW;
+    }
+    if(index < 0 || index >= 8)
+        return FSM_REJECT;
+    NexPlayerFSM *fsm = &playerFSM[index];
+    if(!fsm->known){
+        if(seedState < 0)
+            return FSM_REJECT;
+        fsm->state = seedState;
+        fsm->known = true;
+    }
+    int state = fsm->target != 0 ? fsm->target : fsm->state;
+    int column = fsm->opening && fsm->state <= NXPlayerStateStop ? FSM_STATE_OPENING : state;
+    if(column < 0 || column > FSM_STATE_OPENING)
+        return FSM_REJECT;
+    return fsmActions[row][column];
+}
+
+// Returns the result of the SDK call, PLAYER_ERROR_NONE when none was made.
+-(int)runCommand:(int)token work:(int (^)(void))work {
+    int kind, index, arg;
+    int supersededOpen = 0;
+    int replacedDeferred = 0;
+    int target = 0;
+    NexFSMAction action;
+    // The SDK is asked for the state before commandLock is taken: didChangeFromState takes the lock
+    // from inside the SDK, so calling into the SDK under it would take the two in the opposite order.
+    int seedState = -1;
+    {
+        int unseeded = -1;
+        {
+            std::lock_guard<std::mutex> lock(commandLock);
+            NexCommandRecord *record = NexCommandRecordFor(token);
+            if(record != NULL && record->kind != COMMAND_OPEN && record->kind != COMMAND_CLOSE && record->kind != COMMAND_REOPEN &&
+               record->index >= 0 && record->index < 8 && !playerFSM[record->index].known)
+                unseeded = record->index;
+        }
+        NXPlayer *player = unseeded >= 0 ? [self playerAtIndex:unseeded] : nil;
+        if(player != nil)
+            seedState = (int)player.state;
+    }
+    {
+        std::lock_guard<std::mutex> lock(commandLock);
+        NexCommandRecord *record = NexCommandRecordFor(token);
+        if(record == NULL || record->status == NEXUNITY_COMMAND_CANCELLED)
+            return PLAYER_ERROR_NONE;
+        kind = record->kind;
+        index = record->index;
+        arg = record->arg;
+        bool lifecycle = kind == COMMAND_OPEN || kind == COMMAND_CLOSE || kind == COMMAND_STOP;
+        if((lifecycle && token != latestLifecycleToken) || (kind == COMMAND_SEEK && token != latestSeekToken) ||
+           (kind == COMMAND_REOPEN && arg != latestLifecycleToken)){
+            record->status = NEXUNITY_COMMAND_CANCELLED;
+            return PLAYER_ERROR_NONE;
+        }
+        if(index >= 0 && index < 8 && playerFSM[index].queuedToggleToken == token)
+            playerFSM[index].queuedToggleToken = 0;
+
+        action = [self fsmAction:kind index:index seedState:seedState];
+        if(action == FSM_DEFER){
+            NexPlayerFSM *fsm = &playerFSM[index];
+            int *slot = &fsm->deferredTokens[NexDeferClass(kind)];
+            if(*slot != 0 && *slot != token){
+                NexCommandRecord *previous = NexCommandRecordFor(*slot);
+                if(previous != NULL && previous->status == NEXUNITY_COMMAND_PENDING){
+                    previous->status = NEXUNITY_COMMAND_CANCELLED;
+                    replacedDeferred = *slot;
+                    fsm->avoidedCalls++;
+                }
+            }
+            *slot = token;
+        } else if(action == FSM_NOOP || action == FSM_REJECT){
+            playerFSM[index].avoidedCalls++;
+        } else {
+            record->status = NEXUNITY_COMMAND_RUNNING;
+            if(action == FSM_AS_START)
+                kind = record->kind = COMMAND_START;
+            else if(action == FSM_AS_RESUME)
+                kind = record->kind = COMMAND_RESUME;
+            if(lifecycle && awaitingOpenToken != 0){
+                supersededOpen = awaitingOpenToken;
+                awaitingOpenToken = 0;
+            }
+            if(kind == COMMAND_OPEN || kind == COMMAND_REOPEN){
+                playerFSM[index].opening = true;
+                playerFSM[index].known = false;
+                playerFSM[index].target = 0;
+            }
+            // Set before the SDK call so a state callback that beats its return still reconciles it.
+            switch(kind){
+                case COMMAND_START:
+                case COMMAND_RESUME: target = NXPlayerStatePlay; break;
+                case COMMAND_PAUSE:  target = NXPlayerStatePause; break;
+                case COMMAND_STOP:   target = NXPlayerStateStop; break;
+                default: break;
+            }
+            if(target != 0)
+                playerFSM[index].target = target;
+        }
+    }
+    if(replacedDeferred != 0)
+        [self finishCommand:replacedDeferred status:NEXUNITY_COMMAND_CANCELLED result:0];
+    if(action == FSM_DEFER)
+        return PLAYER_ERROR_NONE;
+    if(action == FSM_NOOP || action == FSM_REJECT){
+        int result = action == FSM_NOOP ? NXErrorNone : NXErrorOperationNotValidInCurrentState;
+        [self finishCommand:token status:action == FSM_NOOP ? NEXUNITY_COMMAND_DONE : NEXUNITY_COMMAND_FAILED result:result];
+        return result;
+    }
+    if(supersededOpen != 0){
+        [self finishCommand:supersededOpen status:NEXUNITY_COMMAND_CANCELLED result:0];
+        // The superseded open is still in flight in the SDK; tear it down before the new command.
+        if(kind == COMMAND_OPEN)
+            [self closePlayer];
+    }
+
+    int result = work != nil ? work() : [self performControl:kind index:index arg:arg];
+    if(result != PLAYER_ERROR_NONE && target != 0){
+        std::lock_guard<std::mutex> lock(commandLock);
+        if(playerFSM[index].target == target)
+            playerFSM[index].target = 0;
+    }
+
+    bool await = result == PLAYER_ERROR_NONE && (kind == COMMAND_OPEN || kind == COMMAND_SEEK);
+    if(await){
+        int cancelled = 0;
+        {
+            std::lock_guard<std::mutex> lock(commandLock);
+            NexCommandRecord *record = NexCommandRecordFor(token);
+            if(record != NULL)
+                record->status = NEXUNITY_COMMAND_WAITING;
+            if(kind == COMMAND_OPEN){
+                awaitingOpenToken = token;
+            } else {
+                cancelled = awaitingSeekToken;
+                awaitingSeekToken = token;
+                awaitingSeekIndex = index;
+            }
+        }
+        if(cancelled != 0)
+            [self finishCommand:cancelled status:NEXUNITY_COMMAND_CANCELLED result:0];
+        return result;
+    }
+    // A reopen is not awaited; its open is over with the first state callback, unless it failed here.
+    if(kind == COMMAND_OPEN || (kind == COMMAND_REOPEN && result != PLAYER_ERROR_NONE)){
+        std::lock_guard<std::mutex> lock(commandLock);
+        playerFSM[index].opening = false;
+    }
+    [self finishCommand:token status:result == PLAYER_ERROR_NONE ? NEXUNITY_COMMAND_DONE : NEXUNITY_COMMAND_FAILED result:result];
+    return result;
+}
+
+// The SDK call behind a control command, once the state machine admitted it.
+-(int)performControl:(int)kind index:(int)index arg:(int)arg {
+    NXPlayer *player = [self playerAtIndex:index];
+    if(player == nil)
+        return PLAYER_ERROR_GENERAL;
+
+    NXError result = NXErrorNone;
+    switch(kind){
+        case COMMAND_START:
+            result = [player startFromTime:arg];
+            break;
+        case COMMAND_PAUSE:
+            result = [player pause];
+            break;
+        case COMMAND_RESUME:
+            result = [player resume];
+            break;
+        case COMMAND_SEEK:
+            result = [player seekTo:arg];
+            break;
+        case COMMAND_STOP:
+            result = [player stop];
+            for(int i = 1; i < self.multiStreamScreens; i++)
+                [multiPlayers[i] stop];
+            break;
+        default:
+            return PLAYER_ERROR_GENERAL;
+    }
+    if(result != NXErrorNone && index == 0)
+        [self nexPlayer:player encounteredError:result];
+    return result;
+}
+
+-(void)playerFSM:(NXPlayer *)nxplayer changedToState:(NXPlayerState)newState {
+    int index = [self indexOfPlayer:nxplayer];
+    if(index < 0)
+        return;
+    int deferred[FSM_DEFER_SLOTS] = {0};
+    {
+        std::lock_guard<std::mutex> lock(commandLock);
+        NexPlayerFSM *fsm = &playerFSM[index];
+        fsm->state = (int)newState;
+        fsm->known = true;
+        // A callback for an older command (pause after a newer resume) leaves the target in place.
+        if(newState == fsm->target || (newState != NXPlayerStatePlay && newState != NXPlayerStatePause))
+            fsm->target = 0;
+        // Every open path ends in startFromTime, so the open is over once playback starts or pauses.
+        if(newState == NXPlayerStatePlay || newState == NXPlayerStatePause){
+            fsm->opening = false;
+            for(int i = 0; i < FSM_DEFER_SLOTS; i++){
+                deferred[i] = fsm->deferredTokens[i];
+                fsm->deferredTokens[i] = 0;
+            }
+        }
+    }
+    // Tokens grow with every command, so sorting them restores the order the app issued them in.
+    std::sort(deferred, deferred + FSM_DEFER_SLOTS);
+    __weak NexPlayerScripting *weakSelf = self;
+    for(int i = 0; i < FSM_DEFER_SLOTS; i++){
+        int replayed = deferred[i];
+        if(replayed == 0)
+            continue;
+        dispatch_async(NexCommandQueue(), ^{
+            [weakSelf runCommand:replayed work:nil];
+        });
+    }
+}
+
+-(void)finishCommand:(int)token status:(int)status result:(int)result {
+    {
+        std::lock_guard<std::mutex> lock(commandLock);
+        NexCommandRecord *record = NexCommandRecordFor(token);
+        if(record == NULL)
+            return;
+        record->status = status;
+        record->result = result;
+    }
+    if(g_playerListener)
+        NexPostEvent(NEXUNITY_EVENT_COMMAND_COMPLETE,token,status,result,0,0);
+}
+
+// Called from the async completion callbacks; finishes the open or seek command waiting on nxplayer.
+-(void)completeAwaitedCommand:(int)kind player:(NXPlayer *)nxplayer result:(NXError)result {
+    int token = 0;
+    int deferred[FSM_DEFER_SLOTS] = {0};
+    {
+        std::lock_guard<std::mutex> lock(commandLock);
+        int index = [self indexOfPlayer:nxplayer];
+        if(kind == COMMAND_OPEN && index >= 0){
+            if(index == 0){
+                token = awaitingOpenToken;
+                awaitingOpenToken = 0;
+            }
+            if(result != NXErrorNone){
+                playerFSM[index].opening = false;
+                for(int i = 0; i < FSM_DEFER_SLOTS; i++){
+                    deferred[i] = playerFSM[index].deferredTokens[i];
+                    playerFSM[index].deferredTokens[i] = 0;
+                }
+            }
+        } else if(kind == COMMAND_SEEK && index == awaitingSeekIndex){
+            token = awaitingSeekToken;
+            awaitingSeekToken = 0;
+        }
+    }
+    if(token != 0)
+        [self finishCommand:token status:result == NXErrorNone ? NEXUNITY_COMMAND_DONE : NEXUNITY_COMMAND_FAILED result:result];
+    for(int i = 0; i < FSM_DEFER_SLOTS; i++)
+        if(deferred[i] != 0)
+            [self finishCommand:deferred[i] status:NEXUNITY_COMMAND_CANCELLED result:0];
+}
+
+-(int)getCommandStatus:(int)token result:(int *)result {
+    std::lock_guard<std::mutex> lock(commandLock);
+    NexCommandRecord *record = NexCommandRecordFor(token);
+    if(record == NULL)
+        return NEXUNITY_COMMAND_UNKNOWN;
+    if(result != NULL)
+        *result = record->result;
+    return record->status;
+}
+
+-(int)getAvoidedCallCount:(int)index {
+    if(index < 0 || index >= 8)
+        return 0;
+    std::lock_guard<std::mutex> lock(commandLock);
+    return playerFSM[index].avoidedCalls;
+}
+//End command worker
+
 - (int)getTrackCount{
-    return self.player.contentInfo.currentVideoStream.tracks.count;
+    std::lock_guard<std::mutex> lock(catalogLock);
+    return NexActiveCatalog().trackCount[0];
 }
 
 - (NexPlayerTrack)getTrack:(int)index{
-    NXTrackInfo * trackInfo = self.player.contentInfo.currentVideoStream.tracks[index];
-    NexPlayerTrack track;
-    if(index >=  self.player.contentInfo.currentVideoStream.tracks.count)
+    NexPlayerTrack track = { -1, 0, 0, 0, 0 };
+    std::lock_guard<std::mutex> lock(catalogLock);
+    const NexCatalogBuffer &catalog = NexActiveCatalog();
+    if(index < 0 || index >= catalog.trackCount[0])
         return track;
-    track.width = [trackInfo width];
-    track.height = [trackInfo height];
-    track.framerate = (int)[trackInfo frameRate];
+    const NexTrackRecord &record = catalog.tracks[catalog.trackStart[0] + index];
+    track.idvalue = record.id;
+    track.bitrate = record.bandwidth;
+    track.width = record.width;
+    track.height = record.height;
+    track.framerate = record.frameRateMilli / 1000;
 
     return track;
 }
@@ -900,140 +2572,81 @@ NSString* datFileString;
     }
 }
 - (void)setProperties{
-    if(self.player) {
+    if(self.player)
         self.player.backgroundMode = YES;
-        if(maxBW > 0)
-            [self.player setProperty:NXPropertyMaxBW toValue:maxBW];
-        if(minBW > 0)
-            [self.player setProperty:NXPropertyMinBW toValue:minBW];
-
-        if(avSyncOffset > 0)
-            [self.player setProperty:NXPropertyAVSyncOffset toValue:avSyncOffset];
-        if(preferLanguage > 0)
-            [self.player setProperty:NXPropertyPreferLanguage toValue:preferLanguage];
-        if(preferBW > 0 )
-            [self.player setProperty:NXPropertyPreferBandwidth toValue:preferBW];
-        if(bufferingTime)
-        {
-            [self.player setProperty:NXPropertyInitialBufferingDuration toValue:bufferingTime];
-            [self.player setProperty:NXPropertyReBufferingDuration toValue:bufferingTime];
-        }
 
-        if(enableTrackDown > 0)
-        {
-            [self.player setProperty:NXPropertyEnableTrackdown toValue:enableTrackDown];
-            [self.player setProperty:NXPropertyTrackdownVideoRatio toValue:trackDwonVideoRatio];
-        }
-
-        if(VDispWait > 0)
-            [self.player setProperty:NXPropertyTimestampDifferenceVDispWait toValue:VDispWait];
-        if(VDispSkip > 0)
-            [self.player setProperty:NXPropertyTimestampDifferenceVDispSkip toValue:VDispSkip];
-        if(StartNearestBW > 0)
-            [self.player setProperty:NXPropertyStartNearestBW toValue:StartNearestBW];
+    for(int i = 0; i < 8 && (i == 0 || i < self.multiStreamScreens); i++){
+        NXPlayer *player = [self playerAtIndex:i];
+        if(player == nil)
+            continue;
+        [self applyConfig:i];
         /*if(MaxCaptionLength > 0)
-         [self.player setProperty:NXPropertySetMaxCaptionLength toValue:MaxCaptionLength];*/
+         [player setProperty:NXPropertySetMaxCaptionLength toValue:MaxCaptionLength];*/
 
-        if(localSPDEnable != 0 && localSPDTime != 0){
+        std::lock_guard<std::mutex> lock(customTagLock);
+        if(subscribedTags != nullptr)
+            [player setProperty:NXPropertyTimedID3MetaKey toValue:(size_t)customTagsValue];
+    }
+}
 
-            [self.player setProperty:NXPropertyEnableSpdSyncToGlobalTime toValue:1];
-            [self.player setProperty:NXPropertySuggestedPresentationDelayTime toValue:localSPDTime];
-            [self.player setProperty:NXPropertyLiveViewOption toValue:NXPropertyLiveViewLowLatency];
-            [self.player setProperty:NXPropertyPartialPrefetch toValue:1];
+// Sends the NXProperty values of the instance config that differ from what its player last received.
+-(void)applyConfig:(int)index {
+    NXPlayer *player = [self playerAtIndex:index];
+    if(player == nil)
+        return;
 
-            if(localSPDSpeedUpSyncTime != 0){
-                [self.player setProperty:NXPropertySpdSyncDiffTime toValue:localSPDSpeedUpSyncTime];
-            }
-            else{
-                [self.player setProperty:NXPropertySpdSyncDiffTime toValue:300];
-            }
+    if(!appliedConfigValid[index]){
+        for(int i = 0; i < CONFIG_PROPERTY_COUNT; i++)
+            appliedConfig[index][i] = CONFIG_UNSET;
+        // WebVTT is always on and not part of the config.
+        [player setProperty:NXPropertyEnableWebVTT toValue:true];
+        configPropertyCalls[index]++;
+        appliedConfigValid[index] = true;
+    }
 
-            if(localSPDJumpSyncTime != 0){
-                [self.player setProperty:NXPropertySpdTooMuchDiffTime toValue:localSPDJumpSyncTime];
-                printf("\n");
-            }
-            else{
-                [self.player setProperty:NXPropertySpdTooMuchDiffTime toValue:5000];
-            }
+    NSInteger values[CONFIG_PROPERTY_COUNT];
+    NexResolveConfig(NexConfigFor(index), values);
+    {
+        std::lock_guard<std::mutex> lock(resilienceLock);
+        if(resilience[index].enabled && resilience[index].policy.dataInactivityTimeoutMs > 0)
+            values[18] = resilience[index].policy.dataInactivityTimeoutMs;
+        if(resilience[index].enabled && resilience[index].policy.socketOperationTimeoutMs > 0)
+            values[19] = resilience[index].policy.socketOperationTimeoutMs;
+    }
+    for(int i = 0; i < CONFIG_PROPERTY_COUNT; i++){
+        if(values[i] == CONFIG_UNSET)
+            continue;
+        if(appliedConfig[index][i] == values[i]){
+            configPropertySkipped[index]++;
+            continue;
         }
+        [player setProperty:configProperties[i] toValue:values[i]];
+        appliedConfig[index][i] = values[i];
+        configPropertyCalls[index]++;
+    }
+}
 
-        [self.player setProperty:NXPropertyEnableWebVTT toValue:true];
-
-        if(self.CUSTOM_TAGS != nil)
-        {
-            const char *value = [self.CUSTOM_TAGS UTF8String];
-            [self.player setProperty:NXPropertyTimedID3MetaKey toValue:(size_t)value];
-        }
-    }
-    for(int i = 1; i < self.multiStreamScreens ;i++){
-        if(multiPlayers[i]) {
-            if(maxBW > 0)
-                [multiPlayers[i] setProperty:NXPropertyMaxBW toValue:maxBW];
-            if(minBW > 0)
-                [multiPlayers[i] setProperty:NXPropertyMinBW toValue:minBW];
-
-            if(avSyncOffset > 0)
-                [multiPlayers[i] setProperty:NXPropertyAVSyncOffset toValue:avSyncOffset];
-            if(preferLanguage > 0)
-                [multiPlayers[i] setProperty:NXPropertyPreferLanguage toValue:preferLanguage];
-            if(preferBW > 0 )
-                [multiPlayers[i] setProperty:NXPropertyPreferBandwidth toValue:preferBW];
-            if(bufferingTime)
-            {
-                [multiPlayers[i] setProperty:NXPropertyInitialBufferingDuration toValue:bufferingTime];
-                [multiPlayers[i] setProperty:NXPropertyReBufferingDuration toValue:bufferingTime];
-            }
-
-            if(enableTrackDown > 0)
-            {
-                [multiPlayers[i] setProperty:NXPropertyEnableTrackdown toValue:enableTrackDown];
-                [multiPlayers[i] setProperty:NXPropertyTrackdownVideoRatio toValue:trackDwonVideoRatio];
-            }
-
-            if(VDispWait > 0)
-                [multiPlayers[i] setProperty:NXPropertyTimestampDifferenceVDispWait toValue:VDispWait];
-            if(VDispSkip > 0)
-                [multiPlayers[i] setProperty:NXPropertyTimestampDifferenceVDispSkip toValue:VDispSkip];
-            if(StartNearestBW > 0)
-                [multiPlayers[i] setProperty:NXPropertyStartNearestBW toValue:StartNearestBW];
-            /*if(MaxCaptionLength > 0)
-             [self.player setProperty:NXPropertySetMaxCaptionLength toValue:MaxCaptionLength];*/
-
-
-            if(localSPDEnable != 0 && localSPDTime != 0){
-                [multiPlayers[i] setProperty:NXPropertyEnableSpdSyncToGlobalTime toValue:1];
-                [multiPlayers[i] setProperty:NXPropertySuggestedPresentationDelayTime toValue:localSPDTime];
-                [multiPlayers[i] setProperty:NXPropertyLiveViewOption toValue:NXPropertyLiveViewLowLatency];
-                [multiPlayers[i] setProperty:NXPropertyPartialPrefetch toValue:1];
-
-                if(localSPDSpeedUpSyncTime != 0){
-                    [multiPlayers[i] setProperty:NXPropertySpdSyncDiffTime toValue:localSPDSpeedUpSyncTime];
-                }
-                else{
-                    [multiPlayers[i] setProperty:NXPropertySpdSyncDiffTime toValue:300];
-                }
-
-                if(localSPDJumpSyncTime != 0){
-                    [multiPlayers[i] setProperty:NXPropertySpdTooMuchDiffTime toValue:localSPDJumpSyncTime];
-                }
-                else{
-                    [multiPlayers[i] setProperty:NXPropertySpdTooMuchDiffTime toValue:5000];
-                }
-            }
-
-            [multiPlayers[i] setProperty:NXPropertyEnableWebVTT toValue:true];
-
-            if(self.CUSTOM_TAGS != nil) {
-                const char *value = [self.CUSTOM_TAGS UTF8String];
-                [multiPlayers[i] setProperty:NXPropertyTimedID3MetaKey toValue:(size_t)value];
-            }
+-(int)setConfig:(int)index toValue:(const NexPlayerConfig *)config {
+    if(index < 0 || index >= 8)
+        return PLAYER_ERROR_GENERAL;
+    if(config == NULL){
+        hasInstanceConfig[index] = false;
+    } else {
+        if(config->version != NEXPLAYER_CONFIG_VERSION || config->size != sizeof(NexPlayerConfig)){
+            [self Log:4 toValue:@"Config version mismatch: " value3:config->version value4:config->size];
+            return PLAYER_ERROR_GENERAL;
         }
+        instanceConfig[index] = *config;
+        hasInstanceConfig[index] = true;
     }
+    [self applyConfig:index];
+    return PLAYER_ERROR_NONE;
 }
 
 -(void) nxRelease {
     self.player.delegate = NULL;
     self.player.ABRDelegate = NULL;
+    self.player.manifestAndPlaylistDescrambler = NULL;
 }
 
 -(void) setEnabledABR:(BOOL)enable {
@@ -1141,65 +2754,12 @@ NSString* datFileString;
             else
                 supportABR = false;
             break;
-        case NEXUNITY_NXPropertyMaxBW:
-            maxBW = value;
-            break;
-        case NEXUNITY_NXPropertyMinBW:
-            minBW = 0;
-            break;
-        case NEXUNITY_NXPropertyAVSyncOffset:
-            avSyncOffset = value;
-            break;
-        case NEXUNITY_NXPropertyPreferLanguage:
-            preferLanguage = value;
-            break;
-        case NEXUNITY_NXPropertyPreferBandwidth:
-            preferBW = value;
-            break;
-        case NEXUNITY_NXPropertyInitialBufferingDuration:
-            bufferingTime = value;
-            break;
-        case NEXUNITY_NXPropertyReBufferingDuration:
-            bufferingTime = value;
-            break;
-        case NEXUNITY_NXPropertyEnableTrackdown:
-            enableTrackDown = value;
-            break;
-        case NEXUNITY_NXPropertyTrackdownVideoRatio:
-            trackDwonVideoRatio = value;
-            break;
-        case NEXUNITY_NXPropertyTimestampDifferenceVDispWait:
-            VDispWait = value;
-            break;
-        case NEXUNITY_NXPropertyTimestampDifferenceVDispSkip:
-            VDispSkip = value;
-            break;
-        case NEXUNITY_NXPropertyStartNearestBW:
-            StartNearestBW = value;
-            break;
         case NEXUNITY_NXPropertyMaxCaptionLength:
-            MaxCaptionLength = value;
-            break;
-
-
-        case NEXUNITY_NXPropertySPDEnable:
-            localSPDEnable = value;
-            break;
-
-        case NEXUNITY_NXPropertySPDTime:
-            localSPDTime = value;
-            break;
-
-        case NEXUNITY_NXPropertySPDSpeedUpSyncTime:
-            localSPDSpeedUpSyncTime = value;
-            break;
-
-        case NEXUNITY_NXPropertySPDJumpSyncTime:
-            localSPDJumpSyncTime = value;
+            // Cue slots hold NEXPLAYER_CUE_TEXT_MAX bytes; a larger limit cannot be honoured.
+            MaxCaptionLength = std::max(2, std::min(value, NEXPLAYER_CUE_TEXT_MAX));
             break;
 
 
-
         case NEXUNITY_NXPropertyDRMLicenseTimeout:
             m_licenseRequestTimeout = value;
 #ifdef NEXPLAYER
@@ -1212,7 +2772,8 @@ NSString* datFileString;
 #endif
             break;
         default:
-            [self Log:4 toValue:@"property not listed"];
+            if(!NexConfigSetField(&sharedConfig, property, value))
+                [self Log:4 toValue:@"property not listed"];
             break;
     }
     return 0;
@@ -1329,12 +2890,16 @@ bool isAlticast = false;
 #endif
 - (void)setSubtitlePath:(NSString *)subtitlePath {
     if(subtitlePath != nil){
+        if([self loadExternalSubtitles:subtitlePath index:0]){
+            self.subtitle_path = nil;
+            return;
+        }
         BOOL subtitleCheck = [NexUtil CheckSubtitleFile:subtitlePath];
         if(subtitleCheck){
             self.subtitle_path = [[NSString alloc] initWithString:subtitlePath];
             [self Log:4 toValue:@"set subtitle path :\n" value5:self.subtitle_path];
         }else{
-            g_playerListener(NEXUNITY_EVENT_TEXT_INIT,INVALID_SUBTITLE_PATH,0,0,0,0);
+            NexPostEvent(NEXUNITY_EVENT_TEXT_INIT,INVALID_SUBTITLE_PATH,0,0,0,0);
             self.subtitle_path = nil;
             [self Log:4 toValue:@"wrong subtitle path"];
         }
@@ -1343,6 +2908,10 @@ bool isAlticast = false;
 
 - (void)setSubtitleFD:(NSString *)subtitleFD {
     NSString *temp = [NexUtil getFileInformation:subtitleFD];
+    if(temp != nil && [self loadExternalSubtitles:temp index:0]){
+        self.subtitle_path = nil;
+        return;
+    }
     if(temp != nil){
         self.subtitle_path = [[NSString alloc] initWithString:temp];
         [self Log:4 toValue:@"[FD] set subtitle path :\n" value5:self.subtitle_path];
@@ -1351,6 +2920,8 @@ bool isAlticast = false;
 
 - (void)changeSubtitlePath:(NSString *)subtitlePath{
     if(subtitlePath != nil){
+        if([self loadExternalSubtitles:subtitlePath index:0])
+            return;
         [self.player setExternalSubtitle:subtitlePath];
         [self Log:4 toValue:@"change subtitle path :\n" value5:subtitlePath];
     }
@@ -1359,6 +2930,8 @@ bool isAlticast = false;
 - (void)changeSubtitleFD:(NSString *)subtitleFD{
     NSString *subtitlePath = [NexUtil getFileInformation:subtitleFD];
     if(subtitlePath != nil){
+        if([self loadExternalSubtitles:subtitlePath index:0])
+            return;
         [self.player setExternalSubtitle:subtitlePath];
         [self Log:4 toValue:@"[FD]change subtitle path :\n" value5:subtitlePath];
     }
@@ -1366,6 +2939,12 @@ bool isAlticast = false;
 }
 
 - (void)OnOffSubtitle:(BOOL) bOnOff {
+    externalSubtitlesOn = bOnOff;
+    for(int i = 0; i < 8; i++){
+        NXPlayer *player = [self playerAtIndex:i];
+        if(player != nil)
+            [self renderExternalSubtitles:i at:(int64_t)player.currentTimeStamp];
+    }
 
     if(self.player != nil){
         [self.player setMediaOnOff:bOnOff mediaType:NXMediaTypeText];
@@ -1383,6 +2962,8 @@ bool isAlticast = false;
 - (void)setAdditionalHttpHeader:(NSString *)httpHeaderValue{
     [self Log:4 toValue:@"Add Additional Header : \n" value5:httpHeaderValue];
     [m_AdditionalHeaders addObject:httpHeaderValue];
+    if(self.player != nil && httpHeaderValue != nil)
+        [self storeHeaderLine:0 line:httpHeaderValue];
 }
 
 - (void)setMute:(BOOL)isMute {
@@ -1476,37 +3057,36 @@ bool isAlticast = false;
     NXMediaStreamInfo *curStream = self.player.contentInfo.currentAudioStream;
     return (NSString*)curStream.language;
 }
+-(int)getStreamCount:(int)kind {
+    std::lock_guard<std::mutex> lock(catalogLock);
+    return NexActiveCatalog().streamCount[0][kind];
+}
+-(int)getStreamID:(int)index kind:(int)kind {
+    std::lock_guard<std::mutex> lock(catalogLock);
+    const NexStreamRecord *stream = NexCatalogStream(0, kind, index);
+    return stream != NULL ? stream->id : -1;
+}
+-(int)getStreamIndexOfID:(int)ID kind:(int)kind {
+    std::lock_guard<std::mutex> lock(catalogLock);
+    const NexCatalogBuffer &catalog = NexActiveCatalog();
+    auto found = catalog.streamById.find(NexCatalogKey(0, kind, (uint32_t)ID));
+    return found != catalog.streamById.end() ? found->second : -1;
+}
 -(int)getAudioStreamCount {
-    int count = 0;
-    count = [[self.player.contentInfo streamsOfType:NXMediaTypeAudio] count];
-    return count;
+    return [self getStreamCount:NEXUNITY_STREAM_AUDIO];
 }
 -(int)getAudioStreamID:(int)index {
-    NXMediaStreamInfo *chosenStream = [[self.player.contentInfo streamsOfType:NXMediaTypeAudio] objectAtIndex:index];
-    return (int)chosenStream.internalId;
+    return [self getStreamID:index kind:NEXUNITY_STREAM_AUDIO];
 }
 -(int)getAudioIndexOfID:(int)ID {
-    int audioCount = [[self.player.contentInfo streamsOfType:NXMediaTypeAudio] count];
-    int chosenIndex = -1;
-    for(int i = 0; i < audioCount; i++){
-        NXMediaStreamInfo *chosenStream = [[self.player.contentInfo streamsOfType:NXMediaTypeAudio] objectAtIndex:i];
-        if(chosenStream.internalId == ID){
-            chosenIndex = i;
-        }
-    }
-    return chosenIndex;
-}
--(NSString*)getAudioStreamName:(int)index {
-    NXMediaStreamInfo *chosenStream = [[self.player.contentInfo streamsOfType:NXMediaTypeAudio] objectAtIndex:index];
-    return (NSString*)chosenStream.name;
-}
--(NSString*)getAudioStreamLanguage:(int)index {
-    NXMediaStreamInfo *chosenStream = [[self.player.contentInfo streamsOfType:NXMediaTypeAudio] objectAtIndex:index];
-    return (NSString*)chosenStream.language;
+    return [self getStreamIndexOfID:ID kind:NEXUNITY_STREAM_AUDIO];
 }
 -(void)setAudioStream:(int)index {
     NXError ret = NXErrorNone;
-    NXMediaStreamInfo *chosenStream = [self.player.contentInfo.streams objectAtIndex:index];
+    NSArray *audioStreams = [self.player.contentInfo streamsOfType:NXMediaTypeAudio];
+    if(index < 0 || index >= audioStreams.count)
+        return;
+    NXMediaStreamInfo *chosenStream = [audioStreams objectAtIndex:index];
     ret = [self.player setVideoStream:nil audioStream:chosenStream textStream:nil trackAttributes:nil];
     if (ret != NXErrorNone) {
         //NSLog(@"ERROR: [%s %d] Failed changing stream:%lx", __PRETTY_FUNCTION__, __LINE__, (unsigned long)ret);
@@ -1516,40 +3096,25 @@ bool isAlticast = false;
 
 
 -(int)getCaptionIndexOfID:(int)ID {
-    int captionCount = [[self.player.contentInfo streamsOfType:NXMediaTypeText] count];
-    int chosenIndex = 0;
-    for(int i = 0; i < captionCount; i++){
-        NXMediaStreamInfo *chosenStream = [[self.player.contentInfo streamsOfType:NXMediaTypeText] objectAtIndex:i];
-        if(chosenStream.internalId == ID){
-            chosenIndex = i;
-        }
-    }
-    return chosenIndex;
+    int index = [self getStreamIndexOfID:ID kind:NEXUNITY_STREAM_TEXT];
+    return index >= 0 ? index : 0;
 }
 -(void)setCaptionStream:(int)index {
     NXError ret = NXErrorNone;
-    NXMediaStreamInfo *chosenStream = [[self.player.contentInfo streamsOfType:NXMediaTypeText] objectAtIndex:index];
+    NSArray *textStreams = [self.player.contentInfo streamsOfType:NXMediaTypeText];
+    if(index < 0 || index >= textStreams.count)
+        return;
+    NXMediaStreamInfo *chosenStream = [textStreams objectAtIndex:index];
     ret = [self.player setVideoStream:nil audioStream:nil textStream:chosenStream trackAttributes:nil];
     if (ret != NXErrorNone) {
         //NSLog(@"ERROR: [%s %d] Failed changing stream:%lx", __PRETTY_FUNCTION__, __LINE__, (unsigned long)ret);
     }
 }
 -(int)getCaptionStreamCount {
-    int count = 0;
-    count = [[self.player.contentInfo streamsOfType:NXMediaTypeText] count];
-    return count;
+    return [self getStreamCount:NEXUNITY_STREAM_TEXT];
 }
 -(int)getCaptionStreamID:(int)index {
-    NXMediaStreamInfo *chosenStream = [[self.player.contentInfo streamsOfType:NXMediaTypeText] objectAtIndex:index];
-    return (int)chosenStream.internalId;
-}
--(NSString*)getCaptionStreamName:(int)index {
-    NXMediaStreamInfo *chosenStream = [[self.player.contentInfo streamsOfType:NXMediaTypeText] objectAtIndex:index];
-    return (NSString*)chosenStream.name;
-}
--(NSString*)getCaptionStreamLanguage:(int)index {
-    NXMediaStreamInfo *chosenStream = [[self.player.contentInfo streamsOfType:NXMediaTypeText] objectAtIndex:index];
-    return (NSString*)chosenStream.language;
+    return [self getStreamID:index kind:NEXUNITY_STREAM_TEXT];
 }
 //END NEW MARTIN 21-10-2019
 
@@ -1608,9 +3173,11 @@ bool isAlticast = false;
 -(int)getDownloadPercentage
 {
     [self checkIfFileExistsAtPath:self.storeStreamURL];
-    if (self.downloadProgress > 99)
+    NexInstanceSnapshot snapshot;
+    instanceSnapshot[0].read(snapshot);
+    if (snapshot.downloadProgress > 99)
         offlineMode = false;
-    return self.downloadProgress;
+    return snapshot.downloadProgress;
 }
 - (void)setupOfflinePlayback
 {
@@ -1670,7 +3237,7 @@ bool isAlticast = false;
 -(void) setMultiProperty:(int)index toValue:(int)property toValuez:(int)value {
     switch(property){
         case 1:
-            if (localSPDEnable == false)
+            if (NexConfigFor(index)->spdEnable == 0)
                 if(value != 0)
                     multiPropertyAutoStart[index] = true;
             break;
@@ -1683,8 +3250,14 @@ bool isAlticast = false;
                 multiPropertyMute[index] = true;
             break;
         default :
-//            if(value != 0)
-//               [multiPlayers[index] setProperty:(NXProperty)property toValue:value];
+            if(index < 0 || index >= 8)
+                break;
+            if(!hasInstanceConfig[index]){
+                instanceConfig[index] = sharedConfig;
+                hasInstanceConfig[index] = true;
+            }
+            if(NexConfigSetField(&instanceConfig[index], property, value))
+                [self applyConfig:index];
             break;
     }
 
@@ -1693,58 +3266,16 @@ bool isAlticast = false;
 
 -(void) setMultiHTTPHeader:(int)index toValue:(NSString*)header {
     [self Log:4 toValue:@"Set setMultiHTTPHeader"];
+    if(index < 0 || index >= 8 || header == nil)
+        return;
 
-    //Before-setup and runtime update
-    if(index == 0){
-        [m_AdditionalHeaders1 addObject:header];
-        if(self.player != nil) [self.player addHTTPHeaderFields:header];
-    }
-    if(index == 1){
-        [m_AdditionalHeaders2 addObject:header];
-        if(multiPlayers[1] != nil) [multiPlayers[1] addHTTPHeaderFields:header];
-    }
-    if(index == 2){
-        [m_AdditionalHeaders3 addObject:header];
-        if(multiPlayers[2] != nil) [multiPlayers[2] addHTTPHeaderFields:header];
-    }
-    if(index == 3){
-        [m_AdditionalHeaders4 addObject:header];
-        if(multiPlayers[3] != nil) [multiPlayers[3] addHTTPHeaderFields:header];
-    }
-    if(index == 4){
-        [m_AdditionalHeaders4 addObject:header];
-        if(multiPlayers[4] != nil) [multiPlayers[4] addHTTPHeaderFields:header];
-    }
-    if(index == 5){
-        [m_AdditionalHeaders5 addObject:header];
-        if(multiPlayers[5] != nil) [multiPlayers[5] addHTTPHeaderFields:header];
-    }
-    if(index == 6){
-        [m_AdditionalHeaders6 addObject:header];
-        if(multiPlayers[6] != nil) [multiPlayers[6] addHTTPHeaderFields:header];
-    }
-    if(index == 7){
-        [m_AdditionalHeaders7 addObject:header];
-        if(multiPlayers[7] != nil) [multiPlayers[7] addHTTPHeaderFields:header];
-    }
-
-
-    //For when updateHttpHeaderFields is ready
-    /*if(index == 0){
-     if(self.player != nil){
-     if(hasAdditionalHttpHeader[0] != true){
-     [[self player] addHTTPHeaderFields:header];
-     hasAdditionalHttpHeader[index] = true;
-     }else [[self player] updateHttpHeaderFields:header];
-     }
-     }else{
-     if(multiPlayers[index] != nil){
-     if(hasAdditionalHttpHeader[index] != true){
-     [multiPlayers[index] addHTTPHeaderFields:header];
-     hasAdditionalHttpHeader[index] = true;
-     }else [multiPlayers[index] updateHttpHeaderFields:header];
-     }
-     }*/
+    // Kept for the next setupPlayer; a player that exists already gets it through the header store,
+    // which replaces a header of the same name instead of adding it again.
+    NSMutableArray *headers[8] = { m_AdditionalHeaders1, m_AdditionalHeaders2, m_AdditionalHeaders3, m_AdditionalHeaders4,
+                                   m_AdditionalHeaders5, m_AdditionalHeaders6, m_AdditionalHeaders7, m_AdditionalHeaders8 };
+    [headers[index] addObject:header];
+    if([self playerAtIndex:index] != nil)
+        [self storeHeaderLine:index line:header];
 }
 -(void) startChosenPlayer:(int)index toValue:(NSString*)url {
     multiPaths[index] = url;
@@ -1758,14 +3289,27 @@ bool isAlticast = false;
     for(int i = 1; i < self.multiStreamScreens; i++){
         multiViews[i] = [[NXPlayerView alloc] initWithFrame: bounds];
         multiPlayers[i] = multiViews[i].player;
+        appliedConfigValid[i] = false;
         multiPlayers[i].delegate = self;
+        multiPlayers[i].manifestAndPlaylistDescrambler = self;
+        multiStatisticsAPI[i] = [[NXStatisticsAPI alloc] initWithPlayer:multiPlayers[i]];
+        multiStatisticsAPI[i].httpStateDelegate = self;
         multiViews[i].autoresizingMask = UIViewAutoresizingFlexibleWidth|UIViewAutoresizingFlexibleHeight;
         multiViews[i].backgroundColor = [UIColor blackColor];
         multiViews[i].autoScaling = NXScale_FitInView;
         [multiPlayers[i] setProperty:NXPropertySetHWdecoderPixelFormat toValue:PIXEL_FORMAT_32BGRA];
+        [multiPlayers[i] setProperty:NXPropertyEnableModifyHTTPRequest toValue:1];
     }
 }
 -(void) openChosenMulti:(int)index {
+    [self applyConfig:index];
+    [self resetResilienceSession:index];
+    {
+        std::lock_guard<std::mutex> lock(commandLock);
+        playerFSM[index].opening = true;
+        playerFSM[index].known = false;
+        playerFSM[index].target = 0;
+    }
     [multiPlayers[index] open:multiPaths[index]
                          mode:NXOpenModeAuto
                     subtitles:self.subtitle_path
@@ -1799,7 +3343,34 @@ bool isAlticast = false;
 
     downloadPercent = 100.0f * current/total;
 
-    self.downloadProgress = downloadPercent;
+    [self publishDownloadProgress:(int)downloadPercent];
+}
+
+-(void)publishDownloadProgress:(int)progress {
+    instanceSnapshot[0].update([progress](NexInstanceSnapshot &snapshot) {
+        snapshot.downloadProgress = progress;
+    });
+}
+
+// type < 0 keeps the previous subtitle type; startMs < 0 when the source has no cue times.
+// Emits NEXUNITY_EVENT_TEXT_RENDER (instance in the first argument) only if the cue changed.
+-(void)publishSubtitle:(NSString *)text player:(NXPlayer *)nxplayer type:(int)type start:(int64_t)startMs end:(int64_t)endMs {
+    int index = [self indexOfPlayer:nxplayer];
+    if(index < 0)
+        index = 0;
+    // A natively parsed external file replaces whatever the SDK still renders for it.
+    if(NexExternalSubtitles(index) != nullptr)
+        return;
+    const char *utf8 = text != nil ? [text UTF8String] : NULL;
+    [self publishCue:utf8 != NULL ? utf8 : "" index:index type:type start:startMs end:endMs playhead:(int64_t)nxplayer.currentTimeStamp];
+}
+
+-(void)publishCue:(const char *)utf8 index:(int)index type:(int)type start:(int64_t)startMs end:(int64_t)endMs playhead:(int64_t)playheadMs {
+    if(!NexPublishCue(index, utf8, type, startMs, endMs, playheadMs))
+        return;
+    lastSubMultiIndex = index;
+    if(!m_isClose && g_playerListener && !isAlticast)
+        NexPostEvent(NEXUNITY_EVENT_TEXT_RENDER,index,0,0,0,0);
 }
 - (NSString *) filePathWithURL:(NSString *)path {
     return [NexPlayerHTTPRetrieveStoreUtils pathForMediaURL:path];
@@ -1809,7 +3380,7 @@ bool isAlticast = false;
     BOOL isDir;
     BOOL result = [[NSFileManager defaultManager] fileExistsAtPath:[self filePathWithURL:path] isDirectory:&isDir];
     self.numberOfStoredFiles = [[[NSFileManager defaultManager] contentsOfDirectoryAtPath:[self filePathWithURL:path] error:nil] count];
-    if(self.numberOfStoredFiles >= self.totalFilesToDload) self.downloadProgress = 100;
+    if(self.numberOfStoredFiles >= self.totalFilesToDload) [self publishDownloadProgress:100];
 }
 
 #pragma mark - NXPlayerDelegate methods
@@ -1821,15 +3392,21 @@ bool isAlticast = false;
         if(self.player == nxplayer) lastMultiInitPlayer = 0;
         else for(int i = 1; i < self.multiStreamScreens; i++) if(multiPlayers[i] == nxplayer) lastMultiInitPlayer = i;
         //End multi-instance martin 17/01/2020
+        [self completeAwaitedCommand:COMMAND_OPEN player:nxplayer result:result];
 
         if(nxplayer != self.player)
             return;
         [self Log:4 toValue:@"completedAsyncCmdOpenWithResult"];
         if( result==NXErrorNone ) {
-            g_playerListener(NEXUNITY_EVENT_ASYNC_COMPLETE,NEXUNITY_ASYNC_CMD_OPEN_STREAMING,0,0,0,0);
+            NexPostEvent(NEXUNITY_EVENT_ASYNC_COMPLETE,NEXUNITY_ASYNC_CMD_OPEN_STREAMING,0,0,0,0);
             [self setThumbnail];
-            [self startPlayer:0 pauseAfterReady:!m_autoPlay];
+            int resumeMs = [self takeWatchdogResume:0];
+            if(resumeMs >= 0)
+                [self startPlayer:resumeMs pauseAfterReady:NO];
+            else
+                [self startPlayer:0 pauseAfterReady:!m_autoPlay || [self isSyncGroupMember:0]];
         } else {
+            [self takeWatchdogResume:0];
             [self nexPlayer:nxplayer encounteredError:result];
             [self Log:4 toValue:@"ERROR completedAsyncCmdOpenWithResult"];
         }
@@ -1841,7 +3418,7 @@ bool isAlticast = false;
     if(!m_isClose && nxplayer == self.player) {
         [self Log:4 toValue:@"completedAsyncCmdStartWithResult"];
         if(result == NXErrorNone)
-            g_playerListener(NEXUNITY_EVENT_ASYNC_COMPLETE,NEXUNITY_ASYNC_CMD_START_STREAMING,0,0,0,0);
+            NexPostEvent(NEXUNITY_EVENT_ASYNC_COMPLETE,NEXUNITY_ASYNC_CMD_START_STREAMING,0,0,0,0);
         else {
             [self nexPlayer:nxplayer encounteredError:result];
             [self Log:4 toValue:@"ERROR completedAsyncCmdStartWithResult"];
@@ -1853,7 +3430,7 @@ bool isAlticast = false;
     [self Log:4 toValue:@"completedAsyncCmdPauseWithResult"];
     if(!m_isClose && nxplayer == self.player) {
         if( result==NXErrorNone ) {
-            g_playerListener(NEXUNITY_EVENT_ASYNC_COMPLETE,NEXUNITY_ASYNC_CMD_PAUSE,0,0,0,0);
+            NexPostEvent(NEXUNITY_EVENT_ASYNC_COMPLETE,NEXUNITY_ASYNC_CMD_PAUSE,0,0,0,0);
         }else{
             [self nexPlayer:nxplayer encounteredError:result];
         }
@@ -1864,7 +3441,7 @@ bool isAlticast = false;
     [self Log:4 toValue:@"completedAsyncCmdResumeWithResult"];
     if(!m_isClose && nxplayer == self.player) {
         if(result == NXErrorNone)
-            g_playerListener(NEXUNITY_EVENT_ASYNC_COMPLETE,NEXUNITY_ASYNC_CMD_RESUME,0,0,0,0);
+            NexPostEvent(NEXUNITY_EVENT_ASYNC_COMPLETE,NEXUNITY_ASYNC_CMD_RESUME,0,0,0,0);
         else
             [self nexPlayer:nxplayer encounteredError:result];
     }
@@ -1876,7 +3453,7 @@ bool isAlticast = false;
 
     if(!m_isClose && nxplayer == self.player) {
         if(result == NXErrorNone)
-            g_playerListener(NEXUNITY_EVENT_ASYNC_COMPLETE,NEXUNITY_ASYNC_CMD_STOP,0,0,0,0);
+            NexPostEvent(NEXUNITY_EVENT_ASYNC_COMPLETE,NEXUNITY_ASYNC_CMD_STOP,0,0,0,0);
         else {
             [self Log:4 toValue:@"ERROR completedAsyncCmdStopWithResult"];
             [self nexPlayer:nxplayer encounteredError:result];
@@ -1886,11 +3463,20 @@ bool isAlticast = false;
 
 - (void)nexPlayer:(NXPlayer *)nxplayer completedAsyncCmdSeekWithResult:(NXError)result {
     [self Log:4 toValue:@"completedAsyncCmdSeekWithResult"];
+    NexPublishPlayhead([self indexOfPlayer:nxplayer], (int64_t)nxplayer.currentTimeStamp, -1, 0);
+    [self renderExternalSubtitles:[self indexOfPlayer:nxplayer] at:(int64_t)nxplayer.currentTimeStamp];
+    [self advanceTimeline:[self indexOfPlayer:nxplayer] to:(int64_t)nxplayer.currentTimeStamp seek:YES];
+
+    if([self completeTrickPlaySeek:nxplayer])
+        return;
+    if([self completeSyncGroupSeek:nxplayer])
+        return;
+    [self completeAwaitedCommand:COMMAND_SEEK player:nxplayer result:result];
 
     if(!m_isClose && nxplayer != nil) // TODO Add this to every other Async event to ensure it works for multistream
     {
         if( result==NXErrorNone ) {
-            g_playerListener(NEXUNITY_EVENT_ASYNC_COMPLETE,NEXUNITY_ASYNC_CMD_SEEK,0,0,0,0);
+            NexPostEvent(NEXUNITY_EVENT_ASYNC_COMPLETE,NEXUNITY_ASYNC_CMD_SEEK,0,0,0,0);
         } else {
             [self nexPlayer:nxplayer encounteredError:result];
         }
@@ -1916,7 +3502,7 @@ bool isAlticast = false;
     }
 
     if(!m_isClose)
-        g_playerListener(NEXUNITY_EVENT_END_OF_CONTENT,0,0,0,0,0);
+        NexPostEvent(NEXUNITY_EVENT_END_OF_CONTENT,0,0,0,0,0);
 
     //[nxplayer stop];
 }
@@ -1928,56 +3514,165 @@ bool isAlticast = false;
     return (int) bufferSize;
 }
 
+#pragma mark - Frame governor
+
+-(void)refreshStats:(int)index {
+    NXPlayer *player = [self playerAtIndex:index];
+    if(player == nil)
+        return;
+    NXStatisticsAPI *statistics = index == 0 ? self.statisticsAPI : multiStatisticsAPI[index];
+    if(statistics == nil && index > 0){
+        statistics = multiStatisticsAPI[index] = [[NXStatisticsAPI alloc] initWithPlayer:player];
+        statistics.httpStateDelegate = self;
+    }
+
+    NXContentInfo *info = player.contentInfo;
+    NexStatsSnapshot stats;
+    stats.state = (int)player.state;
+    stats.currentTimeMs = (int)player.currentTimeStamp;
+    stats.bufferedEndMs = statistics != nil ? stats.currentTimeMs + (int)[statistics.bufferInfo totalDuration:NXBufferInfoMediaTypeVideo] : -1;
+    stats.durationMs = (int)info.totalPlayTime;
+    stats.videoBitrate = (int)info.videoBitrate;
+    stats.audioBitrate = (int)info.audioBitrate;
+    stats.width = (int)info.width;
+    stats.height = (int)info.height;
+    stats.frameRate = (int)info.videoFrameRate;
+    stats.trackBandwidth = (int)info.currentVideoStream.currentTrack.bandwidth;
+    NexPublishStats(index, stats);
+}
+
+-(void)rebuildCatalog {
+    // Written in place into the inactive arena; catalogLock is only taken to flip it in.
+    std::lock_guard<std::mutex> build(catalogBuildLock);
+    NexCatalogBuffer &built = NexBeginCatalog();
+    NXMediaType kinds[2] = { NXMediaTypeAudio, NXMediaTypeText };
+    for(int i = 0; i < 8; i++){
+        NXPlayer *player = [self playerAtIndex:i];
+        NXContentInfo *info = player.contentInfo;
+        for(int kind = NEXUNITY_STREAM_AUDIO; kind <= NEXUNITY_STREAM_TEXT; kind++){
+            built.streamStart[i][kind] = built.streamTotal;
+            built.streamCount[i][kind] = 0;
+            if(info == nil)
+                continue;
+            NXMediaStreamInfo *current = kind == NEXUNITY_STREAM_AUDIO ? info.currentAudioStream : info.currentTextStream;
+            for(NXMediaStreamInfo *stream in [info streamsOfType:kinds[kind]]){
+                if(built.streamTotal == CATALOG_MAX_STREAMS)
+                    break;
+                NexStreamRecord record;
+                record.instance = i;
+                record.kind = kind;
+                record.streamIndex = built.streamCount[i][kind]++;
+                record.id = (int32_t)stream.internalId;
+                record.nameOffset = NexInternString(built, stream.name);
+                record.languageOffset = NexInternString(built, stream.language);
+                record.isCurrent = current != nil && current.internalId == stream.internalId;
+                record.reserved = 0;
+                built.streams[built.streamTotal++] = record;
+                // First occurrence wins, matching the old search loops for duplicate ids.
+                built.streamById.emplace(NexCatalogKey(i, kind, stream.internalId), record.streamIndex);
+            }
+        }
+
+        built.trackStart[i] = built.trackTotal;
+        built.trackCount[i] = 0;
+        NXMediaStreamInfo *video = info.currentVideoStream;
+        for(NXTrackInfo *trackInfo in video.tracks){
+            if(built.trackTotal == CATALOG_MAX_TRACKS)
+                break;
+            NexTrackRecord track;
+            track.instance = i;
+            track.trackIndex = built.trackCount[i]++;
+            track.id = (int32_t)trackInfo.internalId;
+            track.bandwidth = trackInfo.bandwidth;
+            track.width = (int32_t)trackInfo.width;
+            track.height = (int32_t)trackInfo.height;
+            track.frameRateMilli = (int32_t)(trackInfo.frameRate * 1000.0);
+            track.codec = (int32_t)trackInfo.codecID;
+            track.avcProfile = (int32_t)trackInfo.avcProfile;
+            track.avcLevel = (int32_t)trackInfo.avcLevel;
+            track.iFrame = trackInfo.iFrameTrack;
+            track.isCurrent = video.currentTrack != nil && video.currentTrack.internalId == trackInfo.internalId;
+            built.tracks[built.trackTotal++] = track;
+        }
+    }
+    NexPublishCatalog();
+}
+
+-(void)governorTick:(int)budgetUs {
+    int64_t startUs = NexMonotonicUs();
+    int64_t deadlineUs = startUs + std::max(budgetUs - governorDebtUs.load(), budgetUs / 2);
+
+    // Events first, in priority order; at least one per frame so a tiny budget still progresses.
+    NexQueuedEvent event;
+    bool first = true;
+    while((first || NexMonotonicUs() < deadlineUs) && NexPopEvent(&event)){
+        first = false;
+        if(g_playerListener)
+            g_playerListener(event.event,event.args[0],event.args[1],event.args[2],event.args[3],event.args[4]);
+    }
+
+    // Deferred stats refresh, round-robin over the instances in use.
+    int instances = std::max(1, std::min((int)self.multiStreamScreens, 8));
+    for(int i = 0; i < instances && NexMonotonicUs() < deadlineUs; i++){
+        [self refreshStats:governorStatsCursor % instances];
+        governorStatsCursor = (governorStatsCursor + 1) % instances;
+    }
+
+    int elapsedUs = (int)(NexMonotonicUs() - startUs);
+    int debtUs = std::max(0, elapsedUs - budgetUs);
+    governorDebtUs = debtUs;
+    if(debtUs > 0){
+        governorOverruns++;
+        governorLastOverrunUs = debtUs;
+        // Only the tick writes these; the atomics keep GetGovernorStats readers race-free.
+        if(debtUs > governorMaxOverrunUs)
+            governorMaxOverrunUs = debtUs;
+    }
+}
+
 - (void)nexPlayer:(NXPlayer *)nxplayer encounteredError:(NXError)errorCode {
+    if([self absorbError:errorCode player:nxplayer])
+        return;
     if(g_playerListener)
-        g_playerListener(NEXUNITY_EVENT_ERROR,errorCode,0,0,0,0);
+        NexPostEvent(NEXUNITY_EVENT_ERROR,errorCode,0,0,0,0);
 }
 
 -(void)nexPlayerDidUpdateContentInfo:(NXPlayer *)nxplayer {
+    [self rebuildCatalog];
     if(!m_isClose && nxplayer == self.player) {
         if(g_playerListener)
-            g_playerListener(NEXUNITY_EVENT_UPDATE_CONTENT_INFO,0,0,0,0,0);
+            NexPostEvent(NEXUNITY_EVENT_UPDATE_CONTENT_INFO,0,0,0,0,0);
     }
 }
 
 -(void)nexPlayerDidBeginBuffering:(NXPlayer *)nxplayer {
+    [self syncGroupPlayer:nxplayer buffering:YES];
     if(!m_isClose && nxplayer == self.player) {
         if(g_playerListener)
-            g_playerListener(NEXUNITY_EVENT_BUFFERING,0,0,0,0,0);
+            NexPostEvent(NEXUNITY_EVENT_BUFFERING,0,0,0,0,0);
     }
 }
 
 -(void)nexPlayerDidFinishBuffering:(NXPlayer *)nxplayer {
+    [self syncGroupPlayer:nxplayer buffering:NO];
     if(!m_isClose && nxplayer == self.player) {
         if(g_playerListener)
-            g_playerListener(NEXUNITY_EVENT_BUFFERING,2,100,0,0,0);
+            NexPostEvent(NEXUNITY_EVENT_BUFFERING,2,100,0,0,0);
     }
 }
 
 -(void)nexPlayer:(NXPlayer *)nxplayer bufferingProgress:(NSInteger)percent {
     if(!m_isClose && nxplayer == self.player) {
         if(g_playerListener)
-            g_playerListener(NEXUNITY_EVENT_BUFFERING,1,(int)percent,0,0,0);
+            NexPostEvent(NEXUNITY_EVENT_BUFFERING,1,(int)percent,0,0,0);
     }
 }
 
 - (void) nexPlayer:(NXPlayer *)nxplayer subTitleChange:(NSString *)subtitleText start:(NSUInteger)startTime end:(NSUInteger)endTime {
     [self Log:4 toValue:@"caption: text:\n" value5:subtitleText];
 
-    if(self.multiStreamScreens > 1){
-        if(nxplayer == self.player) lastSubMultiIndex = 0;
-        for(int i = 1; i < self.multiStreamScreens; i++)
-            if(nxplayer == multiPlayers[i]) lastSubMultiIndex = i;
-    }
-    [self Log:4 toValue:@"caption: text:\n" value5:subtitleText];
     //NSLog(@"caption Info : %lu %lu \n",startTime,endTime);
-    self.current_subtitle = subtitleText;
-    self.subtitle_startTime = 0;
-    self.subtitle_endTime = 0;
-    if(!m_isClose) {
-        if(g_playerListener && !isAlticast)
-            g_playerListener(NEXUNITY_EVENT_TEXT_RENDER,0,0,0,0,0);
-    }
+    [self publishSubtitle:subtitleText player:nxplayer type:-1 start:(int64_t)startTime end:(int64_t)endTime];
 }
 
 - (void)nexPlayer:(NXPlayer*)nxplayer updatedCaption:(NXClosedCaption *)caption {
@@ -1986,124 +3681,1775 @@ bool isAlticast = false;
 
     [self Log:4 toValue:@"caption: text:\n" value5: caption.text];
 
-    if(self.multiStreamScreens > 1){
-        if(nxplayer == self.player) lastSubMultiIndex = 0;
-        for(int i = 1; i < self.multiStreamScreens; i++)
-            if(nxplayer == multiPlayers[i]) lastSubMultiIndex = i;
-    }
-
     if ( caption.type == NXCaptionTypeWebVTT) {
-        int length = [caption.text length];
-        self.current_subtitle = caption.text;
-        self.subtitle_startTime = 0;
-        self.subtitle_endTime = 0;
-        self.subtitle_type = 0x50000001;
-
-        if(!m_isClose) {
-            if(self.current_subtitle == NULL)
-                self.current_subtitle = @"";
-            //NSLog(@"caption: type:0x%02x\n text:%@ \n length:%d \n", caption.type, self.current_subtitle, length);
-            if(g_playerListener)
-                g_playerListener(NEXUNITY_EVENT_TEXT_RENDER,0,0,0,0,0);
-        }
+        [self publishSubtitle:caption.text player:nxplayer type:NEXUNITY_SUBTITLE_WEBVTT start:-1 end:-1];
     } else if (caption.type == NXCaptionTypeTTML) {
-        // render caption.plainText
+        [self publishSubtitle:caption.plainText player:nxplayer type:NEXUNITY_SUBTITLE_TTML start:-1 end:-1];
     }
 }
 
 - (void)nexPlayer:(NXPlayer*)nxplayer updatedMetaData:(NSDictionary*)metaData {
     [self Log:4 toValue:@"Update Metadta \n"];
-    if(metaData != nil)
-        self.timedMetadata = metaData;
+    int index = [self indexOfPlayer:nxplayer];
+    if(metaData == nil || index < 0)
+        return;
+    std::shared_ptr<const NexTagSet> filter = NexSubscribedTags();
+    if(filter != nullptr){
+        std::lock_guard<std::mutex> lock(customTagLock);
+        if(!NexMetadataChanged(index, metaData, *filter)){
+            suppressedMetadataUpdates[index]++;
+            return;
+        }
+    }
+    // One pass over the dictionary; every getter afterwards reads the flat buffer.
+    std::vector<uint8_t> serialized;
+    NexSerializeMetadata(metaData, serialized, 0, index, filter.get());
+
+    // The callback has no PTS. Metadata is delivered as the demuxer reaches it, so it belongs
+    // at the end of what is buffered, not at the playhead; it is held until the playhead gets there.
+    int64_t playheadMs = (int64_t)nxplayer.currentTimeStamp;
+    int64_t ptsMs = std::max(playheadMs, [self demuxPositionOf:index player:nxplayer]);
+    {
+        std::lock_guard<std::mutex> lock(timelineLock);
+        NexTimelineInsert(index, ptsMs, 0, NEXUNITY_TIMELINE_ID3, serialized);
+    }
+    [self advanceTimeline:index to:playheadMs seek:NO];
+}
 
-    if(g_playerListener)
-        g_playerListener(NEXUNITY_EVENT_TIMED_METADATA_RENDER,0,0,0,0,0);
+-(int64_t)demuxPositionOf:(int)index player:(NXPlayer *)nxplayer {
+    NXStatisticsAPI *statistics = index == 0 ? self.statisticsAPI : multiStatisticsAPI[index];
+    if(statistics == nil)
+        return (int64_t)nxplayer.currentTimeStamp;
+    return (int64_t)nxplayer.currentTimeStamp + (int64_t)[statistics.bufferInfo totalDuration:NXBufferInfoMediaTypeVideo];
 }
 
-- (void) setCustomTags:(NSString *)Tags {
-    self.CUSTOM_TAGS = [[NSString alloc] initWithString:Tags];
+// Makes a serialized metadata buffer the instance's current one (legacy getters, buffer export).
+-(void)publishMetadata:(int)index bytes:(const std::vector<uint8_t> &)bytes {
+    std::lock_guard<std::mutex> lock(metadataLock);
+    uint32_t generation = metadataGeneration[index].load(std::memory_order_relaxed) + 1;
+    std::vector<uint8_t> &slot = metadataBuffers[index];
+    slot = bytes;
+    if(slot.size() >= sizeof(NexMetadataHeader))
+        ((NexMetadataHeader *)slot.data())->generation = generation;
+    metadataGeneration[index].store(generation, std::memory_order_release);
 }
 
-- (void)nexPlayer:(NXPlayer*)nxplayer playheadAdvancedTo:(NXDuration)newPosition {
-    if(g_playerListener)
-        g_playerListener(NEXUNITY_EVENT_TIME,(int)self.player.currentTimeStamp,0,0,0,0);
+// Fires the entries in (cursor, ptsMs]. A seek, or a jump larger than TIMELINE_SEEK_GAP_MS,
+// only moves the cursor; ID3 metadata then re-publishes the latest entry at or before ptsMs so
+// the getters describe the new position.
+-(void)advanceTimeline:(int)index to:(int64_t)ptsMs seek:(BOOL)seek {
+    if(index < 0 || index >= 8)
+        return;
+    std::vector<NexTimelineEntry> crossed;
+    std::vector<uint8_t> current;
+    bool hasCurrent = false;
+    {
+        std::lock_guard<std::mutex> lock(timelineLock);
+        std::vector<NexTimelineItem> &items = timeline[index];
+        int64_t cursorMs = timelineCursorMs[index];
+        bool jump = seek || cursorMs < 0 || ptsMs < cursorMs || ptsMs - cursorMs > TIMELINE_SEEK_GAP_MS;
+        if(jump){
+            auto last = std::upper_bound(items.begin(), items.end(), ptsMs, [](int64_t pts, const NexTimelineItem &item) {
+                return pts < item.entry.ptsMs;
+            });
+            while(last != items.begin()){
+                --last;
+                if(last->entry.kind == NEXUNITY_TIMELINE_ID3){
+                    current = last->payload;
+                    hasCurrent = true;
+                    break;
+                }
+            }
+            // After a jump only entries stamped exactly at the new position fire.
+            cursorMs = ptsMs - 1;
+        }
+        if(ptsMs > cursorMs){
+            auto first = std::upper_bound(items.begin(), items.end(), cursorMs, [](int64_t pts, const NexTimelineItem &item) {
+                return pts < item.entry.ptsMs;
+            });
+            for(auto it = first; it != items.end() && it->entry.ptsMs <= ptsMs; ++it){
+                crossed.push_back(it->entry);
+                if(it->entry.kind == NEXUNITY_TIMELINE_ID3){
+                    current = it->payload;
+                    hasCurrent = true;
+                }
+            }
+        }
+        timelineCursorMs[index] = ptsMs;
+    }
+    if(hasCurrent)
+        [self publishMetadata:index bytes:current];
+    if(m_isClose || !g_playerListener)
+        return;
+    for(const NexTimelineEntry &entry : crossed){
+        NexPostEvent(NEXUNITY_EVENT_METADATA_CUE,index,(int)entry.id,entry.kind,(int)entry.ptsMs,0);
+        if(entry.kind == NEXUNITY_TIMELINE_ID3)
+            NexPostEvent(NEXUNITY_EVENT_TIMED_METADATA_RENDER,index,0,0,0,0);
+    }
 }
 
-#pragma mark - NXABRDelegate
+-(void)resetTimeline:(int)index {
+    std::lock_guard<std::mutex> lock(timelineLock);
+    timeline[index].clear();
+    timelineBytes[index] = 0;
+    timelineCursorMs[index] = -1;
+}
 
-- (NSUInteger)nexPlayer:(NXPlayer *)nxplayer willChangeABRTrackWithParams:(NXPlayerABRControllerTrackChangeParams)params {
-    //NSLog(@"Track change current:%lu next:%lu net:%lu", (unsigned long)params.curTrackBW, (unsigned long)params.nextTrackBW, (unsigned long)params.netBW);
-    return params.nextTrackBW;
+// Comma-separated tag ids (TXXX descriptions, PRIV owners, frame ids); empty clears the subscription.
+- (void) setCustomTags:(NSString *)Tags {
+    std::shared_ptr<NexTagSet> tags;
+    for(NSString *part in [Tags componentsSeparatedByString:@","]){
+        NSString *tag = [part stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+        if(tag.length == 0)
+            continue;
+        if(tags == nullptr)
+            tags = std::make_shared<NexTagSet>();
+        tags->insert([tag UTF8String]);
+    }
+    std::lock_guard<std::mutex> lock(customTagLock);
+    customTagsValue = customTagsInterned.insert(Tags != nil ? [Tags UTF8String] : "").first->c_str();
+    subscribedTags = tags;
+    for(int i = 0; i < 8; i++)
+        tagValueHashes[i].clear();
 }
 
-- (void)setSecretValueForSignature:secret{
-    if(secret)
-        m_AlticastSecret = secret;
+- (void)nexPlayer:(NXPlayer*)nxplayer playheadAdvancedTo:(NXDuration)newPosition {
+    int index = [self indexOfPlayer:nxplayer];
+    NexPublishPlayhead(index, (int64_t)newPosition, -1, 0);
+    if(index >= 0 && resilienceFailing[index].load(std::memory_order_relaxed))
+        [self resilienceProgress:index];
+    [self renderExternalSubtitles:index at:(int64_t)newPosition];
+    [self advanceTimeline:index to:(int64_t)newPosition seek:NO];
+    // The TIME event carries no instance, so only the main player reports it.
+    if(g_playerListener && timeEventsEnabled && index == 0)
+        NexPostEvent(NEXUNITY_EVENT_TIME,(int)newPosition,0,0,0,0);
+}
+
+// Playback-rate changes go through here so the playhead record extrapolates at the new rate.
+-(NXError)setPlaybackRate:(float)rate forPlayer:(NXPlayer *)nxplayer {
+    if(nxplayer == nil)
+        return NXErrorInvalidParameter;
+    NXError result = [nxplayer setPlaybackRate:rate];
+    if(result == NXErrorNone)
+        NexPublishPlayhead([self indexOfPlayer:nxplayer], (int64_t)nxplayer.currentTimeStamp, -1, rate);
+    return result;
 }
 
-- (BOOL)setLicenseFilePath:licensePath {
-    BOOL licenseExists = NO;
-    if(licensePath){
-        BOOL licenseFileExists = [[NSFileManager defaultManager] fileExistsAtPath:licensePath];
-        if(licenseFileExists){
-            m_licenseFilePath = licensePath;
-            licenseExists = YES;
+#pragma mark - External subtitles
+
+// Parses a local WebVTT/SRT/TTML file for an instance. On success the plugin renders it from
+// the playhead and the SDK is not given the file; anything else (remote URLs, other formats)
+// stays with the SDK as before.
+-(BOOL)loadExternalSubtitles:(NSString *)path index:(int)index {
+    std::shared_ptr<NexSubtitleTrack> track;
+    if(path != nil && ![path hasPrefix:@"http://"] && ![path hasPrefix:@"https://"]){
+        NSString *filePath = [path hasPrefix:@"file://"] ? [NSURL URLWithString:path].path : path;
+        NSData *data = [NSData dataWithContentsOfFile:filePath options:NSDataReadingMappedIfSafe error:nil];
+        if(data != nil){
+            track = std::make_shared<NexSubtitleTrack>();
+            if(!track->parse((const char *)data.bytes, data.length))
+                track.reset();
         }
     }
-    return licenseExists;
-}
-
--(void)setTrack:(NSUInteger)bitRate{
-    if(chosenPlayerMulti == 0){
-        self.abrController = [[NXPlayerABRController alloc] initWithPlayer:self.player];
-        [self.abrController setTargetBandwidth:bitRate segmentOption:NexBandwidthSegmentOptionDefault targetOption:NexBandwidthTargetOptionMatch];
+    {
+        std::lock_guard<std::mutex> lock(externalSubtitleLock);
+        externalSubtitles[index] = track;
     }
-    else {
-        self.abrController = [[NXPlayerABRController alloc] initWithPlayer:multiPlayers[chosenPlayerMulti]];
-        [self.abrController setTargetBandwidth:bitRate segmentOption:NexBandwidthSegmentOptionDefault targetOption:NexBandwidthTargetOptionMatch];
+    if(track == nullptr)
+        return NO;
+    [self Log:4 toValue:[NSString stringWithFormat:@"external subtitles: %lu cues parsed in %lld us \n",
+                         (unsigned long)track->cues.size(), (long long)track->parseUs]];
+    NXPlayer *player = [self playerAtIndex:index];
+    if(player != nil)
+        [self renderExternalSubtitles:index at:(int64_t)player.currentTimeStamp];
+    return YES;
+}
+
+// Called on every playhead update and seek completion; the cue slot drops unchanged results.
+-(void)renderExternalSubtitles:(int)index at:(int64_t)ptsMs {
+    std::shared_ptr<const NexSubtitleTrack> track = NexExternalSubtitles(index);
+    if(track == nullptr)
+        return;
+    static thread_local std::vector<uint32_t> active;
+    static thread_local std::string text;
+    text.clear();
+    if(externalSubtitlesOn)
+        track->query(ptsMs, active);
+    else
+        active.clear();
+    // Overlapping cues are shown together, one per line; the result holds while all of them do.
+    int64_t startMs = -1, endMs = -1;
+    for(uint32_t cue : active){
+        const NexSubtitleCue &entry = track->cues[cue];
+        if(!text.empty())
+            text.push_back('\n');
+        text.append(&track->text[entry.textOffset], entry.textLength);
+        startMs = std::max(startMs, entry.startMs);
+        endMs = endMs < 0 ? entry.endMs : std::min(endMs, entry.endMs);
+    }
+    [self publishCue:text.c_str() index:index type:track->format start:startMs end:endMs playhead:ptsMs];
+}
+//End external subtitles
+
+#pragma mark - Manifest index
+
+// Builds an instance's segment index from manifest bytes; url is where they came from and the
+// base for relative BaseURLs. A manifest that does not parse leaves the instance without an index.
+-(BOOL)loadManifest:(const char *)data length:(size_t)length url:(NSString *)url index:(int)index {
+    if(index < 0 || index >= 8)
+        return NO;
+    const char *manifestUrl = url != nil ? [url UTF8String] : "";
+    std::lock_guard<std::mutex> load(manifestLoadLocks[index]);
+    NexManifestIndex *current = manifestIndexes[index].get();
+    if(data != NULL && current != NULL && current->live && current->url == manifestUrl){
+        // A reload of the live manifest already indexed is diffed against it, off the lock.
+        NSString *message = nil;
+        if(current->mediaOnly() && current->refreshable(0, manifestUrl)){
+            std::unique_ptr<NexMediaPlaylist> staged = current->stagePlaylist(0, data, length);
+            if(staged != nullptr){
+                std::lock_guard<std::mutex> lock(manifestLock);
+                current->publishPlaylist(0, std::move(staged));
+                current->generation = ++manifestGeneration;
+                message = [NSString stringWithFormat:@"manifest index: instance %d, %u new segments, refreshed in %lld us \n",
+                           index, current->playlists[0]->appendedSegments, (long long)current->refreshUs];
+            }
+        } else if(current->type == NEXUNITY_MANIFEST_DASH){
+            std::unique_ptr<NexManifestIndex> next(new NexManifestIndex());
+            next->window = (size_t)manifestWindows[index];
+            if(next->parse(data, length, manifestUrl, NexWallClockMs(), current)){
+                next->refreshUs = next->parseUs;
+                message = [NSString stringWithFormat:@"manifest index: instance %d, %lld segments, refreshed in %lld us \n",
+                           index, (long long)next->segmentTotal(), (long long)next->refreshUs];
+                std::lock_guard<std::mutex> lock(manifestLock);
+                next->generation = ++manifestGeneration;
+                manifestIndexes[index].swap(next);
+            }
+        }
+        if(message != nil){
+            [self Log:4 toValue:message];
+            return YES;
+        }
     }
 
+    std::unique_ptr<NexManifestIndex> manifest(new NexManifestIndex());
+    manifest->window = (size_t)manifestWindows[index];
+    bool parsed = data != NULL && manifest->parse(data, length, manifestUrl, NexWallClockMs());
+    if(parsed)
+        manifest->generation = ++manifestGeneration;
+    else
+        manifest.reset();
+    NSString *message = manifest == nullptr ? [NSString stringWithFormat:@"manifest index: instance %d, manifest not parsed \n", index] :
+        [NSString stringWithFormat:@"manifest index: instance %d, %lu renditions, %lld segments, parsed in %lld us \n",
+         index, (unsigned long)manifest->renditions.size(), (long long)manifest->segmentTotal(), (long long)manifest->parseUs];
+    {
+        std::lock_guard<std::mutex> lock(manifestLock);
+        manifestIndexes[index].swap(manifest);
+    }
+    [self Log:4 toValue:message];
+    return parsed;
+}
+
+// Attaches an HLS media playlist to a rendition of the instance's master playlist; reloads of the
+// live playlist attached are staged off the lock and published in its place.
+-(BOOL)loadMediaPlaylist:(const char *)data length:(size_t)length url:(NSString *)url index:(int)index rendition:(int)rendition {
+    if(data == NULL || index < 0 || index >= 8)
+        return NO;
+    const char *playlistUrl = url != nil ? [url UTF8String] : NULL;
+    std::lock_guard<std::mutex> load(manifestLoadLocks[index]);
+    NexManifestIndex *manifest = manifestIndexes[index].get();
+    if(manifest == NULL || manifest->type != NEXUNITY_MANIFEST_HLS || rendition < 0 || rendition >= (int)manifest->renditions.size())
+        return NO;
+    NSString *message;
+    if(manifest->refreshable(rendition, playlistUrl)){
+        std::unique_ptr<NexMediaPlaylist> staged = manifest->stagePlaylist(rendition, data, length);
+        if(staged == nullptr)
+            return NO;
+        std::lock_guard<std::mutex> lock(manifestLock);
+        manifest->publishPlaylist(rendition, std::move(staged));
+        manifest->generation = ++manifestGeneration;
+        message = [NSString stringWithFormat:@"manifest index: instance %d rendition %d, %u new segments, refreshed in %lld us \n",
+                   index, rendition, manifest->playlist(rendition)->appendedSegments, (long long)manifest->refreshUs];
+    } else {
+        std::unique_ptr<NexMediaPlaylist> media(new NexMediaPlaylist());
+        if(!media->parse(data, length, playlistUrl, (size_t)manifestWindows[index])){
+            [self Log:4 toValue:[NSString stringWithFormat:@"manifest index: instance %d, media playlist not parsed \n", index]];
+            return NO;
+        }
+        message = [NSString stringWithFormat:@"manifest index: instance %d rendition %d, %lu segments, parsed in %lld us \n",
+                   index, rendition, (unsigned long)media->segments.size(), (long long)media->parseUs];
+        std::lock_guard<std::mutex> lock(manifestLock);
+        manifest->attachPlaylist(rendition, std::move(media));
+        manifest->generation = ++manifestGeneration;
+    }
+    [self Log:4 toValue:message];
+    return YES;
 }
+//End manifest index
 
--(void) nexPlayer:(NXPlayer *)nxplayer didChangeFromState:(NXPlayerState)oldState toState:(NXPlayerState)newState {
-    NSLog(@"state changed %lu -> %lu",(unsigned long)oldState,(unsigned long)newState);
-    g_playerListener(NEXUNITY_EVENT_STATUS_CHANGED,oldState,newState,0,0,0);
+#pragma mark - Device profile
+
+-(int)setDeviceProfile:(int)index toValue:(const NexDeviceProfile *)profile {
+    if(index < 0 || index >= 8)
+        return PLAYER_ERROR_GENERAL;
+    if(profile != NULL && (profile->version != NEXPLAYER_DEVICE_PROFILE_VERSION || profile->size != sizeof(NexDeviceProfile))){
+        [self Log:4 toValue:@"Device profile version mismatch: " value3:profile->version value4:profile->size];
+        return PLAYER_ERROR_GENERAL;
+    }
+    std::lock_guard<std::mutex> lock(profileLock);
+    hasDeviceProfile[index] = profile != NULL;
+    if(profile != NULL)
+        deviceProfiles[index] = *profile;
+    return PLAYER_ERROR_NONE;
+}
+
+// NXManifestAndPlaylistDescrambler: the SDK hands over only top-level manifests, that is every MPD
+// (reloads included) and the master playlist of an HLS stream, before it parses them. The
+// instance's device profile is applied in place and what is left is indexed. HLS media playlists
+// never come through here, so for HLS the index lists the variants the player can pick but holds
+// their segments only once the app loads them with NexPlayerUnity_LoadMediaPlaylist.
+// Never fails the open: a manifest the rewrite does not understand is passed on as it came.
+- (int)descrambleForPlayer:(NXPlayer *)player URL:(NSURL *)url manifestOrPlaylistData:(char *)pData length:(unsigned int *)pdwDataLen {
+    int index = [self indexOfPlayer:player];
+    if(index < 0 || pData == NULL || pdwDataLen == NULL)
+        return 0;
+    NexDeviceProfile profile;
+    bool apply;
+    {
+        std::lock_guard<std::mutex> lock(profileLock);
+        apply = hasDeviceProfile[index];
+        profile = deviceProfiles[index];
+    }
+    if(apply){
+        NexManifestRewriteInfo info = {};
+        *pdwDataLen = (unsigned int)NexApplyDeviceProfile(profile, pData, *pdwDataLen, info);
+        {
+            std::lock_guard<std::mutex> lock(profileLock);
+            info.count = rewriteInfos[index].count + 1;
+            rewriteInfos[index] = info;
+        }
+        if(info.removed > 0)
+            [self Log:4 toValue:[NSString stringWithFormat:@"device profile: instance %d, %d of %d video renditions removed, %d -> %d bytes in %d us \n",
+                                 index, info.removed, info.removed + info.kept, info.inputSize, info.outputSize, info.rewriteUs]];
+    }
+    [self learnCdnLocations:pData length:*pdwDataLen index:index];
+    [self loadManifest:pData length:*pdwDataLen url:[url absoluteString] index:index];
+    return 0;
 }
-@end
+//End device profile
 
-static NexPlayerScripting* _GetPlayer() {
-    static NexPlayerScripting* _Player = nil;
-    if(!_Player)
-        _Player = [[NexPlayerScripting alloc] init];
+#pragma mark - CDN steering
 
-    frameTexture = 0;
+-(void)setCdnLocations:(int)index locations:(NSString *)locations {
+    if(index < 0 || index >= 8)
+        return;
+    std::vector<std::string> urls;
+    for(NSString *line in [locations componentsSeparatedByCharactersInSet:[NSCharacterSet newlineCharacterSet]]){
+        NSString *url = [line stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+        if(url.length > 0)
+            urls.push_back([url UTF8String]);
+    }
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(steeringLock);
+        cdnSteering[index].setLocations(urls, true);
+        count = cdnSteering[index].locations.size();
+    }
+    [self Log:4 toValue:[NSString stringWithFormat:@"CDN steering: instance %d has %lu locations \n", index, (unsigned long)count]];
+}
 
-    return _Player;
+// Alternate BaseURLs of an MPD become the instance's locations unless the app set its own. A live
+// reload listing the same ones keeps what was learned about them.
+-(void)learnCdnLocations:(const char *)data length:(size_t)length index:(int)index {
+    std::vector<std::string> urls = NexMpdLocations(data, length);
+    if(urls.size() < 2)
+        return;
+    std::lock_guard<std::mutex> lock(steeringLock);
+    NexCdnSteering &steering = cdnSteering[index];
+    if(steering.configured)
+        return;
+    bool same = steering.locations.size() == std::min<size_t>(urls.size(), CDN_MAX_LOCATIONS);
+    for(size_t i = 0; same && i < steering.locations.size(); i++)
+        same = steering.locations[i].prefix == NexSchemeless(urls[i].data(), urls[i].size(), NULL);
+    if(!same)
+        steering.setLocations(urls, false);
+}
+
+- (NSString *)nexPlayer:(NXPlayer *)nxplayer onModifyHttpRequest:(NSString *)requestString {
+    int index = [self indexOfPlayer:nxplayer];
+    if(index < 0 || requestString == nil)
+        return requestString;
+    std::shared_ptr<const NexHeaderSet> headers;
+    {
+        std::lock_guard<std::mutex> lock(headerStoreLock);
+        headers = headerStores[index];
+    }
+    std::string request;
+    bool changed = false;
+    int from = -1, to = -1;
+    {
+        std::lock_guard<std::mutex> lock(steeringLock);
+        NexCdnSteering &steering = cdnSteering[index];
+        if(steering.locations.empty() && headers == nullptr)
+            return requestString;
+        request = [requestString UTF8String];
+        if(!steering.locations.empty()){
+            from = steering.current;
+            changed = steering.rewrite(request, NexMonotonicUs());
+            to = steering.current;
+        }
+    }
+    // After steering, so tokens land in the target actually requested.
+    if(headers != nullptr)
+        changed |= NexApplyHeaderSet(*headers, request);
+    if(to != from && to >= 0)
+        [self Log:4 toValue:[NSString stringWithFormat:@"CDN steering: instance %d moved from location %d to %d \n", index, from, to]];
+    return changed ? [NSString stringWithUTF8String:request.c_str()] : requestString;
 }
 
-static NSString* _GetUrl(const char* filename) {
-    return [NSString stringWithUTF8String:filename];
+- (void)nexPlayer:(NXPlayer *)nxplayer urlString:(NSString *)URLString stateInfoDownStart:(NXHttpStateInfoDownStart *)downStart {
+    int index = [self indexOfPlayer:nxplayer];
+    if(index < 0 || URLString == nil)
+        return;
+    watchdogHttpUs[index].store(NexMonotonicUs(), std::memory_order_relaxed);
+    const char *url = [URLString UTF8String];
+    std::lock_guard<std::mutex> lock(steeringLock);
+    if(!cdnSteering[index].locations.empty())
+        cdnSteering[index].started(NexSchemeless(url, strlen(url), NULL), NexMonotonicUs());
 }
 
-static void* g_TexturePointer = NULL;
-static bool alreadyInit = false;
+- (void)nexPlayer:(NXPlayer *)nxplayer urlString:(NSString *)URLString stateInfoDownEnd:(NXHttpStateInfoDownEnd *)downEnd {
+    int index = [self indexOfPlayer:nxplayer];
+    if(index < 0 || URLString == nil)
+        return;
+    watchdogHttpUs[index].store(NexMonotonicUs(), std::memory_order_relaxed);
+    const char *url = [URLString UTF8String];
+    std::lock_guard<std::mutex> lock(steeringLock);
+    if(!cdnSteering[index].locations.empty())
+        cdnSteering[index].finished(NexSchemeless(url, strlen(url), NULL), (int64_t)downEnd.bytesReceived, NexMonotonicUs());
+}
 
-enum NexPlayerEventType {
-    NEXPLAYER_INIT = 0,
-    NEXPLAYER_SHUTDOWN = 1,
-    NEXPLAYER_UPDATE = 2
-};
+- (void)nexPlayer:(NXPlayer *)nxplayer urlString:(NSString *)URLString stateInfoHttpError:(NXHttpStateInfoHttpError *)httpError {
+    int index = [self indexOfPlayer:nxplayer];
+    if(index < 0 || URLString == nil)
+        return;
+    watchdogHttpUs[index].store(NexMonotonicUs(), std::memory_order_relaxed);
+    const char *url = [URLString UTF8String];
+    [self segmentFailed:index player:nxplayer url:url error:httpError.errorCode];
+    std::lock_guard<std::mutex> lock(steeringLock);
+    if(!cdnSteering[index].locations.empty())
+        cdnSteering[index].failed(NexSchemeless(url, strlen(url), NULL), NexMonotonicUs());
+}
 
-// --------------------------------------------------------------------------
-// UnitySetInterfaces
+- (void)nexPlayer:(NXPlayer *)nxplayer urlString:(NSString *)URLString stateInfoDataReceived:(NXHttpStateInfoDataReceived *)dataReceived {
+    int index = [self indexOfPlayer:nxplayer];
+    if(index >= 0)
+        watchdogHttpUs[index].store(NexMonotonicUs(), std::memory_order_relaxed);
+}
+//End CDN steering
 
-static void UNITY_INTERFACE_API OnGraphicsDeviceEvent(UnityGfxDeviceEventType eventType);
+#pragma mark - Stall watchdog
 
-static IUnityInterfaces* s_UnityInterfaces = NULL;
-static IUnityGraphics* s_Graphics = NULL;
-static UnityGfxRenderer s_DeviceType = kUnityGfxRendererNull;
+-(void)enableWatchdog:(int)index enable:(BOOL)enable {
+    if(index < 0 || index >= 8)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(watchdogLock);
+        if(enable && !stallWatchdog[index].enabled)
+            NexResetWatchdog(stallWatchdog[index], NexMonotonicUs());
+        stallWatchdog[index].enabled = enable;
+    }
+    if(!enable)
+        return;
+    if(watchdogQueue == nil)
+        watchdogQueue = dispatch_queue_create("com.nexplayer.unity.watchdog", DISPATCH_QUEUE_SERIAL);
+    if(watchdogTimer == nil){
+        watchdogTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, watchdogQueue);
+        uint64_t interval = (uint64_t)WATCHDOG_TICK_MS * NSEC_PER_MSEC;
+        dispatch_source_set_timer(watchdogTimer, dispatch_time(DISPATCH_TIME_NOW, interval), interval, interval / 10);
+        __weak NexPlayerScripting *weakSelf = self;
+        dispatch_source_set_event_handler(watchdogTimer, ^{
+            [weakSelf watchdogTick];
+        });
+    }
+    std::lock_guard<std::mutex> lock(watchdogLock);
+    if(!watchdogTimerRunning){
+        watchdogTimerRunning = true;
+        dispatch_resume(watchdogTimer);
+    }
+}
 
-extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginLoad(IUnityInterfaces* unityInterfaces)
+-(void)watchdogTick {
+    NXPlayer *players[8] = {nil};
+    {
+        std::lock_guard<std::mutex> lock(watchdogLock);
+        bool any = false;
+        for(int i = 0; i < 8; i++){
+            if(!stallWatchdog[i].enabled)
+                continue;
+            any = true;
+            players[i] = [self playerAtIndex:i];
+        }
+        if(!any){
+            watchdogTimerRunning = false;
+            dispatch_suspend(watchdogTimer);
+            return;
+        }
+    }
+
+    for(int i = 0; i < 8; i++){
+        NXPlayer *player = players[i];
+        // Trick play and the sync group hold their instances still on purpose.
+        if(player == nil || [self isSyncGroupMember:i])
+            continue;
+        {
+            std::lock_guard<std::mutex> lock(trickPlayLock);
+            if(trickPlay[i].active)
+                continue;
+        }
+        NXStatisticsAPI *statistics = i == 0 ? self.statisticsAPI : multiStatisticsAPI[i];
+        bool playing = player.state == NXPlayerStatePlay;
+        int64_t ptsMs = (int64_t)player.currentTimeStamp;
+        int64_t bufferMs = statistics != nil ? (int64_t)[statistics.bufferInfo totalDuration:NXBufferInfoMediaTypeVideo] : 0;
+        int64_t httpUs = watchdogHttpUs[i].load(std::memory_order_relaxed);
+
+        int action, lastAction;
+        int64_t recoveredUs, stalledMs;
+        {
+            std::lock_guard<std::mutex> lock(watchdogLock);
+            NexWatchdog &watchdog = stallWatchdog[i];
+            if(!watchdog.enabled)
+                continue;
+            lastAction = watchdog.lastAction;
+            action = NexWatchdogObserve(watchdog, playing, ptsMs, bufferMs, httpUs, NexMonotonicUs(),
+                                        watchdogStallMs, watchdogBufferMs, watchdogHttpMs, watchdogStepMs, &recoveredUs);
+            stalledMs = watchdog.stats.stalledMs;
+        }
+        if(recoveredUs > 0)
+            [self Log:4 toValue:[NSString stringWithFormat:@"watchdog: instance %d recovered after %lld ms, last action %d \n", i, recoveredUs / 1000, lastAction]];
+        if(action < 0)
+            continue;
+        [self Log:4 toValue:[NSString stringWithFormat:@"watchdog: instance %d stalled for %lld ms at %lld ms, action %d \n", i, stalledMs, ptsMs, action]];
+        int64_t startUs = NexMonotonicUs();
+        BOOL taken = [self takeRecoveryAction:action index:i player:player position:ptsMs];
+        [self Log:4 toValue:[NSString stringWithFormat:@"watchdog: instance %d action %d %@ in %lld us \n", i, action, taken ? @"issued" : @"unavailable", NexMonotonicUs() - startUs]];
+        if(!taken){
+            // Nothing to wait for, escalate on the next tick.
+            std::lock_guard<std::mutex> lock(watchdogLock);
+            stallWatchdog[i].actionUs = 0;
+        }
+    }
+}
+
+// Bandwidth of the video track one rung below the current one, 0 when it is the lowest.
+-(NSUInteger)lowerBandwidthForPlayer:(NXPlayer *)nxplayer {
+    NXMediaStreamInfo *video = nxplayer.contentInfo.currentVideoStream;
+    NSInteger current = video.currentTrack.bandwidth;
+    NSUInteger lower = 0;
+    for(NXTrackInfo *track in video.tracks){
+        if(!track.valid || track.iFrameTrack || track.bandwidth <= 0 || track.bandwidth >= current)
+            continue;
+        if((NSUInteger)track.bandwidth > lower)
+            lower = track.bandwidth;
+    }
+    return lower;
+}
+
+-(BOOL)takeRecoveryAction:(int)action index:(int)index player:(NXPlayer *)nxplayer position:(int64_t)positionMs {
+    switch(action){
+        case NEXUNITY_RECOVERY_RECONNECT:
+            return [nxplayer reconnectNetwork] == NXErrorNone;
+        case NEXUNITY_RECOVERY_SEEK:
+            // Through the worker, so it queues behind the app's own commands.
+            [self enqueueCommand:COMMAND_SEEK index:index arg:(int)positionMs work:nil];
+            return YES;
+        case NEXUNITY_RECOVERY_DROP_RUNG: {
+            NSUInteger bandwidth = [self lowerBandwidthForPlayer:nxplayer];
+            NXPlayerABRController *abr = [[NXPlayerABRController alloc] initWithPlayer:nxplayer];
+            if(bandwidth == 0 || abr == nil)
+                return NO;
+            [abr setTargetBandwidth:bandwidth segmentOption:NexBandwidthSegmentOptionQuickMix targetOption:NexBandwidthTargetOptionMatch];
+            return YES;
+        }
+        case NEXUNITY_RECOVERY_REOPEN:
+            return [self reopenStalled:index player:nxplayer position:positionMs];
+    }
+    return NO;
+}
+
+// Closes and opens the instance again as a COMMAND_REOPEN on the command worker, resuming VOD at
+// positionMs. Instance 0 resumes from its open completion, the others start right away as
+// openChosenMulti does. A close or stop of the app still queued, or issued before the reopen
+// runs, wins: the reopen is dropped and the instance stays closed.
+-(BOOL)reopenStalled:(int)index player:(NXPlayer *)nxplayer position:(int64_t)positionMs {
+    NSString *path = index == 0 && self.multiStreamScreens <= 1 ? watchdogPaths[0] : multiPaths[index];
+    if(path == nil || offlineMode)
+        return NO;
+    int generation;
+    {
+        std::lock_guard<std::mutex> lock(commandLock);
+        generation = latestLifecycleToken;
+        NexCommandRecord *lifecycle = NexCommandRecordFor(generation);
+        if(lifecycle != NULL && lifecycle->kind != COMMAND_OPEN &&
+           (lifecycle->status == NEXUNITY_COMMAND_PENDING || lifecycle->status == NEXUNITY_COMMAND_RUNNING))
+            return NO;
+    }
+    NXDuration duration = nxplayer.contentInfo.totalPlayTime;
+    int64_t resumeMs = duration != NXDuration_Unknown && duration > 0 ? positionMs : -1;
+    NSString *subtitles = self.subtitle_path;
+    __weak NexPlayerScripting *weakSelf = self;
+    [self enqueueCommand:COMMAND_REOPEN index:index arg:generation work:^int{
+        // Marked only once the reopen runs, so a superseded one leaves no position for the next open.
+        {
+            std::lock_guard<std::mutex> lock(watchdogLock);
+            stallWatchdog[index].reopening = true;
+            stallWatchdog[index].resumeMs = resumeMs;
+        }
+        [nxplayer close];
+        NXError result = [nxplayer open:path mode:NXOpenModeAuto subtitles:subtitles transport:NXTransportTypeTCP autoPlay:index != 0];
+        if(result == NXErrorNone && index != 0)
+            [nxplayer startFromTime:(NXDuration)std::max<int64_t>(resumeMs, 0) pauseAfterReady:NO];
+        if(result != NXErrorNone || index != 0){
+            std::lock_guard<std::mutex> lock(watchdogLock);
+            stallWatchdog[index].reopening = false;
+        }
+        [weakSelf Log:4 toValue:[NSString stringWithFormat:@"watchdog: instance %d reopened, result %d \n", index, (int)result]];
+        return result;
+    }];
+    return YES;
+}
+
+// Start position for the open completion of an instance the watchdog reopened, else -1.
+-(int)takeWatchdogResume:(int)index {
+    std::lock_guard<std::mutex> lock(watchdogLock);
+    if(!stallWatchdog[index].reopening)
+        return -1;
+    stallWatchdog[index].reopening = false;
+    return (int)std::max<int64_t>(stallWatchdog[index].resumeMs, 0);
+}
+//End stall watchdog
+
+#pragma mark - Resilience
+
+-(int)setResiliencePolicy:(int)index toValue:(const NexResiliencePolicy *)policy {
+    if(index < 0 || index >= 8)
+        return PLAYER_ERROR_GENERAL;
+    if(policy != NULL && (policy->version != NEXPLAYER_RESILIENCE_VERSION || policy->size != sizeof(NexResiliencePolicy))){
+        [self Log:4 toValue:@"Resilience policy version mismatch: " value3:policy->version value4:policy->size];
+        return PLAYER_ERROR_GENERAL;
+    }
+    {
+        std::lock_guard<std::mutex> lock(resilienceLock);
+        resilience[index].enabled = policy != NULL;
+        if(policy != NULL)
+            NexResetResilience(resilience[index], policy, (uint64_t)NexMonotonicUs() * (index + 1));
+        resilienceFailing[index].store(false, std::memory_order_relaxed);
+    }
+    // The timeouts go out with the config properties.
+    [self applyConfig:index];
+    return PLAYER_ERROR_NONE;
+}
+
+// A new open gets the whole session budget again.
+-(void)resetResilienceSession:(int)index {
+    std::lock_guard<std::mutex> lock(resilienceLock);
+    NexResilience &instance = resilience[index];
+    if(!instance.enabled)
+        return;
+    NexResiliencePolicy policy = instance.policy;
+    NexResilienceStats stats = instance.stats;
+    int64_t recoveredTotalMs = instance.recoveredTotalMs;
+    NexResetResilience(instance, &policy, instance.random);
+    // Counters span sessions; only the budget starts over.
+    instance.stats = stats;
+    instance.stats.sessionRetriesLeft = policy.sessionRetries;
+    instance.recoveredTotalMs = recoveredTotalMs;
+    resilienceFailing[index].store(false, std::memory_order_relaxed);
+}
+
+// YES when the error is handled here and must not reach the app.
+-(BOOL)absorbError:(NXError)errorCode player:(NXPlayer *)nxplayer {
+    int index = [self indexOfPlayer:nxplayer];
+    if(index < 0)
+        return NO;
+    int decision, delayMs = 0;
+    {
+        std::lock_guard<std::mutex> lock(resilienceLock);
+        if(!resilience[index].enabled)
+            return NO;
+        decision = NexResilienceFailure(resilience[index], (uint32_t)errorCode, NexClassifyError((uint32_t)errorCode), (int64_t)nxplayer.currentTimeStamp,
+                                        NexMonotonicUs(), &delayMs);
+    }
+    if(decision == RESILIENCE_FORWARD){
+        [self Log:4 toValue:[NSString stringWithFormat:@"resilience: instance %d error 0x%x passed to the app \n", index, (unsigned)errorCode]];
+        return NO;
+    }
+    if(decision == RESILIENCE_RETRY)
+        [self scheduleRetry:index player:nxplayer delay:delayMs error:(uint32_t)errorCode];
+    return YES;
+}
+
+-(void)segmentFailed:(int)index player:(NXPlayer *)nxplayer url:(const char *)url error:(NXError)errorCode {
+    int decision, delayMs = 0;
+    {
+        std::lock_guard<std::mutex> lock(resilienceLock);
+        if(!resilience[index].enabled)
+            return;
+        decision = NexResilienceSegmentFailure(resilience[index], url, (uint32_t)errorCode, NexClassifyError((uint32_t)errorCode),
+                                               (int64_t)nxplayer.currentTimeStamp, NexMonotonicUs(), &delayMs);
+    }
+    if(decision == RESILIENCE_RETRY)
+        [self scheduleRetry:index player:nxplayer delay:delayMs error:(uint32_t)errorCode];
+}
+
+-(void)scheduleRetry:(int)index player:(NXPlayer *)nxplayer delay:(int)delayMs error:(uint32_t)errorCode {
+    resilienceFailing[index].store(true, std::memory_order_relaxed);
+    [self Log:4 toValue:[NSString stringWithFormat:@"resilience: instance %d error 0x%x, retry in %d ms \n", index, errorCode, delayMs]];
+    if(resilienceQueue == nil)
+        resilienceQueue = dispatch_queue_create("com.nexplayer.unity.resilience", DISPATCH_QUEUE_SERIAL);
+    __weak NexPlayerScripting *weakSelf = self;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)delayMs * NSEC_PER_MSEC), resilienceQueue, ^{
+        [weakSelf retry:index player:nxplayer];
+    });
+}
+
+// Reconnects an instance that is still playing or paused; one the SDK stopped is reopened at
+// the position of the first error, as the watchdog does.
+-(void)retry:(int)index player:(NXPlayer *)nxplayer {
+    int64_t positionMs;
+    {
+        std::lock_guard<std::mutex> lock(resilienceLock);
+        NexResilience &instance = resilience[index];
+        instance.scheduled = false;
+        if(!instance.enabled || instance.failedUs == 0 || nxplayer != [self playerAtIndex:index])
+            return;
+        instance.stats.retries++;
+        positionMs = instance.positionMs;
+    }
+    int64_t startUs = NexMonotonicUs();
+    NXPlayerState state = nxplayer.state;
+    NXError result = NXErrorNone;
+    if(state == NXPlayerStatePlay || state == NXPlayerStatePause)
+        result = [nxplayer reconnectNetwork];
+    else if(![self reopenStalled:index player:nxplayer position:positionMs])
+        result = NXErrorInvalidState;
+    [self Log:4 toValue:[NSString stringWithFormat:@"resilience: instance %d %@, result %d in %lld us \n", index,
+                         state == NXPlayerStatePlay || state == NXPlayerStatePause ? @"reconnected" : @"reopened", (int)result, NexMonotonicUs() - startUs]];
+    // A retry that cannot even be issued is a failure of its own, with the next backoff.
+    if(result != NXErrorNone && ![self absorbError:NXErrorNetworkProtocol player:nxplayer] && g_playerListener)
+        NexPostEvent(NEXUNITY_EVENT_ERROR,result,0,0,0,0);
+}
+
+-(void)resilienceProgress:(int)index {
+    int64_t recoveryMs;
+    {
+        std::lock_guard<std::mutex> lock(resilienceLock);
+        recoveryMs = NexResilienceProgress(resilience[index], NexMonotonicUs());
+        if(recoveryMs < 0)
+            return;
+        resilienceFailing[index].store(false, std::memory_order_relaxed);
+    }
+    [self Log:4 toValue:[NSString stringWithFormat:@"resilience: instance %d recovered after %lld ms \n", index, recoveryMs]];
+}
+//End resilience
+
+#pragma mark - Header store
+
+// Publishes a copy of the instance's set with one header or query token replaced (value nil
+// removes it); returns the new generation, or -1.
+-(int)storeHeaderField:(int)index name:(NSString *)name value:(NSString *)value query:(BOOL)query {
+    if(index < 0 || index >= 8 || name.length == 0)
+        return -1;
+    NSCharacterSet *space = [NSCharacterSet whitespaceCharacterSet];
+    std::string field = [[name stringByTrimmingCharactersInSet:space] UTF8String];
+    std::string text = value != nil ? [[value stringByTrimmingCharactersInSet:space] UTF8String] : "";
+    if(!NexHeaderFieldValid(field, text, query))
+        return -1;
+    uint32_t generation;
+    {
+        std::lock_guard<std::mutex> lock(headerStoreLock);
+        generation = NexPublishHeaderField(headerStores[index], field, value != nil ? text.c_str() : NULL, query);
+    }
+    [self Log:4 toValue:[NSString stringWithFormat:@"header store: instance %d %@ %s %@, generation %u \n", index,
+                         query ? @"token" : @"header", field.c_str(), value != nil ? @"set" : @"removed", generation]];
+    return (int)generation;
+}
+
+// "Name: value" as given to addHTTPHeaderFields, into the store of an instance that is already playing.
+-(void)storeHeaderLine:(int)index line:(NSString *)line {
+    NSRange colon = [line rangeOfString:@":"];
+    if(colon.location == NSNotFound)
+        return;
+    [self storeHeaderField:index name:[line substringToIndex:colon.location] value:[line substringFromIndex:colon.location + 1] query:NO];
+}
+//End header store
+
+#pragma mark - CEA-608 grid
+
+// Routes an instance's 608 captions to the grid export; NXCEA608Channel_None turns it off and
+// gives the captions back to the player view.
+-(void)setCEA608Channel:(int)channel index:(int)index {
+    NXPlayer *player = [self playerAtIndex:index];
+    if(player == nil)
+        return;
+    player.selectedCEA608Channel = (NXCEA608Channel)channel;
+    if(channel != NXCEA608Channel_None){
+        if(player.CEA608CaptionUpdateReceiver != self){
+            viewCaptionReceivers[index] = player.CEA608CaptionUpdateReceiver;
+            player.CEA608CaptionUpdateReceiver = self;
+        }
+    } else if(player.CEA608CaptionUpdateReceiver == self){
+        player.CEA608CaptionUpdateReceiver = viewCaptionReceivers[index];
+        viewCaptionReceivers[index] = nil;
+    }
+
+    std::lock_guard<std::mutex> lock(captionGridLock);
+    NexCaptionGrid *grid = &captionGrids[index];
+    uint32_t sequence = __atomic_load_n(&grid->sequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&grid->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&grid->channel, (int32_t)channel, __ATOMIC_RELAXED);
+    memset(captionShadow[index], 0, sizeof(captionShadow[index]));
+    for(int row = 0; row < NEXPLAYER_CEA608_ROWS; row++)
+        NexStoreCaptionRow(grid, row, &captionShadow[index][row * NEXPLAYER_CEA608_COLS]);
+    __atomic_fetch_or(&grid->dirtyRows, (1u << NEXPLAYER_CEA608_ROWS) - 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&grid->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+- (void)nexPlayer:(NXPlayer*)nxplayer updatedCaption:(NXCEA608Caption*)caption forCEA608Channel:(NXCEA608Channel)channel {
+    int index = [self indexOfPlayer:nxplayer];
+    if(index < 0 || caption == nil)
+        return;
+
+    // Read the SDK's cell model first; the lock is only held to publish the differences.
+    NexCaptionCell cells[NEXPLAYER_CEA608_ROWS * NEXPLAYER_CEA608_COLS];
+    BOOL empty = caption.isEmpty;
+    for(int row = 0; row < NEXPLAYER_CEA608_ROWS; row++){
+        for(int col = 0; col < NEXPLAYER_CEA608_COLS; col++){
+            NexCaptionCell *cell = &cells[row * NEXPLAYER_CEA608_COLS + col];
+            NXCEA608CellInfo info;
+            memset(&info, 0, sizeof(info));
+            if(!empty)
+                [caption getCellInfo:&info size:sizeof(info) atRow:row andCol:col];
+            cell->character = info.characterCode;
+            cell->fg = (uint8_t)info.foregroundColor;
+            cell->bg = (uint8_t)(info.characterCode != 0 ? info.backgroundColor : NXCEA608Color_Transparent);
+            cell->attributes = (info.italic ? NEXUNITY_CAPTION_ITALIC : 0) | (info.underline ? NEXUNITY_CAPTION_UNDERLINE : 0)
+                             | (info.flash ? NEXUNITY_CAPTION_FLASH : 0) | (info.large ? NEXUNITY_CAPTION_LARGE : 0);
+            cell->charset = (uint8_t)info.characterSet;
+        }
+    }
+
+    uint32_t changed = 0;
+    {
+        std::lock_guard<std::mutex> lock(captionGridLock);
+        NexCaptionGrid *grid = &captionGrids[index];
+        const size_t rowBytes = NEXPLAYER_CEA608_COLS * sizeof(NexCaptionCell);
+        for(int row = 0; row < NEXPLAYER_CEA608_ROWS; row++)
+            if(memcmp(&cells[row * NEXPLAYER_CEA608_COLS], &captionShadow[index][row * NEXPLAYER_CEA608_COLS], rowBytes) != 0)
+                changed |= 1u << row;
+        bool rollupChanged = grid->rollupBaseRow != caption.rollupBaseRow || grid->rollupRows != caption.rollupRows;
+        if(changed == 0 && !rollupChanged)
+            return;
+
+        uint32_t sequence = __atomic_load_n(&grid->sequence, __ATOMIC_RELAXED);
+        __atomic_store_n(&grid->sequence, sequence + 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&grid->channel, (int32_t)channel, __ATOMIC_RELAXED);
+        __atomic_store_n(&grid->rollupBaseRow, (int32_t)caption.rollupBaseRow, __ATOMIC_RELAXED);
+        __atomic_store_n(&grid->rollupRows, (int32_t)caption.rollupRows, __ATOMIC_RELAXED);
+        for(int row = 0; row < NEXPLAYER_CEA608_ROWS; row++){
+            if(!(changed & (1u << row)))
+                continue;
+            memcpy(&captionShadow[index][row * NEXPLAYER_CEA608_COLS], &cells[row * NEXPLAYER_CEA608_COLS], rowBytes);
+            NexStoreCaptionRow(grid, row, &cells[row * NEXPLAYER_CEA608_COLS]);
+        }
+        __atomic_fetch_or(&grid->dirtyRows, changed, __ATOMIC_RELAXED);
+        __atomic_store_n(&grid->sequence, sequence + 2, __ATOMIC_RELEASE);
+    }
+    if(!m_isClose && g_playerListener)
+        NexPostEvent(NEXUNITY_EVENT_CAPTION_GRID,index,(int)changed,0,0,0);
+}
+
+#pragma mark - NXABRDelegate
+
+- (NSUInteger)nexPlayer:(NXPlayer *)nxplayer willChangeABRTrackWithParams:(NXPlayerABRControllerTrackChangeParams)params {
+    //NSLog(@"Track change current:%lu next:%lu net:%lu", (unsigned long)params.curTrackBW, (unsigned long)params.nextTrackBW, (unsigned long)params.netBW);
+    return params.nextTrackBW;
+}
+
+- (void)setSecretValueForSignature:secret{
+    if(secret)
+        m_AlticastSecret = secret;
+}
+
+- (BOOL)setLicenseFilePath:licensePath {
+    BOOL licenseExists = NO;
+    if(licensePath){
+        BOOL licenseFileExists = [[NSFileManager defaultManager] fileExistsAtPath:licensePath];
+        if(licenseFileExists){
+            m_licenseFilePath = licensePath;
+            licenseExists = YES;
+        }
+    }
+    return licenseExists;
+}
+
+-(void)setTrack:(NSUInteger)bitRate{
+    if(chosenPlayerMulti == 0){
+        self.abrController = [[NXPlayerABRController alloc] initWithPlayer:self.player];
+        [self.abrController setTargetBandwidth:bitRate segmentOption:NexBandwidthSegmentOptionDefault targetOption:NexBandwidthTargetOptionMatch];
+    }
+    else {
+        self.abrController = [[NXPlayerABRController alloc] initWithPlayer:multiPlayers[chosenPlayerMulti]];
+        [self.abrController setTargetBandwidth:bitRate segmentOption:NexBandwidthSegmentOptionDefault targetOption:NexBandwidthTargetOptionMatch];
+    }
+
+}
+
+#pragma mark - Trick play
+
+// Lowest-bandwidth I-frame rendition of the current video stream. When the content has
+// none we fall back to the lowest regular rendition so scrubbing at least stays cheap.
+-(NSUInteger)trickPlayBandwidthForPlayer:(NXPlayer *)nxplayer {
+    NSUInteger iFrameBW = 0;
+    NSUInteger lowestBW = 0;
+    for(NXTrackInfo *track in nxplayer.contentInfo.currentVideoStream.tracks){
+        if(!track.valid || track.bandwidth <= 0)
+            continue;
+        if(track.iFrameTrack){
+            if(iFrameBW == 0 || (NSUInteger)track.bandwidth < iFrameBW)
+                iFrameBW = track.bandwidth;
+        } else if(lowestBW == 0 || (NSUInteger)track.bandwidth < lowestBW)
+            lowestBW = track.bandwidth;
+    }
+    return iFrameBW != 0 ? iFrameBW : lowestBW;
+}
+
+-(void)selectTrickPlayTrack:(NXPlayer *)nxplayer bandwidth:(NSUInteger)bandwidth {
+    NXPlayerABRController *abr = [[NXPlayerABRController alloc] initWithPlayer:nxplayer];
+    if(abr == nil || bandwidth == 0)
+        return;
+    [abr setABREnabled:NO];
+    [abr setTargetBandwidth:bandwidth segmentOption:NexBandwidthSegmentOptionQuickMix targetOption:NexBandwidthTargetOptionMatch];
+}
+
+-(void)restoreTrickPlayTrack:(NXPlayer *)nxplayer bandwidth:(NSUInteger)bandwidth {
+    NXPlayerABRController *abr = [[NXPlayerABRController alloc] initWithPlayer:nxplayer];
+    if(abr == nil)
+        return;
+    if(supportABR)
+        [abr setABREnabled:YES];
+    else if(bandwidth > 0)
+        [abr setTargetBandwidth:bandwidth segmentOption:NexBandwidthSegmentOptionQuickMix targetOption:NexBandwidthTargetOptionMatch];
+}
+
+-(void)startTrickPlayTimer {
+    if(trickPlayQueue == nil)
+        trickPlayQueue = dispatch_queue_create("com.nexplayer.unity.trickplay", DISPATCH_QUEUE_SERIAL);
+    if(trickPlayTimer == nil){
+        trickPlayTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, trickPlayQueue);
+        __weak NexPlayerScripting *weakSelf = self;
+        dispatch_source_set_event_handler(trickPlayTimer, ^{
+            [weakSelf trickPlayTick];
+        });
+    }
+    uint64_t interval = (uint64_t)(1000 / trickPlayMaxFps) * NSEC_PER_MSEC;
+    dispatch_source_set_timer(trickPlayTimer, dispatch_time(DISPATCH_TIME_NOW, 0), interval, interval / 10);
+    std::lock_guard<std::mutex> lock(trickPlayLock);
+    if(!trickPlayTimerRunning){
+        trickPlayTimerRunning = true;
+        dispatch_resume(trickPlayTimer);
+    }
+}
+
+-(void)trickPlayTick {
+    int intervalMs = 1000 / trickPlayMaxFps;
+    int pendingSeek[8];
+    bool anyActive = false;
+
+    {
+        std::lock_guard<std::mutex> lock(trickPlayLock);
+        for(int i = 0; i < 8; i++){
+            NexTrickPlaySession *session = &trickPlay[i];
+            pendingSeek[i] = -1;
+            if(!session->active)
+                continue;
+            anyActive = true;
+
+            NXPlayer *preview = [self playerAtIndex:i];
+            if(preview == nil){
+                session->active = false;
+                continue;
+            }
+            int duration = (int)preview.contentInfo.totalPlayTime;
+            session->positionMs += session->speed * intervalMs;
+            if(session->positionMs < 0)
+                session->positionMs = 0;
+            if(duration > 0 && session->positionMs > duration)
+                session->positionMs = duration;
+
+            if(session->seekInFlight){
+                session->inFlightMs += intervalMs;
+                if(session->inFlightMs < TRICKPLAY_SEEK_TIMEOUT_MS)
+                    continue;
+                session->seekInFlight = false;
+            }
+            if(session->positionMs == session->lastIssuedMs)
+                continue;
+
+            session->seekInFlight = true;
+            session->inFlightMs = 0;
+            session->lastIssuedMs = session->positionMs;
+            pendingSeek[i] = session->positionMs;
+        }
+    }
+
+    // Seeks are issued outside the lock: the SDK may report completion on any thread.
+    for(int i = 0; i < 8; i++){
+        if(pendingSeek[i] < 0)
+            continue;
+        if([[self playerAtIndex:i] seekTo:pendingSeek[i]] != NXErrorNone){
+            std::lock_guard<std::mutex> lock(trickPlayLock);
+            trickPlay[i].seekInFlight = false;
+        }
+    }
+
+    if(anyActive)
+        return;
+    // Re-check under the lock: a session may have started since the scan above.
+    std::lock_guard<std::mutex> lock(trickPlayLock);
+    for(int i = 0; i < 8; i++){
+        if(trickPlay[i].active)
+            return;
+    }
+    if(trickPlayTimerRunning){
+        trickPlayTimerRunning = false;
+        dispatch_suspend(trickPlayTimer);
+    }
+}
+
+-(BOOL)completeTrickPlaySeek:(NXPlayer *)nxplayer {
+    int index = [self indexOfPlayer:nxplayer];
+    if(index < 0)
+        return NO;
+
+    std::lock_guard<std::mutex> lock(trickPlayLock);
+    if(!trickPlay[index].active || !trickPlay[index].seekInFlight)
+        return NO;
+    trickPlay[index].seekInFlight = false;
+    return YES;
+}
+
+-(int)clampTrickPlaySpeed:(int)speed {
+    if(speed == 0)
+        return 0;
+    int magnitude = abs(speed);
+    if(magnitude < TRICKPLAY_MIN_SPEED)
+        magnitude = TRICKPLAY_MIN_SPEED;
+    if(magnitude > TRICKPLAY_MAX_SPEED)
+        magnitude = TRICKPLAY_MAX_SPEED;
+    return speed < 0 ? -magnitude : magnitude;
+}
+
+-(int)startTrickPlay:(int)previewIndex toValue:(int)playbackIndex speed:(int)speed {
+    NXPlayer *preview = [self playerAtIndex:previewIndex];
+    NXPlayer *playback = [self playerAtIndex:playbackIndex];
+    if(preview == nil || playback == nil)
+        return PLAYER_ERROR_GENERAL;
+
+    NXPlayerState state = preview.state;
+    if(state != NXPlayerStatePlay && state != NXPlayerStatePause)
+        return NXErrorOperationNotValidInCurrentState;
+
+    {
+        std::lock_guard<std::mutex> lock(trickPlayLock);
+        NexTrickPlaySession *session = &trickPlay[previewIndex];
+        if(session->active)
+            return PLAYER_ERROR_NONE;
+        memset(session, 0, sizeof(NexTrickPlaySession));
+        session->active = true;
+        session->playbackIndex = playbackIndex;
+        session->speed = [self clampTrickPlaySpeed:speed];
+        session->startMs = (int)playback.currentTimeStamp;
+        session->positionMs = session->startMs;
+        session->lastIssuedMs = previewIndex == playbackIndex ? session->startMs : -1;
+        session->wasPlaying = playback.state == NXPlayerStatePlay;
+        session->restoreBW = preview.contentInfo.currentVideoStream.currentTrack.bandwidth;
+    }
+
+    [self Log:4 toValue:@"Trick play start on instance " value3:previewIndex value4:speed];
+
+    if(preview.state == NXPlayerStatePlay)
+        [preview pause];
+    if(playback != preview && playback.state == NXPlayerStatePlay)
+        [playback pause];
+    [self selectTrickPlayTrack:preview bandwidth:[self trickPlayBandwidthForPlayer:preview]];
+    [self startTrickPlayTimer];
+    return PLAYER_ERROR_NONE;
+}
+
+-(void)setTrickPlaySpeed:(int)previewIndex toValue:(int)speed {
+    if(previewIndex < 0 || previewIndex >= 8)
+        return;
+    std::lock_guard<std::mutex> lock(trickPlayLock);
+    if(trickPlay[previewIndex].active)
+        trickPlay[previewIndex].speed = [self clampTrickPlaySpeed:speed];
+}
+
+-(void)scrubTrickPlay:(int)previewIndex toValue:(int)msec {
+    if(previewIndex < 0 || previewIndex >= 8)
+        return;
+    // Scrub targets only move the virtual playhead; the timer coalesces them so a fast
+    // drag never issues more keyframe seeks than trickPlayMaxFps.
+    std::lock_guard<std::mutex> lock(trickPlayLock);
+    if(trickPlay[previewIndex].active){
+        trickPlay[previewIndex].speed = 0;
+        trickPlay[previewIndex].positionMs = msec < 0 ? 0 : msec;
+    }
+}
+
+-(int)getTrickPlayPosition:(int)previewIndex {
+    if(previewIndex < 0 || previewIndex >= 8)
+        return -1;
+    std::lock_guard<std::mutex> lock(trickPlayLock);
+    return trickPlay[previewIndex].active ? trickPlay[previewIndex].positionMs : -1;
+}
+
+-(int)stopTrickPlay:(int)previewIndex commit:(BOOL)commit {
+    if(previewIndex < 0 || previewIndex >= 8)
+        return PLAYER_ERROR_GENERAL;
+
+    NexTrickPlaySession session;
+    {
+        std::lock_guard<std::mutex> lock(trickPlayLock);
+        if(!trickPlay[previewIndex].active)
+            return PLAYER_ERROR_NONE;
+        session = trickPlay[previewIndex];
+        trickPlay[previewIndex].active = false;
+    }
+
+    NXPlayer *preview = [self playerAtIndex:previewIndex];
+    NXPlayer *playback = [self playerAtIndex:session.playbackIndex];
+    int landingMs = commit ? session.positionMs : session.startMs;
+    [self Log:4 toValue:@"Trick play landing at " value3:landingMs];
+
+    [self restoreTrickPlayTrack:preview bandwidth:session.restoreBW];
+    if(playback == nil)
+        return PLAYER_ERROR_GENERAL;
+
+    NXError result = [playback seekTo:landingMs];
+    if(session.wasPlaying)
+        [playback resume];
+    return result;
+}
+//End trick play
+
+#pragma mark - Sync group
+
+-(BOOL)isSyncGroupMember:(int)index {
+    if(index < 0 || index >= 8)
+        return NO;
+    std::lock_guard<std::mutex> lock(syncGroupLock);
+    return syncGroup.phase != SYNCGROUP_IDLE && syncGroup.members[index].member;
+}
+
+-(void)startSyncGroupTimer {
+    if(syncGroupQueue == nil)
+        syncGroupQueue = dispatch_queue_create("com.nexplayer.unity.syncgroup", DISPATCH_QUEUE_SERIAL);
+    if(syncGroupTimer == nil){
+        syncGroupTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, syncGroupQueue);
+        uint64_t interval = (uint64_t)SYNCGROUP_TICK_MS * NSEC_PER_MSEC;
+        dispatch_source_set_timer(syncGroupTimer, dispatch_time(DISPATCH_TIME_NOW, interval), interval, interval / 10);
+        __weak NexPlayerScripting *weakSelf = self;
+        dispatch_source_set_event_handler(syncGroupTimer, ^{
+            [weakSelf syncGroupTick];
+        });
+    }
+    std::lock_guard<std::mutex> lock(syncGroupLock);
+    if(!syncGroupTimerRunning){
+        syncGroupTimerRunning = true;
+        dispatch_resume(syncGroupTimer);
+    }
+}
+
+-(int)openSyncGroup:(int)memberMask autoStart:(BOOL)autoStart {
+    NXPlayer *players[8] = {nil};
+    int count = 0;
+    for(int i = 0; i < 8; i++){
+        if((memberMask & (1 << i)) == 0 || multiPaths[i] == nil)
+            continue;
+        players[i] = [self playerAtIndex:i];
+        if(players[i] != nil)
+            count++;
+    }
+    if(count < 2)
+        return PLAYER_ERROR_GENERAL;
+
+    {
+        std::lock_guard<std::mutex> lock(syncGroupLock);
+        syncGroup.phase = SYNCGROUP_OPENING;
+        syncGroup.autoStart = autoStart;
+        syncGroup.resumeAfterSeek = false;
+        syncGroup.holdForBuffering = false;
+        syncGroup.pendingSeeks = 0;
+        syncGroup.anchorPtsMs = 0;
+        syncGroup.clockRunning = false;
+        for(int i = 0; i < 8; i++){
+            NexSyncMember member = { players[i] != nil, false, false, false, 1.0f, 0.0f };
+            syncGroup.members[i] = member;
+        }
+    }
+
+    // Every member opens paused on its first frame; the group starts once all are ready.
+    for(int i = 0; i < 8; i++){
+        if(players[i] == nil)
+            continue;
+        [self applyConfig:i];
+        [players[i] open:multiPaths[i]
+                    mode:NXOpenModeAuto
+               subtitles:self.subtitle_path
+               transport:NXTransportTypeTCP
+                autoPlay:NO];
+        if(i > 0)
+            [players[i] startFromTime:0 pauseAfterReady:YES];
+    }
+    [self startSyncGroupTimer];
+    [self Log:4 toValue:@"Sync group opening, members: " value3:count];
+    return PLAYER_ERROR_NONE;
+}
+
+-(void)closeSyncGroup {
+    NXPlayer *players[8] = {nil};
+    {
+        std::lock_guard<std::mutex> lock(syncGroupLock);
+        if(syncGroup.phase == SYNCGROUP_IDLE)
+            return;
+        for(int i = 0; i < 8; i++){
+            if(syncGroup.members[i].member && syncGroup.members[i].rate != 1.0f)
+                players[i] = [self playerAtIndex:i];
+            syncGroup.members[i].member = false;
+        }
+        syncGroup.phase = SYNCGROUP_IDLE;
+    }
+    for(int i = 0; i < 8; i++)
+        [self setPlaybackRate:1.0f forPlayer:players[i]];
+}
+
+-(void)syncGroupSeekAll:(int)msec resume:(BOOL)resume {
+    NXPlayer *players[8] = {nil};
+    {
+        std::lock_guard<std::mutex> lock(syncGroupLock);
+        syncGroup.phase = SYNCGROUP_SEEKING;
+        syncGroup.resumeAfterSeek = resume;
+        syncGroup.clockRunning = false;
+        syncGroup.anchorPtsMs = msec;
+        syncGroup.pendingSeeks = 0;
+        for(int i = 0; i < 8; i++){
+            NexSyncMember *member = &syncGroup.members[i];
+            if(!member->member)
+                continue;
+            players[i] = [self playerAtIndex:i];
+            member->seekPending = true;
+            member->driftMs = 0;
+            syncGroup.pendingSeeks++;
+        }
+    }
+    for(int i = 0; i < 8; i++){
+        if(players[i] == nil)
+            continue;
+        if([players[i] seekTo:msec] != NXErrorNone)
+            [self completeSyncGroupSeek:players[i]];
+    }
+}
+
+-(BOOL)completeSyncGroupSeek:(NXPlayer *)nxplayer {
+    int index = [self indexOfPlayer:nxplayer];
+    if(index < 0)
+        return NO;
+
+    bool resumeAll = false;
+    {
+        std::lock_guard<std::mutex> lock(syncGroupLock);
+        NexSyncMember *member = &syncGroup.members[index];
+        if(syncGroup.phase == SYNCGROUP_IDLE || !member->member || !member->seekPending)
+            return NO;
+        member->seekPending = false;
+        // Drift-correction seeks are internal; only a group seek reports completion.
+        if(syncGroup.phase != SYNCGROUP_SEEKING || --syncGroup.pendingSeeks > 0)
+            return YES;
+        if(syncGroup.resumeAfterSeek)
+            resumeAll = true;
+        else
+            syncGroup.phase = SYNCGROUP_PAUSED;
+    }
+
+    if(g_playerListener)
+        NexPostEvent(NEXUNITY_EVENT_ASYNC_COMPLETE,NEXUNITY_ASYNC_CMD_SEEK,0,0,0,0);
+    if(resumeAll){
+        {
+            std::lock_guard<std::mutex> lock(syncGroupLock);
+            syncGroup.phase = SYNCGROUP_PAUSED;
+        }
+        [self resumeSyncGroup];
+    }
+    return YES;
+}
+
+-(void)syncGroupPlayer:(NXPlayer *)nxplayer changedToState:(NXPlayerState)newState {
+    int index = [self indexOfPlayer:nxplayer];
+    if(index < 0)
+        return;
+
+    int startMs = 0;
+    {
+        std::lock_guard<std::mutex> lock(syncGroupLock);
+        if(syncGroup.phase != SYNCGROUP_OPENING || !syncGroup.members[index].member)
+            return;
+        if(newState == NXPlayerStatePause)
+            syncGroup.members[index].ready = true;
+        for(int i = 0; i < 8; i++)
+            if(syncGroup.members[i].member && !syncGroup.members[i].ready)
+                return;
+        if(!syncGroup.autoStart){
+            syncGroup.phase = SYNCGROUP_PAUSED;
+            return;
+        }
+        // Common start PTS: the furthest member, so nobody has to wait on a backwards seek.
+        for(int i = 0; i < 8; i++){
+            NXPlayer *player = syncGroup.members[i].member ? [self playerAtIndex:i] : nil;
+            if(player != nil && (int)player.currentTimeStamp > startMs)
+                startMs = (int)player.currentTimeStamp;
+        }
+    }
+    [self Log:4 toValue:@"Sync group ready, starting at " value3:startMs];
+    [self syncGroupSeekAll:startMs resume:YES];
+}
+
+-(void)syncGroupPlayer:(NXPlayer *)nxplayer buffering:(BOOL)buffering {
+    int index = [self indexOfPlayer:nxplayer];
+    if(index < 0)
+        return;
+
+    NXPlayer *players[8] = {nil};
+    bool pauseOthers = false;
+    bool resumeAll = false;
+    {
+        std::lock_guard<std::mutex> lock(syncGroupLock);
+        if(!syncGroup.members[index].member)
+            return;
+        syncGroup.members[index].buffering = buffering;
+        if(buffering && syncGroup.phase == SYNCGROUP_RUNNING && !syncGroup.holdForBuffering){
+            syncGroup.anchorPtsMs = NexSyncGroupClockMs(NexMonotonicUs());
+            syncGroup.clockRunning = false;
+            syncGroup.holdForBuffering = true;
+            pauseOthers = true;
+        } else if(!buffering && syncGroup.holdForBuffering){
+            for(int i = 0; i < 8; i++)
+                if(syncGroup.members[i].member && syncGroup.members[i].buffering)
+                    return;
+            syncGroup.holdForBuffering = false;
+            syncGroup.clockRunning = true;
+            syncGroup.anchorMonoUs = NexMonotonicUs();
+            resumeAll = true;
+        } else
+            return;
+        for(int i = 0; i < 8; i++)
+            if(syncGroup.members[i].member && i != index)
+                players[i] = [self playerAtIndex:i];
+    }
+    for(int i = 0; i < 8; i++){
+        if(pauseOthers)
+            [players[i] pause];
+        else if(resumeAll)
+            [players[i] resume];
+    }
+}
+
+-(void)pauseSyncGroup {
+    NXPlayer *players[8] = {nil};
+    {
+        std::lock_guard<std::mutex> lock(syncGroupLock);
+        if(syncGroup.phase == SYNCGROUP_SEEKING){
+            syncGroup.resumeAfterSeek = false;
+            return;
+        }
+        if(syncGroup.phase != SYNCGROUP_RUNNING)
+            return;
+        syncGroup.anchorPtsMs = NexSyncGroupClockMs(NexMonotonicUs());
+        syncGroup.clockRunning = false;
+        syncGroup.holdForBuffering = false;
+        syncGroup.phase = SYNCGROUP_PAUSED;
+        for(int i = 0; i < 8; i++)
+            if(syncGroup.members[i].member)
+                players[i] = [self playerAtIndex:i];
+    }
+    for(int i = 0; i < 8; i++)
+        [players[i] pause];
+}
+
+-(void)resumeSyncGroup {
+    NXPlayer *players[8] = {nil};
+    {
+        std::lock_guard<std::mutex> lock(syncGroupLock);
+        if(syncGroup.phase == SYNCGROUP_SEEKING){
+            syncGroup.resumeAfterSeek = true;
+            return;
+        }
+        if(syncGroup.phase != SYNCGROUP_PAUSED)
+            return;
+        syncGroup.phase = SYNCGROUP_RUNNING;
+        syncGroup.clockRunning = true;
+        syncGroup.anchorMonoUs = NexMonotonicUs();
+        for(int i = 0; i < 8; i++){
+            if(!syncGroup.members[i].member)
+                continue;
+            players[i] = [self playerAtIndex:i];
+            syncGroup.members[i].driftMs = 0;
+        }
+    }
+    for(int i = 0; i < 8; i++)
+        [players[i] resume];
+}
+
+-(void)seekSyncGroup:(int)msec {
+    BOOL resume;
+    {
+        std::lock_guard<std::mutex> lock(syncGroupLock);
+        if(syncGroup.phase == SYNCGROUP_IDLE || syncGroup.phase == SYNCGROUP_OPENING)
+            return;
+        resume = syncGroup.phase == SYNCGROUP_RUNNING || (syncGroup.phase == SYNCGROUP_SEEKING && syncGroup.resumeAfterSeek);
+    }
+    [self syncGroupSeekAll:msec resume:resume];
+}
+
+-(float)getSyncGroupDrift:(int)index {
+    if(index < 0 || index >= 8)
+        return 0;
+    std::lock_guard<std::mutex> lock(syncGroupLock);
+    return syncGroup.members[index].member ? syncGroup.members[index].driftMs : 0;
+}
+
+-(void)syncGroupTick {
+    NXPlayer *players[8] = {nil};
+    {
+        std::lock_guard<std::mutex> lock(syncGroupLock);
+        if(syncGroup.phase == SYNCGROUP_IDLE){
+            syncGroupTimerRunning = false;
+            dispatch_suspend(syncGroupTimer);
+            return;
+        }
+        if(syncGroup.phase != SYNCGROUP_RUNNING || !syncGroup.clockRunning)
+            return;
+        for(int i = 0; i < 8; i++){
+            NexSyncMember *member = &syncGroup.members[i];
+            if(member->member && !member->seekPending && !member->buffering)
+                players[i] = [self playerAtIndex:i];
+        }
+    }
+
+    // Positions are sampled outside the lock and compared with the clock at sampling time.
+    int64_t position[8];
+    int64_t sampledUs[8];
+    for(int i = 0; i < 8; i++){
+        position[i] = -1;
+        if(players[i] == nil || players[i].state != NXPlayerStatePlay)
+            continue;
+        position[i] = (int64_t)players[i].currentTimeStamp;
+        sampledUs[i] = NexMonotonicUs();
+    }
+
+    int seekTarget[8];
+    float newRate[8];
+    {
+        std::lock_guard<std::mutex> lock(syncGroupLock);
+        for(int i = 0; i < 8; i++){
+            seekTarget[i] = -1;
+            newRate[i] = 0;
+            NexSyncMember *member = &syncGroup.members[i];
+            if(position[i] < 0 || !member->member || member->seekPending || syncGroup.phase != SYNCGROUP_RUNNING)
+                continue;
+
+            int64_t clockMs = NexSyncGroupClockMs(sampledUs[i]);
+            float drift = (float)(position[i] - clockMs);
+            float rate = 1.0f;
+            if(fabsf(drift) >= syncGroup.seekThresholdMs){
+                member->driftMs = drift;
+                member->seekPending = true;
+                seekTarget[i] = (int)(clockMs + syncGroup.seekLeadMs);
+            } else {
+                member->driftMs = member->driftMs * 0.7f + drift * 0.3f;
+                if(fabsf(member->driftMs) >= syncGroup.nudgeThresholdMs){
+                    rate = 1.0f - member->driftMs / syncGroup.correctionWindowMs;
+                    rate = fminf(fmaxf(rate, 1.0f - syncGroup.maxRateNudge), 1.0f + syncGroup.maxRateNudge);
+                    rate = roundf(rate * 200.0f) / 200.0f;
+                }
+            }
+            if(rate != member->rate){
+                member->rate = rate;
+                newRate[i] = rate;
+            }
+        }
+    }
+
+    for(int i = 0; i < 8; i++){
+        if(players[i] == nil)
+            continue;
+        if(newRate[i] > 0)
+            [self setPlaybackRate:newRate[i] forPlayer:players[i]];
+        if(seekTarget[i] >= 0 && [players[i] seekTo:seekTarget[i]] != NXErrorNone){
+            std::lock_guard<std::mutex> lock(syncGroupLock);
+            syncGroup.members[i].seekPending = false;
+        }
+    }
+}
+//End sync group
+
+#pragma mark - Live latency
+
+-(void)enableLatencyControl:(int)index enable:(BOOL)enable target:(int)targetMs {
+    if(index < 0 || index >= 8)
+        return;
+    NXPlayer *restore = nil;
+    {
+        std::lock_guard<std::mutex> lock(latencyLock);
+        NexLatencyControl *control = &latencyControl[index];
+        if(!enable && control->enabled && control->rate != 1.0f)
+            restore = [self playerAtIndex:index];
+        if(enable && !control->enabled){
+            control->latencyMs = -1;
+            control->rate = 1.0f;
+            control->lastJumpUs = 0;
+            control->jumps = 0;
+            control->sampleCount = 0;
+            control->sampleHead = 0;
+            control->pdtText[0] = 0;
+        }
+        control->enabled = enable;
+        if(targetMs > 0)
+            control->targetMs = targetMs;
+        if(!enable)
+            control->rate = 1.0f;
+    }
+    [self setPlaybackRate:1.0f forPlayer:restore];
+
+    if(enable){
+        if(latencyQueue == nil)
+            latencyQueue = dispatch_queue_create("com.nexplayer.unity.latency", DISPATCH_QUEUE_SERIAL);
+        if(latencyTimer == nil){
+            latencyTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, latencyQueue);
+            uint64_t interval = (uint64_t)LATENCY_TICK_MS * NSEC_PER_MSEC;
+            dispatch_source_set_timer(latencyTimer, dispatch_time(DISPATCH_TIME_NOW, interval), interval, interval / 10);
+            __weak NexPlayerScripting *weakSelf = self;
+            dispatch_source_set_event_handler(latencyTimer, ^{
+                [weakSelf latencyTick];
+            });
+        }
+        std::lock_guard<std::mutex> lock(latencyLock);
+        if(!latencyTimerRunning){
+            latencyTimerRunning = true;
+            dispatch_resume(latencyTimer);
+        }
+    }
+}
+
+// Epoch of an ISO-8601 program date time, or -1.
+static int64_t NexParsePDT(const char *text) {
+    static NSISO8601DateFormatter *fractional = nil;
+    static NSISO8601DateFormatter *whole = nil;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        fractional = [[NSISO8601DateFormatter alloc] init];
+        fractional.formatOptions = NSISO8601DateFormatWithInternetDateTime | NSISO8601DateFormatWithFractionalSeconds;
+        whole = [[NSISO8601DateFormatter alloc] init];
+    });
+    NSString *string = [NSString stringWithUTF8String:text];
+    if(string.length == 0)
+        return -1;
+    NSDate *date = [fractional dateFromString:string];
+    if(date == nil)
+        date = [whole dateFromString:string];
+    return date != nil ? (int64_t)(date.timeIntervalSince1970 * 1000.0) : -1;
+}
+
+-(int)measureLatency:(int)index player:(NXPlayer *)player fromPDT:(bool *)fromPDT {
+    char pdt[256] = {0};
+    NSInteger offset = 0;
+    [player getProgramDateTime:&offset buffer:pdt];
+    if(pdt[0] != 0){
+        int64_t epochMs;
+        {
+            std::lock_guard<std::mutex> lock(latencyLock);
+            epochMs = strncmp(pdt, latencyControl[index].pdtText, sizeof(latencyControl[index].pdtText)) == 0 ? latencyControl[index].pdtEpochMs : -2;
+        }
+        if(epochMs == -2){
+            epochMs = NexParsePDT(pdt);
+            std::lock_guard<std::mutex> lock(latencyLock);
+            strlcpy(latencyControl[index].pdtText, pdt, sizeof(latencyControl[index].pdtText));
+            latencyControl[index].pdtEpochMs = epochMs;
+        }
+        if(epochMs > 0){
+            *fromPDT = true;
+            return (int)(NexWallClockMs() - (epochMs + offset));
+        }
+    }
+
+    int32_t startTime = 0, endTime = 0;
+    [player getSeekableRange:&startTime endTime:&endTime];
+    if(endTime <= startTime)
+        return -1;
+    *fromPDT = false;
+    return std::max(0, (int)(endTime - (int32_t)player.currentTimeStamp));
+}
+
+-(void)latencyTick {
+    NXPlayer *players[8] = {nil};
+    {
+        std::lock_guard<std::mutex> lock(latencyLock);
+        bool any = false;
+        for(int i = 0; i < 8; i++){
+            if(!latencyControl[i].enabled)
+                continue;
+            any = true;
+            players[i] = [self playerAtIndex:i];
+        }
+        if(!any){
+            latencyTimerRunning = false;
+            dispatch_suspend(latencyTimer);
+            return;
+        }
+    }
+
+    for(int i = 0; i < 8; i++){
+        NXPlayer *player = players[i];
+        // Sync group and trick play own the playback rate of their instances.
+        if(player == nil || player.state != NXPlayerStatePlay || [self isSyncGroupMember:i])
+            continue;
+        {
+            std::lock_guard<std::mutex> lock(trickPlayLock);
+            if(trickPlay[i].active)
+                continue;
+        }
+
+        bool fromPDT = false;
+        int latency = [self measureLatency:i player:player fromPDT:&fromPDT];
+        if(latency < 0)
+            continue;
+
+        float newRate = 0;
+        bool jump = false;
+        {
+            std::lock_guard<std::mutex> lock(latencyLock);
+            NexLatencyControl *control = &latencyControl[i];
+            if(!control->enabled)
+                continue;
+            control->latencyMs = latency;
+            control->fromPDT = fromPDT;
+            control->samples[control->sampleHead] = latency;
+            control->sampleHead = (control->sampleHead + 1) % LATENCY_SAMPLES;
+            if(control->sampleCount < LATENCY_SAMPLES)
+                control->sampleCount++;
+
+            int error = latency - control->targetMs;
+            float rate = 1.0f;
+            int64_t nowUs = NexMonotonicUs();
+            if(error > latencyJumpThresholdMs && nowUs - control->lastJumpUs > (int64_t)LATENCY_JUMP_COOLDOWN_MS * 1000){
+                control->lastJumpUs = nowUs;
+                control->jumps++;
+                jump = true;
+            } else if(abs(error) > latencyDeadbandMs){
+                rate = 1.0f + (float)error / latencyCorrectionWindowMs;
+                rate = fminf(fmaxf(rate, latencyMinRate), latencyMaxRate);
+                rate = roundf(rate * 100.0f) / 100.0f;
+            }
+            if(rate != control->rate){
+                control->rate = rate;
+                newRate = rate;
+            }
+        }
+
+        if(newRate > 0)
+            [self setPlaybackRate:newRate forPlayer:player];
+        if(jump){
+            [self Log:4 toValue:@"Latency over threshold, jumping to live on instance " value3:i value4:latency];
+            [player goToCurrentLivePosition:NO];
+        }
+    }
+}
+
+-(int)getLatency:(int)index {
+    if(index < 0 || index >= 8)
+        return -1;
+    std::lock_guard<std::mutex> lock(latencyLock);
+    return latencyControl[index].latencyMs;
+}
+
+-(int)getLatencyPercentile:(int)index percentile:(int)percentile {
+    if(index < 0 || index >= 8 || percentile < 0 || percentile > 100)
+        return -1;
+    int samples[LATENCY_SAMPLES];
+    int count;
+    {
+        std::lock_guard<std::mutex> lock(latencyLock);
+        count = latencyControl[index].sampleCount;
+        memcpy(samples, latencyControl[index].samples, sizeof(int) * count);
+    }
+    if(count == 0)
+        return -1;
+    int rank = std::min(count - 1, (count * percentile) / 100);
+    std::nth_element(samples, samples + rank, samples + count);
+    return samples[rank];
+}
+
+-(void)resetLatencyStats:(int)index {
+    if(index < 0 || index >= 8)
+        return;
+    std::lock_guard<std::mutex> lock(latencyLock);
+    latencyControl[index].sampleCount = 0;
+    latencyControl[index].sampleHead = 0;
+    latencyControl[index].jumps = 0;
+}
+//End live latency
+
+-(void) nexPlayer:(NXPlayer *)nxplayer didChangeFromState:(NXPlayerState)oldState toState:(NXPlayerState)newState {
+    NSLog(@"state changed %lu -> %lu",(unsigned long)oldState,(unsigned long)newState);
+    [self playerFSM:nxplayer changedToState:newState];
+    NexPublishPlayhead([self indexOfPlayer:nxplayer], (int64_t)nxplayer.currentTimeStamp, (int)newState, 0);
+    [self syncGroupPlayer:nxplayer changedToState:newState];
+    NexPostEvent(NEXUNITY_EVENT_STATUS_CHANGED,oldState,newState,0,0,0);
+}
+@end
+
+static NexPlayerScripting* _GetPlayer() {
+    static NexPlayerScripting* _Player = nil;
+    if(!_Player)
+        _Player = [[NexPlayerScripting alloc] init];
+
+    frameTexture = 0;
+
+    return _Player;
+}
+
+static NSString* _GetUrl(const char* filename) {
+    return [NSString stringWithUTF8String:filename];
+}
+
+static void* g_TexturePointer = NULL;
+static bool alreadyInit = false;
+
+enum NexPlayerEventType {
+    NEXPLAYER_INIT = 0,
+    NEXPLAYER_SHUTDOWN = 1,
+    NEXPLAYER_UPDATE = 2
+};
+
+// --------------------------------------------------------------------------
+// UnitySetInterfaces
+
+static void UNITY_INTERFACE_API OnGraphicsDeviceEvent(UnityGfxDeviceEventType eventType);
+
+static IUnityInterfaces* s_UnityInterfaces = NULL;
+static IUnityGraphics* s_Graphics = NULL;
+static UnityGfxRenderer s_DeviceType = kUnityGfxRendererNull;
+
+extern "C" void UNITY_INTERFACE_EXPORT UNITY_INTERFACE_API UnityPluginLoad(IUnityInterfaces* unityInterfaces)
 {
     [_GetPlayer() Log:4 toValue:@"UnityPluginLoad \n"];
     s_UnityInterfaces = unityInterfaces;
@@ -2186,26 +5532,53 @@ extern "C" UnityRenderingEvent NexPlayerUnityRenderEvent() {
     return OnRenderEvent;
 }
 
+extern "C" int NexPlayerUnity_PauseAsync() {
+    return [_GetPlayer() pausePlayer];
+}
+
 extern "C" void NEXPLAYERUnity_Pause() {
     //printf("iOS - NEXPLAYERUnity_Pause \n");
     [_GetPlayer() pausePlayer];
 }
 
+extern "C" int NexPlayerUnity_ResumeAsync() {
+    return [_GetPlayer() resumePlayer];
+}
+
 extern "C" void NEXPLAYERUnity_Resume() {
     [_GetPlayer() Log:4 toValue:@"iOS - NEXPLAYERUnity_Resume \n"];
     [_GetPlayer() resumePlayer];
 }
 
 
+extern "C" int NexPlayerUnity_StopAsync() {
+    return [_GetPlayer() stopPlayer];
+}
+
 extern "C" void NEXPLAYERUnity_Stop() {
     //printf("iOS - NEXPLAYERUnity_Stop \n");
-    [_GetPlayer() stopPlayer];
+    NexPlayerUnity_StopAsync();
 }
 
+// Opt-in asynchronous open: returns the command token, the outcome arrives as NEXUNITY_EVENT_COMMAND_COMPLETE.
+extern "C" int NexPlayerUnity_OpenAsync(const char* url) {
+    [_GetPlayer() Log:4 toValue:@"iOS - NexPlayerUnity_OpenAsync \n"];
+    NexPlayerScripting *player = _GetPlayer();
+    NSString *path = _GetUrl(url);
+    return [player enqueueCommand:COMMAND_OPEN index:0 arg:0 work:^int{
+        return [player openPlayer:path];
+    }];
+}
 
+// Synchronous for the prebuilt NexPlayerUnityDLL, which knows no command tokens: the open still runs on
+// the command worker, behind anything queued, and the openPlayer: result comes back to the caller.
 extern "C" int NEXPLAYERUnity_Open(const char* url) {
     [_GetPlayer() Log:4 toValue:@"iOS - NEXPLAYERUnity_Open \n"];
-    return [_GetPlayer() openPlayer:_GetUrl(url)];
+    NexPlayerScripting *player = _GetPlayer();
+    NSString *path = _GetUrl(url);
+    return [player performCommand:COMMAND_OPEN index:0 arg:0 work:^int{
+        return [player openPlayer:path];
+    }];
 }
 
 extern "C" void NEXPLAYERUnity_Start(int msec) {
@@ -2213,14 +5586,34 @@ extern "C" void NEXPLAYERUnity_Start(int msec) {
     [_GetPlayer() startPlayer:msec];
 }
 
+extern "C" int NexPlayerUnity_SeekAsync(int msec) {
+    return [_GetPlayer() seekPlayerToTime:msec];
+}
+
 extern "C" void NEXPLAYERUnity_Seek(int msec) {
     [_GetPlayer() Log:4 toValue:@"iOS - NEXPLAYERUnity_Seek \n"];
-    [_GetPlayer() seekPlayerToTime:msec];
+    NexPlayerUnity_SeekAsync(msec);
+}
+
+extern "C" int NexPlayerUnity_CloseAsync() {
+    NexPlayerScripting *player = _GetPlayer();
+    return [player enqueueCommand:COMMAND_CLOSE index:0 arg:0 work:^int{
+        [player closePlayer];
+        return PLAYER_ERROR_NONE;
+    }];
 }
 
 extern "C" void NEXPLAYERUnity_Close() {
     [_GetPlayer() Log:4 toValue:@"iOS - NEXPLAYERUnity_Close \n"];
-    [_GetPlayer() closePlayer];
+    NexPlayerUnity_CloseAsync();
+}
+
+extern "C" int NexPlayerUnity_GetCommandStatus(int token, int* result) {
+    return [_GetPlayer() getCommandStatus:token result:result];
+}
+
+extern "C" int NexPlayerUnity_GetAvoidedCallCount(int index) {
+    return [_GetPlayer() getAvoidedCallCount:index];
 }
 
 extern "C" int NEXPLAYERUnity_GetContentInfoInt(int info_index) {
@@ -2233,6 +5626,91 @@ extern "C" int NEXPLAYERUnity_GetBufferInfo() {
     return [_GetPlayer() getBufferInfo];
 }
 
+extern "C" void NexPlayerUnity_EnableGovernor(bool enable) {
+    governorEnabled = enable;
+    if(enable)
+        return;
+    // Hand anything still queued to Unity so no event is lost when switching back.
+    NexQueuedEvent event;
+    while(NexPopEvent(&event))
+        if(g_playerListener)
+            g_playerListener(event.event,event.args[0],event.args[1],event.args[2],event.args[3],event.args[4]);
+}
+
+// Call once per frame from Unity's main thread with the microseconds the bridge may use.
+extern "C" void NexPlayerUnity_GovernorTick(int budgetUs) {
+    if(budgetUs > 0)
+        [_GetPlayer() governorTick:budgetUs];
+}
+
+extern "C" void NexPlayerUnity_GetGovernorStats(int* overruns, int* lastOverrunUs, int* maxOverrunUs, int* backlog, int* dropped) {
+    std::lock_guard<std::mutex> lock(governorLock);
+    *overruns = governorOverruns;
+    *lastOverrunUs = governorLastOverrunUs;
+    *maxOverrunUs = governorMaxOverrunUs;
+    *backlog = governorQueues[0].count + governorQueues[1].count + governorQueues[2].count + (int)governorCritical.size();
+    *dropped = governorDropped;
+}
+
+extern "C" bool NexPlayerUnity_GetStats(int index, NexStatsSnapshot* stats) {
+    if(index < 0 || index >= 8 || stats == NULL)
+        return false;
+    return NexReadStats(index, *stats);
+}
+
+// Pointer to one of the NexPlayerREGION memory regions, for C# to wrap as a NativeArray
+// without copying. count is the number of records (bytes for NEXUNITY_REGION_STRINGS) and
+// generation changes whenever the contents do. Every region lives for the life of the plugin.
+// Catalog regions flip between two arenas on content-info updates: fetch them again once the
+// generation moves on, and trust what was read only while it has advanced by at most one.
+extern "C" const void* NexPlayerUnity_GetRegion(int region, int* count, uint32_t* generation) {
+    const void *base = NULL;
+    int length = 0;
+    uint32_t current = 0;
+    switch(region){
+        case NEXUNITY_REGION_EVENTS:
+            base = eventRing;
+            length = EVENT_RING_SIZE;
+            current = eventRingWritten.load(std::memory_order_acquire);
+            break;
+        case NEXUNITY_REGION_STATS:
+            base = statsRecords;
+            length = 8;
+            current = statsGeneration.load(std::memory_order_acquire);
+            break;
+        case NEXUNITY_REGION_PLAYHEAD:
+            base = playheadRecords;
+            length = 8;
+            current = playheadGeneration.load(std::memory_order_acquire);
+            break;
+        case NEXUNITY_REGION_STREAMS:
+        case NEXUNITY_REGION_TRACKS:
+        case NEXUNITY_REGION_STRINGS: {
+            std::lock_guard<std::mutex> lock(catalogLock);
+            current = catalogGeneration.load(std::memory_order_relaxed);
+            const NexCatalogBuffer &buffer = NexCatalogAt(current);
+            if(region == NEXUNITY_REGION_STREAMS){
+                base = buffer.streams;
+                length = buffer.streamTotal;
+            } else if(region == NEXUNITY_REGION_TRACKS){
+                base = buffer.tracks;
+                length = buffer.trackTotal;
+            } else {
+                base = buffer.strings;
+                length = buffer.stringBytes;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    if(count != NULL)
+        *count = length;
+    if(generation != NULL)
+        *generation = current;
+    return base;
+}
+
 extern "C" void setPlayerListener(PlayerListener l) {
     [_GetPlayer() Log:4 toValue:@"iOS - setPlayerListener \n"];
     if(g_playerListener != NULL)
@@ -2269,9 +5747,22 @@ extern "C" int NEXPLAYERUnity_GetBufferedEndTime () {
 extern "C" void UpdateTextureFromUnity(void* texturePtr,int w, int h) {
     [_GetPlayer() Log:4 toValue:@"iOS - UpdateTextureFromUnity \n"];
 }
+extern "C" int NexPlayerUnity_OpenFDAsync(const char* fileName) {
+    NexPlayerScripting *player = _GetPlayer();
+    NSString *name = _GetUrl(fileName);
+    return [player enqueueCommand:COMMAND_OPEN index:0 arg:0 work:^int{
+        return [player openFD:name];
+    }];
+}
+
+// Synchronous like NEXPLAYERUnity_Open; NexPlayerUnity_OpenFDAsync is the non-blocking form.
 extern "C" int NEXPLAYERUnity_OpenFD(const char* fileName) {
     [_GetPlayer() Log:4 toValue:@"iOS - NEXPLAYERUnity_OpenFD \n"];
-    return [_GetPlayer() openFD:_GetUrl(fileName)];
+    NexPlayerScripting *player = _GetPlayer();
+    NSString *name = _GetUrl(fileName);
+    return [player performCommand:COMMAND_OPEN index:0 arg:0 work:^int{
+        return [player openFD:name];
+    }];
 }
 
 extern "C" void NEXPLAYERUnity_SetKeyServerUri(const char* uri) {
@@ -2309,38 +5800,101 @@ extern "C" void NexPlayerUnity_SetFirstFrame(bool isShow) {
     [_GetPlayer() setFirstFrame:isShow];
 }
 
-extern "C" int NEXPLAYERUnity_GetCurrentSubtitleByteArray(unsigned char* buffer) {
-    NSString *temp = [_GetPlayer() current_subtitle];
-    const char* string = [temp UTF8String];
+static int _GetSubtitleIndex() {
+    int index = lastSubMultiIndex;
+    return index >= 0 && index < 8 ? index : 0;
+}
 
-    int length = (int)strlen(string);
-    memcpy(buffer, string, length);
+// buffer must hold NEXPLAYER_CUE_TEXT_MAX bytes; NexPlayerUnity_GetCueText takes a capacity.
+extern "C" int NEXPLAYERUnity_GetCurrentSubtitleByteArray(unsigned char* buffer) {
+    NexCueRecord cue;
+    NexReadCue(_GetSubtitleIndex(), cue, (char *)buffer, NEXPLAYER_CUE_TEXT_MAX - 1);
 
-    return length;
+    return cue.length;
 }
 
+// The C# wrapper frees the returned copy; NexPlayerUnity_GetCue reads the text in place.
 extern "C" char* NEXPLAYERUnity_GetCurrentSubtitleString() {
-    NSString *temp = [_GetPlayer() current_subtitle];
-    const char* string = [temp UTF8String];
-    char* result = strdup(string);
+    NexCueRecord cue;
+    char text[NEXPLAYER_CUE_TEXT_MAX];
+    NexReadCue(_GetSubtitleIndex(), cue, text, NEXPLAYER_CUE_TEXT_MAX - 1);
+    text[cue.length] = 0;
+    char* result = strdup(text);
 
     return result;
 }
 
 extern "C" int NEXPLAYERUnity_GetCurrentSubtitleType() {
-    int type = [_GetPlayer() subtitle_type];
-    return type;
+    NexCueRecord cue;
+    NexReadCue(_GetSubtitleIndex(), cue, NULL, 0);
+    return cue.type;
 }
 
 extern "C" int NEXPLAYERUnity_GetCurrentSubtitleStartTime() {
-    NSUInteger startTime = [_GetPlayer() subtitle_startTime];
-
-    return (int)startTime;
+    NexCueRecord cue;
+    NexReadCue(_GetSubtitleIndex(), cue, NULL, 0);
+    return (int)cue.startMs;
 }
 
 extern "C" int NEXPLAYERUnity_GetCurrentSubtitleEndTime() {
-    NSUInteger endTime = [_GetPlayer() subtitle_endTime];
-    return (int)endTime;
+    NexCueRecord cue;
+    NexReadCue(_GetSubtitleIndex(), cue, NULL, 0);
+    return (int)cue.endMs;
+}
+
+// Active cue of an instance, in place. Copy what is needed, then check that the record's
+// sequence is unchanged (and even), or that *generation still matches
+// NexPlayerUnity_GetCueGeneration; otherwise read again.
+extern "C" const NexCueRecord* NexPlayerUnity_GetCue(int index, uint32_t* generation) {
+    if(index < 0 || index >= 8)
+        return NULL;
+    uint32_t current = cueGeneration[index].load(std::memory_order_acquire);
+    if(generation != NULL)
+        *generation = current;
+    return &cueSlots[index][current & 1];
+}
+
+extern "C" uint32_t NexPlayerUnity_GetCueGeneration(int index) {
+    if(index < 0 || index >= 8)
+        return 0;
+    return cueGeneration[index].load(std::memory_order_acquire);
+}
+
+// Cue text copied into buffer (at most capacity bytes, not terminated); returns the length.
+extern "C" int NexPlayerUnity_GetCueText(int index, unsigned char* buffer, int capacity, int64_t* startMs, int64_t* endMs) {
+    if(index < 0 || index >= 8 || buffer == NULL || capacity <= 0)
+        return 0;
+    NexCueRecord cue;
+    NexReadCue(index, cue, (char *)buffer, capacity);
+    if(startMs != NULL)
+        *startMs = cue.startMs;
+    if(endMs != NULL)
+        *endMs = cue.endMs;
+    return cue.length;
+}
+
+extern "C" const NexPlayheadRecord* NexPlayerUnity_GetPlayheadRecords(int* count) {
+    if(count != NULL)
+        *count = 8;
+    return playheadRecords;
+}
+
+extern "C" int64_t NexPlayerUnity_GetMonotonicUs() {
+    return NexMonotonicUs();
+}
+
+// monotonicUs <= 0 interpolates for now.
+extern "C" int64_t NexPlayerUnity_GetInterpolatedPts(int index, int64_t monotonicUs) {
+    return NexInterpolatePlayhead(index, monotonicUs > 0 ? monotonicUs : NexMonotonicUs());
+}
+
+extern "C" void NexPlayerUnity_EnableTimeEvents(bool enable) {
+    timeEventsEnabled = enable;
+}
+
+// Subtitle of one multiview instance, copied into buffer (capacity bytes); returns the copied length.
+extern "C" int NexPlayerUnity_GetSubtitleByteArrayMulti(int index, unsigned char* buffer, int capacity) {
+    return NexPlayerUnity_GetCueText(index, buffer, capacity, NULL, NULL);
 }
 
 extern "C" void NEXPLAYERUnity_OnOffSubtitle(bool bOnOff) {
@@ -2359,6 +5913,298 @@ extern "C" void NEXPLAYERUnity_ChangeSubtitlePath(const char* subtitlePath) {
     return [_GetPlayer() changeSubtitlePath:_GetUrl(subtitlePath)];
 }
 
+// Selects the CEA-608 channel (NXCEA608Channel) whose cell grid an instance exports; 0 turns it off.
+extern "C" void NexPlayerUnity_SetCEA608Channel(int index, int channel) {
+    if(index < 0 || index >= 8 || channel < NXCEA608Channel_None || channel > NXCEA608Channel_Ch4)
+        return;
+    [_GetPlayer() setCEA608Channel:channel index:index];
+}
+
+// Grid of an instance, in place. Copy the rows named by the dirty mask, then check that
+// sequence is unchanged and even; otherwise copy again.
+extern "C" const NexCaptionGrid* NexPlayerUnity_GetCaptionGrid(int index) {
+    if(index < 0 || index >= 8)
+        return NULL;
+    return &captionGrids[index];
+}
+
+// Rows changed since the previous call, cleared as they are returned.
+extern "C" uint32_t NexPlayerUnity_TakeCaptionDirtyRows(int index) {
+    if(index < 0 || index >= 8)
+        return 0;
+    return __atomic_exchange_n(&captionGrids[index].dirtyRows, 0u, __ATOMIC_ACQ_REL);
+}
+
+// Natively parsed subtitles of an instance: cue count and parse time, or false if the SDK renders them.
+extern "C" bool NexPlayerUnity_GetExternalSubtitleStats(int index, int* cues, int* parseUs) {
+    std::shared_ptr<const NexSubtitleTrack> track = NexExternalSubtitles(index);
+    if(track == nullptr)
+        return false;
+    if(cues != NULL)
+        *cues = (int)track->cues.size();
+    if(parseUs != NULL)
+        *parseUs = (int)track->parseUs;
+    return true;
+}
+
+// Parses a DASH manifest or HLS playlist the app fetched into the instance's segment index;
+// url is the manifest URL, against which relative URLs are resolved.
+extern "C" bool NexPlayerUnity_LoadManifest(int index, const char* url, const char* data, int length) {
+    return [_GetPlayer() loadManifest:data length:(size_t)std::max(0, length) url:url != NULL ? [NSString stringWithUTF8String:url] : nil index:index];
+}
+
+// Media playlist of a rendition of the HLS master playlist loaded for the instance.
+extern "C" bool NexPlayerUnity_LoadMediaPlaylist(int index, int rendition, const char* url, const char* data, int length) {
+    return [_GetPlayer() loadMediaPlaylist:data length:(size_t)std::max(0, length) url:url != NULL ? [NSString stringWithUTF8String:url] : nil
+                                     index:index rendition:rendition];
+}
+
+// Most segments the instance's index keeps per rendition once a live manifest has more; the
+// oldest leave first. 0 (the default) keeps every segment the manifest lists.
+extern "C" void NexPlayerUnity_SetManifestWindow(int index, int segments) {
+    if(index >= 0 && index < 8)
+        manifestWindows[index] = std::max(0, segments);
+}
+
+extern "C" bool NexPlayerUnity_GetManifestInfo(int index, NexManifestInfo* info) {
+    std::lock_guard<std::mutex> lock(manifestLock);
+    const NexManifestIndex *manifest = NexManifestLocked(index);
+    if(manifest == NULL || info == NULL)
+        return false;
+    info->generation = manifest->generation;
+    info->type = manifest->type;
+    info->live = manifest->live;
+    info->periodCount = (int32_t)manifest->periods.size();
+    info->renditionCount = (int32_t)manifest->renditions.size();
+    info->parseUs = (int32_t)manifest->parseUs;
+    info->refreshUs = (int32_t)manifest->refreshUs;
+    info->reserved = 0;
+    info->durationMs = manifest->durationMs;
+    info->segmentCount = manifest->segmentTotal();
+    return true;
+}
+
+extern "C" bool NexPlayerUnity_GetManifestRendition(int index, int rendition, NexRenditionRecord* record) {
+    std::lock_guard<std::mutex> lock(manifestLock);
+    const NexManifestIndex *manifest = NexManifestLocked(index);
+    if(manifest == NULL || record == NULL || rendition < 0 || rendition >= (int)manifest->renditions.size())
+        return false;
+    *record = manifest->renditions[rendition].record;
+    return true;
+}
+
+extern "C" bool NexPlayerUnity_GetManifestSegment(int index, int rendition, int position, NexSegmentRecord* segment) {
+    std::lock_guard<std::mutex> lock(manifestLock);
+    const NexManifestIndex *manifest = NexManifestLocked(index);
+    return manifest != NULL && segment != NULL && rendition >= 0 && position >= 0 && manifest->segment(rendition, position, *segment);
+}
+
+// Position of the rendition's segment holding timeMs, -1 when outside the indexed range.
+extern "C" int NexPlayerUnity_FindManifestSegment(int index, int rendition, int64_t timeMs) {
+    std::lock_guard<std::mutex> lock(manifestLock);
+    const NexManifestIndex *manifest = NexManifestLocked(index);
+    if(manifest == NULL || rendition < 0)
+        return -1;
+    return (int)manifest->findSegment(rendition, timeMs);
+}
+
+static int NexCopyString(const std::string &value, char *buffer, int capacity) {
+    if(buffer != NULL && capacity > 0){
+        size_t copied = std::min(value.size(), (size_t)capacity - 1);
+        memcpy(buffer, value.data(), copied);
+        buffer[copied] = 0;
+    }
+    return (int)value.size();
+}
+
+// Absolute URL of a segment, or of its initialization segment when init is set. Returns the
+// length without terminator; a result of capacity or more means the buffer was too small.
+extern "C" int NexPlayerUnity_GetManifestSegmentURL(int index, int rendition, int position, bool init, char* buffer, int capacity) {
+    std::string url;
+    {
+        std::lock_guard<std::mutex> lock(manifestLock);
+        const NexManifestIndex *manifest = NexManifestLocked(index);
+        if(manifest == NULL || rendition < 0 || position < 0 || !manifest->segmentURL(rendition, position, init, url))
+            return -1;
+    }
+    return NexCopyString(url, buffer, capacity);
+}
+
+// LL-HLS part of a segment; position == segmentCount addresses the segment still being produced,
+// whose last part may be the preload hint.
+extern "C" bool NexPlayerUnity_GetManifestPart(int index, int rendition, int position, int part, NexSegmentRecord* segment) {
+    std::lock_guard<std::mutex> lock(manifestLock);
+    const NexManifestIndex *manifest = NexManifestLocked(index);
+    return manifest != NULL && segment != NULL && rendition >= 0 && position >= 0 && part >= 0 && manifest->part(rendition, position, part, *segment, NULL);
+}
+
+extern "C" int NexPlayerUnity_GetManifestPartURL(int index, int rendition, int position, int part, char* buffer, int capacity) {
+    std::string url;
+    {
+        std::lock_guard<std::mutex> lock(manifestLock);
+        const NexManifestIndex *manifest = NexManifestLocked(index);
+        NexSegmentRecord segment;
+        if(manifest == NULL || rendition < 0 || position < 0 || part < 0 || !manifest->part(rendition, position, part, segment, &url))
+            return -1;
+    }
+    return NexCopyString(url, buffer, capacity);
+}
+
+extern "C" bool NexPlayerUnity_GetManifestKey(int index, int rendition, int key, NexKeyRecord* record) {
+    std::lock_guard<std::mutex> lock(manifestLock);
+    const NexManifestIndex *manifest = NexManifestLocked(index);
+    const NexMediaPlaylist *media = manifest != NULL && rendition >= 0 ? manifest->playlist(rendition) : NULL;
+    if(media == NULL || record == NULL || key < 0 || key >= (int)media->keys.size())
+        return false;
+    *record = media->keys[key];
+    return true;
+}
+
+extern "C" bool NexPlayerUnity_GetManifestDateRange(int index, int rendition, int range, NexDateRangeRecord* record) {
+    std::lock_guard<std::mutex> lock(manifestLock);
+    const NexManifestIndex *manifest = NexManifestLocked(index);
+    const NexMediaPlaylist *media = manifest != NULL && rendition >= 0 ? manifest->playlist(rendition) : NULL;
+    if(media == NULL || record == NULL || range < 0 || range >= (int)media->dateRanges.size())
+        return false;
+    *record = media->dateRanges[range];
+    return true;
+}
+
+// Copies a record string; rendition is -1 for NexRenditionRecord strings and the rendition for
+// strings of its HLS media playlist (keys, date ranges). Returns the length, -1 for an invalid offset.
+extern "C" int NexPlayerUnity_GetManifestString(int index, int rendition, int offset, char* buffer, int capacity) {
+    std::string value;
+    {
+        std::lock_guard<std::mutex> lock(manifestLock);
+        const NexManifestIndex *manifest = NexManifestLocked(index);
+        const char *string = manifest != NULL ? manifest->string(rendition, offset) : NULL;
+        if(string == NULL)
+            return -1;
+        value = string;
+    }
+    return NexCopyString(value, buffer, capacity);
+}
+
+//Stall watchdog
+extern "C" void NexPlayerUnity_EnableWatchdog(int index, bool enable){
+    [_GetPlayer() Log:4 toValue:@"iOS - NexPlayerUnity_EnableWatchdog \n"];
+    [_GetPlayer() enableWatchdog:index enable:enable];
+}
+
+// Windows in ms for which position, buffer level and HTTP traffic must all stand still, and the
+// wait after each recovery action before the next; values <= 0 keep the current one.
+extern "C" void NexPlayerUnity_SetWatchdogWindows(int stallMs, int bufferMs, int httpMs, int stepMs){
+    std::lock_guard<std::mutex> lock(watchdogLock);
+    if(stallMs > 0)
+        watchdogStallMs = stallMs;
+    if(bufferMs > 0)
+        watchdogBufferMs = bufferMs;
+    if(httpMs > 0)
+        watchdogHttpMs = httpMs;
+    if(stepMs > 0)
+        watchdogStepMs = stepMs;
+}
+
+extern "C" bool NexPlayerUnity_GetRecoveryStats(int index, NexRecoveryStats* stats){
+    if(index < 0 || index >= 8 || stats == NULL)
+        return false;
+    std::lock_guard<std::mutex> lock(watchdogLock);
+    *stats = stallWatchdog[index].stats;
+    return true;
+}
+//End stall watchdog
+
+//Resilience
+// Retry policy for an instance's network errors; NULL passes every error to the app again.
+extern "C" int NexPlayerUnity_SetResiliencePolicy(int index, const NexResiliencePolicy* policy){
+    return [_GetPlayer() setResiliencePolicy:index toValue:policy];
+}
+
+extern "C" bool NexPlayerUnity_GetResilienceStats(int index, NexResilienceStats* stats){
+    if(index < 0 || index >= 8 || stats == NULL)
+        return false;
+    std::lock_guard<std::mutex> lock(resilienceLock);
+    *stats = resilience[index].stats;
+    return true;
+}
+
+// NexPlayerERROR_CLASS of an NXError code.
+extern "C" int NexPlayerUnity_ClassifyError(int errorCode){
+    return NexClassifyError((uint32_t)errorCode);
+}
+//End resilience
+
+//Header store
+// Header every later request of the instance carries, replacing one of the same name; value NULL
+// stops overriding it. Returns the store generation, or -1 for an invalid name or value.
+extern "C" int NexPlayerUnity_SetHttpHeader(int index, const char* name, const char* value){
+    return [_GetPlayer() storeHeaderField:index name:name != NULL ? [NSString stringWithUTF8String:name] : nil
+                                    value:value != NULL ? [NSString stringWithUTF8String:value] : nil query:NO];
+}
+
+// Query parameter every later request URL of the instance carries, replaced where present and
+// appended otherwise. value is expected URL-encoded: %XX escapes are kept, while spaces, '&', '#'
+// and other bytes a query value cannot hold are percent-encoded. NULL removes it.
+extern "C" int NexPlayerUnity_SetQueryToken(int index, const char* name, const char* value){
+    return [_GetPlayer() storeHeaderField:index name:name != NULL ? [NSString stringWithUTF8String:name] : nil
+                                    value:value != NULL ? [NSString stringWithUTF8String:value] : nil query:YES];
+}
+
+extern "C" void NexPlayerUnity_ClearHeaderStore(int index){
+    if(index < 0 || index >= 8)
+        return;
+    std::lock_guard<std::mutex> lock(headerStoreLock);
+    headerStores[index] = nullptr;
+}
+//End header store
+
+// Equivalent URL prefixes for an instance's requests, one per line in the order of preference;
+// NULL or fewer than two goes back to the alternate BaseURLs of the MPD, if any.
+extern "C" void NexPlayerUnity_SetCdnLocations(int index, const char* locations) {
+    [_GetPlayer() setCdnLocations:index locations:locations != NULL ? [NSString stringWithUTF8String:locations] : @""];
+}
+
+extern "C" int NexPlayerUnity_GetCdnLocationCount(int index) {
+    if(index < 0 || index >= 8)
+        return 0;
+    std::lock_guard<std::mutex> lock(steeringLock);
+    return (int)cdnSteering[index].locations.size();
+}
+
+extern "C" bool NexPlayerUnity_GetCdnLocationStats(int index, int location, NexCdnLocationStats* stats) {
+    if(index < 0 || index >= 8 || stats == NULL)
+        return false;
+    std::lock_guard<std::mutex> lock(steeringLock);
+    const NexCdnSteering &steering = cdnSteering[index];
+    if(location < 0 || location >= (int)steering.locations.size())
+        return false;
+    const NexCdnLocation &entry = steering.locations[location];
+    int64_t nowUs = NexMonotonicUs();
+    stats->state = steering.state(entry, nowUs);
+    stats->consecutiveErrors = entry.consecutiveErrors;
+    stats->throughputBps = (int64_t)(entry.throughput * 8);
+    stats->errorRate = (float)entry.errorRate;
+    stats->requests = entry.requests;
+    stats->failures = entry.failures;
+    stats->steeredTo = entry.steeredTo;
+    stats->holdRemainingMs = (int32_t)std::max<int64_t>(0, (entry.holdUntilUs - nowUs) / 1000);
+    stats->reserved = 0;
+    return true;
+}
+
+// Device profile for the manifests an instance opens from now on; NULL stops rewriting them.
+extern "C" int NexPlayerUnity_SetDeviceProfile(int index, const NexDeviceProfile* profile) {
+    return [_GetPlayer() setDeviceProfile:index toValue:profile];
+}
+
+extern "C" bool NexPlayerUnity_GetManifestRewriteInfo(int index, NexManifestRewriteInfo* info) {
+    if(index < 0 || index >= 8 || info == NULL)
+        return false;
+    std::lock_guard<std::mutex> lock(profileLock);
+    *info = rewriteInfos[index];
+    return info->count > 0;
+}
+
 extern "C" void NEXPLAYERUnity_ChangeSubtitleFD(const char* subtitleURI) {
     return [_GetPlayer() changeSubtitleFD:_GetUrl(subtitleURI)];
 }
@@ -2380,124 +6226,69 @@ extern "C" void NexPlayerUnity_SetLowLatency(bool enable, int value) {
 }
 
 extern "C" int NEXPLAYERUnity_GetTimedMetadata_Data(int nType, const char* TagID, unsigned char* TagData) {
-    NSDictionary *TimedMetadata = [_GetPlayer() timedMetadata];
-    NSString *text;
-    const char* string_tagData;
-    NSString* string_tagID;
-    int length = 0;
-    NSDictionary* extraTags;
-    NxTimedMetaExtraTag *extraTag;
-
-    switch(nType)
-    {
-        case 0:   //Title
-            text = [TimedMetadata objectForKey:kNXTimedMetaKeyTitle];
-            break;
-        case 1:   //Album
-            text = [TimedMetadata objectForKey:kNXTimedMetaKeyAlbum];
-            break;
-        case 2:   //Artist
-            text = [TimedMetadata objectForKey:kNXTimedMetaKeyArtist];
-            break;
-        case 4:   //Genre
-            text = [TimedMetadata objectForKey:kNXTimedMetaKeyGenre];
-            break;
-        case 6:   //Track Number
-            text = [TimedMetadata objectForKey:kNXTimedMetaKeyTrackNum];
-            break;
-        case 7:   //Year
-            text = [TimedMetadata objectForKey:kNXTimedMetaKeyYear];
-            break;
-        case 10:  //Comment
-            text = [TimedMetadata objectForKey:kNXTimedMetaKeyComment];
-            break;
-        case 11:  //Text
-            text = [TimedMetadata objectForKey:kNXTimedMetaKeyText];
-            break;
-        case 12:  //Extra Tag
-            extraTags = [TimedMetadata objectForKey:kNXTimedMetaKeyExtraData];
-            string_tagID = _GetUrl(TagID);
-            for(NSString *key in [extraTags keyEnumerator]){
-
-                if([key isEqualToString:string_tagID] == YES) {
-                    extraTag = extraTags[key];
-                    text = [extraTag text];
-                    break;
-                }
-            }
-            break;
-        default:
-            break;
-
-    }
-    if(text != nil) {
-        string_tagData = [text UTF8String];
-        length = (int)strlen(string_tagData);
-        memcpy(TagData, string_tagData, length);
-    }
-    return length;
+    std::lock_guard<std::mutex> lock(metadataLock);
+    return NexLookupMetadataText(nType, TagID, TagData);
 }
 
 extern "C" int NEXPLAYERUnity_GetTimedMetadata_Data_Length(int nType, const char* TagID)
 {
-    NSDictionary *TimedMetadata = [_GetPlayer() timedMetadata];
-    NSString *text;
-    const char* string_tagData;
-    NSString* string_tagID;
-    int length = 0;
-    NSDictionary* extraTags;
-    NxTimedMetaExtraTag *extraTag;
+    std::lock_guard<std::mutex> lock(metadataLock);
+    return NexLookupMetadataText(nType, TagID, NULL);
+}
 
-    switch(nType)
-    {
-        case 0:   //Title
-            text = [TimedMetadata objectForKey:kNXTimedMetaKeyTitle];
-            break;
-        case 1:   //Album
-            text = [TimedMetadata objectForKey:kNXTimedMetaKeyAlbum];
-            break;
-        case 2:   //Artist
-            text = [TimedMetadata objectForKey:kNXTimedMetaKeyArtist];
-            break;
-        case 4:   //Genre
-            text = [TimedMetadata objectForKey:kNXTimedMetaKeyGenre];
-            break;
-        case 6:   //Track Number
-            text = [TimedMetadata objectForKey:kNXTimedMetaKeyTrackNum];
-            break;
-        case 7:   //Year
-            text = [TimedMetadata objectForKey:kNXTimedMetaKeyYear];
-            break;
-        case 10:  //Comment
-            text = [TimedMetadata objectForKey:kNXTimedMetaKeyComment];
-            break;
-        case 11:  //Text
-            text = [TimedMetadata objectForKey:kNXTimedMetaKeyText];
-            break;
-        case 12:  //Extra Tag
-            extraTags = [TimedMetadata objectForKey:kNXTimedMetaKeyExtraData];
-            string_tagID = _GetUrl(TagID);
-            for(NSString *key in [extraTags keyEnumerator]){
-
-                if([key isEqualToString:string_tagID] == YES)
-                {
-                    extraTag = extraTags[key];
-                    text = [extraTag text];
-                    break;
-                }
-            }
-            break;
-        default:
-            break;
+// Latest timed metadata of an instance as one flat buffer (NexMetadataHeader layout), text and
+// binary frames alike, copied into buffer when it has room for all of it. Returns the full size
+// (0 when there is none); call with capacity 0 to size the buffer. *generation is the update
+// the size and copy belong to.
+extern "C" int NexPlayerUnity_GetTimedMetadataBuffer(int index, uint8_t* buffer, int capacity, uint32_t* generation) {
+    if(index < 0 || index >= 8)
+        return 0;
+    std::lock_guard<std::mutex> lock(metadataLock);
+    const std::vector<uint8_t> &data = metadataBuffers[index];
+    if(buffer != NULL && capacity >= (int)data.size() && !data.empty())
+        memcpy(buffer, data.data(), data.size());
+    if(generation != NULL)
+        *generation = metadataGeneration[index].load(std::memory_order_relaxed);
+    return (int)data.size();
+}
+
+// Entries with t0 <= ptsMs < t1, in PTS order; returns how many were written to entries.
+extern "C" int NexPlayerUnity_QueryTimeline(int index, int64_t t0, int64_t t1, NexTimelineEntry* entries, int capacity) {
+    if(index < 0 || index >= 8 || entries == NULL)
+        return 0;
+    std::lock_guard<std::mutex> lock(timelineLock);
+    const std::vector<NexTimelineItem> &items = timeline[index];
+    int count = 0;
+    for(auto it = std::lower_bound(items.begin(), items.end(), t0, NexTimelineLess);
+        it != items.end() && it->entry.ptsMs < t1 && count < capacity; ++it)
+        entries[count++] = it->entry;
+    return count;
+}
 
+// Payload of an entry copied into buffer (at most capacity bytes); returns its full size, -1 if gone.
+extern "C" int NexPlayerUnity_GetTimelinePayload(int index, uint32_t id, uint8_t* buffer, int capacity) {
+    if(index < 0 || index >= 8)
+        return -1;
+    std::lock_guard<std::mutex> lock(timelineLock);
+    for(const NexTimelineItem &item : timeline[index]){
+        if(item.entry.id != id)
+            continue;
+        if(buffer != NULL && capacity > 0)
+            memcpy(buffer, item.payload.data(), std::min((int)item.payload.size(), capacity));
+        return (int)item.payload.size();
     }
-    if(text != nil)
-    {
-        string_tagData = [text UTF8String];
-        length = (int)strlen(string_tagData);
+    return -1;
+}
 
-    }
-    return length;
+// Adds an application-defined entry (ad beacon, chapter marker) to an instance's timeline.
+extern "C" uint32_t NexPlayerUnity_AddTimelineEntry(int index, int64_t ptsMs, int64_t durationMs, const uint8_t* payload, int size) {
+    if(index < 0 || index >= 8 || ptsMs < 0)
+        return 0;
+    std::vector<uint8_t> bytes;
+    if(payload != NULL && size > 0)
+        bytes.assign(payload, payload + size);
+    std::lock_guard<std::mutex> lock(timelineLock);
+    return NexTimelineInsert(index, ptsMs, durationMs, NEXUNITY_TIMELINE_EVENT, bytes);
 }
 
 extern "C" int NEXPLAYERUnity_GetTimedMetadata_EncodingType(int nTyoe, const char* TagID)
@@ -2513,6 +6304,14 @@ extern "C" int NEXPLAYERUnity_SetTimedMetadata_CustomTags(const char* Tags)
     return 0;
 }
 
+// Metadata updates dropped because no subscribed tag or standard field changed.
+extern "C" int NexPlayerUnity_GetSuppressedMetadataCount(int index) {
+    if(index < 0 || index >= 8)
+        return 0;
+    std::lock_guard<std::mutex> lock(customTagLock);
+    return suppressedMetadataUpdates[index];
+}
+
 extern "C" BOOL NEXPLAYERUnity_setLicenseFile(const char* licenseFilePath)
 {
     return [_GetPlayer() setLicenseFilePath:_GetUrl(licenseFilePath)];
@@ -2559,19 +6358,11 @@ extern "C" int NEXPLAYERUnity_GetAudioStreamID(int index) {
 }
 extern "C" char* NEXPLAYERUnity_GetAudioStreamName(int index) {
     [_GetPlayer() Log:4 toValue:@"iOS - NEXPLAYERUnity_GetAudioStreamName \n"];
-    NSString *temp = [_GetPlayer() getAudioStreamName:index];
-    const char* string = [temp UTF8String];
-    char* result = strdup(string);
-
-    return result;
+    return NexCatalogStringCopy(0, NEXUNITY_STREAM_AUDIO, index, false);
 }
 extern "C" char* NEXPLAYERUnity_GetAudioStreamLanguage(int index) {
     [_GetPlayer() Log:4 toValue:@"iOS - NEXPLAYERUnity_GetAudioStreamLanguage \n"];
-    NSString *temp = [_GetPlayer() getAudioStreamLanguage:index];
-    const char* string = [temp UTF8String];
-    char* result = strdup(string);
-
-    return result;
+    return NexCatalogStringCopy(0, NEXUNITY_STREAM_AUDIO, index, true);
 }
 
 extern "C" void NEXPLAYERUnity_SetCaptionStream(int ID) {
@@ -2589,23 +6380,64 @@ extern "C" int NEXPLAYERUnity_GetCaptionStreamID(int index) {
 }
 extern "C" char* NEXPLAYERUnity_GetCaptionStreamName(int index) {
     [_GetPlayer() Log:4 toValue:@"iOS - NEXPLAYERUnity_GetCaptionStreamName \n"];
-    NSString *temp = [_GetPlayer() getCaptionStreamName:index];
-    const char* string = [temp UTF8String];
-    char* result = strdup(string);
-
-    return result;
+    return NexCatalogStringCopy(0, NEXUNITY_STREAM_TEXT, index, false);
 }
 extern "C" char* NEXPLAYERUnity_GetCaptionStreamLanguage(int index) {
     [_GetPlayer() Log:4 toValue:@"iOS - NEXPLAYERUnity_GetCaptionStreamLanguage \n"];
-    NSString *temp = [_GetPlayer() getCaptionStreamLanguage:index];
-    const char* string = [temp UTF8String];
-    char* result = strdup(string);
-
-    return result;
+    return NexCatalogStringCopy(0, NEXUNITY_STREAM_TEXT, index, true);
 }
 //END NEW MARTIN 21-10-2019
 
+// Catalog lookups for any instance. Records are copied out; strings are returned in place.
+// Their storage is never freed, but the text is rewritten once the NEXUNITY_REGION_STRINGS
+// generation has advanced by more than one. Nothing here allocates.
+extern "C" void NexPlayerUnity_GetCatalogRange(int instance, int kind, int* start, int* count) {
+    *start = 0;
+    *count = 0;
+    if(instance < 0 || instance >= 8)
+        return;
+    std::lock_guard<std::mutex> lock(catalogLock);
+    const NexCatalogBuffer &catalog = NexActiveCatalog();
+    if(kind == NEXUNITY_STREAM_VIDEO_TRACK){
+        *start = catalog.trackStart[instance];
+        *count = catalog.trackCount[instance];
+    } else if(kind == NEXUNITY_STREAM_AUDIO || kind == NEXUNITY_STREAM_TEXT){
+        *start = catalog.streamStart[instance][kind];
+        *count = catalog.streamCount[instance][kind];
+    }
+}
+
+extern "C" bool NexPlayerUnity_GetStreamRecord(int instance, int kind, int index, NexStreamRecord* record) {
+    std::lock_guard<std::mutex> lock(catalogLock);
+    const NexStreamRecord *stream = NexCatalogStream(instance, kind, index);
+    if(stream == NULL || record == NULL)
+        return false;
+    *record = *stream;
+    return true;
+}
+
+extern "C" bool NexPlayerUnity_GetTrackRecord(int instance, int index, NexTrackRecord* record) {
+    if(instance < 0 || instance >= 8 || record == NULL)
+        return false;
+    std::lock_guard<std::mutex> lock(catalogLock);
+    const NexCatalogBuffer &catalog = NexActiveCatalog();
+    if(index < 0 || index >= catalog.trackCount[instance])
+        return false;
+    *record = catalog.tracks[catalog.trackStart[instance] + index];
+    return true;
+}
+
+extern "C" const char* NexPlayerUnity_GetStreamName(int instance, int kind, int index) {
+    std::lock_guard<std::mutex> lock(catalogLock);
+    const NexStreamRecord *stream = NexCatalogStream(instance, kind, index);
+    return stream != NULL ? NexCatalogString(stream->nameOffset) : "";
+}
 
+extern "C" const char* NexPlayerUnity_GetStreamLanguage(int instance, int kind, int index) {
+    std::lock_guard<std::mutex> lock(catalogLock);
+    const NexStreamRecord *stream = NexCatalogStream(instance, kind, index);
+    return stream != NULL ? NexCatalogString(stream->languageOffset) : "";
+}
 
 //Martin 05112019 - Offline DRM HLS/DASH playback
 
@@ -2672,6 +6504,18 @@ extern "C" void NexPlayerUnity_SetMultiProperty(int index, int property, int val
     [_GetPlayer() Log:4 toValue:@"iOS - NexPlayerUnity_SetMultiProperty \n"];
     [_GetPlayer() setMultiProperty:index toValue:property toValuez: value];
 }
+extern "C" int NexPlayerUnity_SetConfig(int index, const NexPlayerConfig* config)
+{
+    [_GetPlayer() Log:4 toValue:@"iOS - NexPlayerUnity_SetConfig \n"];
+    return [_GetPlayer() setConfig:index toValue:config];
+}
+extern "C" void NexPlayerUnity_GetConfigStats(int index, int* propertyCalls, int* propertySkipped)
+{
+    if(index < 0 || index >= 8)
+        return;
+    *propertyCalls = configPropertyCalls[index];
+    *propertySkipped = configPropertySkipped[index];
+}
 extern "C" void NexPlayerUnity_SetMultiHTTPHeader(int index, char* header)
 {
     [_GetPlayer() Log:4 toValue:@"iOS - NexPlayerUnity_SetMultiHTTPHeader \n"];
@@ -2706,6 +6550,111 @@ extern "C" NexPlayerTrack NEXPLAYERUnity_GetTrack(int index){
     return [_GetPlayer() getTrack:index];
 }
 
+//Trick play
+extern "C" int NEXPLAYERUnity_StartTrickPlay(int previewIndex, int playbackIndex, int speed){
+    [_GetPlayer() Log:4 toValue:@"iOS - NEXPLAYERUnity_StartTrickPlay \n"];
+    return [_GetPlayer() startTrickPlay:previewIndex toValue:playbackIndex speed:speed];
+}
+
+extern "C" void NEXPLAYERUnity_SetTrickPlaySpeed(int previewIndex, int speed){
+    [_GetPlayer() setTrickPlaySpeed:previewIndex toValue:speed];
+}
+
+extern "C" void NEXPLAYERUnity_ScrubTrickPlay(int previewIndex, int msec){
+    [_GetPlayer() scrubTrickPlay:previewIndex toValue:msec];
+}
+
+extern "C" int NEXPLAYERUnity_GetTrickPlayPosition(int previewIndex){
+    return [_GetPlayer() getTrickPlayPosition:previewIndex];
+}
+
+extern "C" int NEXPLAYERUnity_StopTrickPlay(int previewIndex, bool commit){
+    [_GetPlayer() Log:4 toValue:@"iOS - NEXPLAYERUnity_StopTrickPlay \n"];
+    return [_GetPlayer() stopTrickPlay:previewIndex commit:commit];
+}
+
+extern "C" void NEXPLAYERUnity_SetTrickPlayMaxFps(int fps){
+    if(fps > 0 && fps <= 30)
+        trickPlayMaxFps = fps;
+}
+//End trick play
+
+//Sync group
+extern "C" int NexPlayerUnity_SyncGroupOpen(int memberMask, bool autoStart){
+    [_GetPlayer() Log:4 toValue:@"iOS - NexPlayerUnity_SyncGroupOpen \n"];
+    return [_GetPlayer() openSyncGroup:memberMask autoStart:autoStart];
+}
+
+extern "C" void NexPlayerUnity_SyncGroupClose(){
+    [_GetPlayer() Log:4 toValue:@"iOS - NexPlayerUnity_SyncGroupClose \n"];
+    [_GetPlayer() closeSyncGroup];
+}
+
+extern "C" void NexPlayerUnity_SyncGroupPause(){
+    [_GetPlayer() pauseSyncGroup];
+}
+
+extern "C" void NexPlayerUnity_SyncGroupResume(){
+    [_GetPlayer() resumeSyncGroup];
+}
+
+extern "C" void NexPlayerUnity_SyncGroupSeek(int msec){
+    [_GetPlayer() seekSyncGroup:msec];
+}
+
+extern "C" float NexPlayerUnity_SyncGroupGetDrift(int index){
+    return [_GetPlayer() getSyncGroupDrift:index];
+}
+
+extern "C" void NexPlayerUnity_SyncGroupSetThresholds(int nudgeMs, int seekMs, float maxNudge){
+    std::lock_guard<std::mutex> lock(syncGroupLock);
+    if(nudgeMs > 0)
+        syncGroup.nudgeThresholdMs = nudgeMs;
+    if(seekMs > nudgeMs)
+        syncGroup.seekThresholdMs = seekMs;
+    if(maxNudge > 0 && maxNudge <= 0.25f)
+        syncGroup.maxRateNudge = maxNudge;
+}
+//End sync group
+
+//Live latency
+extern "C" void NexPlayerUnity_EnableLatencyControl(int index, bool enable, int targetMs){
+    [_GetPlayer() Log:4 toValue:@"iOS - NexPlayerUnity_EnableLatencyControl \n"];
+    [_GetPlayer() enableLatencyControl:index enable:enable target:targetMs];
+}
+
+extern "C" void NexPlayerUnity_SetLatencyControlBand(float minRate, float maxRate, int deadbandMs, int jumpThresholdMs){
+    std::lock_guard<std::mutex> lock(latencyLock);
+    if(minRate > 0.5f && minRate <= 1.0f)
+        latencyMinRate = minRate;
+    if(maxRate >= 1.0f && maxRate < 2.0f)
+        latencyMaxRate = maxRate;
+    if(deadbandMs >= 0)
+        latencyDeadbandMs = deadbandMs;
+    if(jumpThresholdMs > deadbandMs)
+        latencyJumpThresholdMs = jumpThresholdMs;
+}
+
+extern "C" int NexPlayerUnity_GetLatency(int index){
+    return [_GetPlayer() getLatency:index];
+}
+
+extern "C" int NexPlayerUnity_GetLatencyPercentile(int index, int percentile){
+    return [_GetPlayer() getLatencyPercentile:index percentile:percentile];
+}
+
+extern "C" int NexPlayerUnity_GetLatencyJumpCount(int index){
+    if(index < 0 || index >= 8)
+        return 0;
+    std::lock_guard<std::mutex> lock(latencyLock);
+    return latencyControl[index].jumps;
+}
+
+extern "C" void NexPlayerUnity_ResetLatencyStats(int index){
+    [_GetPlayer() resetLatencyStats:index];
+}
+//End live latency
+
 extern "C" void NexPlayerUnity_ReleasePlayer() {
     [_GetPlayer() nxRelease];
 }
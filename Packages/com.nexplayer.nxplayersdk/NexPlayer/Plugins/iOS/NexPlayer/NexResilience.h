@@ -0,0 +1,140 @@
+//
+//  NexResilience.h
+//  Unity-iPhone
+//
+//  Retry policy for an instance's network errors: per-segment and per-session budgets and
+//  exponential backoff with jitter. Plain C++ on a caller-supplied clock; the bridge classifies
+//  NXError codes and schedules the retries.
+//
+
+#ifndef NexResilience_h
+#define NexResilience_h
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+#include <NexPlayer/NexPlayerEnum.h>
+#include <NexPlayer/NexPlayerTypes.h>
+
+#define RESILIENCE_SEGMENTS 64      // segment URLs counted at once
+#define RESILIENCE_FORWARD 0        // NexResilienceFailure: pass the error to the app
+#define RESILIENCE_RETRY 1          // retry after *delayMs
+#define RESILIENCE_ABSORBED 2       // nothing to do, a retry is already waiting or the SDK retries
+
+static const NexResiliencePolicy resilienceDefaults = { NEXPLAYER_RESILIENCE_VERSION, sizeof(NexResiliencePolicy), 3, 20, 500, 16000, 50, 0, 0 };
+
+typedef struct {
+    bool enabled;
+    NexResiliencePolicy policy;     // zero fields resolved to resilienceDefaults
+    int sessionRetries;
+    int attempt;                    // consecutive retries, reset once playback advances
+    bool scheduled;
+    int64_t failedUs;               // first error of the failure in progress, 0 when none
+    int64_t positionMs;             // where playback was at that error
+    int64_t recoveredTotalMs;
+    uint64_t random;                // xorshift state for the jitter
+    std::unordered_map<std::string, int> segmentErrors;
+    NexResilienceStats stats;
+} NexResilience;
+
+static inline void NexResetResilience(NexResilience &resilience, const NexResiliencePolicy *policy, uint64_t seed) {
+    resilience.policy = *policy;
+    int *fields[5] = { &resilience.policy.segmentRetries, &resilience.policy.sessionRetries, &resilience.policy.backoffBaseMs,
+                       &resilience.policy.backoffMaxMs, &resilience.policy.jitterPercent };
+    const int defaults[5] = { resilienceDefaults.segmentRetries, resilienceDefaults.sessionRetries, resilienceDefaults.backoffBaseMs,
+                              resilienceDefaults.backoffMaxMs, resilienceDefaults.jitterPercent };
+    for(int i = 0; i < 5; i++)
+        if(*fields[i] <= 0)
+            *fields[i] = defaults[i];
+    resilience.policy.jitterPercent = std::min(resilience.policy.jitterPercent, 100);
+    resilience.policy.backoffMaxMs = std::max(resilience.policy.backoffMaxMs, resilience.policy.backoffBaseMs);
+    resilience.sessionRetries = 0;
+    resilience.attempt = 0;
+    resilience.scheduled = false;
+    resilience.failedUs = 0;
+    resilience.recoveredTotalMs = 0;
+    resilience.random = seed | 1;
+    resilience.segmentErrors.clear();
+    resilience.stats = NexResilienceStats();
+    resilience.stats.sessionRetriesLeft = resilience.policy.sessionRetries;
+    resilience.stats.meanRecoveryMs = -1;
+}
+
+// backoffBaseMs doubled per consecutive retry up to backoffMaxMs, then moved by up to
+// jitterPercent either way so instances failing together do not retry together.
+static inline int NexBackoffMs(NexResilience &resilience) {
+    const NexResiliencePolicy &policy = resilience.policy;
+    int64_t delayMs = std::min<int64_t>((int64_t)policy.backoffBaseMs << std::min(resilience.attempt, 20), policy.backoffMaxMs);
+    uint64_t x = resilience.random;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    resilience.random = x;
+    double spread = (double)(x >> 11) / (double)(1ULL << 53) * 2.0 - 1.0;
+    return (int)std::max<int64_t>(0, delayMs + (int64_t)(delayMs * policy.jitterPercent / 100 * spread));
+}
+
+// An error of the instance, of class errorClass (NexPlayerERROR_CLASS); returns RESILIENCE_FORWARD, RESILIENCE_RETRY with *delayMs, or RESILIENCE_ABSORBED.
+static inline int NexResilienceFailure(NexResilience &resilience, uint32_t code, int errorClass, int64_t positionMs, int64_t nowUs, int *delayMs) {
+    NexResilienceStats &stats = resilience.stats;
+    stats.lastError = (int32_t)code;
+    if(errorClass == NEXUNITY_ERROR_FATAL){
+        stats.fatalErrors++;
+        return RESILIENCE_FORWARD;
+    }
+    stats.retryableErrors++;
+    if(resilience.scheduled)
+        return RESILIENCE_ABSORBED;
+    if(resilience.sessionRetries >= resilience.policy.sessionRetries){
+        stats.forwarded++;
+        return RESILIENCE_FORWARD;
+    }
+    if(resilience.failedUs == 0){
+        resilience.failedUs = nowUs;
+        resilience.positionMs = positionMs;
+    }
+    *delayMs = NexBackoffMs(resilience);
+    resilience.attempt++;
+    resilience.sessionRetries++;
+    resilience.scheduled = true;
+    stats.sessionRetriesLeft = resilience.policy.sessionRetries - resilience.sessionRetries;
+    return RESILIENCE_RETRY;
+}
+
+// An HTTP error of one request. The SDK retries a segment itself; only one failing more than
+// segmentRetries times becomes a failure of the instance.
+static inline int NexResilienceSegmentFailure(NexResilience &resilience, const std::string &url, uint32_t code, int errorClass,
+                                              int64_t positionMs, int64_t nowUs, int *delayMs) {
+    if(errorClass == NEXUNITY_ERROR_FATAL)
+        return RESILIENCE_ABSORBED;
+    if(resilience.segmentErrors.size() >= RESILIENCE_SEGMENTS)
+        resilience.segmentErrors.clear();
+    int &errors = resilience.segmentErrors[url];
+    if(++errors <= resilience.policy.segmentRetries)
+        return RESILIENCE_ABSORBED;
+    resilience.segmentErrors.erase(url);
+    int decision = NexResilienceFailure(resilience, code, errorClass, positionMs, nowUs, delayMs);
+    // No error was raised for it; if the budget is spent the SDK's own error reaches the app.
+    return decision == RESILIENCE_FORWARD ? RESILIENCE_ABSORBED : decision;
+}
+
+// Playback advanced; ends the failure in progress. Returns its length in ms, or -1.
+static inline int64_t NexResilienceProgress(NexResilience &resilience, int64_t nowUs) {
+    if(resilience.failedUs == 0 || resilience.scheduled)
+        return -1;
+    NexResilienceStats &stats = resilience.stats;
+    int64_t recoveryMs = (nowUs - resilience.failedUs) / 1000;
+    resilience.failedUs = 0;
+    resilience.attempt = 0;
+    stats.recoveries++;
+    resilience.recoveredTotalMs += recoveryMs;
+    stats.meanRecoveryMs = (int32_t)(resilience.recoveredTotalMs / stats.recoveries);
+    stats.lastRecoveryMs = (int32_t)recoveryMs;
+    stats.maxRecoveryMs = std::max(stats.maxRecoveryMs, stats.lastRecoveryMs);
+    return recoveryMs;
+}
+
+#endif /* NexResilience_h */
@@ -0,0 +1,364 @@
+//
+//  NexSubtitleParser.h
+//  Unity-iPhone
+//
+//  Native WebVTT/SRT/TTML parser behind the bridge's external subtitles. Plain C++; the format
+//  constants come from NexPlayerEnum.h.
+//
+
+#ifndef NexSubtitleParser_h
+#define NexSubtitleParser_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <NexPlayer/NexPlayerEnum.h>
+
+#include "NexPlayerCore.h"
+#include "NexTextScan.h"
+
+// WebVTT, SRT and TTML/IMSC1 (text profile) files are parsed natively into one arena per track:
+// cue text back to back in a single buffer, cues sorted by start, and an implicit interval tree
+// (maxEnd of each balanced subtree) so the cues active at a PTS come back in O(log n + k),
+// overlapping cues included. The playhead then drives rendering without the SDK.
+typedef struct {
+    int64_t startMs;
+    int64_t endMs;
+    uint32_t textOffset;
+    uint32_t textLength;
+} NexSubtitleCue;
+
+class NexSubtitleTrack {
+public:
+    int format;                     // NexPlayerSUBTITLE_FORMAT
+    std::vector<NexSubtitleCue> cues;
+    std::vector<int64_t> maxEnd;    // per cue: latest end in the subtree rooted at it
+    std::vector<char> text;
+    int64_t parseUs;
+
+    NexSubtitleTrack() : format(0), parseUs(0) {}
+
+    bool parse(const char *data, size_t size);
+
+    // Indices of cues active at ptsMs, in start order.
+    void query(int64_t ptsMs, std::vector<uint32_t> &active) const {
+        active.clear();
+        query(ptsMs, 0, cues.size(), active);
+    }
+
+private:
+    void addCue(int64_t startMs, int64_t endMs, const std::string &cueText) {
+        if(endMs <= startMs || cueText.empty())
+            return;
+        NexSubtitleCue cue = { startMs, endMs, (uint32_t)text.size(), (uint32_t)cueText.size() };
+        text.insert(text.end(), cueText.begin(), cueText.end());
+        cues.push_back(cue);
+    }
+
+    int64_t buildIndex(size_t lo, size_t hi) {
+        if(lo >= hi)
+            return INT64_MIN;
+        size_t mid = lo + (hi - lo) / 2;
+        int64_t end = std::max(cues[mid].endMs, std::max(buildIndex(lo, mid), buildIndex(mid + 1, hi)));
+        maxEnd[mid] = end;
+        return end;
+    }
+
+    void query(int64_t ptsMs, size_t lo, size_t hi, std::vector<uint32_t> &active) const {
+        while(lo < hi){
+            size_t mid = lo + (hi - lo) / 2;
+            if(maxEnd[mid] <= ptsMs)
+                return;
+            query(ptsMs, lo, mid, active);
+            if(cues[mid].startMs > ptsMs)
+                return;
+            if(ptsMs < cues[mid].endMs)
+                active.push_back((uint32_t)mid);
+            lo = mid + 1;
+        }
+    }
+
+    bool parseCueBlocks(const char *p, const char *end, bool webvtt);
+    bool parseTTML(const char *p, const char *end);
+};
+
+// [HH:]MM:SS(.|,)mmm; advances p past the timestamp.
+static inline bool NexParseCueTime(const char *&p, const char *end, int64_t &ms) {
+    int64_t fields[3] = { 0, 0, 0 };
+    int count = 0;
+    while(count < 3){
+        if(p >= end || *p < '0' || *p > '9')
+            return false;
+        int64_t value = 0;
+        while(p < end && *p >= '0' && *p <= '9')
+            value = value * 10 + (*p++ - '0');
+        fields[count++] = value;
+        if(p < end && *p == ':')
+            p++;
+        else
+            break;
+    }
+    if(count < 2)
+        return false;
+    int64_t fraction = 0;
+    if(p < end && (*p == '.' || *p == ',')){
+        p++;
+        int digits = 0;
+        while(p < end && *p >= '0' && *p <= '9'){
+            if(digits++ < 3)
+                fraction = fraction * 10 + (*p - '0');
+            p++;
+        }
+        for(; digits < 3; digits++)
+            fraction *= 10;
+    }
+    int64_t seconds = count == 3 ? fields[0] * 3600 + fields[1] * 60 + fields[2] : fields[0] * 60 + fields[1];
+    ms = seconds * 1000 + fraction;
+    return true;
+}
+
+// "start --> end" timing line; WebVTT cue settings after the end time are ignored.
+static inline bool NexParseTimingLine(const char *p, const char *lineEnd, int64_t &startMs, int64_t &endMs) {
+    while(p < lineEnd && (*p == ' ' || *p == '\t'))
+        p++;
+    if(!NexParseCueTime(p, lineEnd, startMs))
+        return false;
+    while(p < lineEnd && (*p == ' ' || *p == '\t'))
+        p++;
+    if(lineEnd - p < 3 || p[0] != '-' || p[1] != '-' || p[2] != '>')
+        return false;
+    p += 3;
+    while(p < lineEnd && (*p == ' ' || *p == '\t'))
+        p++;
+    return NexParseCueTime(p, lineEnd, endMs);
+}
+
+// WebVTT cue text without voice (<v Name>), class (<c.name>), language and timestamp tags,
+// which carry no text of their own; <b>, <i>, <u> and <ruby> are kept for the renderer.
+static inline void NexAppendVttText(std::string &out, const char *p, const char *end) {
+    while(p < end){
+        const char *tag = (const char *)memchr(p, '<', end - p);
+        if(tag == NULL)
+            tag = end;
+        out.append(p, tag - p);
+        if(tag == end)
+            return;
+        const char *tagEnd = (const char *)memchr(tag, '>', end - tag);
+        if(tagEnd == NULL){
+            out.append(tag, end - tag);
+            return;
+        }
+        const char *name = tag + 1 < tagEnd && tag[1] == '/' ? tag + 2 : tag + 1;
+        const char *nameEnd = name;
+        while(nameEnd < tagEnd && *nameEnd != '.' && *nameEnd != ' ' && *nameEnd != '\t')
+            nameEnd++;
+        size_t length = nameEnd - name;
+        bool drop = (length == 1 && (*name == 'v' || *name == 'c')) || (length == 4 && strncmp(name, "lang", 4) == 0)
+                    || (length > 0 && *name >= '0' && *name <= '9');
+        if(!drop)
+            out.append(tag, tagEnd + 1 - tag);
+        p = tagEnd + 1;
+    }
+}
+
+// SRT and WebVTT share the block layout: optional identifier, timing line, text up to a blank line.
+inline bool NexSubtitleTrack::parseCueBlocks(const char *p, const char *end, bool webvtt) {
+    std::string cueText;
+    if(webvtt)
+        p = NexNextLine(p, end);    // WEBVTT header line
+    while(p < end){
+        const char *lineEnd = NexLineEnd(p, end);
+        if(NexBlankLine(p, lineEnd)){
+            p = NexNextLine(p, end);
+            continue;
+        }
+        // Block start: the timing line is this one or, after an identifier, the next.
+        int64_t startMs, endMs;
+        bool timed = NexParseTimingLine(p, lineEnd, startMs, endMs);
+        if(!timed){
+            const char *next = NexNextLine(p, end);
+            const char *nextEnd = NexLineEnd(next, end);
+            timed = next < end && NexParseTimingLine(next, nextEnd, startMs, endMs);
+            if(timed){
+                p = next;
+                lineEnd = nextEnd;
+            }
+        }
+        p = NexNextLine(p, end);
+        // Text lines; for untimed blocks (WebVTT NOTE/STYLE/REGION, SRT junk) they are skipped.
+        cueText.clear();
+        while(p < end){
+            lineEnd = NexLineEnd(p, end);
+            if(NexBlankLine(p, lineEnd))
+                break;
+            if(timed){
+                if(!cueText.empty())
+                    cueText.push_back('\n');
+                if(webvtt)
+                    NexAppendVttText(cueText, p, lineEnd);
+                else
+                    cueText.append(p, lineEnd - p);
+            }
+            p = NexNextLine(p, end);
+        }
+        if(timed)
+            addCue(startMs, endMs, cueText);
+    }
+    return !cues.empty();
+}
+
+// TTML time expression: clock time (HH:MM:SS[.fff] or HH:MM:SS:FF) or offset time (12.5s, 300ms, 2m, 1h, 90f, 4000t).
+static inline bool NexParseTTMLTime(const std::string &value, double frameRate, double tickRate, int64_t &ms) {
+    const char *p = value.c_str();
+    if(strchr(p, ':') != NULL){
+        int hours = 0, minutes = 0, frames = 0;
+        double seconds = 0;
+        int fields = sscanf(p, "%d:%d:%lf:%d", &hours, &minutes, &seconds, &frames);
+        if(fields < 3)
+            return false;
+        ms = (int64_t)((hours * 3600 + minutes * 60 + seconds) * 1000.0 + 0.5);
+        if(fields == 4)
+            ms += (int64_t)(frames * 1000.0 / frameRate);
+        return true;
+    }
+    char *unit;
+    double number = strtod(p, &unit);
+    if(unit == p)
+        return false;
+    double scale;
+    if(strcmp(unit, "h") == 0)
+        scale = 3600000.0;
+    else if(strcmp(unit, "m") == 0)
+        scale = 60000.0;
+    else if(strcmp(unit, "s") == 0 || *unit == 0)
+        scale = 1000.0;
+    else if(strcmp(unit, "ms") == 0)
+        scale = 1.0;
+    else if(strcmp(unit, "f") == 0)
+        scale = 1000.0 / frameRate;
+    else if(strcmp(unit, "t") == 0)
+        scale = 1000.0 / tickRate;
+    else
+        return false;
+    ms = (int64_t)(number * scale + 0.5);
+    return true;
+}
+
+// Timed <p> elements of the body; begin/end/dur on the <p> itself, timing inherited from
+// <div>/<body> is not applied. Spans and styling are flattened to text; <br/> is a line break.
+inline bool NexSubtitleTrack::parseTTML(const char *p, const char *end) {
+    double frameRate = 30.0, tickRate = 1.0;
+    std::string value, cueText;
+    const char *tt = p;
+    while((tt = (const char *)memchr(tt, '<', end - tt)) != NULL && !NexIsTag(tt + 1, end, "tt"))
+        tt++;
+    if(tt != NULL){
+        const char *ttEnd = (const char *)memchr(tt, '>', end - tt);
+        if(ttEnd != NULL){
+            // Without ttp:tickRate the tick is one frame when ttp:frameRate is given, else one second.
+            bool hasFrameRate = NexXmlAttribute(tt, ttEnd, "ttp:frameRate", value);
+            if(hasFrameRate)
+                frameRate = std::max(1.0, atof(value.c_str()));
+            if(NexXmlAttribute(tt, ttEnd, "ttp:tickRate", value))
+                tickRate = std::max(1.0, atof(value.c_str()));
+            else if(hasFrameRate)
+                tickRate = frameRate;
+        }
+    }
+    while(p < end){
+        const char *tag = (const char *)memchr(p, '<', end - p);
+        if(tag == NULL)
+            break;
+        const char *tagEnd = (const char *)memchr(tag, '>', end - tag);
+        if(tagEnd == NULL)
+            break;
+        p = tagEnd + 1;
+        if(!NexIsTag(tag + 1, tagEnd, "p"))
+            continue;
+        int64_t startMs = -1, endMs = -1, durMs;
+        if(NexXmlAttribute(tag, tagEnd, "begin", value))
+            NexParseTTMLTime(value, frameRate, tickRate, startMs);
+        if(NexXmlAttribute(tag, tagEnd, "end", value))
+            NexParseTTMLTime(value, frameRate, tickRate, endMs);
+        else if(startMs >= 0 && NexXmlAttribute(tag, tagEnd, "dur", value) && NexParseTTMLTime(value, frameRate, tickRate, durMs))
+            endMs = startMs + durMs;
+        if(tagEnd[-1] == '/')
+            continue;
+
+        // Content up to the matching </p>; nested <p> is not allowed in TTML.
+        cueText.clear();
+        while(p < end){
+            const char *next = (const char *)memchr(p, '<', end - p);
+            if(next == NULL)
+                next = end;
+            NexAppendXmlText(cueText, p, next);
+            if(next == end){
+                p = end;
+                break;
+            }
+            const char *innerEnd = (const char *)memchr(next, '>', end - next);
+            if(innerEnd == NULL){
+                p = end;
+                break;
+            }
+            p = innerEnd + 1;
+            if(next[1] == '/' && NexIsTag(next + 2, innerEnd, "p"))
+                break;
+            if(NexIsTag(next + 1, innerEnd, "br")){
+                while(!cueText.empty() && cueText.back() == ' ')
+                    cueText.pop_back();
+                cueText.push_back('\n');
+            }
+        }
+        while(!cueText.empty() && (cueText.back() == ' ' || cueText.back() == '\n'))
+            cueText.pop_back();
+        size_t first = cueText.find_first_not_of(" \n");
+        if(first != std::string::npos && first > 0)
+            cueText.erase(0, first);
+        if(startMs >= 0 && endMs > startMs)
+            addCue(startMs, endMs, cueText);
+    }
+    return !cues.empty();
+}
+
+inline bool NexSubtitleTrack::parse(const char *data, size_t size) {
+    int64_t startUs = NexMonotonicUs();
+    cues.clear();
+    text.clear();
+    const char *p = data, *end = data + size;
+    if(size >= 3 && (uint8_t)p[0] == 0xEF && (uint8_t)p[1] == 0xBB && (uint8_t)p[2] == 0xBF)
+        p += 3;
+    const char *first = p;
+    while(first < end && (*first == ' ' || *first == '\t' || *first == '\r' || *first == '\n'))
+        first++;
+
+    bool parsed;
+    if(end - first >= 6 && strncmp(first, "WEBVTT", 6) == 0){
+        format = NEXUNITY_SUBTITLE_WEBVTT;
+        parsed = parseCueBlocks(first, end, true);
+    } else if(*first == '<'){
+        format = NEXUNITY_SUBTITLE_TTML;
+        parsed = parseTTML(first, end);
+    } else {
+        format = NEXUNITY_SUBTITLE_SRT;
+        parsed = parseCueBlocks(first, end, false);
+    }
+    if(!parsed)
+        return false;
+
+    // Files are nearly always in order already; the sort is then a linear pass.
+    if(!std::is_sorted(cues.begin(), cues.end(), [](const NexSubtitleCue &a, const NexSubtitleCue &b) { return a.startMs < b.startMs; }))
+        std::stable_sort(cues.begin(), cues.end(), [](const NexSubtitleCue &a, const NexSubtitleCue &b) { return a.startMs < b.startMs; });
+    maxEnd.resize(cues.size());
+    buildIndex(0, cues.size());
+    parseUs = NexMonotonicUs() - startUs;
+    return true;
+}
+
+#endif /* NexSubtitleParser_h */
@@ -0,0 +1,127 @@
+//
+//  NexTextScan.h
+//  Unity-iPhone
+//
+//  Line and XML scanning shared by the subtitle and manifest parsers. Plain C++, no SDK types.
+//
+
+#ifndef NexTextScan_h
+#define NexTextScan_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+static inline const char *NexLineEnd(const char *p, const char *end) {
+    while(p < end && *p != '\n' && *p != '\r')
+        p++;
+    return p;
+}
+
+static inline const char *NexNextLine(const char *p, const char *end) {
+    p = NexLineEnd(p, end);
+    if(p < end && *p == '\r')
+        p++;
+    if(p < end && *p == '\n')
+        p++;
+    return p;
+}
+
+static inline bool NexBlankLine(const char *p, const char *lineEnd) {
+    for(; p < lineEnd; p++)
+        if(*p != ' ' && *p != '\t')
+            return false;
+    return true;
+}
+
+static inline bool NexXmlAttribute(const char *tag, const char *tagEnd, const char *name, std::string &value) {
+    size_t nameLength = strlen(name);
+    for(const char *p = tag + 1; p + nameLength + 2 <= tagEnd; p++){
+        if((p[-1] != ' ' && p[-1] != '\t' && p[-1] != '\n' && p[-1] != '\r') || strncmp(p, name, nameLength) != 0)
+            continue;
+        const char *q = p + nameLength;
+        while(q < tagEnd && (*q == ' ' || *q == '\t'))
+            q++;
+        if(q >= tagEnd || *q != '=')
+            continue;
+        q++;
+        while(q < tagEnd && (*q == ' ' || *q == '\t'))
+            q++;
+        if(q >= tagEnd || (*q != '"' && *q != '\''))
+            continue;
+        char quote = *q++;
+        const char *valueEnd = (const char *)memchr(q, quote, tagEnd - q);
+        if(valueEnd == NULL)
+            return false;
+        value.assign(q, valueEnd - q);
+        return true;
+    }
+    return false;
+}
+
+static inline void NexAppendXmlText(std::string &out, const char *p, const char *end) {
+    while(p < end){
+        if(*p == '\r' || *p == '\n' || *p == '\t'){
+            // XML whitespace collapses; explicit line breaks come from <br/>.
+            if(!out.empty() && out.back() != ' ' && out.back() != '\n')
+                out.push_back(' ');
+            p++;
+            continue;
+        }
+        if(*p != '&'){
+            if(*p != ' ' || (!out.empty() && out.back() != ' ' && out.back() != '\n'))
+                out.push_back(*p);
+            p++;
+            continue;
+        }
+        const char *semicolon = (const char *)memchr(p, ';', std::min<size_t>(end - p, 10));
+        if(semicolon == NULL){
+            out.push_back(*p++);
+            continue;
+        }
+        std::string entity(p + 1, semicolon - p - 1);
+        uint32_t code = 0;
+        if(entity == "amp") code = '&';
+        else if(entity == "lt") code = '<';
+        else if(entity == "gt") code = '>';
+        else if(entity == "quot") code = '"';
+        else if(entity == "apos") code = '\'';
+        else if(entity.size() > 1 && entity[0] == '#')
+            code = (uint32_t)(entity[1] == 'x' ? strtoul(entity.c_str() + 2, NULL, 16) : strtoul(entity.c_str() + 1, NULL, 10));
+        if(code == 0 || code > 0x10FFFF){
+            out.append(p, semicolon + 1 - p);
+        } else if(code < 0x80){
+            out.push_back((char)code);
+        } else if(code < 0x800){
+            out.push_back((char)(0xC0 | (code >> 6)));
+            out.push_back((char)(0x80 | (code & 0x3F)));
+        } else if(code < 0x10000){
+            out.push_back((char)(0xE0 | (code >> 12)));
+            out.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back((char)(0x80 | (code & 0x3F)));
+        } else {
+            out.push_back((char)(0xF0 | (code >> 18)));
+            out.push_back((char)(0x80 | ((code >> 12) & 0x3F)));
+            out.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back((char)(0x80 | (code & 0x3F)));
+        }
+        p = semicolon + 1;
+    }
+}
+
+static inline bool NexIsTag(const char *p, const char *end, const char *name) {
+    // Matches <name, <tt:name and other prefixed forms, followed by whitespace, '>' or '/'.
+    const char *colon = (const char *)memchr(p, ':', std::min<size_t>(end - p, 16));
+    const char *space = p;
+    while(space < end && *space != ' ' && *space != '>' && *space != '/' && *space != '\n' && *space != '\t' && *space != '\r')
+        space++;
+    if(colon != NULL && colon < space)
+        p = colon + 1;
+    size_t length = strlen(name);
+    return (size_t)(space - p) == length && strncmp(p, name, length) == 0;
+}
+
+#endif /* NexTextScan_h */
@@ -0,0 +1,259 @@
+// NexCdnSteering: requests moved off a failing location, its hold-off and probe, failback once it
+// recovers, and the choice of the healthiest location by error rate and throughput; on a simulated
+// clock, and in real time against stand-in CDNs.
+
+#include <thread>
+
+#include "NexCdnSteering.h"
+#include "NexHttpStandIn.h"
+#include "NexTest.h"
+
+namespace {
+
+const int64_t kSecondUs = 1000000;
+
+struct Steering {
+    NexCdnSteering steering;
+    int64_t nowUs = 1000 * kSecondUs;
+
+    Steering() {
+        steering.setLocations({ "http://a.example.com/vod/", "http://b.example.net/cache/vod/" }, true);
+    }
+
+    // Hands a request for a segment on location a to the steering, as onModifyHttpRequest does,
+    // and returns the schemeless URL it went to.
+    std::string request(int segment) {
+        std::string path = "/vod/seg" + std::to_string(segment) + ".m4s";
+        std::string request = "GET " + path + " HTTP/1.1\r\nHost: a.example.com\r\nRange: bytes=0-\r\n\r\n";
+        steering.rewrite(request, nowUs);
+        size_t host = request.find("Host: ") + 6;
+        return request.substr(host, request.find("\r\n", host) - host) + request.substr(4, request.find(' ', 4) - 4);
+    }
+
+    // One transfer of `url` taking `elapsedUs`, successful or not.
+    void transfer(const std::string &url, bool ok, int64_t bytes = 1000000, int64_t elapsedUs = 100000) {
+        steering.started(url, nowUs);
+        nowUs += elapsedUs;
+        if(ok)
+            steering.finished(url, bytes, nowUs);
+        else
+            steering.failed(url, nowUs);
+    }
+
+    int state(int location) const {
+        return steering.state(steering.locations[location], nowUs);
+    }
+};
+
+}
+
+NEX_TEST(RewritesRequestsOnlyWhenTheNamedLocationIsUnhealthy) {
+    Steering s;
+    NEX_CHECK(s.steering.configured);
+    NEX_CHECK_STR(s.request(1), "a.example.com/vod/seg1.m4s");
+    NEX_CHECK_EQ(s.steering.current, 0);
+
+    std::string absolute = "GET http://a.example.com/vod/seg2.m4s HTTP/1.1\r\nHost: a.example.com\r\n\r\n";
+    s.steering.locations[0].holdUntilUs = s.nowUs + kSecondUs;
+    NEX_CHECK(s.steering.rewrite(absolute, s.nowUs));
+    NEX_CHECK_STR(absolute, "GET http://b.example.net/cache/vod/seg2.m4s HTTP/1.1\r\nHost: b.example.net\r\n\r\n");
+    NEX_CHECK_EQ(s.steering.locations[1].steeredTo, 1);
+
+    // Neither a location of the set nor a request line it understands.
+    std::string other = "GET /live/x.m4s HTTP/1.1\r\nHost: c.example.org\r\n\r\n";
+    NEX_CHECK(!s.steering.rewrite(other, s.nowUs));
+    std::string broken = "GET\r\n\r\n";
+    NEX_CHECK(!s.steering.rewrite(broken, s.nowUs));
+}
+
+NEX_TEST(HoldOffProbeAndFailback) {
+    Steering s;
+    s.transfer(s.request(1), true);
+    // One failure is not enough to leave a location; a second in a row holds it off.
+    s.transfer(s.request(2), false);
+    NEX_CHECK_EQ(s.state(0), NEXUNITY_CDN_HEALTHY);
+    NEX_CHECK_EQ(s.steering.locations[0].consecutiveErrors, 1);
+    NEX_CHECK_STR(s.request(3), "a.example.com/vod/seg3.m4s");
+    s.transfer("a.example.com/vod/seg3.m4s", false);
+    NEX_CHECK_EQ(s.state(0), NEXUNITY_CDN_HELD);
+    int64_t heldUntilUs = s.steering.locations[0].holdUntilUs;
+    NEX_CHECK_EQ(heldUntilUs - s.nowUs, CDN_HOLD_MIN_US);
+
+    // Held: everything goes to b, and b's transfers count for b.
+    for(int i = 4; i < 10; i++){
+        std::string url = s.request(i);
+        NEX_CHECK_STR(url, "b.example.net/cache/vod/seg" + std::to_string(i) + ".m4s");
+        s.transfer(url, true);
+    }
+    NEX_CHECK_EQ(s.steering.locations[1].requests, 6);
+    NEX_CHECK_EQ(s.steering.locations[0].requests, 3);
+
+    // Out of the hold-off: one probe goes to a, the requests beside it stay on b.
+    s.nowUs = heldUntilUs;
+    NEX_CHECK_EQ(s.state(0), NEXUNITY_CDN_PROBING);
+    NEX_CHECK_STR(s.request(10), "a.example.com/vod/seg10.m4s");
+    NEX_CHECK(s.steering.locations[0].probing);
+    NEX_CHECK_STR(s.request(11), "b.example.net/cache/vod/seg11.m4s");
+    // The probe fails: the hold-off doubles.
+    s.transfer("a.example.com/vod/seg10.m4s", false);
+    NEX_CHECK_EQ(s.steering.locations[0].holdUntilUs - s.nowUs, 2 * CDN_HOLD_MIN_US);
+    NEX_CHECK_STR(s.request(12), "b.example.net/cache/vod/seg12.m4s");
+
+    // It recovers: the next probe succeeds and traffic fails back.
+    s.nowUs = s.steering.locations[0].holdUntilUs;
+    std::string probe = s.request(13);
+    NEX_CHECK_STR(probe, "a.example.com/vod/seg13.m4s");
+    s.transfer(probe, true);
+    NEX_CHECK_EQ(s.state(0), NEXUNITY_CDN_HEALTHY);
+    NEX_CHECK(s.steering.locations[0].errorRate == 0);
+    NEX_CHECK_EQ(s.steering.locations[0].holdUs, CDN_HOLD_MIN_US);
+    for(int i = 14; i < 18; i++)
+        NEX_CHECK_STR(s.request(i), "a.example.com/vod/seg" + std::to_string(i) + ".m4s");
+}
+
+NEX_TEST(ProbeWithoutAnswerIsGivenUp) {
+    Steering s;
+    s.transfer(s.request(1), false);
+    s.transfer(s.request(2), false);
+    s.nowUs = s.steering.locations[0].holdUntilUs;
+    NEX_CHECK_STR(s.request(3), "a.example.com/vod/seg3.m4s");
+    // The player never reports seg3; a new probe goes out once CDN_HOLD_MIN_US has passed.
+    s.nowUs += CDN_HOLD_MIN_US / 2;
+    NEX_CHECK_STR(s.request(4), "b.example.net/cache/vod/seg4.m4s");
+    s.nowUs += CDN_HOLD_MIN_US;
+    NEX_CHECK_STR(s.request(5), "a.example.com/vod/seg5.m4s");
+}
+
+NEX_TEST(PrefersTheHealthierLocationNotJustTheFirst) {
+    Steering s;
+    for(int i = 0; i < 4; i++)
+        s.transfer(s.request(i), true, 1000000, 100000);        // a: 10 MB/s
+    // Error rates: a is left only for one clearly better than a single failure's worth.
+    s.steering.locations[0].errorRate = 0.15;
+    NEX_CHECK_STR(s.request(4), "a.example.com/vod/seg4.m4s");
+    s.steering.locations[0].errorRate = 0.24;
+    NEX_CHECK_EQ(s.state(0), NEXUNITY_CDN_HEALTHY);
+    NEX_CHECK_STR(s.request(5), "b.example.net/cache/vod/seg5.m4s");
+    s.steering.locations[0].errorRate = 0;
+
+    // Same error rate: throughput decides, with a margin before leaving the preferred one.
+    NexCdnLocation &b = s.steering.locations[1];
+    b.samples = CDN_MIN_SAMPLES;
+    b.throughput = 11000000;                                    // b: 11 MB/s, within the margin
+    b.lastUs = s.nowUs;
+    NEX_CHECK_STR(s.request(6), "a.example.com/vod/seg6.m4s");
+    b.throughput = 16000000;                                    // b: 16 MB/s
+    NEX_CHECK_EQ(s.state(0), NEXUNITY_CDN_HEALTHY);
+    NEX_CHECK_STR(s.request(7), "b.example.net/cache/vod/seg7.m4s");
+
+    // Under half of the best it is degraded and only used when nothing else is left.
+    b.throughput = 25000000;
+    NEX_CHECK_EQ(s.state(0), NEXUNITY_CDN_DEGRADED);
+    NEX_CHECK_STR(s.request(8), "b.example.net/cache/vod/seg8.m4s");
+    b.holdUntilUs = s.nowUs + kSecondUs;
+    NEX_CHECK_STR(s.request(9), "a.example.com/vod/seg9.m4s");
+    b.holdUntilUs = 0;
+
+    // Once a has gone without traffic long enough, its figures no longer count and it is tried again.
+    b.throughput = 16000000;
+    NEX_CHECK_STR(s.request(10), "b.example.net/cache/vod/seg10.m4s");
+    s.nowUs += CDN_HOLD_MAX_US + 1;
+    b.lastUs = s.nowUs;
+    NEX_CHECK_STR(s.request(11), "a.example.com/vod/seg11.m4s");
+}
+
+NEX_TEST(FailsOverBetweenStandInsAndBack) {
+    // Three stand-ins for the same content: a drops every connection, b stalls every request, c
+    // serves. The loop plays segments the way the player does, through rewrite and the transfer
+    // callbacks, retrying a segment until it comes through. Bodies stay under CDN_MIN_SAMPLE_BYTES:
+    // throughput over loopback is noise, so only failures steer here.
+    NexHttpStandIn servers[3] = { NexHttpStandIn(11), NexHttpStandIn(12), NexHttpStandIn(13) };
+    for(NexHttpStandIn &server : servers){
+        NEX_CHECK(server.listening());
+        server.setBodyBytes(CDN_MIN_SAMPLE_BYTES / 4);
+    }
+    servers[0].setFaults(100, 0);
+    servers[1].setFaults(0, 100);
+    std::vector<std::string> urls;
+    for(NexHttpStandIn &server : servers)
+        urls.push_back("http://127.0.0.1:" + std::to_string(server.port()) + "/vod/");
+    NexCdnSteering steering;
+    steering.setLocations(urls, true);
+    NEX_CHECK_EQ(steering.locations.size(), 3);
+
+    const int timeoutMs = 150;
+    std::vector<int> played;                // location each segment came from
+    bool recovered = false, failedBack = false;
+    int afterFailback = 0;
+    int64_t deadlineUs = NexStandInNowUs() + 4 * CDN_HOLD_MIN_US;
+    for(int segment = 0; afterFailback < 5 && NexStandInNowUs() < deadlineUs; segment++){
+        while(NexStandInNowUs() < deadlineUs){
+            std::string request = NexStandInRequest(servers[0].port(), "/vod/seg" + std::to_string(segment) + ".m4s");
+            steering.rewrite(request, NexStandInNowUs());
+            size_t host = request.find("Host: ") + 6;
+            std::string url = request.substr(host, request.find("\r\n", host) - host) + request.substr(4, request.find(' ', 4) - 4);
+            int location = steering.locate(url);
+            steering.started(url, NexStandInNowUs());
+            NexHttpResponse response = NexHttpFetch(servers[location].port(), request, timeoutMs);
+            if(response.status != 200){
+                steering.failed(url, NexStandInNowUs());
+                continue;
+            }
+            steering.finished(url, (int64_t)response.bytes, NexStandInNowUs());
+            played.push_back(location);
+            break;
+        }
+        // Once c carries the traffic, a and b come back; a is the preferred location again as soon
+        // as its probe succeeds, b once its own probe does.
+        if(!recovered && played.back() == 2){
+            recovered = true;
+            servers[0].setFaults(0, 0);
+            servers[1].setFaults(0, 0);
+        }
+        if(played.back() == 0 && recovered)
+            failedBack = true;
+        if(failedBack && steering.state(steering.locations[1], NexStandInNowUs()) == NEXUNITY_CDN_HEALTHY && played.back() == 0)
+            afterFailback++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    NEX_CHECK(recovered);
+    NEX_CHECK(failedBack);
+    NEX_CHECK_EQ(afterFailback, 5);
+    // Two failures in a row put each faulty location on hold; nothing else was lost.
+    NEX_CHECK_EQ(servers[0].dropped.load(), CDN_FAILURES_TO_HOLD);
+    NEX_CHECK_EQ(servers[1].stalled.load(), CDN_FAILURES_TO_HOLD);
+    NEX_CHECK_EQ(steering.locations[0].failures, CDN_FAILURES_TO_HOLD);
+    NEX_CHECK_EQ(steering.locations[1].failures, CDN_FAILURES_TO_HOLD);
+    NEX_CHECK_EQ((int)played.size(), servers[0].served + servers[1].served + servers[2].served);
+    // c took over from the first segment and kept the traffic until a's probe, which came once
+    // a's hold-off was over.
+    NEX_CHECK_EQ(played.front(), 2);
+    NEX_CHECK(servers[2].served.load() > 10);
+    NEX_CHECK_EQ(steering.locations[0].holdUs, CDN_HOLD_MIN_US);
+    NEX_CHECK_EQ(steering.locations[1].holdUs, CDN_HOLD_MIN_US);
+    NEX_CHECK_EQ(steering.current, 0);
+}
+
+NEX_TEST(SingleLocationOrMixedSchemesDoNotSteer) {
+    NexCdnSteering steering;
+    steering.setLocations({ "http://a.example.com/vod/" }, true);
+    NEX_CHECK(steering.locations.empty());
+    steering.setLocations({ "https://a.example.com/vod/", "http://b.example.net/vod/" }, true);
+    steering.locations[0].holdUntilUs = INT64_MAX;
+    std::string request = "GET https://a.example.com/vod/seg1.m4s HTTP/1.1\r\nHost: a.example.com\r\n\r\n";
+    NEX_CHECK(!steering.rewrite(request, 0));
+}
+
+NEX_TEST(MpdBaseUrlsBeforeThePeriodAreLocations) {
+    std::string mpd = "<MPD>\n <BaseURL>https://a.example.com/vod/</BaseURL>\n <BaseURL serviceLocation=\"b\">https://b.example.net/vod/</BaseURL>\n"
+                      " <BaseURL>relative/</BaseURL>\n <Period>\n  <BaseURL>https://c.example.org/</BaseURL>\n </Period>\n</MPD>\n";
+    std::vector<std::string> urls = NexMpdLocations(mpd.data(), mpd.size());
+    NEX_CHECK_EQ(urls.size(), 2);
+    if(urls.size() == 2){
+        NEX_CHECK_STR(urls[0], "https://a.example.com/vod/");
+        NEX_CHECK_STR(urls[1], "https://b.example.net/vod/");
+    }
+}
+
+NEX_TEST_MAIN()
@@ -0,0 +1,188 @@
+// NexApplyDeviceProfile: video renditions cut out of the bbb_30fps MPD and an HLS master playlist
+// in place, and what is left still indexed by NexManifestIndex.
+
+#include "NexDeviceProfile.h"
+#include "NexTest.h"
+
+namespace {
+
+const char *kBbbUrl = "https://dash.akamaized.net/akamai/bbb_30fps/bbb_30fps.mpd";
+const char *kMasterUrl = "https://vod.example.com/show/master.m3u8";
+
+const char *kMaster =
+    "#EXTM3U\n"
+    "#EXT-X-INDEPENDENT-SEGMENTS\n"
+    "#EXT-X-MEDIA:TYPE=AUDIO,GROUP-ID=\"aac\",NAME=\"English\",LANGUAGE=\"en\",DEFAULT=YES,URI=\"audio/en.m3u8\"\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=5000000,RESOLUTION=1920x1080,CODECS=\"avc1.640028,mp4a.40.2\",AUDIO=\"aac\"\n"
+    "1080p.m3u8\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=800000,RESOLUTION=640x360,CODECS=\"avc1.64001e,mp4a.40.2\",AUDIO=\"aac\"\n"
+    "360p.m3u8\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=3500000,RESOLUTION=1920x1080,CODECS=\"hvc1.2.4.L123.B0,mp4a.40.2\",AUDIO=\"aac\"\n"
+    "1080p_hevc.m3u8\n"
+    "#EXT-X-STREAM-INF:BANDWIDTH=2500000,RESOLUTION=1280x720,CODECS=\"avc1.64001f,mp4a.40.2\",AUDIO=\"aac\"\n"
+    "720p.m3u8\n"
+    "#EXT-X-I-FRAME-STREAM-INF:BANDWIDTH=200000,RESOLUTION=1920x1080,CODECS=\"avc1.640028\",URI=\"1080p_iframes.m3u8\"\n"
+    "#EXT-X-I-FRAME-STREAM-INF:BANDWIDTH=90000,RESOLUTION=640x360,CODECS=\"avc1.64001e\",URI=\"360p_iframes.m3u8\"\n";
+
+NexDeviceProfile Profile() {
+    NexDeviceProfile profile = {};
+    profile.version = NEXPLAYER_DEVICE_PROFILE_VERSION;
+    profile.size = sizeof(NexDeviceProfile);
+    return profile;
+}
+
+// Runs the rewrite on a copy, the way the descrambler gets the SDK's buffer.
+std::string Apply(const NexDeviceProfile &profile, const std::string &manifest, NexManifestRewriteInfo &info) {
+    std::vector<char> buffer(manifest.begin(), manifest.end());
+    info = NexManifestRewriteInfo();
+    size_t size = NexApplyDeviceProfile(profile, buffer.data(), buffer.size(), info);
+    NEX_CHECK(size <= manifest.size());
+    NEX_CHECK_EQ(info.outputSize, (int32_t)size);
+    return std::string(buffer.data(), size);
+}
+
+std::vector<std::string> RenditionIds(const NexManifestIndex &index) {
+    std::vector<std::string> ids;
+    for(const NexManifestRendition &rendition : index.renditions)
+        ids.push_back(index.string(rendition.record.idOffset));
+    return ids;
+}
+
+size_t BlankLines(const std::string &text) {
+    size_t count = 0;
+    for(size_t at = text.find("\n\n"); at != std::string::npos; at = text.find("\n\n", at + 1))
+        count++;
+    return count;
+}
+
+std::vector<std::string> Uris(const std::string &playlist) {
+    std::vector<std::string> uris;
+    const char *p = playlist.data(), *end = p + playlist.size();
+    while(p < end){
+        const char *line = p, *lineEnd = NexLineEnd(p, end);
+        p = NexNextLine(p, end);
+        if(line < lineEnd && *line != '#')
+            uris.emplace_back(line, lineEnd);
+    }
+    return uris;
+}
+
+}
+
+NEX_TEST(MaxHeightCutsTheBbbRenditionsAbove720p) {
+    std::string mpd = NexReadStreamingAsset("bbb_30fps.mpd");
+    NexDeviceProfile profile = Profile();
+    profile.maxHeight = 720;
+    NexManifestRewriteInfo info;
+    std::string rewritten = Apply(profile, mpd, info);
+    NEX_CHECK_EQ(info.type, NEXUNITY_MANIFEST_DASH);
+    NEX_CHECK_EQ(info.kept, 8);
+    NEX_CHECK_EQ(info.removed, 2);
+    NEX_CHECK_EQ(info.inputSize, (int32_t)mpd.size());
+    NEX_CHECK(rewritten.size() < mpd.size());
+    NEX_CHECK(rewritten.find("1920x1080") == std::string::npos);
+    NEX_CHECK(rewritten.find("3840x2160") == std::string::npos);
+    // Whole lines go: no blank line is left where a Representation was.
+    NEX_CHECK_EQ(BlankLines(rewritten), BlankLines(mpd));
+
+    NexManifestIndex index;
+    NEX_CHECK(index.parse(rewritten.data(), rewritten.size(), kBbbUrl, 0));
+    NEX_CHECK_EQ(index.renditions.size(), 9);
+    NEX_CHECK_EQ(index.segmentTotal(), 9 * 159);
+    NEX_CHECK_EQ(index.durationMs, 634566);
+    NexSegmentRecord last = {};
+    NEX_CHECK(index.segment(0, 158, last));
+    NEX_CHECK_EQ(last.durationMs, 2566);
+    for(const NexManifestRendition &rendition : index.renditions)
+        NEX_CHECK(rendition.record.height <= 720);
+    std::vector<std::string> ids = RenditionIds(index);
+    NEX_CHECK_STR(ids.front(), "bbb_30fps_1024x576_2500k");
+    NEX_CHECK_STR(ids.back(), "bbb_a64k");
+}
+
+NEX_TEST(AvcLevelAndBitrateLimitsApplyPerRepresentation) {
+    std::string mpd = NexReadStreamingAsset("bbb_30fps.mpd");
+    NexDeviceProfile profile = Profile();
+    profile.maxAvcLevel = 30;           // avc1.64001f (3.1) and up go
+    NexManifestRewriteInfo info;
+    std::string rewritten = Apply(profile, mpd, info);
+    NEX_CHECK_EQ(info.kept, 6);
+    NEX_CHECK_EQ(info.removed, 4);
+    NEX_CHECK(rewritten.find("avc1.64001f") == std::string::npos);
+
+    profile = Profile();
+    profile.maxBitrate = 1500000;
+    rewritten = Apply(profile, mpd, info);
+    NEX_CHECK_EQ(info.kept, 5);
+    NexManifestIndex index;
+    NEX_CHECK(index.parse(rewritten.data(), rewritten.size(), kBbbUrl, 0));
+    NEX_CHECK_EQ(index.renditions.size(), 6);
+    for(const NexManifestRendition &rendition : index.renditions)
+        NEX_CHECK(rendition.record.bandwidth <= 1500000);
+
+    // Nothing to cut: the manifest comes back byte for byte.
+    NEX_CHECK_STR(Apply(Profile(), mpd, info), mpd);
+    NEX_CHECK_EQ(info.removed, 0);
+}
+
+NEX_TEST(KeepsTheLowestWhenTheProfileRulesOutEveryRendition) {
+    std::string mpd = NexReadStreamingAsset("bbb_30fps.mpd");
+    NexDeviceProfile profile = Profile();
+    profile.videoCodecs = NEXUNITY_VIDEO_CODEC_HEVC;
+    NexManifestRewriteInfo info;
+    std::string rewritten = Apply(profile, mpd, info);
+    NEX_CHECK_EQ(info.kept, 1);
+    NEX_CHECK_EQ(info.removed, 9);
+    NexManifestIndex index;
+    NEX_CHECK(index.parse(rewritten.data(), rewritten.size(), kBbbUrl, 0));
+    std::vector<std::string> ids = RenditionIds(index);
+    NEX_CHECK_EQ(ids.size(), 2);
+    NEX_CHECK_STR(ids[0], "bbb_30fps_320x180_200k");
+    NEX_CHECK_STR(ids[1], "bbb_a64k");
+}
+
+NEX_TEST(MasterPlaylistDropsAndOrdersVariants) {
+    std::string master = kMaster;
+    NexDeviceProfile profile = Profile();
+    profile.videoCodecs = NEXUNITY_VIDEO_CODEC_AVC;
+    profile.maxHeight = 720;
+    profile.order = NEXUNITY_RENDITION_ORDER_ASCENDING;
+    NexManifestRewriteInfo info;
+    std::string rewritten = Apply(profile, master, info);
+    NEX_CHECK_EQ(info.type, NEXUNITY_MANIFEST_HLS);
+    NEX_CHECK_EQ(info.kept, 3);         // 360p, 720p and the 360p I-frame variant
+    NEX_CHECK_EQ(info.removed, 3);
+    std::vector<std::string> uris = Uris(rewritten);
+    NEX_CHECK_EQ(uris.size(), 2);
+    if(uris.size() == 2){
+        NEX_CHECK_STR(uris[0], "360p.m3u8");
+        NEX_CHECK_STR(uris[1], "720p.m3u8");
+    }
+    NEX_CHECK(rewritten.find("360p_iframes.m3u8") != std::string::npos);
+    NEX_CHECK(rewritten.find("1080p_iframes.m3u8") == std::string::npos);
+    NEX_CHECK(rewritten.find("#EXT-X-MEDIA:TYPE=AUDIO") != std::string::npos);
+
+    profile.order = NEXUNITY_RENDITION_ORDER_DESCENDING;
+    uris = Uris(Apply(profile, master, info));
+    NEX_CHECK_EQ(uris.size(), 2);
+    if(uris.size() == 2)
+        NEX_CHECK_STR(uris[0], "720p.m3u8");
+
+    // The index sees the variants only; their segments come from the media playlists.
+    NexManifestIndex index;
+    NEX_CHECK(index.parse(rewritten.data(), rewritten.size(), kMasterUrl, 0));
+    NEX_CHECK_EQ(index.segmentTotal(), 0);
+}
+
+NEX_TEST(MediaPlaylistsAndUnknownInputPassThrough) {
+    std::string media = "#EXTM3U\n#EXT-X-TARGETDURATION:4\n#EXTINF:4.0,\nseg0.ts\n#EXT-X-ENDLIST\n";
+    NexDeviceProfile profile = Profile();
+    profile.maxHeight = 1;
+    NexManifestRewriteInfo info;
+    NEX_CHECK_STR(Apply(profile, media, info), media);
+    NEX_CHECK_EQ(info.kept + info.removed, 0);
+    std::string garbage = "{\"not\": \"a manifest\"}";
+    NEX_CHECK_STR(Apply(profile, garbage, info), garbage);
+}
+
+NEX_TEST_MAIN()
@@ -0,0 +1,201 @@
+// NexHeaderStore: query token encoding, header validation and replacement, and a token refresh
+// against a local HTTP stand-in that refuses expired tokens while segments keep being fetched.
+
+#include "NexHeaderStore.h"
+#include "NexHttpStandIn.h"
+#include "NexTest.h"
+
+namespace {
+
+const char *kSegmentRequest = "GET /live/video/seg_1234.m4s?token=expired&v=1 HTTP/1.1\r\nHost: cdn.example.com\r\n"
+                              "Authorization: Bearer expired\r\nUser-Agent: NexPlayer\r\n\r\n";
+
+std::string Apply(const std::shared_ptr<const NexHeaderSet> &set, std::string request) {
+    NexApplyHeaderSet(*set, request);
+    return request;
+}
+
+std::string RequestLine(const std::string &request) {
+    return request.substr(0, request.find("\r\n"));
+}
+
+std::string PercentDecode(const std::string &value) {
+    std::string decoded;
+    for(size_t i = 0; i < value.size(); i++){
+        if(value[i] == '%' && i + 2 < value.size()){
+            decoded += (char)strtol(value.substr(i + 1, 2).c_str(), NULL, 16);
+            i += 2;
+        } else {
+            decoded += value[i];
+        }
+    }
+    return decoded;
+}
+
+// Value of a query parameter in a request head's target, decoded; "" when absent.
+std::string QueryValue(const std::string &head, const std::string &name) {
+    std::string line = RequestLine(head);
+    size_t targetStart = line.find(' ') + 1, targetEnd = line.find(' ', targetStart);
+    std::string target = line.substr(targetStart, targetEnd - targetStart);
+    size_t query = target.find('?');
+    for(size_t p = query == std::string::npos ? target.size() : query + 1; p < target.size();){
+        size_t end = target.find('&', p);
+        end = end == std::string::npos ? target.size() : end;
+        if(target.compare(p, name.size() + 1, name + "=") == 0)
+            return PercentDecode(target.substr(p + name.size() + 1, end - p - name.size() - 1));
+        p = end + 1;
+    }
+    return "";
+}
+
+int Count(const std::string &text, const std::string &what) {
+    int count = 0;
+    for(size_t at = text.find(what); at != std::string::npos; at = text.find(what, at + 1))
+        count++;
+    return count;
+}
+
+}
+
+NEX_TEST(QueryTokenValuesAreEncodedForTheRequestLine) {
+    NEX_CHECK_STR(NexEncodeQueryValue("a b&c#d"), "a%20b%26c%23d");
+    NEX_CHECK_STR(NexEncodeQueryValue("exp=1700000000~hmac=3f%2Fab"), "exp=1700000000~hmac=3f%2Fab");
+    NEX_CHECK_STR(NexEncodeQueryValue("100%"), "100%25");
+    NEX_CHECK_STR(NexEncodeQueryValue("%zz%4"), "%25zz%254");
+    NEX_CHECK_STR(NexEncodeQueryValue("caf\xC3\xA9"), "caf%C3%A9");
+    NEX_CHECK_STR(NexEncodeQueryValue("a\r\nb\t"), "a%0D%0Ab%09");
+    NEX_CHECK_STR(NexEncodeQueryValue("Base64+/=_-.~"), "Base64+/=_-.~");
+
+    std::shared_ptr<const NexHeaderSet> store;
+    NEX_CHECK_EQ(NexPublishHeaderField(store, "token", "a b&c#d", true), 1);
+    std::string request = Apply(store, kSegmentRequest);
+    NEX_CHECK_STR(RequestLine(request), "GET /live/video/seg_1234.m4s?token=a%20b%26c%23d&v=1 HTTP/1.1");
+    NEX_CHECK_STR(QueryValue(request, "token"), "a b&c#d");
+    NEX_CHECK_STR(QueryValue(request, "v"), "1");
+}
+
+NEX_TEST(RejectsFieldsThatWouldCorruptTheRequest) {
+    NEX_CHECK(NexHeaderFieldValid("Authorization", "Bearer abc", false));
+    NEX_CHECK(NexHeaderFieldValid("X-Token", "a\tb", false));
+    NEX_CHECK(!NexHeaderFieldValid("", "x", false));
+    NEX_CHECK(!NexHeaderFieldValid("Bad Name", "x", false));
+    NEX_CHECK(!NexHeaderFieldValid("a:b", "x", false));
+    NEX_CHECK(!NexHeaderFieldValid("X-Token", "a\r\nInjected: yes", false));
+    NEX_CHECK(!NexHeaderFieldValid("X-Token", std::string("a\0b", 3), false));
+    NEX_CHECK(NexHeaderFieldValid("token", "a b&c#d", true));         // encoded, not refused
+    NEX_CHECK(!NexHeaderFieldValid("tok&en", "x", true));
+    NEX_CHECK(!NexHeaderFieldValid("tok=en", "x", true));
+    NEX_CHECK(!NexHeaderFieldValid("tok en", "x", true));
+    NEX_CHECK(!NexHeaderFieldValid("tok#", "x", true));
+}
+
+NEX_TEST(ApplyReplacesHeadersOnceAndAppendsWhatIsMissing) {
+    std::shared_ptr<const NexHeaderSet> store;
+    NexPublishHeaderField(store, "authorization", "Bearer fresh", false);
+    NexPublishHeaderField(store, "X-Session", "42", false);
+    NexPublishHeaderField(store, "sig", "abc", true);
+    std::string request = Apply(store, "GET /seg.m4s HTTP/1.1\r\nHost: h\r\nAuthorization: Bearer old\r\nAUTHORIZATION: Bearer older\r\n\r\n");
+    NEX_CHECK_STR(request, "GET /seg.m4s?sig=abc HTTP/1.1\r\nHost: h\r\nauthorization: Bearer fresh\r\nX-Session: 42\r\n\r\n");
+    // Applying again changes nothing.
+    std::string again = request;
+    NEX_CHECK(!NexApplyHeaderSet(*store, again));
+    NEX_CHECK_STR(again, request);
+
+    NEX_CHECK_STR(RequestLine(Apply(store, "GET /seg.m4s? HTTP/1.1\r\n\r\n")), "GET /seg.m4s?sig=abc HTTP/1.1");
+    NEX_CHECK_STR(RequestLine(Apply(store, "GET /seg.m4s?a=1&sigma=2 HTTP/1.1\r\n\r\n")), "GET /seg.m4s?a=1&sigma=2&sig=abc HTTP/1.1");
+}
+
+NEX_TEST(PublishingLeavesTheSetReadersHoldUnchanged) {
+    std::shared_ptr<const NexHeaderSet> store;
+    NexPublishHeaderField(store, "token", "one", true);
+    std::shared_ptr<const NexHeaderSet> held = store;
+    NEX_CHECK_EQ(NexPublishHeaderField(store, "token", "two", true), 2);
+    NEX_CHECK_EQ(NexPublishHeaderField(store, "Authorization", "Bearer two", false), 3);
+    NEX_CHECK_EQ(held->generation, 1);
+    NEX_CHECK_STR(held->tokens[0].value, "one");
+    NEX_CHECK(held->headers.empty());
+    NEX_CHECK_STR(QueryValue(Apply(held, kSegmentRequest), "token"), "one");
+    NEX_CHECK_STR(QueryValue(Apply(store, kSegmentRequest), "token"), "two");
+
+    // NULL removes the field; the request keeps what it came with.
+    NEX_CHECK_EQ(NexPublishHeaderField(store, "token", NULL, true), 4);
+    NEX_CHECK(store->tokens.empty());
+    NEX_CHECK_STR(QueryValue(Apply(store, kSegmentRequest), "token"), "expired");
+}
+
+// A CDN whose tokens expire: it accepts a token and its matching Authorization only while their
+// generation is among the last three issued. The app refreshes both every 5 ms while segments
+// keep coming; every request must carry a valid pair of one generation, none may fail, and the
+// generations must only move forward.
+NEX_TEST(TokenRefreshDoesNotInterruptPlayback) {
+    NexHttpStandIn server;
+    NEX_CHECK(server.listening());
+    server.setBodyBytes(16384);
+    server.setFaults(0, 0, 0, 403);
+    std::atomic<uint32_t> newest(1), oldest(1);
+    server.setDecider([&](const std::string &head) {
+        std::string token = QueryValue(head, "token");
+        uint32_t generation = (uint32_t)strtoul(token.c_str() + (token.compare(0, 4, "gen ") == 0 ? 4 : 0), NULL, 10);
+        bool valid = generation >= oldest && generation <= newest && token == "gen " + std::to_string(generation) + " sig&x#y" &&
+                     Count(head, "Authorization: ") == 1 && head.find("Authorization: Bearer " + std::to_string(generation) + "\r\n") != std::string::npos &&
+                     Count(RequestLine(head), " ") == 2;
+        return valid ? NEX_STANDIN_SERVE : NEX_STANDIN_STATUS;
+    });
+
+    std::mutex storeLock;
+    std::shared_ptr<const NexHeaderSet> store;
+    auto issue = [&](uint32_t generation) {
+        std::lock_guard<std::mutex> guard(storeLock);
+        NexPublishHeaderField(store, "token", ("gen " + std::to_string(generation) + " sig&x#y").c_str(), true);
+        NexPublishHeaderField(store, "Authorization", ("Bearer " + std::to_string(generation)).c_str(), false);
+    };
+    issue(1);
+    std::atomic<bool> done(false);
+    std::thread refresher([&] {
+        for(uint32_t generation = 2; !done; generation++){
+            newest = generation;
+            issue(generation);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            oldest = generation > 2 ? generation - 2 : 1;
+        }
+    });
+
+    // At least 200 segments, and on until 20 refreshes have gone by.
+    int segments = 0, played = 0;
+    uint32_t previous = 0, firstGeneration = 0;
+    bool ordered = true;
+    int64_t longestUs = 0;
+    for(int i = 0; i < 20000 && (i < 200 || previous < firstGeneration + 20); i++, segments++){
+        std::string request = kSegmentRequest;
+        std::shared_ptr<const NexHeaderSet> set;
+        {
+            std::lock_guard<std::mutex> guard(storeLock);
+            set = store;
+        }
+        NexApplyHeaderSet(*set, request);
+        // The request carries the pair of the set's generation, which is two publishes on.
+        uint32_t generation = set->generation / 2;
+        ordered &= generation >= previous;
+        previous = generation;
+        if(i == 0)
+            firstGeneration = generation;
+        NexHttpResponse response = NexHttpFetch(server.port(), request, 2000);
+        played += response.status == 200 && response.bytes == 16384;
+        longestUs = std::max(longestUs, response.elapsedUs);
+    }
+    done = true;
+    refresher.join();
+
+    NEX_CHECK_EQ(played, segments);
+    NEX_CHECK_EQ(server.failed, 0);
+    NEX_CHECK_EQ(server.served, segments);
+    NEX_CHECK(ordered);
+    NEX_CHECK(previous >= firstGeneration + 20);    // the tokens did change under the playing stream
+    NEX_CHECK(longestUs < 1000000);
+    std::vector<std::string> heads = server.requests();
+    NEX_CHECK_EQ(heads.size(), segments);
+    for(const std::string &head : heads)
+        NEX_CHECK_EQ(Count(head, "token="), 1);
+}
+
+NEX_TEST_MAIN()
@@ -0,0 +1,186 @@
+// NexManifestIndex on DASH MPDs: the project's StreamingAssets/bbb_30fps.mpd, SegmentTimeline runs
+// (r="-1" included), URL template expansion and BaseURL resolution.
+
+#include "NexManifestIndex.h"
+#include "NexTest.h"
+
+namespace {
+
+const char *kBbbUrl = "https://dash.akamaized.net/akamai/bbb_30fps/bbb_30fps.mpd";
+
+bool Parse(NexManifestIndex &index, const std::string &mpd, const char *url, int64_t nowMs = 0) {
+    return index.parse(mpd.data(), mpd.size(), url, nowMs);
+}
+
+NexSegmentRecord Segment(const NexManifestIndex &index, size_t rendition, uint32_t position) {
+    NexSegmentRecord segment = {};
+    NEX_CHECK(index.segment(rendition, position, segment));
+    return segment;
+}
+
+std::string SegmentURL(const NexManifestIndex &index, size_t rendition, uint32_t position, bool init = false) {
+    std::string url;
+    NEX_CHECK(index.segmentURL(rendition, position, init, url));
+    return url;
+}
+
+// Single-period static MPD around one AdaptationSet body.
+std::string StaticMPD(const char *duration, const std::string &adaptationSet, const std::string &prefix = "") {
+    return std::string("<?xml version=\"1.0\"?>\n<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\" type=\"static\" mediaPresentationDuration=\"") +
+           duration + "\">\n" + prefix + " <Period>\n  <AdaptationSet mimeType=\"video/mp4\">\n" + adaptationSet +
+           "  </AdaptationSet>\n </Period>\n</MPD>\n";
+}
+
+}
+
+NEX_TEST(ParsesBbb30fpsIntoElevenRenditionsOf159Segments) {
+    NexManifestIndex index;
+    NEX_CHECK(Parse(index, NexReadStreamingAsset("bbb_30fps.mpd"), kBbbUrl));
+    NEX_CHECK_EQ(index.type, NEXUNITY_MANIFEST_DASH);
+    NEX_CHECK(!index.live);
+    NEX_CHECK_EQ(index.durationMs, 634566);
+    NEX_CHECK_EQ(index.periods.size(), 1);
+    NEX_CHECK_EQ(index.renditions.size(), 11);
+    NEX_CHECK_EQ(index.segmentTotal(), 11 * 159);
+
+    int video = 0, audio = 0;
+    for(const NexManifestRendition &rendition : index.renditions){
+        NEX_CHECK_EQ(rendition.record.segmentCount, 159);
+        NEX_CHECK_EQ(rendition.record.firstNumber, 1);
+        NEX_CHECK_EQ(rendition.record.startMs, 0);
+        NEX_CHECK_EQ(rendition.record.durationMs, 634566);
+        video += rendition.record.kind == NEXUNITY_STREAM_VIDEO_TRACK;
+        audio += rendition.record.kind == NEXUNITY_STREAM_AUDIO;
+    }
+    NEX_CHECK_EQ(video, 10);
+    NEX_CHECK_EQ(audio, 1);
+
+    const NexRenditionRecord &first = index.renditions[0].record;
+    NEX_CHECK_STR(index.string(first.idOffset), "bbb_30fps_1024x576_2500k");
+    NEX_CHECK_STR(index.string(first.codecsOffset), "avc1.64001f");
+    NEX_CHECK_EQ(first.width, 1024);
+    NEX_CHECK_EQ(first.height, 576);
+    NEX_CHECK_EQ(first.bandwidth, 3134488);
+    NEX_CHECK_EQ(first.frameRateMilli, 30000);
+    // The audio AdaptationSet carries Role and Accessibility but no lang.
+    NEX_CHECK_EQ(index.renditions[10].record.languageOffset, -1);
+
+    NEX_CHECK_STR(SegmentURL(index, 0, 0, true),
+                  "https://dash.akamaized.net/akamai/bbb_30fps/bbb_30fps_1024x576_2500k/bbb_30fps_1024x576_2500k_0.m4v");
+    NEX_CHECK_STR(SegmentURL(index, 0, 0), "https://dash.akamaized.net/akamai/bbb_30fps/bbb_30fps_1024x576_2500k/bbb_30fps_1024x576_2500k_1.m4v");
+    NEX_CHECK_STR(SegmentURL(index, 10, 158), "https://dash.akamaized.net/akamai/bbb_30fps/bbb_a64k/bbb_a64k_159.m4a");
+}
+
+NEX_TEST(ClipsLastSegmentToPeriodEnd) {
+    NexManifestIndex index;
+    NEX_CHECK(Parse(index, NexReadStreamingAsset("bbb_30fps.mpd"), kBbbUrl));
+    NexSegmentRecord segment = Segment(index, 0, 157);
+    NEX_CHECK_EQ(segment.startMs, 628000);
+    NEX_CHECK_EQ(segment.durationMs, 4000);
+    segment = Segment(index, 0, 158);
+    NEX_CHECK_EQ(segment.number, 159);
+    NEX_CHECK_EQ(segment.startMs, 632000);
+    NEX_CHECK_EQ(segment.durationMs, 2566);
+    // Audio segments are 192512/48000 s.
+    segment = Segment(index, 10, 158);
+    NEX_CHECK_EQ(segment.startMs, 633685);
+    NEX_CHECK_EQ(segment.durationMs, 881);
+
+    NEX_CHECK_EQ(index.findSegment(0, 0), 0);
+    NEX_CHECK_EQ(index.findSegment(0, 3999), 0);
+    NEX_CHECK_EQ(index.findSegment(0, 4000), 1);
+    NEX_CHECK_EQ(index.findSegment(0, 634565), 158);
+    NEX_CHECK_EQ(index.findSegment(0, 634566), -1);
+    NEX_CHECK_EQ(index.findSegment(10, 633685), 158);
+}
+
+NEX_TEST(ResolvesOpenTimelineRunToPeriodEnd) {
+    // Three 4 s segments, then 6 s segments up to the end: 48 s fill 8 exactly, 49 s need a
+    // ninth that is cut to 1 s.
+    const std::string timeline =
+        "   <SegmentTemplate timescale=\"1000\" media=\"$RepresentationID$/seg_$Time$.m4s\" initialization=\"$RepresentationID$/init.mp4\">\n"
+        "    <SegmentTimeline>\n     <S t=\"0\" d=\"4000\" r=\"2\"/>\n     <S d=\"6000\" r=\"-1\"/>\n    </SegmentTimeline>\n"
+        "   </SegmentTemplate>\n"
+        "   <Representation id=\"v1\" bandwidth=\"1000000\" width=\"640\" height=\"360\"/>\n"
+        "   <Representation id=\"v2\" bandwidth=\"3000000\" width=\"1280\" height=\"720\"/>\n";
+    NexManifestIndex exact;
+    NEX_CHECK(Parse(exact, StaticMPD("PT60S", timeline), "https://cdn.example.com/vod/main.mpd"));
+    NEX_CHECK_EQ(exact.renditions.size(), 2);
+    NEX_CHECK_EQ(exact.renditions[0].record.segmentCount, 11);
+    NEX_CHECK_EQ(exact.renditions[1].record.segmentCount, 11);
+    NEX_CHECK_EQ(exact.renditions[0].record.durationMs, 60000);
+    NEX_CHECK_EQ(Segment(exact, 0, 10).durationMs, 6000);
+    NEX_CHECK_STR(SegmentURL(exact, 0, 3), "https://cdn.example.com/vod/v1/seg_12000.m4s");
+    NEX_CHECK_STR(SegmentURL(exact, 1, 10), "https://cdn.example.com/vod/v2/seg_54000.m4s");
+    NEX_CHECK_STR(SegmentURL(exact, 1, 0, true), "https://cdn.example.com/vod/v2/init.mp4");
+
+    NexManifestIndex ragged;
+    NEX_CHECK(Parse(ragged, StaticMPD("PT61S", timeline), "https://cdn.example.com/vod/main.mpd"));
+    NEX_CHECK_EQ(ragged.renditions[0].record.segmentCount, 12);
+    NEX_CHECK_EQ(ragged.renditions[0].record.durationMs, 61000);
+    NexSegmentRecord last = Segment(ragged, 0, 11);
+    NEX_CHECK_EQ(last.time, 60000);
+    NEX_CHECK_EQ(last.durationMs, 1000);
+}
+
+NEX_TEST(ResolvesOpenTimelineRunAtLiveEdge) {
+    const std::string mpd =
+        "<MPD type=\"dynamic\" availabilityStartTime=\"1970-01-01T00:00:00Z\" timeShiftBufferDepth=\"PT60S\">\n"
+        " <Period start=\"PT0S\">\n  <AdaptationSet contentType=\"audio\" lang=\"en\">\n"
+        "   <SegmentTemplate timescale=\"48000\" media=\"a_$Number$.m4s\" startNumber=\"100\">\n"
+        "    <SegmentTimeline><S t=\"0\" d=\"96000\" r=\"-1\"/></SegmentTimeline>\n   </SegmentTemplate>\n"
+        "   <Representation id=\"a\" bandwidth=\"128000\"/>\n  </AdaptationSet>\n </Period>\n</MPD>\n";
+    NexManifestIndex index;
+    // Only complete segments are available: 11 s into the stream that is five of 2 s.
+    NEX_CHECK(Parse(index, mpd, "https://live.example.com/channel/manifest.mpd", 11000));
+    NEX_CHECK(index.live);
+    NEX_CHECK_EQ(index.renditions.size(), 1);
+    NEX_CHECK_EQ(index.renditions[0].record.kind, NEXUNITY_STREAM_AUDIO);
+    NEX_CHECK_EQ(index.renditions[0].record.segmentCount, 5);
+    NEX_CHECK_STR(SegmentURL(index, 0, 4), "https://live.example.com/channel/a_104.m4s");
+    NEX_CHECK_EQ(Segment(index, 0, 4).startMs, 8000);
+}
+
+NEX_TEST(ExpandsNumberTimeAndBandwidthTemplates) {
+    NexManifestIndex index;
+    NEX_CHECK(Parse(index, StaticMPD("PT20S",
+        "   <SegmentTemplate timescale=\"90000\" duration=\"180000\" startNumber=\"7\"\n"
+        "                    media=\"$RepresentationID$/$Bandwidth$/chunk_$Number%05d$_$Time%012d$$$.m4s\"\n"
+        "                    initialization=\"$RepresentationID$/$Bandwidth$/init.mp4\"/>\n"
+        "   <Representation id=\"hd\" bandwidth=\"4500000\"/>\n"), "https://cdn.example.com/live/stream.mpd"));
+    NEX_CHECK_EQ(index.renditions.size(), 1);
+    NEX_CHECK_EQ(index.renditions[0].record.segmentCount, 10);
+    NEX_CHECK_EQ(Segment(index, 0, 0).number, 7);
+    NEX_CHECK_STR(SegmentURL(index, 0, 0), "https://cdn.example.com/live/hd/4500000/chunk_00007_000000000000$.m4s");
+    NEX_CHECK_STR(SegmentURL(index, 0, 9), "https://cdn.example.com/live/hd/4500000/chunk_00016_000001620000$.m4s");
+    NEX_CHECK_STR(SegmentURL(index, 0, 0, true), "https://cdn.example.com/live/hd/4500000/init.mp4");
+    std::string url;
+    NEX_CHECK(!index.segmentURL(0, 10, false, url));
+}
+
+NEX_TEST(ResolvesBaseURLsLevelByLevel) {
+    const std::string mpd =
+        "<MPD type=\"static\" mediaPresentationDuration=\"PT8S\">\n"
+        " <BaseURL>https://origin.example.com/content/</BaseURL>\n"
+        " <Period>\n  <BaseURL>period1/</BaseURL>\n"
+        "  <AdaptationSet mimeType=\"video/mp4\">\n   <BaseURL>video/</BaseURL>\n"
+        "   <SegmentTemplate timescale=\"1\" duration=\"4\" media=\"$RepresentationID$_$Number$.m4s\"/>\n"
+        "   <Representation id=\"low\" bandwidth=\"500000\">\n    <BaseURL>../low/</BaseURL>\n   </Representation>\n"
+        "   <Representation id=\"mid\" bandwidth=\"1500000\"/>\n"
+        "   <Representation id=\"cdn\" bandwidth=\"3000000\">\n    <BaseURL>https://cdn2.example.com/abs/</BaseURL>\n"
+        "    <BaseURL>https://ignored.example.com/</BaseURL>\n   </Representation>\n"
+        "  </AdaptationSet>\n"
+        "  <AdaptationSet mimeType=\"audio/mp4\">\n"
+        "   <SegmentTemplate timescale=\"1\" duration=\"4\" media=\"/root/$RepresentationID$_$Number$.m4s\"/>\n"
+        "   <Representation id=\"aac\" bandwidth=\"64000\"/>\n  </AdaptationSet>\n"
+        " </Period>\n</MPD>\n";
+    NexManifestIndex index;
+    NEX_CHECK(Parse(index, mpd, "https://manifests.example.com/a/b.mpd"));
+    NEX_CHECK_EQ(index.renditions.size(), 4);
+    NEX_CHECK_STR(SegmentURL(index, 0, 0), "https://origin.example.com/content/period1/low/low_1.m4s");
+    NEX_CHECK_STR(SegmentURL(index, 1, 1), "https://origin.example.com/content/period1/video/mid_2.m4s");
+    NEX_CHECK_STR(SegmentURL(index, 2, 0), "https://cdn2.example.com/abs/cdn_1.m4s");
+    NEX_CHECK_STR(SegmentURL(index, 3, 0), "https://origin.example.com/root/aac_1.m4s");
+}
+
+NEX_TEST_MAIN()
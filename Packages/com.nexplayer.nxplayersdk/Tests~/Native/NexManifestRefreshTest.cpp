@@ -0,0 +1,205 @@
+// Live reloads of NexManifestIndex: HLS tail refresh staged off the readers' copy, LL-HLS parts
+// leaving with the server's listing, and DASH timeline refresh against a full parse.
+
+#include "NexManifestIndex.h"
+#include "NexTest.h"
+
+namespace {
+
+const char *kMediaUrl = "https://live.example.com/event/720p.m3u8";
+
+// LL-HLS media playlist listing segments [first, first + count): the last `parted` of them keep
+// four 0.5 s parts, and two parts plus a preload hint of the next segment follow.
+std::string LivePlaylist(uint64_t first, int count, int parted) {
+    char line[256];
+    snprintf(line, sizeof(line), "#EXTM3U\n#EXT-X-VERSION:9\n#EXT-X-TARGETDURATION:2\n#EXT-X-PART-INF:PART-TARGET=0.5\n"
+             "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=1.5\n#EXT-X-MEDIA-SEQUENCE:%llu\n", (unsigned long long)first);
+    std::string playlist = line;
+    for(uint64_t n = first; n < first + count; n++){
+        if((int)(first + count - n) <= parted){
+            for(int k = 0; k < 4; k++){
+                snprintf(line, sizeof(line), "#EXT-X-PART:DURATION=0.5,URI=\"seg%llu.%d.mp4\"%s\n", (unsigned long long)n, k, k == 0 ? ",INDEPENDENT=YES" : "");
+                playlist += line;
+            }
+        }
+        snprintf(line, sizeof(line), "#EXTINF:2.000,\nseg%llu.mp4\n", (unsigned long long)n);
+        playlist += line;
+    }
+    uint64_t next = first + count;
+    for(int k = 0; k < 2; k++){
+        snprintf(line, sizeof(line), "#EXT-X-PART:DURATION=0.5,URI=\"seg%llu.%d.mp4\"\n", (unsigned long long)next, k);
+        playlist += line;
+    }
+    snprintf(line, sizeof(line), "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"seg%llu.2.mp4\"\n", (unsigned long long)next);
+    return playlist + line;
+}
+
+bool Load(NexManifestIndex &index, const std::string &playlist) {
+    return index.parse(playlist.data(), playlist.size(), kMediaUrl, 0);
+}
+
+bool Refresh(NexManifestIndex &index, const std::string &playlist) {
+    return index.refreshPlaylist(0, playlist.data(), playlist.size());
+}
+
+NexSegmentRecord Segment(const NexManifestIndex &index, uint32_t position) {
+    NexSegmentRecord record = {};
+    NEX_CHECK(index.segment(0, position, record));
+    return record;
+}
+
+std::string PartURL(const NexManifestIndex &index, uint32_t position, uint32_t part) {
+    NexSegmentRecord record = {};
+    std::string url;
+    return index.part(0, position, part, record, &url) ? url : "";
+}
+
+// Everything a reader can get out of rendition 0, for comparing two indexes.
+std::string Dump(const NexManifestIndex &index) {
+    std::string dump;
+    char line[96];
+    const NexRenditionRecord &record = index.renditions[0].record;
+    snprintf(line, sizeof(line), "%u segments from %llu, %lld+%lld ms\n", record.segmentCount, (unsigned long long)record.firstNumber,
+             (long long)record.startMs, (long long)record.durationMs);
+    dump += line;
+    for(uint32_t i = 0; i < record.segmentCount; i++){
+        NexSegmentRecord segment = {};
+        std::string url;
+        index.segment(0, i, segment);
+        index.segmentURL(0, i, false, url);
+        snprintf(line, sizeof(line), "%llu %llu %lld %lld %d ", (unsigned long long)segment.number, (unsigned long long)segment.time,
+                 (long long)segment.startMs, (long long)segment.durationMs, segment.partCount);
+        dump += line + url + "\n";
+    }
+    return dump;
+}
+
+}
+
+NEX_TEST(RefreshParsesOnlyTheNewTail) {
+    NexManifestIndex index;
+    NEX_CHECK(Load(index, LivePlaylist(100, 30, 3)));
+    NEX_CHECK(index.live);
+    NEX_CHECK_EQ(index.renditions[0].record.segmentCount, 30);
+    NEX_CHECK(index.refreshable(0, kMediaUrl));
+
+    NEX_CHECK(Refresh(index, LivePlaylist(102, 30, 3)));
+    const NexMediaPlaylist *media = index.playlist(0);
+    NEX_CHECK_EQ(media->appendedSegments, 2);
+    NEX_CHECK(media->refreshUs > 0);
+    NEX_CHECK_EQ(media->mediaSequence, 102);
+    NEX_CHECK_EQ(index.renditions[0].record.segmentCount, 30);
+    NEX_CHECK_EQ(index.renditions[0].record.startMs, 4000);
+
+    // The spare the first reload left behind is one reload back; it must catch up correctly.
+    for(uint64_t first = 103; first < 140; first++)
+        NEX_CHECK(Refresh(index, LivePlaylist(first, 30, 3)));
+    NexManifestIndex fresh;
+    NEX_CHECK(Load(fresh, LivePlaylist(139, 30, 3)));
+    // Same segments; the refreshed timeline keeps counting from the first load.
+    NEX_CHECK_EQ(index.renditions[0].record.firstNumber, 139);
+    NEX_CHECK_EQ(index.renditions[0].record.startMs, 78000);
+    NexSegmentRecord a = {}, b = {};
+    for(uint32_t i = 0; i < 30; i++){
+        NEX_CHECK(index.segment(0, i, a));
+        NEX_CHECK(fresh.segment(0, i, b));
+        NEX_CHECK_EQ(a.number, b.number);
+        NEX_CHECK_EQ(a.durationMs, b.durationMs);
+        NEX_CHECK_EQ(a.startMs - 78000, b.startMs);
+        NEX_CHECK_EQ(a.partCount, b.partCount);
+    }
+}
+
+NEX_TEST(DropsPartsTheServerNoLongerLists) {
+    NexManifestIndex index;
+    NEX_CHECK(Load(index, LivePlaylist(0, 10, 3)));
+    NEX_CHECK_EQ(Segment(index, 7).partCount, 4);
+    NEX_CHECK_STR(PartURL(index, 7, 0), "https://live.example.com/event/seg7.0.mp4");
+    NEX_CHECK_EQ(index.renditions[0].record.pendingPartCount, 3);
+
+    // One more segment: seg7 leaves the parted tail, seg10 joins it.
+    NEX_CHECK(Refresh(index, LivePlaylist(0, 11, 3)));
+    NEX_CHECK_EQ(index.renditions[0].record.segmentCount, 11);
+    NEX_CHECK_EQ(Segment(index, 7).partCount, 0);
+    NEX_CHECK_STR(PartURL(index, 7, 0), "");
+    NEX_CHECK_EQ(Segment(index, 8).partCount, 4);
+    NEX_CHECK_EQ(Segment(index, 10).partCount, 4);
+    NEX_CHECK_STR(PartURL(index, 10, 3), "https://live.example.com/event/seg10.3.mp4");
+    NEX_CHECK_STR(PartURL(index, 11, 1), "https://live.example.com/event/seg11.1.mp4");
+    NEX_CHECK_EQ(index.playlist(0)->parts.size(), 3 * 4 + 3);
+
+    // A server that keeps parts on fewer segments.
+    NEX_CHECK(Refresh(index, LivePlaylist(0, 12, 1)));
+    for(uint32_t i = 0; i < 11; i++)
+        NEX_CHECK_EQ(Segment(index, i).partCount, 0);
+    NEX_CHECK_EQ(Segment(index, 11).partCount, 4);
+    NEX_CHECK_EQ(index.playlist(0)->parts.size(), 4 + 3);
+}
+
+NEX_TEST(StagedReloadLeavesPublishedPlaylistUntouched) {
+    NexManifestIndex index;
+    NEX_CHECK(Load(index, LivePlaylist(500, 20, 2)));
+    NEX_CHECK(Refresh(index, LivePlaylist(501, 20, 2)));
+    std::string before = Dump(index);
+    const NexMediaPlaylist *published = index.playlist(0);
+
+    std::string next = LivePlaylist(503, 20, 2);
+    std::unique_ptr<NexMediaPlaylist> staged = index.stagePlaylist(0, next.data(), next.size());
+    NEX_CHECK(staged != nullptr);
+    NEX_CHECK(index.playlist(0) == published);
+    NEX_CHECK_STR(Dump(index), before);
+
+    index.publishPlaylist(0, std::move(staged));
+    NEX_CHECK(index.playlist(0) != published);
+    NEX_CHECK_EQ(index.playlist(0)->appendedSegments, 2);
+    NEX_CHECK_EQ(index.renditions[0].record.firstNumber, 503);
+    NEX_CHECK_EQ(index.renditions[0].record.segmentCount, 20);
+
+    std::string broken = "not a playlist";
+    NEX_CHECK(index.stagePlaylist(0, broken.data(), broken.size()) == nullptr);
+    NEX_CHECK(Refresh(index, LivePlaylist(504, 20, 2)));
+    NEX_CHECK_EQ(index.renditions[0].record.firstNumber, 504);
+}
+
+NEX_TEST(WindowBoundsTheRefreshedPlaylist) {
+    NexManifestIndex index;
+    index.window = 8;
+    NEX_CHECK(Load(index, LivePlaylist(0, 40, 2)));
+    NEX_CHECK_EQ(index.renditions[0].record.segmentCount, 8);
+    NEX_CHECK_EQ(index.renditions[0].record.firstNumber, 32);
+    NEX_CHECK(Refresh(index, LivePlaylist(0, 45, 2)));
+    NEX_CHECK_EQ(index.renditions[0].record.segmentCount, 8);
+    NEX_CHECK_EQ(index.renditions[0].record.firstNumber, 37);
+    NEX_CHECK_EQ(Segment(index, 7).partCount, 4);
+}
+
+NEX_TEST(DashRefreshMatchesFullParse) {
+    // A live timeline listing `count` segments from `first`, with t only on the first S. Segment n
+    // lasts 2000 + n % 2 ms, so the S elements do not fold into one run.
+    auto mpd = [](uint64_t first, int count) {
+        char line[128];
+        std::string text = "<MPD type=\"dynamic\" availabilityStartTime=\"1970-01-01T00:00:00Z\" minimumUpdatePeriod=\"PT2S\">\n"
+                           " <Period id=\"1\" start=\"PT0S\">\n  <AdaptationSet mimeType=\"video/mp4\">\n"
+                           "   <SegmentTemplate timescale=\"1000\" media=\"v_$Time$.m4s\" startNumber=\"";
+        text += std::to_string(first + 1) + "\">\n    <SegmentTimeline>\n";
+        for(int i = 0; i < count; i++){
+            if(i == 0)
+                snprintf(line, sizeof(line), "     <S t=\"%llu\" d=\"%d\"/>\n", (unsigned long long)(first * 2000 + first / 2), 2000 + (int)((first + i) % 2));
+            else
+                snprintf(line, sizeof(line), "     <S d=\"%d\"/>\n", 2000 + (int)((first + i) % 2));
+            text += line;
+        }
+        return text + "    </SegmentTimeline>\n   </SegmentTemplate>\n   <Representation id=\"v\" bandwidth=\"2000000\"/>\n"
+                      "  </AdaptationSet>\n </Period>\n</MPD>\n";
+    };
+    std::string url = "https://live.example.com/event/manifest.mpd";
+    std::string first = mpd(0, 50), second = mpd(3, 50);
+    NexManifestIndex previous, refreshed, fresh;
+    NEX_CHECK(previous.parse(first.data(), first.size(), url.c_str(), 200000));
+    NEX_CHECK(refreshed.parse(second.data(), second.size(), url.c_str(), 200000, &previous));
+    NEX_CHECK(fresh.parse(second.data(), second.size(), url.c_str(), 200000));
+    NEX_CHECK_EQ(refreshed.renditions[0].record.segmentCount, 50);
+    NEX_CHECK_STR(Dump(refreshed), Dump(fresh));
+}
+
+NEX_TEST_MAIN()
@@ -0,0 +1,142 @@
+// NexResilience: backoff and budgets on a virtual clock, then recovery of a fetch loop from
+// drops, stalls and 503s injected by a local HTTP stand-in.
+
+#include "NexResilienceDrill.h"
+#include "NexTest.h"
+
+namespace {
+
+NexResiliencePolicy Policy(int sessionRetries, int backoffBaseMs, int backoffMaxMs, int jitterPercent) {
+    NexResiliencePolicy policy = { NEXPLAYER_RESILIENCE_VERSION, sizeof(NexResiliencePolicy), 3, sessionRetries, backoffBaseMs, backoffMaxMs, jitterPercent, 0, 0 };
+    return policy;
+}
+
+// One retryable failure on the virtual clock; the retry it asks for is taken at once.
+int Fail(NexResilience &resilience, int64_t nowUs, int *delayMs) {
+    int decision = NexResilienceFailure(resilience, NEX_DRILL_ERROR_TIMEOUT, NEXUNITY_ERROR_RETRYABLE, 0, nowUs, delayMs);
+    if(decision == RESILIENCE_RETRY)
+        resilience.scheduled = false;
+    return decision;
+}
+
+}
+
+NEX_TEST(BackoffDoublesToTheMaximumWithinItsJitter) {
+    NexResiliencePolicy policy = Policy(20, 500, 16000, 50);
+    NexResilience resilience = {};
+    NexResetResilience(resilience, &policy, 42);
+    int64_t nowUs = 1000000;
+    for(int attempt = 0; attempt < 10; attempt++){
+        int delayMs = -1;
+        NEX_CHECK_EQ(Fail(resilience, nowUs, &delayMs), RESILIENCE_RETRY);
+        int64_t nominal = std::min<int64_t>(500LL << attempt, 16000);
+        NEX_CHECK(delayMs >= nominal / 2 && delayMs <= nominal * 3 / 2);
+    }
+    NEX_CHECK_EQ(resilience.stats.sessionRetriesLeft, 10);
+
+    // 0 would take the default jitter; 1% keeps the delays within a few ms of nominal.
+    policy = Policy(20, 100, 350, 1);
+    NexResetResilience(resilience, &policy, 42);
+    const int expected[4] = { 100, 200, 350, 350 };
+    for(int delay : expected){
+        int delayMs = -1;
+        Fail(resilience, nowUs, &delayMs);
+        NEX_CHECK(delayMs >= delay * 99 / 100 && delayMs <= delay * 101 / 100);
+    }
+}
+
+NEX_TEST(ZeroFieldsTakeTheDefaults) {
+    NexResiliencePolicy policy = Policy(0, 0, 0, 0);
+    NexResilience resilience = {};
+    NexResetResilience(resilience, &policy, 1);
+    NEX_CHECK_EQ(resilience.policy.segmentRetries, 3);
+    NEX_CHECK_EQ(resilience.policy.sessionRetries, resilienceDefaults.sessionRetries);
+    NEX_CHECK_EQ(resilience.policy.backoffBaseMs, resilienceDefaults.backoffBaseMs);
+    NEX_CHECK_EQ(resilience.policy.backoffMaxMs, resilienceDefaults.backoffMaxMs);
+    NEX_CHECK_EQ(resilience.policy.jitterPercent, resilienceDefaults.jitterPercent);
+    policy = Policy(1, 2000, 100, 400);
+    NexResetResilience(resilience, &policy, 1);
+    NEX_CHECK_EQ(resilience.policy.backoffMaxMs, 2000);
+    NEX_CHECK_EQ(resilience.policy.jitterPercent, 100);
+}
+
+NEX_TEST(SessionBudgetAndFatalErrorsReachTheApp) {
+    NexResiliencePolicy policy = Policy(3, 10, 100, 1);
+    NexResilience resilience = {};
+    NexResetResilience(resilience, &policy, 7);
+    int delayMs = 0;
+    NEX_CHECK_EQ(NexResilienceFailure(resilience, 0x2000, NEXUNITY_ERROR_FATAL, 0, 1000, &delayMs), RESILIENCE_FORWARD);
+    NEX_CHECK_EQ(resilience.stats.fatalErrors, 1);
+    NEX_CHECK_EQ(resilience.failedUs, 0);
+
+    for(int i = 0; i < 3; i++)
+        NEX_CHECK_EQ(Fail(resilience, 1000 + i, &delayMs), RESILIENCE_RETRY);
+    NEX_CHECK_EQ(Fail(resilience, 2000, &delayMs), RESILIENCE_FORWARD);
+    NEX_CHECK_EQ(resilience.stats.forwarded, 1);
+    NEX_CHECK_EQ(resilience.stats.sessionRetriesLeft, 0);
+
+    // While a retry waits, further errors are absorbed.
+    NexResetResilience(resilience, &policy, 7);
+    NEX_CHECK_EQ(NexResilienceFailure(resilience, 1, NEXUNITY_ERROR_RETRYABLE, 0, 1000, &delayMs), RESILIENCE_RETRY);
+    NEX_CHECK_EQ(NexResilienceFailure(resilience, 1, NEXUNITY_ERROR_RETRYABLE, 0, 1500, &delayMs), RESILIENCE_ABSORBED);
+    NEX_CHECK_EQ(NexResilienceProgress(resilience, 3000), -1);      // the retry has not run yet
+    resilience.scheduled = false;
+    NEX_CHECK_EQ(NexResilienceProgress(resilience, 1000 + 250000), 250);
+    NEX_CHECK_EQ(resilience.stats.recoveries, 1);
+    NEX_CHECK_EQ(resilience.attempt, 0);
+    NEX_CHECK_EQ(NexResilienceProgress(resilience, 400000), -1);
+}
+
+NEX_TEST(SegmentErrorsAreLeftToTheSdkUntilTheyPassSegmentRetries) {
+    NexResiliencePolicy policy = Policy(5, 10, 100, 1);
+    NexResilience resilience = {};
+    NexResetResilience(resilience, &policy, 7);
+    int delayMs = 0;
+    for(int i = 0; i < 3; i++)
+        NEX_CHECK_EQ(NexResilienceSegmentFailure(resilience, "seg1.m4s", NEX_DRILL_ERROR_STATUS, NEXUNITY_ERROR_RETRYABLE, 0, 1000, &delayMs), RESILIENCE_ABSORBED);
+    NEX_CHECK_EQ(NexResilienceSegmentFailure(resilience, "seg2.m4s", NEX_DRILL_ERROR_STATUS, NEXUNITY_ERROR_RETRYABLE, 0, 1000, &delayMs), RESILIENCE_ABSORBED);
+    NEX_CHECK_EQ(NexResilienceSegmentFailure(resilience, "seg1.m4s", NEX_DRILL_ERROR_STATUS, NEXUNITY_ERROR_RETRYABLE, 0, 1000, &delayMs), RESILIENCE_RETRY);
+    NEX_CHECK_EQ(resilience.segmentErrors.count("seg1.m4s"), 0);
+    NEX_CHECK_EQ(resilience.segmentErrors["seg2.m4s"], 1);
+    // A 404 is the SDK's to report.
+    NEX_CHECK_EQ(NexResilienceSegmentFailure(resilience, "seg3.m4s", 0x404, NEXUNITY_ERROR_FATAL, 0, 1000, &delayMs), RESILIENCE_ABSORBED);
+}
+
+NEX_TEST(RecoversFromDropsAndStallsOfALocalStandIn) {
+    NexHttpStandIn server(0x1234567);
+    NEX_CHECK(server.listening());
+    server.setBodyBytes(32768);
+    server.setFaults(20, 10, 10);
+    NexResiliencePolicy policy = Policy(1000, 5, 40, 50);
+    NexDrillResult result = NexResilienceDrill(server, policy, 60, 80, 99);
+    NEX_CHECK_EQ(result.fetched, 60);
+    NEX_CHECK_EQ(result.forwarded, 0);
+    NEX_CHECK(server.dropped > 0 && server.stalled > 0 && server.failed > 0);
+    NEX_CHECK_EQ(result.retries, server.dropped + server.stalled + server.failed);
+    NEX_CHECK_EQ(server.served, 60);
+    // Every failure ended in a recovery no longer than its timeouts and backoffs add up to.
+    NEX_CHECK(!result.recoveriesMs.empty());
+    for(int64_t recoveryMs : result.recoveriesMs)
+        NEX_CHECK(recoveryMs < 80 * 8 + 40 * 8 + 500);
+}
+
+NEX_TEST(OutageLongerThanTheBudgetReachesTheApp) {
+    NexHttpStandIn server(7);
+    server.setFaults(0, 100);
+    NexResiliencePolicy policy = Policy(3, 10, 40, 1);
+    NexDrillResult result = NexResilienceDrill(server, policy, 1, 50, 1);
+    NEX_CHECK_EQ(result.fetched, 0);
+    NEX_CHECK_EQ(result.forwarded, 1);
+    NEX_CHECK_EQ(result.retries, 3);
+    NEX_CHECK_EQ(server.stalled, 4);
+    // Four timeouts and backoffs of about 10, 20 and 40 ms.
+    NEX_CHECK(result.elapsedUs >= (4 * 50 + 69) * 1000);
+
+    // Service comes back: the next segment plays without a new session.
+    server.setFaults(0, 0);
+    result = NexResilienceDrill(server, policy, 3, 50, 1);
+    NEX_CHECK_EQ(result.fetched, 3);
+    NEX_CHECK_EQ(result.retries, 0);
+}
+
+NEX_TEST_MAIN()
@@ -0,0 +1,138 @@
+// Stress test of NexSeqlock against a simulated backend: "SDK callback" threads publish
+// per-instance snapshots (a subtitle-sized string among them) while a "Unity" thread reads
+// every instance in a tight loop. Run under ThreadSanitizer (NEXPLAYER_TSAN, on by default);
+// any torn copy fails the checksum check, any unsynchronised access fails the TSan run.
+
+#include "NexPlayerCore.h"
+#include "NexTest.h"
+
+#include <thread>
+
+namespace {
+
+const int kInstances = 8;
+const int kCallbackThreads = 4;
+const int kWritesPerThread = 20000;
+
+struct SimulatedSnapshot {
+    uint32_t serial;
+    int32_t downloadProgress;
+    int64_t positionMs;
+    char subtitle[192];
+    uint32_t checksum;
+};
+
+uint32_t Checksum(const SimulatedSnapshot &snapshot) {
+    uint32_t hash = 2166136261u ^ snapshot.serial;
+    hash = (hash ^ (uint32_t)snapshot.downloadProgress) * 16777619u;
+    hash = (hash ^ (uint32_t)snapshot.positionMs) * 16777619u;
+    for(size_t i = 0; i < sizeof(snapshot.subtitle); i++)
+        hash = (hash ^ (uint8_t)snapshot.subtitle[i]) * 16777619u;
+    return hash;
+}
+
+// What a delegate callback would publish for its serial'th update.
+SimulatedSnapshot MakeSnapshot(uint32_t serial) {
+    SimulatedSnapshot snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.serial = serial;
+    snapshot.downloadProgress = (int32_t)(serial % 101);
+    snapshot.positionMs = (int64_t)serial * 33;
+    int length = 1 + (int)(serial % (sizeof(snapshot.subtitle) - 1));
+    for(int i = 0; i < length; i++)
+        snapshot.subtitle[i] = (char)('a' + (serial + i) % 26);
+    snapshot.checksum = Checksum(snapshot);
+    return snapshot;
+}
+
+NexSeqlock<SimulatedSnapshot> snapshots[kInstances];
+
+}
+
+NEX_TEST(ReadersNeverSeeTornSnapshots) {
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0), regressed(0);
+    std::atomic<long> reads(0);
+
+    // Unity's thread: polls every instance, never blocks the callbacks.
+    std::thread unity([&]() {
+        uint32_t lastSerial[kInstances] = { 0 };
+        uint32_t lastGeneration[kInstances] = { 0 };
+        while(!done.load(std::memory_order_acquire)){
+            for(int i = 0; i < kInstances; i++){
+                SimulatedSnapshot snapshot;
+                uint32_t generation = snapshots[i].read(snapshot);
+                if(generation == 0)
+                    continue;
+                if(snapshot.checksum != Checksum(snapshot))
+                    torn++;
+                if(snapshot.serial < lastSerial[i] || generation < lastGeneration[i])
+                    regressed++;
+                lastSerial[i] = snapshot.serial;
+                lastGeneration[i] = generation;
+                reads++;
+            }
+        }
+    });
+
+    // SDK callback threads; each owns two instances and publishes increasing serials.
+    std::vector<std::thread> callbacks;
+    for(int t = 0; t < kCallbackThreads; t++){
+        callbacks.emplace_back([t]() {
+            for(int n = 1; n <= kWritesPerThread; n++){
+                int index = t * (kInstances / kCallbackThreads) + n % (kInstances / kCallbackThreads);
+                snapshots[index].write(MakeSnapshot((uint32_t)n));
+            }
+        });
+    }
+    for(std::thread &callback : callbacks)
+        callback.join();
+    done.store(true, std::memory_order_release);
+    unity.join();
+
+    NEX_CHECK_EQ(torn.load(), 0);
+    NEX_CHECK_EQ(regressed.load(), 0);
+    NEX_CHECK(reads.load() > 0);
+    for(int i = 0; i < kInstances; i++){
+        SimulatedSnapshot snapshot;
+        NEX_CHECK_EQ(snapshots[i].read(snapshot), kWritesPerThread / (kInstances / kCallbackThreads));
+        NEX_CHECK(snapshot.checksum == Checksum(snapshot));
+    }
+}
+
+// Several SDK threads reporting on one instance (progress and playhead callbacks) must not
+// lose each other's read-modify-write updates.
+NEX_TEST(ConcurrentUpdatesAreSerialised) {
+    NexSeqlock<SimulatedSnapshot> shared;
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+    std::thread unity([&]() {
+        while(!done.load(std::memory_order_acquire)){
+            SimulatedSnapshot snapshot;
+            shared.read(snapshot);
+            if(snapshot.serial != 0 && snapshot.checksum != Checksum(snapshot))
+                torn++;
+        }
+    });
+    std::vector<std::thread> callbacks;
+    for(int t = 0; t < kCallbackThreads; t++){
+        callbacks.emplace_back([&shared]() {
+            for(int n = 0; n < kWritesPerThread / 4; n++){
+                shared.update([](SimulatedSnapshot &snapshot) {
+                    snapshot = MakeSnapshot(snapshot.serial + 1);
+                });
+            }
+        });
+    }
+    for(std::thread &callback : callbacks)
+        callback.join();
+    done.store(true, std::memory_order_release);
+    unity.join();
+
+    SimulatedSnapshot last;
+    NEX_CHECK_EQ(shared.read(last), kCallbackThreads * (kWritesPerThread / 4));
+    NEX_CHECK_EQ(last.serial, kCallbackThreads * (kWritesPerThread / 4));
+    NEX_CHECK_EQ(torn.load(), 0);
+}
+
+NEX_TEST_MAIN()
@@ -0,0 +1,146 @@
+// NexSubtitleTrack: WebVTT/SRT/TTML parsing and the interval index behind external subtitles.
+
+#include "NexSubtitleParser.h"
+#include "NexTest.h"
+
+namespace {
+
+NexSubtitleTrack Parse(const std::string &data) {
+    NexSubtitleTrack track;
+    NEX_CHECK(track.parse(data.data(), data.size()));
+    return track;
+}
+
+std::string CueText(const NexSubtitleTrack &track, size_t cue) {
+    const NexSubtitleCue &entry = track.cues[cue];
+    return std::string(&track.text[entry.textOffset], entry.textLength);
+}
+
+std::vector<uint32_t> Active(const NexSubtitleTrack &track, int64_t ptsMs) {
+    std::vector<uint32_t> active;
+    track.query(ptsMs, active);
+    return active;
+}
+
+}
+
+NEX_TEST(ParsesSrtWithCrlfAndCommaFractions) {
+    NexSubtitleTrack track = Parse(
+        "\xEF\xBB\xBF" "1\r\n00:00:01,000 --> 00:00:02,500\r\nFirst line\r\nSecond line\r\n\r\n"
+        "2\r\n00:01:00,250 --> 00:01:03,000\r\n<i>Italic</i>\r\n");
+    NEX_CHECK_EQ(track.format, NEXUNITY_SUBTITLE_SRT);
+    NEX_CHECK_EQ(track.cues.size(), 2);
+    NEX_CHECK_EQ(track.cues[0].startMs, 1000);
+    NEX_CHECK_EQ(track.cues[0].endMs, 2500);
+    NEX_CHECK_STR(CueText(track, 0), "First line\nSecond line");
+    NEX_CHECK_EQ(track.cues[1].startMs, 60250);
+    NEX_CHECK_STR(CueText(track, 1), "<i>Italic</i>");
+}
+
+NEX_TEST(ParsesWebVttAndStripsVoiceAndClassTags) {
+    NexSubtitleTrack track = Parse(
+        "WEBVTT - title\n\n"
+        "NOTE a comment\nspanning lines\n\n"
+        "STYLE\n::cue { color: yellow }\n\n"
+        "intro\n00:01.000 --> 00:04.000 align:start position:10%\n<v Roger Bingham>We are in New York City</v>\n\n"
+        "00:00:05.000 --> 00:00:06.000\n<v.loud Neil>Hi</v> <c.yellow.bg_blue>there</c>, <lang en-GB>mate</lang>\n\n"
+        "00:00:07.000 --> 00:00:09.000\n<b>Bold</b> karaoke <00:00:08.000>word\n");
+    NEX_CHECK_EQ(track.format, NEXUNITY_SUBTITLE_WEBVTT);
+    NEX_CHECK_EQ(track.cues.size(), 3);
+    NEX_CHECK_EQ(track.cues[0].startMs, 1000);
+    NEX_CHECK_EQ(track.cues[0].endMs, 4000);
+    NEX_CHECK_STR(CueText(track, 0), "We are in New York City");
+    NEX_CHECK_STR(CueText(track, 1), "Hi there, mate");
+    NEX_CHECK_STR(CueText(track, 2), "<b>Bold</b> karaoke word");
+}
+
+NEX_TEST(TtmlTickRateFollowsFrameRateOnlyWhenGiven) {
+    // No ttp:tickRate and no ttp:frameRate: one tick is one second.
+    NexSubtitleTrack plain = Parse(
+        "<?xml version=\"1.0\"?>\n<tt xmlns=\"http://www.w3.org/ns/ttml\"><body><div>"
+        "<p begin=\"5t\" end=\"7t\">Five</p></div></body></tt>");
+    NEX_CHECK_EQ(plain.format, NEXUNITY_SUBTITLE_TTML);
+    NEX_CHECK_EQ(plain.cues.size(), 1);
+    NEX_CHECK_EQ(plain.cues[0].startMs, 5000);
+    NEX_CHECK_EQ(plain.cues[0].endMs, 7000);
+
+    // ttp:frameRate alone: one tick is one frame.
+    NexSubtitleTrack framed = Parse(
+        "<tt xmlns=\"http://www.w3.org/ns/ttml\" xmlns:ttp=\"http://www.w3.org/ns/ttml#parameter\" ttp:frameRate=\"30\">"
+        "<body><div><p begin=\"60t\" dur=\"30t\">Two</p><p begin=\"00:00:04:15\" end=\"00:00:05:00\">Frames</p></div></body></tt>");
+    NEX_CHECK_EQ(framed.cues.size(), 2);
+    NEX_CHECK_EQ(framed.cues[0].startMs, 2000);
+    NEX_CHECK_EQ(framed.cues[0].endMs, 3000);
+    NEX_CHECK_EQ(framed.cues[1].startMs, 4500);
+
+    // An explicit ttp:tickRate wins.
+    NexSubtitleTrack ticked = Parse(
+        "<tt:tt xmlns:tt=\"http://www.w3.org/ns/ttml\" ttp:frameRate=\"25\" ttp:tickRate=\"10000000\">"
+        "<tt:body><tt:div><tt:p begin=\"10000000t\" end=\"25000000t\">One<tt:br/>two &amp; <tt:span>three</tt:span></tt:p>"
+        "</tt:div></tt:body></tt:tt>");
+    NEX_CHECK_EQ(ticked.cues.size(), 1);
+    NEX_CHECK_EQ(ticked.cues[0].startMs, 1000);
+    NEX_CHECK_EQ(ticked.cues[0].endMs, 2500);
+    NEX_CHECK_STR(CueText(ticked, 0), "One\ntwo & three");
+}
+
+NEX_TEST(QueryReturnsOverlappingCuesInStartOrder) {
+    NexSubtitleTrack track = Parse(
+        "WEBVTT\n\n"
+        "00:00:10.000 --> 00:00:30.000\nLong\n\n"
+        "00:00:02.000 --> 00:00:04.000\nEarly\n\n"
+        "00:00:12.000 --> 00:00:14.000\nShort\n\n"
+        "00:00:13.000 --> 00:00:20.000\nMiddle\n");
+    // Out-of-order input is sorted by start.
+    NEX_CHECK_EQ(track.cues[0].startMs, 2000);
+    NEX_CHECK(Active(track, 1999).empty());
+    NEX_CHECK_EQ(Active(track, 2000).size(), 1);
+    NEX_CHECK(Active(track, 4000).empty());     // end is exclusive
+    std::vector<uint32_t> active = Active(track, 13500);
+    NEX_CHECK_EQ(active.size(), 3);
+    if(active.size() == 3){
+        NEX_CHECK_STR(CueText(track, active[0]), "Long");
+        NEX_CHECK_STR(CueText(track, active[1]), "Short");
+        NEX_CHECK_STR(CueText(track, active[2]), "Middle");
+    }
+    NEX_CHECK_EQ(Active(track, 25000).size(), 1);
+    NEX_CHECK(Active(track, 30000).empty());
+}
+
+// The interval index must agree with a linear scan on a large file with many overlaps.
+NEX_TEST(IntervalIndexMatchesLinearScanOnTenThousandCues) {
+    std::string srt;
+    uint32_t seed = 12345;
+    char line[128];
+    for(int i = 0; i < 10000; i++){
+        seed = seed * 1103515245u + 12345u;
+        int64_t startMs = (int64_t)i * 400 + (seed >> 16) % 300;
+        int64_t endMs = startMs + 200 + (seed >> 8) % 5000;
+        snprintf(line, sizeof(line), "%d\n%02d:%02d:%02d,%03d --> %02d:%02d:%02d,%03d\nCue %d\n\n", i + 1,
+                 (int)(startMs / 3600000), (int)(startMs / 60000 % 60), (int)(startMs / 1000 % 60), (int)(startMs % 1000),
+                 (int)(endMs / 3600000), (int)(endMs / 60000 % 60), (int)(endMs / 1000 % 60), (int)(endMs % 1000), i);
+        srt += line;
+    }
+    NexSubtitleTrack track = Parse(srt);
+    NEX_CHECK_EQ(track.cues.size(), 10000);
+    int mismatches = 0;
+    for(int64_t ptsMs = 0; ptsMs < 4010000; ptsMs += 997){
+        std::vector<uint32_t> expected;
+        for(uint32_t i = 0; i < track.cues.size(); i++)
+            if(track.cues[i].startMs <= ptsMs && ptsMs < track.cues[i].endMs)
+                expected.push_back(i);
+        if(Active(track, ptsMs) != expected)
+            mismatches++;
+    }
+    NEX_CHECK_EQ(mismatches, 0);
+}
+
+NEX_TEST(RejectsFilesWithoutCues) {
+    NexSubtitleTrack track;
+    std::string empty = "WEBVTT\n\nNOTE nothing timed here\n";
+    NEX_CHECK(!track.parse(empty.data(), empty.size()));
+    std::string garbage = "not a subtitle file";
+    NEX_CHECK(!track.parse(garbage.data(), garbage.size()));
+}
+
+NEX_TEST_MAIN()
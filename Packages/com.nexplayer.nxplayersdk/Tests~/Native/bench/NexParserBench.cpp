@@ -0,0 +1,172 @@
+// Parser benchmarks that used to ship as NexPlayerUnity_Benchmark* exports: external subtitle
+// lookups, DASH and HLS parsing, live refresh, and the device profile rewrite. Run by hand:
+//
+//   NexParserBench [subtitles|manifest|playlist|refresh|rewrite]...
+
+#include <chrono>
+
+#include "NexSubtitleParser.h"
+#include "NexManifestIndex.h"
+#include "NexDeviceProfile.h"
+#include "NexSynthetic.h"
+
+namespace {
+
+int64_t ElapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Lookups spread over a 10000-cue file.
+void Subtitles(int cues, int lookups) {
+    std::string srt = NexSyntheticSrt(cues);
+    NexSubtitleTrack track;
+    if(!track.parse(srt.data(), srt.size()))
+        return;
+    int64_t spanMs = track.cues.back().startMs + 1;
+    std::vector<uint32_t> active;
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < lookups; i++){
+        track.query((int64_t)i * 7919 % spanMs, active);
+        found += active.size();
+    }
+    int64_t elapsedNs = ElapsedNs(start);
+    printf("subtitles: %d cues parsed in %lld us; %d lookups, %lu active cues, %lld ns per lookup\n", cues, (long long)track.parseUs,
+           lookups, (unsigned long)found, (long long)(elapsedNs / lookups));
+}
+
+// Multi-period VOD MPD: parse time, index size and the cost of resolving every segment URL.
+void Manifest(int periods, int representations, int segments) {
+    std::string mpd = NexSyntheticMPD(periods, representations, segments);
+    NexManifestIndex manifest;
+    if(!manifest.parse(mpd.data(), mpd.size(), "https://cdn.example.com/vod/manifest.mpd", NexWallClockMs()))
+        return;
+    std::string url;
+    int64_t total = manifest.segmentTotal();
+    auto start = std::chrono::steady_clock::now();
+    for(size_t r = 0; r < manifest.renditions.size(); r++)
+        for(uint32_t i = 0; i < manifest.renditions[r].record.segmentCount; i++)
+            manifest.segmentURL(r, i, false, url);
+    int64_t urlNs = ElapsedNs(start);
+    size_t indexBytes = manifest.runs.size() * sizeof(NexSegmentRun) + manifest.renditions.size() * sizeof(NexManifestRendition) + manifest.strings.size();
+    printf("manifest: %lu bytes parsed in %lld us, %lld segments in %lu index bytes, %lld ns per URL\n", (unsigned long)mpd.size(),
+           (long long)manifest.parseUs, (long long)total, (unsigned long)indexBytes, (long long)(total > 0 ? urlNs / total : 0));
+}
+
+void Playlist(int segments) {
+    std::string playlist = NexSyntheticPlaylist(segments);
+    NexMediaPlaylist media;
+    if(!media.parse(playlist.data(), playlist.size(), "https://cdn.example.com/live/event.m3u8", 0))
+        return;
+    size_t indexBytes = media.segments.size() * sizeof(NexHlsSegment) + media.parts.size() * sizeof(NexHlsPart) + media.strings.size();
+    printf("playlist: %lu bytes, %lu segments parsed in %lld us, %lu index bytes\n", (unsigned long)playlist.size(),
+           (unsigned long)media.segments.size(), (long long)media.parseUs, (unsigned long)indexBytes);
+}
+
+// `hours` of a live event reloaded after every segment: an HLS EVENT playlist of 4 s segments and
+// a live MPD of 2 s segments grow by one segment per reload. Each hour compares a full parse of
+// the manifest as it then stands with the incremental refresh. The HLS refresh only reads what
+// follows the segments it already has; a DASH reload still tokenises the whole MPD and reuses only
+// the parsed runs, so its cost keeps growing with the event, and the summary says by how much.
+void Refresh(int hours) {
+    const char *playlistUrl = "https://cdn.example.com/live/event.m3u8", *mpdUrl = "https://cdn.example.com/live/event.mpd";
+    const int playlistHour = 900, mpdHour = 1800;
+    // Every reload of the playlist is a prefix of the whole event's, ending after a segment.
+    std::string playlist = NexSyntheticPlaylist(hours * playlistHour);
+    std::vector<size_t> segmentEnds;
+    for(size_t p = 0; p < playlist.size();){
+        size_t next = playlist.find('\n', p);
+        next = next == std::string::npos ? playlist.size() : next + 1;
+        if(playlist[p] != '#' && playlist[p] != '\n')
+            segmentEnds.push_back(next);
+        p = next;
+    }
+    NexMediaPlaylist media;
+    media.parse(playlist.data(), segmentEnds[0], playlistUrl, 0);
+    int64_t hlsFirstNs = 0, hlsLastNs = 0, dashFirstUs = 0, dashLastUs = 0;
+    for(int hour = 1; hour <= hours; hour++){
+        size_t first = (size_t)(hour - 1) * playlistHour + 1, last = std::min<size_t>((size_t)hour * playlistHour, segmentEnds.size());
+        auto start = std::chrono::steady_clock::now();
+        for(size_t i = first; i < last; i++)
+            media.refresh(playlist.data(), segmentEnds[i], 0);
+        int64_t refreshNs = ElapsedNs(start) / (int64_t)std::max<size_t>(1, last - first);
+        NexMediaPlaylist full;
+        full.parse(playlist.data(), segmentEnds[last - 1], playlistUrl, 0);
+
+        // The MPD grows inside its timelines, so each hour reloads it once from the hour's end.
+        std::string before = NexSyntheticLiveMPD(hour * mpdHour), after = NexSyntheticLiveMPD(hour * mpdHour + 1);
+        NexManifestIndex previous, fresh;
+        previous.parse(before.data(), before.size(), mpdUrl, NexWallClockMs());
+        fresh.parse(after.data(), after.size(), mpdUrl, NexWallClockMs());
+        int64_t mpdRefreshUs = INT64_MAX;
+        for(int repeat = 0; repeat < 20; repeat++){
+            NexManifestIndex refreshed;
+            refreshed.parse(after.data(), after.size(), mpdUrl, NexWallClockMs(), &previous);
+            mpdRefreshUs = std::min(mpdRefreshUs, refreshed.parseUs);
+        }
+        printf("refresh: hour %d, HLS %lu segments parsed in %lld us, refreshed in %lld ns; DASH %lld segments parsed in %lld us, refreshed in %lld us\n",
+               hour, (unsigned long)media.segments.size(), (long long)full.parseUs, (long long)refreshNs, (long long)fresh.segmentTotal(),
+               (long long)fresh.parseUs, (long long)mpdRefreshUs);
+        if(hour == 1){
+            hlsFirstNs = refreshNs;
+            dashFirstUs = mpdRefreshUs;
+        }
+        hlsLastNs = refreshNs;
+        dashLastUs = mpdRefreshUs;
+    }
+    printf("refresh: over %d hours the HLS refresh went from %lld to %lld ns (%.1fx, constant per reload); "
+           "the DASH refresh went from %lld to %lld us (%.1fx, linear in the MPD, which is re-read whole)\n",
+           hours, (long long)hlsFirstNs, (long long)hlsLastNs, (double)hlsLastNs / std::max<int64_t>(1, hlsFirstNs),
+           (long long)dashFirstUs, (long long)dashLastUs, (double)dashLastUs / std::max<int64_t>(1, dashFirstUs));
+}
+
+// A 1280x720, 5 Mbps, High 4.0 profile on an MPD and a master playlist with `representations`
+// video renditions each, 100 times each from a fresh copy.
+void Rewrite(int representations) {
+    NexDeviceProfile profile = { NEXPLAYER_DEVICE_PROFILE_VERSION, sizeof(NexDeviceProfile), 1280, 720, 5000000, NEXUNITY_VIDEO_CODEC_AVC,
+                                 NEXUNITY_AVC_PROFILE_MAIN | NEXUNITY_AVC_PROFILE_HIGH, 40, NEXUNITY_RENDITION_ORDER_ASCENDING, 0 };
+    const std::string manifests[2] = { NexSyntheticMPD(1, representations, 300), NexSyntheticMaster(representations) };
+    const int repeats = 100;
+    for(const std::string &manifest : manifests){
+        std::vector<char> data(manifest.size());
+        NexManifestRewriteInfo info = {};
+        int64_t totalNs = 0;
+        for(int i = 0; i < repeats; i++){
+            memcpy(data.data(), manifest.data(), manifest.size());
+            info = NexManifestRewriteInfo();
+            auto start = std::chrono::steady_clock::now();
+            NexApplyDeviceProfile(profile, data.data(), data.size(), info);
+            totalNs += ElapsedNs(start);
+        }
+        printf("rewrite: %s, %d of %d video renditions removed, %d -> %d bytes in %lld ns\n", info.type == NEXUNITY_MANIFEST_DASH ? "DASH" : "HLS",
+               info.removed, info.removed + info.kept, info.inputSize, info.outputSize, (long long)(totalNs / repeats));
+    }
+}
+
+}
+
+int main(int argc, char **argv) {
+    std::vector<std::string> runs(argv + 1, argv + argc);
+    if(runs.empty())
+        runs = { "subtitles", "manifest", "playlist", "refresh", "rewrite" };
+    for(const std::string &run : runs){
+        if(run == "subtitles"){
+            Subtitles(10000, 1000000);
+        } else if(run == "manifest"){
+            Manifest(1, 8, 1800);
+            Manifest(24, 8, 150);
+        } else if(run == "playlist"){
+            Playlist(900);
+            Playlist(21600);
+        } else if(run == "refresh"){
+            Refresh(6);
+        } else if(run == "rewrite"){
+            Rewrite(8);
+            Rewrite(32);
+        } else {
+            fprintf(stderr, "unknown benchmark %s\n", run.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
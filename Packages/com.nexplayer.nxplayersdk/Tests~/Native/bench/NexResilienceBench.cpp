@@ -0,0 +1,50 @@
+// Recovery latency of the resilience policy against a local HTTP stand-in under loss and timeout
+// profiles, in real time. Run by hand:
+//
+//   NexResilienceBench [dropPercent stallPercent timeoutMs [segments [backoffBaseMs]]]
+//
+// Without arguments it runs the profiles below. Dropped requests fail at once; stalled ones fail
+// when the client's inactivity timeout runs out.
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "NexResilienceDrill.h"
+
+namespace {
+
+void Profile(int dropPercent, int stallPercent, int timeoutMs, int segments, int backoffBaseMs) {
+    NexHttpStandIn server;
+    if(!server.listening())
+        exit(1);
+    server.setFaults(dropPercent, stallPercent);
+    NexResiliencePolicy policy = resilienceDefaults;
+    policy.backoffBaseMs = backoffBaseMs;
+    policy.backoffMaxMs = backoffBaseMs * 32;
+    policy.sessionRetries = 1000000;
+    NexDrillResult result = NexResilienceDrill(server, policy, segments, timeoutMs, 0x9E3779B97F4A7C15ULL);
+    std::vector<int64_t> &latencies = result.recoveriesMs;
+    std::sort(latencies.begin(), latencies.end());
+    int64_t total = 0;
+    for(int64_t latency : latencies)
+        total += latency;
+    printf("resilience: %2d%% drop, %2d%% stall, %4d ms timeout: %d of %d segments, %lu recoveries, mean %lld ms, p95 %lld ms, max %lld ms, "
+           "%d retries, %d passed to the app, %lld ms in all\n", dropPercent, stallPercent, timeoutMs, result.fetched, segments,
+           (unsigned long)latencies.size(), (long long)(latencies.empty() ? 0 : total / (int64_t)latencies.size()),
+           (long long)(latencies.empty() ? 0 : latencies[latencies.size() * 95 / 100]), (long long)(latencies.empty() ? 0 : latencies.back()),
+           result.retries, result.forwarded, (long long)(result.elapsedUs / 1000));
+}
+
+}
+
+int main(int argc, char **argv) {
+    if(argc >= 4){
+        Profile(atoi(argv[1]), atoi(argv[2]), atoi(argv[3]), argc >= 5 ? atoi(argv[4]) : 200, argc >= 6 ? atoi(argv[5]) : 50);
+        return 0;
+    }
+    const int profiles[][3] = { { 1, 0, 250 }, { 5, 0, 250 }, { 20, 0, 250 }, { 0, 5, 250 }, { 0, 5, 1000 }, { 10, 10, 500 } };
+    for(const int *profile : profiles)
+        Profile(profile[0], profile[1], profile[2], 200, 50);
+    return 0;
+}
@@ -0,0 +1,23 @@
+//
+//  NexHostShim.h
+//  NexPlayerNativeTests
+//
+//  The few SDK declarations NexPlayerEnum.h relies on, for building the bridge headers off-device.
+//
+
+#ifndef NexHostShim_h
+#define NexHostShim_h
+
+typedef long NSInteger;
+
+typedef enum {
+    NXLogLevelError = 0,
+    NXLogLevelWarning,
+    NXLogLevelInformation,
+    NXLogLevelDebug,
+    NXLogLevelVerbose,
+    NXLogLevelAboveVerbose,
+    NXLogLevelExtraVerbose
+} NXLogLevel;
+
+#endif /* NexHostShim_h */
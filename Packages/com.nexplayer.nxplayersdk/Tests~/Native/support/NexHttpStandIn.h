@@ -0,0 +1,283 @@
+//
+//  NexHttpStandIn.h
+//  NexPlayerNativeTests
+//
+//  Local HTTP/1.1 server standing in for a CDN, with injected faults, and the client the tests
+//  and benchmarks fetch from it with. One connection per request (Connection: close).
+//
+
+#ifndef NexHttpStandIn_h
+#define NexHttpStandIn_h
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// What the stand-in does with a request.
+enum NexStandInFault {
+    NEX_STANDIN_SERVE = 0,
+    NEX_STANDIN_DROP = 1,       // closes the connection without answering, as when the path loses it
+    NEX_STANDIN_STALL = 2,      // keeps the connection and never answers; the client has to time out
+    NEX_STANDIN_STATUS = 3,     // answers errorStatus
+};
+
+// NexHttpResponse::status when no HTTP status came back.
+#define NEX_HTTP_TIMEOUT -1
+#define NEX_HTTP_CLOSED -2
+#define NEX_HTTP_CONNECT_FAILED -3
+
+inline int64_t NexStandInNowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class NexHttpStandIn {
+public:
+    std::atomic<int> served, dropped, stalled, failed;
+
+    explicit NexHttpStandIn(uint64_t seed = 0x9E3779B97F4A7C15ULL)
+        : served(0), dropped(0), stalled(0), failed(0), random(seed | 1), listener(-1), running(false) {
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if(bind(listener, (sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 64) != 0 ||
+           getsockname(listener, (sockaddr *)&address, &length) != 0){
+            fprintf(stderr, "stand-in: cannot listen: %s\n", strerror(errno));
+            close(listener);
+            listener = -1;
+            return;
+        }
+        boundPort = ntohs(address.sin_port);
+        running = true;
+        worker = std::thread([this] { serve(); });
+    }
+
+    ~NexHttpStandIn() {
+        running = false;
+        if(worker.joinable())
+            worker.join();
+        for(int connection : stalls)
+            close(connection);
+        if(listener >= 0)
+            close(listener);
+    }
+
+    bool listening() const { return listener >= 0; }
+    int port() const { return boundPort; }
+
+    // Share of requests, in percent, dropped, stalled and answered with errorStatus; the rest are
+    // served a body of bodyBytes. Which ones comes from a seeded xorshift, so runs repeat.
+    void setFaults(int dropPercent, int stallPercent, int statusPercent = 0, int errorStatus = 503) {
+        std::lock_guard<std::mutex> guard(lock);
+        drop = dropPercent;
+        stall = stallPercent;
+        status = statusPercent;
+        this->errorStatus = errorStatus;
+    }
+
+    void setBodyBytes(size_t bytes) {
+        std::lock_guard<std::mutex> guard(lock);
+        bodyBytes = bytes;
+    }
+
+    // Decides the fault of each request from its head instead of the percentages; empty to go back.
+    void setDecider(std::function<int(const std::string &)> decider) {
+        std::lock_guard<std::mutex> guard(lock);
+        decide = std::move(decider);
+    }
+
+    // Request heads received so far, request line and headers.
+    std::vector<std::string> requests() {
+        std::lock_guard<std::mutex> guard(lock);
+        return heads;
+    }
+
+private:
+    uint64_t random;
+    int listener, boundPort = 0;
+    std::atomic<bool> running;
+    std::thread worker;
+    std::mutex lock;
+    int drop = 0, stall = 0, status = 0, errorStatus = 503;
+    size_t bodyBytes = 65536;
+    std::function<int(const std::string &)> decide;
+    std::vector<std::string> heads;
+    std::vector<int> stalls;
+
+    int fault(const std::string &head) {
+        std::lock_guard<std::mutex> guard(lock);
+        heads.push_back(head);
+        if(decide)
+            return decide(head);
+        random ^= random << 13;
+        random ^= random >> 7;
+        random ^= random << 17;
+        int roll = (int)((random >> 33) % 100);
+        return roll < drop ? NEX_STANDIN_DROP : roll < drop + stall ? NEX_STANDIN_STALL : roll < drop + stall + status ? NEX_STANDIN_STATUS : NEX_STANDIN_SERVE;
+    }
+
+    void serve() {
+        pollfd waiting = { listener, POLLIN, 0 };
+        while(running){
+            if(poll(&waiting, 1, 20) <= 0)
+                continue;
+            int connection = accept(listener, NULL, NULL);
+            if(connection < 0)
+                continue;
+            std::string head;
+            if(!readHead(connection, head)){
+                close(connection);
+                continue;
+            }
+            switch(fault(head)){
+                case NEX_STANDIN_DROP:
+                    dropped++;
+                    close(connection);
+                    break;
+                case NEX_STANDIN_STALL:
+                    stalled++;
+                    stalls.push_back(connection);
+                    if(stalls.size() > 64){
+                        close(stalls.front());
+                        stalls.erase(stalls.begin());
+                    }
+                    break;
+                case NEX_STANDIN_STATUS: {
+                    failed++;
+                    char response[128];
+                    int length;
+                    {
+                        std::lock_guard<std::mutex> guard(lock);
+                        length = snprintf(response, sizeof(response), "HTTP/1.1 %d Error\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", errorStatus);
+                    }
+                    sendAll(connection, response, (size_t)length);
+                    close(connection);
+                    break;
+                }
+                default: {
+                    served++;
+                    size_t bytes;
+                    {
+                        std::lock_guard<std::mutex> guard(lock);
+                        bytes = bodyBytes;
+                    }
+                    std::string response = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(bytes) + "\r\nConnection: close\r\n\r\n";
+                    response.append(bytes, 'x');
+                    sendAll(connection, response.data(), response.size());
+                    close(connection);
+                    break;
+                }
+            }
+        }
+    }
+
+    bool readHead(int connection, std::string &head) {
+        char chunk[4096];
+        while(head.find("\r\n\r\n") == std::string::npos){
+            pollfd readable = { connection, POLLIN, 0 };
+            if(!running || poll(&readable, 1, 1000) <= 0)
+                return false;
+            ssize_t read = recv(connection, chunk, sizeof(chunk), 0);
+            if(read <= 0)
+                return false;
+            head.append(chunk, (size_t)read);
+        }
+        head.resize(head.find("\r\n\r\n") + 2);
+        return true;
+    }
+
+    static void sendAll(int connection, const char *data, size_t size) {
+        while(size > 0){
+            ssize_t sent = send(connection, data, size, MSG_NOSIGNAL);
+            if(sent <= 0)
+                return;
+            data += sent;
+            size -= (size_t)sent;
+        }
+    }
+};
+
+typedef struct {
+    int status;             // HTTP status, or NEX_HTTP_TIMEOUT, NEX_HTTP_CLOSED, NEX_HTTP_CONNECT_FAILED
+    size_t bytes;           // body bytes received
+    int64_t elapsedUs;
+} NexHttpResponse;
+
+// Sends `request` (a whole request head) to the stand-in and reads the answer, giving up after
+// timeoutMs without progress the way the SDK's data inactivity timeout does.
+inline NexHttpResponse NexHttpFetch(int port, const std::string &request, int timeoutMs) {
+    NexHttpResponse response = { NEX_HTTP_CONNECT_FAILED, 0, 0 };
+    int64_t startUs = NexStandInNowUs();
+    int connection = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons((uint16_t)port);
+    if(connect(connection, (sockaddr *)&address, sizeof(address)) != 0 ||
+       send(connection, request.data(), request.size(), MSG_NOSIGNAL) != (ssize_t)request.size()){
+        close(connection);
+        response.elapsedUs = NexStandInNowUs() - startUs;
+        return response;
+    }
+    std::string received;
+    size_t bodyStart = std::string::npos, contentLength = 0;
+    char chunk[16384];
+    response.status = NEX_HTTP_CLOSED;
+    while(true){
+        pollfd readable = { connection, POLLIN, 0 };
+        if(poll(&readable, 1, timeoutMs) <= 0){
+            response.status = NEX_HTTP_TIMEOUT;
+            break;
+        }
+        ssize_t read = recv(connection, chunk, sizeof(chunk), 0);
+        if(read <= 0)
+            break;
+        if(bodyStart == std::string::npos){
+            received.append(chunk, (size_t)read);
+            size_t headEnd = received.find("\r\n\r\n");
+            if(headEnd == std::string::npos)
+                continue;
+            bodyStart = headEnd + 4;
+            int status = 0;
+            if(sscanf(received.c_str(), "HTTP/1.1 %d", &status) != 1)
+                break;
+            size_t length = received.find("Content-Length: ");
+            contentLength = length != std::string::npos && length < headEnd ? strtoul(received.c_str() + length + 16, NULL, 10) : 0;
+            response.bytes = received.size() - bodyStart;
+            response.status = status;
+        } else {
+            response.bytes += (size_t)read;
+        }
+        if(response.bytes >= contentLength)
+            break;
+    }
+    // A body cut short is as good as none.
+    if(response.status > 0 && response.bytes < contentLength)
+        response.status = NEX_HTTP_CLOSED;
+    close(connection);
+    response.elapsedUs = NexStandInNowUs() - startUs;
+    return response;
+}
+
+inline std::string NexStandInRequest(int port, const std::string &path) {
+    return "GET " + path + " HTTP/1.1\r\nHost: 127.0.0.1:" + std::to_string(port) + "\r\nUser-Agent: NexPlayer\r\n\r\n";
+}
+
+#endif /* NexHttpStandIn_h */
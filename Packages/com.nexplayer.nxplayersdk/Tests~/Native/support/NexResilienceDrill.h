@@ -0,0 +1,70 @@
+//
+//  NexResilienceDrill.h
+//  NexPlayerNativeTests
+//
+//  Plays segments from a NexHttpStandIn the way an instance with a resilience policy does, in
+//  real time, for the recovery tests and benchmarks.
+//
+
+#ifndef NexResilienceDrill_h
+#define NexResilienceDrill_h
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "NexResilience.h"
+#include "NexHttpStandIn.h"
+
+// Stand-in codes for the NXErrors the SDK would raise; the policy only sees their class.
+#define NEX_DRILL_ERROR_TIMEOUT 0x1001
+#define NEX_DRILL_ERROR_CLOSED 0x1002
+#define NEX_DRILL_ERROR_STATUS 0x1003
+
+typedef struct {
+    int fetched;                        // segments that played
+    int retries;
+    int forwarded;                      // failures that reached the app, which would reopen
+    std::vector<int64_t> recoveriesMs;  // first error to the next segment that played
+    int64_t elapsedUs;
+} NexDrillResult;
+
+// Fetches `segments` segments in order. A failed fetch is a retryable error for
+// NexResilienceFailure: the drill waits the backoff it returns and fetches again, and the next
+// segment that comes through ends the failure (NexResilienceProgress). A failure passed to the
+// app skips the segment and starts a new session, as a reopen would.
+inline NexDrillResult NexResilienceDrill(NexHttpStandIn &server, const NexResiliencePolicy &policy, int segments, int timeoutMs, uint64_t seed) {
+    NexDrillResult result = {};
+    NexResilience resilience = {};
+    NexResetResilience(resilience, &policy, seed);
+    int64_t startUs = NexStandInNowUs();
+    for(int segment = 0; segment < segments; segment++){
+        std::string request = NexStandInRequest(server.port(), "/vod/seg" + std::to_string(segment) + ".m4s");
+        while(true){
+            NexHttpResponse response = NexHttpFetch(server.port(), request, timeoutMs);
+            if(response.status == 200){
+                result.fetched++;
+                int64_t recoveryMs = NexResilienceProgress(resilience, NexStandInNowUs());
+                if(recoveryMs >= 0)
+                    result.recoveriesMs.push_back(recoveryMs);
+                break;
+            }
+            uint32_t code = response.status == NEX_HTTP_TIMEOUT ? NEX_DRILL_ERROR_TIMEOUT : response.status > 0 ? NEX_DRILL_ERROR_STATUS : NEX_DRILL_ERROR_CLOSED;
+            int delayMs = 0;
+            int decision = NexResilienceFailure(resilience, code, NEXUNITY_ERROR_RETRYABLE, segment * 2000, NexStandInNowUs(), &delayMs);
+            if(decision != RESILIENCE_RETRY){
+                result.forwarded++;
+                NexResetResilience(resilience, &policy, resilience.random);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+            resilience.scheduled = false;
+            resilience.stats.retries++;
+            result.retries++;
+        }
+    }
+    result.elapsedUs = NexStandInNowUs() - startUs;
+    return result;
+}
+
+#endif /* NexResilienceDrill_h */
@@ -0,0 +1,157 @@
+//
+//  NexSynthetic.h
+//  NexPlayerNativeTests
+//
+//  Generated manifests, playlists and subtitle files of any size for the benchmarks.
+//
+
+#ifndef NexSynthetic_h
+#define NexSynthetic_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <string>
+
+// Multi-period VOD MPD: per period one video AdaptationSet with `representations` renditions and
+// one audio set, both on explicit SegmentTimelines whose S elements alternate in duration so none
+// of them fold into runs.
+inline std::string NexSyntheticMPD(int periods, int representations, int segments) {
+    std::string mpd;
+    char line[256];
+    snprintf(line, sizeof(line), "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\" type=\"static\" mediaPresentationDuration=\"PT%dS\">\n", periods * segments * 2);
+    mpd += line;
+    mpd += " <BaseURL>https://cdn.example.com/vod/</BaseURL>\n";
+    for(int period = 0; period < periods; period++){
+        snprintf(line, sizeof(line), " <Period id=\"p%d\" start=\"PT%dS\">\n  <BaseURL>period%d/</BaseURL>\n", period, period * segments * 2, period);
+        mpd += line;
+        for(int set = 0; set < 2; set++){
+            mpd += set == 0 ? "  <AdaptationSet contentType=\"video\" mimeType=\"video/mp4\">\n" : "  <AdaptationSet contentType=\"audio\" mimeType=\"audio/mp4\" lang=\"en\">\n";
+            mpd += "   <SegmentTemplate timescale=\"90000\" media=\"$RepresentationID$/$Time$.m4s\" initialization=\"$RepresentationID$/init.mp4\">\n    <SegmentTimeline>\n";
+            uint64_t time = 0;
+            for(int i = 0; i < segments; i++){
+                int duration = i % 2 == 0 ? 180000 : 179999;
+                snprintf(line, sizeof(line), i == 0 ? "     <S t=\"0\" d=\"%d\"/>\n" : "     <S d=\"%d\"/>\n", duration);
+                mpd += line;
+                time += duration;
+            }
+            mpd += "    </SegmentTimeline>\n   </SegmentTemplate>\n";
+            for(int r = 0; r < (set == 0 ? representations : 1); r++){
+                snprintf(line, sizeof(line), "   <Representation id=\"%c%d\" bandwidth=\"%d\" width=\"%d\" height=\"%d\" codecs=\"%s\"/>\n",
+                         set == 0 ? 'v' : 'a', r, 300000 * (r + 1), 320 * (r + 1), 180 * (r + 1), set == 0 ? "avc1.64001f" : "mp4a.40.2");
+                mpd += line;
+            }
+            mpd += "  </AdaptationSet>\n";
+        }
+        mpd += " </Period>\n";
+    }
+    mpd += "</MPD>\n";
+    return mpd;
+}
+
+// EVENT playlist: byte-ranged segments with a PROGRAM-DATE-TIME each, a key rotation and a
+// DATERANGE every 100 segments, and LL-HLS parts on the last three segments.
+inline std::string NexSyntheticPlaylist(int segments) {
+    std::string playlist = "#EXTM3U\n#EXT-X-VERSION:9\n#EXT-X-TARGETDURATION:4\n#EXT-X-PLAYLIST-TYPE:EVENT\n"
+                           "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=1.0\n#EXT-X-PART-INF:PART-TARGET=0.33334\n"
+                           "#EXT-X-MEDIA-SEQUENCE:0\n#EXT-X-MAP:URI=\"init.mp4\"\n";
+    char line[256];
+    time_t base = 1700000000;
+    for(int i = 0; i < segments; i++){
+        time_t date = base + i * 4;
+        struct tm fields;
+        gmtime_r(&date, &fields);
+        if(i % 100 == 0){
+            snprintf(line, sizeof(line), "#EXT-X-KEY:METHOD=AES-128,URI=\"https://keys.example.com/k%d\",IV=0x%032x\n", i / 100, i);
+            playlist += line;
+            strftime(line, sizeof(line), "#EXT-X-DATERANGE:ID=\"ad%%d\",CLASS=\"com.example.ad\",START-DATE=\"%Y-%m-%dT%H:%M:%S.000Z\",DURATION=30.0\n", &fields);
+            char daterange[256];
+            snprintf(daterange, sizeof(daterange), line, i / 100);
+            playlist += daterange;
+        }
+        strftime(line, sizeof(line), "#EXT-X-PROGRAM-DATE-TIME:%Y-%m-%dT%H:%M:%S.000Z\n", &fields);
+        playlist += line;
+        if(i >= segments - 3){
+            for(int part = 0; part < 12; part++){
+                snprintf(line, sizeof(line), "#EXT-X-PART:DURATION=0.33334,URI=\"seg%d.part%d.m4s\"%s\n", i, part, part % 6 == 0 ? ",INDEPENDENT=YES" : "");
+                playlist += line;
+            }
+        }
+        snprintf(line, sizeof(line), "#EXTINF:4.00000,\n#EXT-X-BYTERANGE:%d@%lld\nmedia%d.m4s\n", 480000 + i % 7, (long long)(i % 50) * 500000, i / 50);
+        playlist += line;
+    }
+    snprintf(line, sizeof(line), "#EXT-X-PART:DURATION=0.33334,URI=\"seg%d.part0.m4s\",INDEPENDENT=YES\n#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"seg%d.part1.m4s\"\n", segments, segments);
+    playlist += line;
+    return playlist;
+}
+
+// Live MPD: `segments` segments of about two seconds in a video and an audio SegmentTimeline, one
+// S with a t each and alternating durations, the way packagers write 29.97 fps video and AAC
+// audio that do not fold into repeats.
+inline std::string NexSyntheticLiveMPD(int segments) {
+    std::string mpd = "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\" type=\"dynamic\" availabilityStartTime=\"2026-01-01T00:00:00Z\" "
+                      "minimumUpdatePeriod=\"PT2S\" timeShiftBufferDepth=\"PT24H\">\n <BaseURL>https://cdn.example.com/live/</BaseURL>\n"
+                      " <Period id=\"event\" start=\"PT0S\">\n";
+    char line[256];
+    for(int set = 0; set < 2; set++){
+        bool video = set == 0;
+        mpd += video ? "  <AdaptationSet contentType=\"video\" mimeType=\"video/mp4\">\n" : "  <AdaptationSet contentType=\"audio\" mimeType=\"audio/mp4\" lang=\"en\">\n";
+        snprintf(line, sizeof(line), "   <SegmentTemplate timescale=\"%d\" media=\"$RepresentationID$/$Time$.m4s\" initialization=\"$RepresentationID$/init.mp4\">\n    <SegmentTimeline>\n",
+                 video ? 90000 : 48000);
+        mpd += line;
+        uint64_t time = 0;
+        for(int i = 0; i < segments; i++){
+            int duration = video ? (i % 2 == 0 ? 180180 : 179820) : (i % 2 == 0 ? 96256 : 95232);
+            snprintf(line, sizeof(line), "     <S t=\"%llu\" d=\"%d\"/>\n", (unsigned long long)time, duration);
+            mpd += line;
+            time += duration;
+        }
+        mpd += "    </SegmentTimeline>\n   </SegmentTemplate>\n";
+        mpd += video ? "   <Representation id=\"v0\" bandwidth=\"3000000\" width=\"1280\" height=\"720\" codecs=\"avc1.64001f\"/>\n" :
+                       "   <Representation id=\"a0\" bandwidth=\"128000\" codecs=\"mp4a.40.2\"/>\n";
+        mpd += "  </AdaptationSet>\n";
+    }
+    mpd += " </Period>\n</MPD>\n";
+    return mpd;
+}
+
+// Master playlist: `variants` AVC variants climbing to 4K, each with an I-frame variant, sharing
+// one audio group.
+inline std::string NexSyntheticMaster(int variants) {
+    std::string master = "#EXTM3U\n#EXT-X-VERSION:7\n#EXT-X-INDEPENDENT-SEGMENTS\n"
+                         "#EXT-X-MEDIA:TYPE=AUDIO,GROUP-ID=\"aac\",NAME=\"English\",LANGUAGE=\"en\",DEFAULT=YES,URI=\"audio/en.m3u8\"\n";
+    char line[320];
+    for(int i = 0; i < variants; i++){
+        int width = 3840 * (i + 1) / variants, height = 2160 * (i + 1) / variants, bandwidth = 16000000 / variants * (i + 1);
+        snprintf(line, sizeof(line), "#EXT-X-STREAM-INF:BANDWIDTH=%d,RESOLUTION=%dx%d,FRAME-RATE=30.000,CODECS=\"avc1.%s,mp4a.40.2\",AUDIO=\"aac\"\nvideo/%dp.m3u8\n",
+                 bandwidth, width, height, height > 1080 ? "640033" : height > 720 ? "640028" : "64001f", height);
+        master += line;
+    }
+    for(int i = 0; i < variants; i++){
+        int width = 3840 * (i + 1) / variants, height = 2160 * (i + 1) / variants;
+        snprintf(line, sizeof(line), "#EXT-X-I-FRAME-STREAM-INF:BANDWIDTH=%d,RESOLUTION=%dx%d,CODECS=\"avc1.64001f\",URI=\"video/%dp_iframes.m3u8\"\n",
+                 1000000 / variants * (i + 1), width, height, height);
+        master += line;
+    }
+    return master;
+}
+
+// SRT file of `cues` cues 400 ms apart lasting 0.2 to 5.2 s each, so many of them overlap.
+inline std::string NexSyntheticSrt(int cues) {
+    std::string srt;
+    uint32_t seed = 12345;
+    char line[128];
+    for(int i = 0; i < cues; i++){
+        seed = seed * 1103515245u + 12345u;
+        int64_t startMs = (int64_t)i * 400 + (seed >> 16) % 300;
+        int64_t endMs = startMs + 200 + (seed >> 8) % 5000;
+        snprintf(line, sizeof(line), "%d\n%02d:%02d:%02d,%03d --> %02d:%02d:%02d,%03d\nCue %d\n\n", i + 1,
+                 (int)(startMs / 3600000), (int)(startMs / 60000 % 60), (int)(startMs / 1000 % 60), (int)(startMs % 1000),
+                 (int)(endMs / 3600000), (int)(endMs / 60000 % 60), (int)(endMs / 1000 % 60), (int)(endMs % 1000), i);
+        srt += line;
+    }
+    return srt;
+}
+
+#endif /* NexSynthetic_h */
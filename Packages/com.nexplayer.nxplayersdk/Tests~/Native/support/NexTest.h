@@ -0,0 +1,103 @@
+//
+//  NexTest.h
+//  NexPlayerNativeTests
+//
+//  Minimal test registry and checks; every test file ends with NEX_TEST_MAIN().
+//
+
+#ifndef NexTest_h
+#define NexTest_h
+
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+typedef void (*NexTestFunction)();
+
+struct NexTestCase {
+    const char *name;
+    NexTestFunction run;
+};
+
+inline std::vector<NexTestCase> &NexTestCases() {
+    static std::vector<NexTestCase> cases;
+    return cases;
+}
+
+// Atomic so checks may run on the threads a stress test spawns.
+static std::atomic<int> nexTestFailures(0);
+
+struct NexTestRegistrar {
+    NexTestRegistrar(const char *name, NexTestFunction run) {
+        NexTestCases().push_back({ name, run });
+    }
+};
+
+#define NEX_TEST(name) \
+    static void name(); \
+    static NexTestRegistrar name##Registrar(#name, name); \
+    static void name()
+
+#define NEX_CHECK(condition) \
+    do { \
+        if(!(condition)){ \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            nexTestFailures++; \
+        } \
+    } while(0)
+
+#define NEX_CHECK_EQ(actual, expected) \
+    do { \
+        long long nexActual = (long long)(actual), nexExpected = (long long)(expected); \
+        if(nexActual != nexExpected){ \
+            fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, nexActual, nexExpected); \
+            nexTestFailures++; \
+        } \
+    } while(0)
+
+#define NEX_CHECK_STR(actual, expected) \
+    do { \
+        std::string nexActual(actual), nexExpected(expected); \
+        if(nexActual != nexExpected){ \
+            fprintf(stderr, "%s:%d: %s is \"%s\", expected \"%s\"\n", __FILE__, __LINE__, #actual, nexActual.c_str(), nexExpected.c_str()); \
+            nexTestFailures++; \
+        } \
+    } while(0)
+
+// Reads a file relative to the source directory, which the tests run in.
+inline std::string NexReadFile(const std::string &path) {
+    std::string data;
+    FILE *file = fopen(path.c_str(), "rb");
+    if(file == NULL){
+        fprintf(stderr, "missing test input %s\n", path.c_str());
+        nexTestFailures++;
+        return data;
+    }
+    char chunk[65536];
+    size_t read;
+    while((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        data.append(chunk, read);
+    fclose(file);
+    return data;
+}
+
+// Reads a file the project ships in Assets/StreamingAssets, as the player would open it.
+inline std::string NexReadStreamingAsset(const char *name) {
+    return NexReadFile(std::string("../../../../Assets/StreamingAssets/") + name);
+}
+
+inline int NexRunTests() {
+    for(const NexTestCase &test : NexTestCases()){
+        int before = nexTestFailures;
+        test.run();
+        printf("%s %s\n", nexTestFailures == before ? "PASS" : "FAIL", test.name);
+    }
+    return nexTestFailures == 0 ? 0 : 1;
+}
+
+#define NEX_TEST_MAIN() int main() { return NexRunTests(); }
+
+#endif /* NexTest_h */